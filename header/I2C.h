@@ -1,11 +1,36 @@
 /*
 * filename: I2C.h
-* purpose: Driver for I2C1 communication (e.g., for LCD or Sensors)
+* purpose: Driver for the I2C1/I2C2 controllers (e.g., for LCD or Sensors)
 * author: Connor Ockerse
 * date: 11/27/2025
-* * Connections:
-* I2C1_SCL -> PB8
-* I2C1_SDA -> PB9
+* * Connections (the F446RE pin of each controller; board.h says which are wired):
+* I2C1_SCL -> PB8,  I2C1_SDA -> PB9
+* I2C2_SCL -> PB10, I2C2_SDA -> PC12
+* I2C3 is left out: its SCL (PA8) is the buzzer's TIM1_CH1.
+* note: Every transaction takes the I2CBus it runs on. The buses are
+* independent: each has its own peripheral, pins and failure counters, so a
+* device on one bus can be used while another bus is mid-transaction (from
+* an ISR, say). The wait sites and their budgets are shared.
+*
+* Every wait on the peripheral has a budget of I2C_WAIT_US (spinwait.h
+* site timeouts, set by I2C_INIT()) and also ends on an error flag, so a
+* transaction returns an I2CStatus instead of hanging:
+*
+*   I2C_ERR_NACK     address or data byte not acknowledged; STOP sent
+*   I2C_ERR_ARLO     arbitration lost; the peripheral already let go
+*   I2C_ERR_BUS      misplaced START/STOP seen; bus recovered
+*   I2C_ERR_TIMEOUT  a flag never came (slave stretching SCL or holding SDA
+*                    low, bus stuck busy); bus recovered
+*
+* Recovery (I2C_recover()) turns SCL/SDA into open-drain GPIOs, clocks SCL
+* up to 9 times until the slave releases SDA (it was in the middle of a byte
+* it thinks it is sending), generates a STOP and re-initializes that bus.
+*
+* Worst case of a transaction that makes n waits: n x I2C_WAIT_US plus one
+* recovery, I2C_WORST_CASE_US(n). The waits per call are listed with each
+* function. A healthy byte takes 9 SCL periods (90 us), so the budget only
+* runs out on a broken bus or a slave stretching the clock for over 1 ms.
+* The budgets hold with SPIN_ACCOUNTING=0 too: only the statistics go.
 */
 
 #ifndef I2C_H
@@ -15,28 +40,146 @@
 #include <stm32f446xx.h>
 #include <stdint.h>
 
+// === CONFIGURATION ===
+// Longest a single flag wait may take
+#ifndef I2C_WAIT_US
+#define I2C_WAIT_US 1000U
+#endif
+
+// 9 SCL pulses and a STOP at 100 kHz (100 us), plus the re-init
+#define I2C_RECOVERY_US 120U
+
+// Bound on a transaction with n flag waits, failing or not
+#define I2C_WORST_CASE_US(waits) ((uint32_t)(waits) * I2C_WAIT_US + I2C_RECOVERY_US)
+
+// Handle of one controller
+typedef enum {
+    I2C_BUS1,
+    I2C_BUS2,
+    I2C_NUM_BUSES
+}I2CBus;
+
+typedef enum {
+    I2C_OK,
+    I2C_ERR_NACK,
+    I2C_ERR_ARLO,
+    I2C_ERR_BUS,
+    I2C_ERR_TIMEOUT
+}I2CStatus;
+
+// Failures on one bus since boot, by kind
+typedef struct {
+    uint32_t nacks;
+    uint32_t arbitration_lost;
+    uint32_t bus_errors;
+    uint32_t timeouts;
+    uint32_t recoveries;
+    uint32_t recovery_failed;   // SDA still low after 9 clocks
+}I2CStats;
+
 /**
- * @brief Initializes I2C1 Peripheral on PB8 (SCL) and PB9 (SDA)
- * @details Configures clocks, GPIO AF4, and I2C timing (Standard Mode 100kHz)
- * Uses clock frequency from RccConfig for timing calculations.
+ * @brief Initializes every bus the board wires (BOARD_I2C_BUSES in board.h)
+ * @details I2C_bus_init() on each of them.
  */
 void I2C_INIT(void);
 
+/**
+ * @brief Initializes one I2C controller
+ * @details Configures I2C timing (Standard Mode 100kHz). Clocks and the
+ * open-drain AF4 pins come from BOARD_INIT (board.h).
+ * Uses clock frequency from RccConfig for timing calculations.
+ * Sets the I2C_WAIT_US budgets of the I2C wait sites.
+ * @param bus: Controller to bring up
+ */
+void I2C_bus_init(I2CBus bus);
+
 /**
  * @brief Writes a single byte to a specific register on an I2C slave device
+ * @details 6 waits: I2C_WORST_CASE_US(6)
+ * @param bus: Bus the slave is on
  * @param saddr: Slave Address (7-bit address shifted left by 1)
  * @param maddr: Memory/Register Address inside the slave device to write to
  * @param data: The 8-bit data byte to write
+ * @return I2C_OK or what went wrong
  */
-void I2C1_byteWrite(uint8_t saddr, uint8_t maddr, uint8_t data);
+I2CStatus I2C_byteWrite(I2CBus bus, uint8_t saddr, uint8_t maddr, uint8_t data);
 
 /**
  * @brief Reads a single byte from a specific register on an I2C slave device
+ * @details 8 waits: I2C_WORST_CASE_US(8)
+ * @param bus: Bus the slave is on
  * @param saddr: Slave Address (7-bit address shifted left by 1)
  * @param maddr: Memory/Register Address inside the slave device to read from
  * @param data: Pointer to variable where the read data will be stored
+ * (left alone on an error)
+ * @return I2C_OK or what went wrong
+ */
+I2CStatus I2C_byteRead(I2CBus bus, uint8_t saddr, uint8_t maddr, uint8_t* data);
+
+/**
+ * @brief Writes consecutive bytes from a register/memory address in one transaction
+ * @details START, address, maddr, every byte, STOP. Whatever auto-increment
+ * (or page roll-over) the slave does applies. 5 + len waits.
+ * @param bus: Bus the slave is on
+ * @param saddr: Slave Address (7-bit address shifted left by 1)
+ * @param maddr: First register/memory address
+ * @param data: Bytes to send
+ * @param len: Number of bytes (at least 1)
+ * @return I2C_OK or what went wrong
+ */
+I2CStatus I2C_burstWrite(I2CBus bus, uint8_t saddr, uint8_t maddr, const uint8_t* data, uint16_t len);
+
+/**
+ * @brief Reads consecutive bytes from a register/memory address in one transaction
+ * @details Every byte but the last is ACKed; the last gets NACK + STOP,
+ * following the RM0390 sequences for 1, 2 (POS) and 3+ bytes (BTF), so the
+ * polling may run late without an extra byte being clocked in. At most
+ * 7 + len waits.
+ * @param bus: Bus the slave is on
+ * @param saddr: Slave Address (7-bit address shifted left by 1)
+ * @param maddr: First register/memory address
+ * @param data: Receives len bytes
+ * @param len: Number of bytes (at least 1)
+ * @return I2C_OK or what went wrong
+ */
+I2CStatus I2C_burstRead(I2CBus bus, uint8_t saddr, uint8_t maddr, uint8_t* data, uint16_t len);
+
+/**
+ * @brief Checks whether a transaction is on the wire (START to STOP)
+ * @details For interrupt handlers that must not start one in the middle of
+ * the code they interrupted.
+ * @return 1 if the bus is busy, 0 if idle
+ */
+uint8_t I2C_is_busy(I2CBus bus);
+
+/**
+ * @brief I2C_is_busy() over every bus brought up so far
+ * @return 1 if any of them is busy
+ */
+uint8_t I2C_any_busy(void);
+
+/**
+ * @brief Frees a stuck bus: up to 9 SCL clocks, STOP, I2C_bus_init()
+ * @details Called by the transactions after a timeout or bus error;
+ * blocks for at most I2C_RECOVERY_US.
+ * @return 1 if SDA is released, 0 if a slave still holds it low
+ */
+uint8_t I2C_recover(I2CBus bus);
+
+/**
+ * @brief Copies the failure counters of one bus
+ */
+void I2C_get_stats(I2CBus bus, I2CStats* stats);
+
+/**
+ * @brief Name of a status for reports ("OK", "NACK", ...)
+ */
+const char* I2C_status_name(I2CStatus status);
+
+/**
+ * @brief Name of a bus for reports ("I2C1", ...)
  */
-void I2C1_byteRead(uint8_t saddr, uint8_t maddr, uint8_t* data);
+const char* I2C_bus_name(I2CBus bus);
 
 
-#endif
\ No newline at end of file
+#endif
@@ -4,8 +4,9 @@
 * author: Connor Ockerse
 * date: 11/28/2025
 * * Connections:
-* SCL -> PB8
+* SCL -> PB8 (I2C1, BOARD_RTC_BUS in board.h)
 * SDA -> PB9
+* INT/SQW -> PA0 (EXTI0, open drain, active low)
 * VCC -> 3.3V or 5V
 * GND -> GND
 */
@@ -15,6 +16,7 @@
 
 #include <stm32f446xx.h>
 #include <stdint.h>
+#include "I2C.h"
 
 // I2C Address (7-bit)
 #define RTC_ADDRESS 0x68
@@ -27,6 +29,12 @@
 #define DATE_ADDRESS   0x04
 #define MONTH_ADDRESS  0x05
 #define YEAR_ADDRESS   0x06
+#define ALARM1_ADDRESS  0x07
+#define CONTROL_ADDRESS 0x0E
+#define STATUS_ADDRESS  0x0F
+
+// What RTC_read_*() return when the bus fails (no field reaches it)
+#define RTC_READ_FAILED 0xFFU
 
 // Time Structure to hold all data
 typedef struct {
@@ -39,110 +47,164 @@ typedef struct {
     uint8_t year;
 }Clock;
 
+// === BUS ===
+
+/**
+ * @brief Moves the driver to another I2C bus
+ * @details Starts out on BOARD_RTC_BUS; only needed for other wiring.
+ * @param bus: Bus the DS3231 is on (initialized with I2C_bus_init())
+ */
+void RTC_set_bus(I2CBus bus);
+
+/**
+ * @brief Bus the driver talks to
+ */
+I2CBus RTC_get_bus(void);
+
 // === READ FUNCTIONS (Return the value) ===
 
 /**
  * @brief Reads the seconds register
- * @return Seconds in Decimal (Converted from BCD)
+ * @return Seconds in Decimal (Converted from BCD), RTC_READ_FAILED if the bus fails
  */
 uint8_t RTC_read_second(void);
 
 /**
  * @brief Reads the minutes register
- * @return Minutes in Decimal
+ * @return Minutes in Decimal, RTC_READ_FAILED if the bus fails
  */
 uint8_t RTC_read_minute(void);
 
 /**
  * @brief Reads the hours register (24-hour format)
- * @return Hours in Decimal
+ * @return Hours in Decimal, RTC_READ_FAILED if the bus fails
  */
 uint8_t RTC_read_hour(void);
 
 /**
  * @brief Reads the day of the week
- * @return 1-7 (1=Sunday usually)
+ * @return 1-7 (1=Sunday usually), RTC_READ_FAILED if the bus fails
  */
 uint8_t RTC_read_day(void);
 
 /**
  * @brief Reads the day of the month
- * @return Date (1-31)
+ * @return Date (1-31), RTC_READ_FAILED if the bus fails
  */
 uint8_t RTC_read_date(void);
 
 /**
  * @brief Reads the month
- * @return Month (1-12)
+ * @return Month (1-12), RTC_READ_FAILED if the bus fails
  */
 uint8_t RTC_read_month(void);
 
 /**
  * @brief Reads the year (2-digit)
- * @return Year (0-99) representing 2000-2099
+ * @return Year (0-99) representing 2000-2099, RTC_READ_FAILED if the bus fails
  */
 uint8_t RTC_read_year(void);
 
 /**
  * @brief Reads all time registers at once into a struct
- * @param time: Pointer to Clock struct to fill
+ * @param time: Pointer to Clock struct to fill (RTC_READ_FAILED in fields that failed)
+ * @return I2C_OK or the first failure
  */
-void RTC_read_clock(Clock* time);
+I2CStatus RTC_read_clock(Clock* time);
 
 // === WRITE FUNCTIONS (Set the value) ===
 
 /**
  * @brief Sets the seconds
  * @param sec: 0-59
+ * @return I2C_OK or what went wrong on the bus
  */
-void RTC_write_second(uint8_t sec);
+I2CStatus RTC_write_second(uint8_t sec);
 
 /**
  * @brief Sets the minutes
  * @param min: 0-59
+ * @return I2C_OK or what went wrong on the bus
  */
-void RTC_write_minute(uint8_t min);
+I2CStatus RTC_write_minute(uint8_t min);
 
 /**
  * @brief Sets the hours
  * @param hour: 0-23 (24h format)
+ * @return I2C_OK or what went wrong on the bus
  */
-void RTC_write_hour(uint8_t hour);
+I2CStatus RTC_write_hour(uint8_t hour);
 
 /**
  * @brief Sets the day of week
  * @param day: 1-7
+ * @return I2C_OK or what went wrong on the bus
  */
-void RTC_write_day(uint8_t day);
+I2CStatus RTC_write_day(uint8_t day);
 
 /**
  * @brief Sets the date
  * @param date: 1-31
+ * @return I2C_OK or what went wrong on the bus
  */
-void RTC_write_date(uint8_t date);
+I2CStatus RTC_write_date(uint8_t date);
 
 /**
  * @brief Sets the month
  * @param month: 1-12
+ * @return I2C_OK or what went wrong on the bus
  */
-void RTC_write_month(uint8_t month);
+I2CStatus RTC_write_month(uint8_t month);
 
 /**
  * @brief Sets the year
  * @param year: 0-99
+ * @return I2C_OK or what went wrong on the bus
  */
-void RTC_write_year(uint8_t year);
+I2CStatus RTC_write_year(uint8_t year);
 
 /**
  * @brief Sets the entire clock at once
+ * @details Stops at the first failure.
  * @param time: Pointer to struct containing values
+ * @return I2C_OK or the first failure
+ */
+I2CStatus RTC_write_clock(Clock* time);
+
+// === ALARM FUNCTIONS ===
+
+/**
+ * @brief Sets alarm 1 to go off every day at the given time
+ * @details Pulls INT/SQW low at the match (EXTI0 falling edge), which also
+ * wakes the MCU from Stop mode. The pin stays low until RTC_alarm_fired()
+ * clears the alarm flag. PA0 is set up by BOARD_INIT().
+ * @param hour: 0-23
+ * @param min: 0-59
+ * @param sec: 0-59
+ * @return I2C_OK, or the first failure (the control register is then left alone)
+ */
+I2CStatus RTC_set_alarm(uint8_t hour, uint8_t min, uint8_t sec);
+
+/**
+ * @brief Turns alarm 1 off (INT/SQW released)
+ * @return I2C_OK or the first failure
+ */
+I2CStatus RTC_disable_alarm(void);
+
+/**
+ * @brief Checks whether the alarm went off since the last call
+ * @details Thread context only: clears the DS3231 alarm flag over I2C. An
+ * alarm is only reported once that worked; until then it stays pending and
+ * every call retries the clear.
+ * @return 1 if the alarm went off (flag cleared), 0 otherwise
  */
-void RTC_write_clock(Clock* time);
+uint8_t RTC_alarm_fired(void);
 
 // === HELPER FUNCTIONS ===
 
 /**
  * @brief Prints the current time to UART in format "HH:MM:SS DD/MM/YY"
+ * @details Prints "RTC: " and I2C_status_name() instead if the read fails.
  */
 void RTC_print_clock(void);
 
@@ -23,60 +23,67 @@ HCLK / APB2_PSC = PCLK2 (APB2ENR Clock) (90 MHz maximum)
 PCLK2 * 2 = APB2_Timer_Clocks (180 MHz maximum)
 ********************************************************************************/
 
-// === GLOBAL CLOCK VARIABLE ===
-// Referenced by main.c, buzzer.c, usart.c, etc.
+#include "clocktree.h"
+
+// === BOOT CLOCK ===
+// SYSCLK set by SysClockConfig, one of CLOCK_PROFILE_LIST. Drivers ask
+// CLOCK_get_*() instead, since CLOCK_set_profile() can change the clocks.
 #define CLOCK_FREQUENCY 45000000U
 
 /*******************************************************************************/
 /* USER PREPROCESSOR DEFS */
 /*******************************************************************************/
-/*
-1: 0b0xxx   0
-2: 0b1000   8
-4: 0b1001   9
-8: 0b1010   10
-16: 0b1011  11
-64: 0b1100  12
-128: 0b1101 13
-256: 0b1110 14
-512: 0b1111 15
-*/
+/// @brief Profile SYSCLKs in ClockProfile order. Everything else (PLL_M/N/P,
+/// @brief bus prescalers, flash latency, regulator scale) is derived by
+/// @brief clocktree.h and checked at build time.
+#define CLOCK_PROFILE_LIST(X) \
+    X(45000000U)               \
+    X(90000000U)               \
+    X(180000000U)
+
+/// @brief Every SYSCLK a driver can run at: reset (HSI), HSE while the PLL
+/// @brief relocks, and the profiles. Drivers assert their dividers over it.
+#define CLOCK_SYSCLK_LIST(X) \
+    X(HSI_FREQUENCY)         \
+    X(HSE_FREQUENCY)         \
+    CLOCK_PROFILE_LIST(X)
+
 /// @brief AHB prescaler value (Divide by 1 = 0)
 #define AHB_PSC 0
 
-/*
-1: 0b0xx  0
-2: 0b100  4
-4: 0b101  5
-8: 0b110  6
-16: 0b111 7
-*/
-/// @brief APB1 prescaler value (Divide by 1 = 0)
-// 45 MHz is safe for APB1, so we don't need to divide
-#define APB1_PSC 0
-
-/// @brief APB2 prescaler value (Divide by 1 = 0)
-#define APB2_PSC 0
+/*******************************************************************************/
+/*******************************************************************************/
 
+/*******************************************************************************/
+/* RUNTIME CLOCK PROFILES */
+/*******************************************************************************/
 /*
-2: 0b00 0
-4: 0b01 1
-6: 0b10 2
-8: 0b11 3
+What the solver derives for CLOCK_PROFILE_LIST: all three share the 360 MHz
+VCO (HSE / 4 * 180), only PLL_P and the bus prescalers change.
+
+Profile   SYSCLK  APB1       APB2       Timers APB1/APB2  Flash  Regulator
+45 MHz    45      45 (/1)    45 (/1)    45 / 45           1 WS   Scale 3
+90 MHz    90      45 (/2)    90 (/1)    90 / 90           2 WS   Scale 3
+180 MHz   180     45 (/4)    90 (/2)    90 / 180          5 WS   Scale 1 + over-drive
 */
-/// @brief PLL_P division value
-// We use 3 (Binary 11) to divide by 8. 
-// Calculation: 360MHz / 8 = 45MHz
-#define PLL_P 3
+typedef enum {
+    CLOCK_PROFILE_45MHZ,    // Boot default, lowest power
+    CLOCK_PROFILE_90MHZ,
+    CLOCK_PROFILE_180MHZ,   // Full speed (over-drive)
+    CLOCK_NUM_PROFILES
+} ClockProfile;
+
+/// @brief What a clock callback is told
+typedef enum {
+    CLOCK_PRE_CHANGE,       // Clocks are about to change: finish transfers in flight
+    CLOCK_POST_CHANGE       // New clocks are running: recompute PSC/BRR/CCR
+} ClockEvent;
 
-/* direct conversion for these two values */
-/// @brief PLL_M division value
-// 8MHz / 4 = 2MHz Input
-#define PLL_M 4
+/// @brief Driver hook, called in thread context around every clock change
+typedef void (*ClockCallback)(ClockEvent event);
 
-/// @brief PLL_N multiplier value
-// 2MHz * 180 = 360MHz VCO Output
-#define PLL_N 180
+/// @brief Maximum number of registered drivers
+#define CLOCK_MAX_CALLBACKS 12U
 
 /*******************************************************************************/
 /*******************************************************************************/
@@ -88,6 +95,47 @@ PCLK2 * 2 = APB2_Timer_Clocks (180 MHz maximum)
 /// @brief Without calling this, the default is 16MHz using
 /// @brief the internal RC oscillator.
 void SysClockConfig(void);
+
+/// @brief Turns the HSE crystal on and returns without waiting for it.
+/// @brief CLOCK_set_profile() waits for whatever start-up time is left,
+/// @brief so calling this early lets other init overlap the ~1 ms start-up.
+void CLOCK_start_hse(void);
+
+/// @brief Switches SYSCLK and the bus prescalers to a profile.
+/// @brief Runs from HSE while the PLL relocks; registered drivers get a
+/// @brief PRE/POST pair around both switches. Thread context only.
+/// @param profile: Profile to switch to
+void CLOCK_set_profile(ClockProfile profile);
+
+/// @brief Brings the cached frequencies back in line after Stop mode, which
+/// @brief restarts SYSCLK on HSI (HSE, PLL and over-drive off, bus prescalers
+/// @brief kept). Registered drivers get a POST_CHANGE for HSI; call
+/// @brief CLOCK_set_profile() afterwards to get the profile back.
+void CLOCK_resume_from_stop(void);
+
+/// @brief Profile in use (CLOCK_NUM_PROFILES before SysClockConfig)
+ClockProfile CLOCK_get_profile(void);
+
+/// @brief Registers a driver for clock change notifications.
+/// @brief Registering the same callback again has no effect.
+/// @return 1 if registered, 0 if the table is full
+uint8_t CLOCK_register(ClockCallback callback);
+
+/// @brief Current clock frequencies in Hz
+uint32_t CLOCK_get_sysclk(void);
+uint32_t CLOCK_get_hclk(void);
+uint32_t CLOCK_get_pclk1(void);
+uint32_t CLOCK_get_pclk2(void);
+
+/// @brief Timer kernel clocks: PCLK x2 when the APB prescaler is not 1
+uint32_t CLOCK_get_apb1_timer_clock(void);     // TIM2-7, TIM12-14
+uint32_t CLOCK_get_apb2_timer_clock(void);     // TIM1, TIM8-11
+
+/// @brief Loads a new prescaler into a running timer without losing its count.
+/// @brief UG is raised with URS set, so no update interrupt or DMA request.
+/// @param tim: Timer to retune
+/// @param psc: New PSC value
+void CLOCK_timer_set_prescaler(TIM_TypeDef* tim, uint32_t psc);
 /*******************************************************************************/
 /*******************************************************************************/
 
@@ -1,9 +1,10 @@
 /*
 * filename: TIM6.h
-* purpose: Basic 1ms timer driver using TIM6
+* purpose: Legacy millisecond count and delay (formerly a 1 ms TIM6 interrupt)
 * author: Connor Ockerse
 * date: 11/27/2025
-* note: TIM6 is an APB1 Basic Timer.
+* note: TIM6 itself stays off; these functions run on the TIM5 timebase
+* (timebase.h) with the semantics of the old 1 ms tick.
 */
 
 #ifndef TIM6_H
@@ -13,26 +14,30 @@
 #include <stdint.h>
 
 /**
- * @brief Initializes TIM6 to generate an interrupt every 1ms
- * @details Calculates Prescaler based on CLOCK_FREQUENCY from RccConfig
+ * @brief Starts the timebase the millisecond count is read from
+ * @details Calls TIMEBASE_INIT(); no periodic interrupt is enabled
  */
 void TIM6_INIT(void);
 
 /**
- * @brief Blocking delay using the TIM6 counter
+ * @brief Blocking delay on the timebase
+ * @details Sleeps (WFI) until the deadline. Prefer a software timer (swtimer.h).
  * @param ms: Milliseconds to wait
  */
 void TIM6_delay(uint32_t ms);
 
 /**
- * @brief get current ms count of TIM6
- * @return millisecond count that is incremented by interrupt
+ * @brief get current ms count
+ * @return milliseconds since TIM6_INIT() or the last TIM6_reset_count()
  */
 uint32_t TIM6_get_count(void);
 
 
 /**
  * @brief reset millisecond count to prevent overflow issues
+ * @note LEGACY ONLY: zeroing the count breaks every elapsed-time calculation
+ * made by other code. New code should use TIMEBASE_now_ms()/TIMEBASE_now_us()
+ * from timebase.h, which are monotonic and never reset.
  */
 void TIM6_reset_count(void);
 #endif
\ No newline at end of file
@@ -0,0 +1,211 @@
+/*
+* filename: board.h
+* purpose: Pin and peripheral clock table for the whole board
+* author: Connor Ockerse
+* date: 10/19/2026
+* note: Every pin the drivers use is listed once here, per port. The
+* register values are computed by the preprocessor, so BOARD_INIT() does
+* one write per GPIO register and one per RCC enable register instead of
+* a read-modify-write in every driver. Pins not in the table keep their
+* reset configuration (SWD on PA13/PA14 included).
+*
+* The build fails when a pin is listed twice, a debug pin is taken, an
+* AF number is given to a pin that isn't in AF mode, or a peripheral
+* clock is listed twice.
+*
+* BOARD_I2C2 = 1 gives the 24C02C a bus of its own (I2C2 on PB10 / PC12) so
+* it no longer waits for, or blocks, the DS3231 on I2C1. PB10 was the encoder
+* button, which then moves to PC13 (the Nucleo's user button).
+*
+* Call BOARD_INIT() first thing in main(), before any *_INIT().
+*/
+
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <stm32f446xx.h>
+#include <stdint.h>
+
+#include "staticassert.h"
+#include "I2C.h"        // I2CBus of each device
+
+// === OPTIONS ===
+// 1 = 24C02C on I2C2 (PB10 SCL, PC12 SDA), encoder button on PC13
+#ifndef BOARD_I2C2
+#define BOARD_I2C2 0
+#endif
+
+// === I2C DEVICES ===
+#define BOARD_RTC_BUS       I2C_BUS1        // DS3231
+#if BOARD_I2C2
+#define BOARD_EEPROM_BUS    I2C_BUS2        // 24C02C
+#else
+#define BOARD_EEPROM_BUS    I2C_BUS1
+#endif
+#define BOARD_I2C_BUSES     ((1U << BOARD_RTC_BUS) | (1U << BOARD_EEPROM_BUS))
+
+// === ENCODER BUTTON ===
+// Active low, EXTI line = pin (EXTI15_10 either way)
+#if BOARD_I2C2
+#define BOARD_BUTTON_PORT       GPIOC
+#define BOARD_BUTTON_PIN        13U
+#define BOARD_BUTTON_EXTI_PORT  2U          // SYSCFG_EXTICR code of port C
+#else
+#define BOARD_BUTTON_PORT       GPIOB
+#define BOARD_BUTTON_PIN        10U
+#define BOARD_BUTTON_EXTI_PORT  1U          // Port B
+#endif
+
+// === PIN SETTINGS ===
+// MODER
+#define BOARD_INPUT         0U
+#define BOARD_OUTPUT        1U
+#define BOARD_AF            2U
+#define BOARD_ANALOG        3U
+// OTYPER
+#define BOARD_PUSH_PULL     0U
+#define BOARD_OPEN_DRAIN    1U
+// OSPEEDR
+#define BOARD_LOW_SPEED     0U
+#define BOARD_MEDIUM_SPEED  1U
+#define BOARD_FAST_SPEED    2U
+#define BOARD_HIGH_SPEED    3U
+// PUPDR
+#define BOARD_NO_PULL       0U
+#define BOARD_PULL_UP       1U
+#define BOARD_PULL_DOWN     2U
+
+// === PIN TABLE ===
+// X(pin, mode, output type, speed, pull, alternate function)
+#define BOARD_GPIOA_PINS(X)                                                                  \
+    X(0,  BOARD_INPUT,  BOARD_PUSH_PULL,  BOARD_LOW_SPEED,    BOARD_PULL_UP, 0U) /* DS3231 INT/SQW (EXTI0) */   \
+    X(1,  BOARD_ANALOG, BOARD_PUSH_PULL,  BOARD_LOW_SPEED,    BOARD_NO_PULL, 0U) /* Photoresistor (ADC1_IN1) */ \
+    X(2,  BOARD_AF,     BOARD_PUSH_PULL,  BOARD_LOW_SPEED,    BOARD_NO_PULL, 7U) /* USART2_TX */                \
+    X(8,  BOARD_AF,     BOARD_PUSH_PULL,  BOARD_LOW_SPEED,    BOARD_NO_PULL, 1U) /* Buzzer (TIM1_CH1) */
+
+#define BOARD_GPIOB_PINS(X)                                                                  \
+    X(0,  BOARD_OUTPUT, BOARD_PUSH_PULL,  BOARD_MEDIUM_SPEED, BOARD_NO_PULL, 0U) /* Stepper coil 1 */           \
+    X(1,  BOARD_OUTPUT, BOARD_PUSH_PULL,  BOARD_MEDIUM_SPEED, BOARD_NO_PULL, 0U) /* Stepper coil 2 */           \
+    X(2,  BOARD_OUTPUT, BOARD_PUSH_PULL,  BOARD_MEDIUM_SPEED, BOARD_NO_PULL, 0U) /* Stepper coil 3 */           \
+    X(3,  BOARD_OUTPUT, BOARD_PUSH_PULL,  BOARD_MEDIUM_SPEED, BOARD_NO_PULL, 0U) /* Stepper coil 4 */           \
+    X(4,  BOARD_AF,     BOARD_PUSH_PULL,  BOARD_LOW_SPEED,    BOARD_NO_PULL, 2U) /* Sonar trigger (TIM3_CH1) */ \
+    X(5,  BOARD_AF,     BOARD_PUSH_PULL,  BOARD_LOW_SPEED,    BOARD_NO_PULL, 2U) /* Sonar echo (TIM3_CH2) */    \
+    X(6,  BOARD_AF,     BOARD_PUSH_PULL,  BOARD_LOW_SPEED,    BOARD_NO_PULL, 2U) /* Encoder A (TIM4_CH1) */     \
+    X(7,  BOARD_AF,     BOARD_PUSH_PULL,  BOARD_LOW_SPEED,    BOARD_NO_PULL, 2U) /* Encoder B (TIM4_CH2) */     \
+    X(8,  BOARD_AF,     BOARD_OPEN_DRAIN, BOARD_HIGH_SPEED,   BOARD_NO_PULL, 4U) /* I2C1_SCL */                 \
+    X(9,  BOARD_AF,     BOARD_OPEN_DRAIN, BOARD_HIGH_SPEED,   BOARD_NO_PULL, 4U) /* I2C1_SDA */                 \
+    BOARD_PB10(X)
+
+#if BOARD_I2C2
+#define BOARD_PB10(X) \
+    X(10, BOARD_AF,     BOARD_OPEN_DRAIN, BOARD_HIGH_SPEED,   BOARD_NO_PULL, 4U) /* I2C2_SCL */
+#define BOARD_GPIOC_PINS(X)                                                                  \
+    X(12, BOARD_AF,     BOARD_OPEN_DRAIN, BOARD_HIGH_SPEED,   BOARD_NO_PULL, 4U) /* I2C2_SDA */                 \
+    X(13, BOARD_INPUT,  BOARD_PUSH_PULL,  BOARD_LOW_SPEED,    BOARD_PULL_UP, 0U) /* Encoder button (EXTI13) */
+#else
+#define BOARD_PB10(X) \
+    X(10, BOARD_INPUT,  BOARD_PUSH_PULL,  BOARD_LOW_SPEED,    BOARD_PULL_UP, 0U) /* Encoder button (EXTI10) */
+#define BOARD_GPIOC_PINS(X)
+#endif
+
+// === PERIPHERAL CLOCK TABLE ===
+// X(enable bit)
+#define BOARD_TIMEBASE_CLOCK(X) X(3)    /* TIM5: tickless timebase */
+
+#if BOARD_I2C2
+#define BOARD_I2C2_CLOCKS(X) X(22)  /* I2C2: 24C02C */
+#define BOARD_GPIOC_CLOCK(X) X(2)   /* GPIOC */
+#else
+#define BOARD_I2C2_CLOCKS(X)
+#define BOARD_GPIOC_CLOCK(X)
+#endif
+
+#define BOARD_AHB1_CLOCKS(X)                        \
+    X(0)    /* GPIOA */                             \
+    X(1)    /* GPIOB */                             \
+    BOARD_GPIOC_CLOCK(X)                            \
+    X(12)   /* CRC */                               \
+    X(18)   /* BKPSRAM: supervisor, brown-out */    \
+    X(21)   /* DMA1: dma.h streams */               \
+    X(22)   /* DMA2: dma.h streams (buzzer, CRC) */
+
+#define BOARD_APB1_CLOCKS(X)                        \
+    X(0)    /* TIM2: stopwatch */                   \
+    X(1)    /* TIM3: sonar */                       \
+    X(2)    /* TIM4: encoder */                     \
+    BOARD_TIMEBASE_CLOCK(X)                         \
+    X(11)   /* WWDG: loop supervisor */             \
+    X(17)   /* USART2 */                            \
+    X(21)   /* I2C1 */                              \
+    BOARD_I2C2_CLOCKS(X)                            \
+    X(28)   /* PWR: clock profiles, Stop mode, RTC access */
+
+#define BOARD_APB2_CLOCKS(X)                        \
+    X(0)    /* TIM1: buzzer */                      \
+    X(8)    /* ADC1: photoresistor */               \
+    X(14)   /* SYSCFG: EXTI routing */
+
+// === GENERATED REGISTER VALUES ===
+// Terms OR'ed (or summed) over a table
+#define BOARD_PIN_BIT(pin, mode, otype, speed, pull, af)     | (1U << (pin))
+#define BOARD_PIN_SUM(pin, mode, otype, speed, pull, af)     + (1U << (pin))
+#define BOARD_PIN_MASK2(pin, mode, otype, speed, pull, af)   | (3U << (2U * (pin)))
+#define BOARD_PIN_MODE(pin, mode, otype, speed, pull, af)    | ((mode) << (2U * (pin)))
+#define BOARD_PIN_OTYPE(pin, mode, otype, speed, pull, af)   | ((otype) << (pin))
+#define BOARD_PIN_SPEED(pin, mode, otype, speed, pull, af)   | ((speed) << (2U * (pin)))
+#define BOARD_PIN_PULL(pin, mode, otype, speed, pull, af)    | ((pull) << (2U * (pin)))
+#define BOARD_PIN_AFL_MASK(pin, mode, otype, speed, pull, af) | (((pin) < 8U) ? (0xFU << (4U * ((pin) & 7U))) : 0U)
+#define BOARD_PIN_AFH_MASK(pin, mode, otype, speed, pull, af) | (((pin) >= 8U) ? (0xFU << (4U * ((pin) & 7U))) : 0U)
+#define BOARD_PIN_AFL(pin, mode, otype, speed, pull, af)     | (((pin) < 8U) ? ((af) << (4U * ((pin) & 7U))) : 0U)
+#define BOARD_PIN_AFH(pin, mode, otype, speed, pull, af)     | (((pin) >= 8U) ? ((af) << (4U * ((pin) & 7U))) : 0U)
+#define BOARD_PIN_BAD(pin, mode, otype, speed, pull, af) \
+    | (((pin) > 15U) || ((mode) > 3U) || ((otype) > 1U) || ((speed) > 3U) || ((pull) > 2U) || \
+       ((af) > 15U) || (((mode) != BOARD_AF) && ((af) != 0U)))
+#define BOARD_CLOCK_BIT(bit) | (1UL << (bit))
+#define BOARD_CLOCK_SUM(bit) + (1ULL << (bit))
+
+/// Register value: reset configuration outside the table's pins, table inside
+#define BOARD_GPIO_REG(PINS, reset, MASK, VALUE) \
+    ((uint32_t)(((reset) & ~(0U PINS(MASK))) | (0U PINS(VALUE))))
+
+#define BOARD_GPIO_MODER(PINS, reset)   BOARD_GPIO_REG(PINS, reset, BOARD_PIN_MASK2, BOARD_PIN_MODE)
+#define BOARD_GPIO_OTYPER(PINS, reset)  BOARD_GPIO_REG(PINS, reset, BOARD_PIN_BIT, BOARD_PIN_OTYPE)
+#define BOARD_GPIO_OSPEEDR(PINS, reset) BOARD_GPIO_REG(PINS, reset, BOARD_PIN_MASK2, BOARD_PIN_SPEED)
+#define BOARD_GPIO_PUPDR(PINS, reset)   BOARD_GPIO_REG(PINS, reset, BOARD_PIN_MASK2, BOARD_PIN_PULL)
+#define BOARD_GPIO_AFRL(PINS, reset)    BOARD_GPIO_REG(PINS, reset, BOARD_PIN_AFL_MASK, BOARD_PIN_AFL)
+#define BOARD_GPIO_AFRH(PINS, reset)    BOARD_GPIO_REG(PINS, reset, BOARD_PIN_AFH_MASK, BOARD_PIN_AFH)
+
+/// Checks one port: every pin once, every field in range
+#define BOARD_ASSERT_PORT(PINS)                                                         \
+    STATIC_ASSERT((0U PINS(BOARD_PIN_SUM)) == (0U PINS(BOARD_PIN_BIT)),                 \
+                  "pin listed twice in the board table");                               \
+    STATIC_ASSERT((0U PINS(BOARD_PIN_BAD)) == 0U,                                       \
+                  "invalid pin setting in the board table")
+
+/// Checks one RCC enable register: every peripheral once
+#define BOARD_ASSERT_CLOCKS(CLOCKS)                                                     \
+    STATIC_ASSERT((0ULL CLOCKS(BOARD_CLOCK_SUM)) == (0ULL CLOCKS(BOARD_CLOCK_BIT)),       \
+                  "peripheral clock listed twice in the board table")
+
+// Reset values (RM0390 8.4)
+#define BOARD_GPIOA_MODER_RESET     0xA8000000U     // PA13-15 debug AF
+#define BOARD_GPIOA_OSPEEDR_RESET   0x0C000000U
+#define BOARD_GPIOA_PUPDR_RESET     0x64000000U
+#define BOARD_GPIOB_MODER_RESET     0x00000280U     // PB3/PB4 debug AF
+#define BOARD_GPIOB_OSPEEDR_RESET   0x000000C0U
+#define BOARD_GPIOB_PUPDR_RESET     0x00000100U
+#define BOARD_GPIOC_MODER_RESET     0x00000000U
+#define BOARD_GPIOC_OSPEEDR_RESET   0x00000000U
+#define BOARD_GPIOC_PUPDR_RESET     0x00000000U
+
+// SWDIO (PA13) and SWCLK (PA14) stay with the debugger
+#define BOARD_SWD_PINS ((1U << 13) | (1U << 14))
+
+/**
+ * @brief Enables every peripheral clock and configures every pin in the table
+ * @details One write per RCC enable register and per GPIO register; the
+ * enable registers are OR'ed so clocks turned on earlier stay on.
+ */
+void BOARD_INIT(void);
+
+#endif
@@ -0,0 +1,106 @@
+/*
+* filename: boot.h
+* purpose: Timed, overlapped bring-up of clocks, watchdog and I2C devices
+* author: Connor Ockerse
+* date: 10/19/2026
+* note: BOOT_INIT() starts every slow thing first and only waits for it when
+* the result is needed:
+*
+*   1. Timebase at HSI 16 MHz (used for the phase timestamps)
+*   2. HSE crystal and LSI/IWDG started, nothing waited for
+*   3. I2C up at HSI: DS3231 time and the first EEPROM bytes read while
+*      the crystal starts (~1 ms) and the IWDG registers sync (~5 LSI cycles)
+*   4. Join: PLL locked, SYSCLK at CLOCK_FREQUENCY (HSE long ready by now)
+*   5. Join: IWDG settings applied, first kick
+*   6. USART2
+*
+* With BOOT_OVERLAP = 0 the same work runs one piece after another, each
+* waiting where it starts (clocks, watchdog, then I2C), for comparison.
+* Times are microseconds on the timebase, which starts right after
+* BOARD_INIT(). The application marks BOOT_PHASE_READY at its first valid
+* sensor reading and can print the breakdown with BOOT_report(). A device
+* that didn't answer during the preload is reported there, and its
+* BOOT_get_*() returns NULL.
+*/
+
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <stm32f446xx.h>
+#include <stdint.h>
+#include "RTC.h"
+
+// === CONFIGURATION ===
+// 1 = overlapped bring-up, 0 = serial (old order) for comparison
+#ifndef BOOT_OVERLAP
+#define BOOT_OVERLAP 1
+#endif
+
+// EEPROM bytes read at boot (from address 0)
+#define BOOT_EEPROM_PRELOAD_BYTES 8U
+
+// Boot phases, in overlapped order
+typedef enum {
+    BOOT_PHASE_TIMEBASE,    // TIM5 timebase running
+    BOOT_PHASE_KICKOFF,     // HSE and LSI/IWDG started (overlapped only)
+    BOOT_PHASE_PRELOAD,     // I2C up, DS3231 time and EEPROM bytes read
+    BOOT_PHASE_CLOCKS,      // PLL locked, SYSCLK at CLOCK_FREQUENCY
+    BOOT_PHASE_WATCHDOG,    // IWDG configured and kicked
+    BOOT_PHASE_USART,       // USART2 ready
+    BOOT_PHASE_READY,       // First valid sensor reading (marked by the application)
+    BOOT_NUM_PHASES
+}BootPhase;
+
+/**
+ * @brief Brings up the timebase, clocks, watchdog, I2C devices and USART2
+ * @details Call right after BOARD_INIT(). Replaces SysClockConfig(),
+ * TIM6_INIT(), WDT_INIT(), I2C_INIT() and USART_INIT(). The watchdog runs
+ * from here on, so the application must kick it.
+ */
+void BOOT_INIT(void);
+
+/**
+ * @brief Records that a phase finished now
+ * @param phase: Phase that just finished
+ */
+void BOOT_mark(BootPhase phase);
+
+/**
+ * @brief When a phase finished
+ * @param phase: Phase to look up
+ * @return Microseconds since the timebase started, 0 if not reached
+ */
+uint32_t BOOT_get_us(BootPhase phase);
+
+/**
+ * @brief DS3231 time read during boot
+ * @return The time, NULL if the read failed (see BOOT_get_clock_status())
+ */
+const Clock* BOOT_get_clock(void);
+
+/**
+ * @brief First BOOT_EEPROM_PRELOAD_BYTES of the EEPROM, read during boot
+ * @return The bytes, NULL if any read failed (see BOOT_get_eeprom_status())
+ */
+const uint8_t* BOOT_get_eeprom(void);
+
+/**
+ * @brief How the DS3231 read during boot went
+ * @return I2C_OK, the failure, or I2C_ERR_BUS before BOOT_INIT()
+ */
+I2CStatus BOOT_get_clock_status(void);
+
+/**
+ * @brief How the EEPROM reads during boot went (the first failure)
+ * @return I2C_OK, the failure, or I2C_ERR_BUS before BOOT_INIT()
+ */
+I2CStatus BOOT_get_eeprom_status(void);
+
+/**
+ * @brief Prints each phase (in the order they finished) over USART2
+ * @details Blocking. Shows when each phase finished and how long it took
+ * after the one before it.
+ */
+void BOOT_report(void);
+
+#endif
@@ -0,0 +1,122 @@
+/*
+* filename: brownout.h
+* purpose: Power-fail snapshot of the motion state, saved from the PVD interrupt
+* author: Connor Ockerse
+* date: 10/19/2026
+* note: Stepper position, encoder count and stopwatch time live in RAM and
+* timer registers and are gone when the supply drops out. The PVD raises an
+* interrupt when VDD falls below BROWNOUT_PVD_LEVEL; from then on the board
+* runs on its bulk capacitance for BROWNOUT_HOLDUP_US. The handler turns
+* the stepper coils off first (the biggest load, and the motor then stays at
+* the position saved), packs the state into one 16-byte BrownoutSnapshot
+* (CRC-32 included) and writes it:
+*
+*   1. to backup SRAM, after the supervisor snapshot: four word stores,
+*      about a microsecond. Kept as long as VBAT is there.
+*   2. to one EEPROM page (BROWNOUT_EEPROM_PAGE) with a single page write:
+*      one I2C transaction (~1.7 ms at 100 kHz) and one write cycle (5 ms
+*      max) instead of the 16 cycles (32 ms) byte-wise EEPROM_write() takes.
+*      Skipped if the EEPROM's bus or the chip is still busy: the handler
+*      can't wait out a transaction of the code it interrupted. With the
+*      EEPROM on its own bus (BOARD_I2C2) a DS3231 read no longer costs
+*      the copy.
+*
+* BROWNOUT_INIT() at the next boot restores the backup SRAM copy, or the
+* EEPROM one without it, and invalidates both so an ordinary reset later
+* doesn't bring back old state. If VDD comes back up without dropping out,
+* the copies are invalidated too (the EEPROM page from the event loop).
+*
+* Worst-case save latency (PVD edge to snapshot stored) is the interrupt
+* entry plus whatever holds the PVD interrupt off: interrupts masked, another
+* priority 0 ISR running (they all are), or a flash program (CONFIG_set(),
+* up to CONFIG_PROGRAM_MAX_US). A flash erase (CONFIG_maintain()) stalls it
+* for up to seconds, so only allow one while the supply is good. The handler
+* measures its own part with the DWT cycle counter (BROWNOUT_get_stats()),
+* and the numbers of the last save survive in backup SRAM.
+*
+* Call BROWNOUT_INIT() after STEPPER_INIT(), ENCODER_INIT(), STOPWATCH_INIT()
+* and I2C_INIT(); the backup SRAM clock comes from BOARD_INIT().
+*/
+
+#ifndef BROWNOUT_H
+#define BROWNOUT_H
+
+#include <stm32f446xx.h>
+#include <stdint.h>
+
+// === CONFIGURATION ===
+// PVD level: 0-7 = 2.0, 2.1, 2.3, 2.5, 2.6, 2.7, 2.8, 2.9 V (7 is the earliest warning)
+#ifndef BROWNOUT_PVD_LEVEL
+#define BROWNOUT_PVD_LEVEL 7U
+#endif
+
+// Time from the PVD level down to the power-down reset (1.7 V) at full
+// load; 470 uF at 50 mA gives ~10 ms
+#ifndef BROWNOUT_HOLDUP_US
+#define BROWNOUT_HOLDUP_US 10000U
+#endif
+
+// 1 = also save to an EEPROM page (boards without a VBAT cell need it)
+#ifndef BROWNOUT_EEPROM
+#define BROWNOUT_EEPROM 1
+#endif
+#define BROWNOUT_EEPROM_PAGE 3U         // 0x30-0x3F
+
+// 24C02C write cycle, datasheet maximum
+#define BROWNOUT_EEPROM_CYCLE_US 5000U
+
+// Where the copy sits in backup SRAM (the supervisor snapshot is before it)
+#define BROWNOUT_BACKUP_OFFSET 0x80U
+
+#if BROWNOUT_PVD_LEVEL > 7
+#error "BROWNOUT_PVD_LEVEL is 0-7"
+#endif
+
+// The saved state (one EEPROM page)
+typedef struct {
+    int32_t stepper_position;
+    uint32_t stopwatch_ms;
+    uint16_t encoder;
+    uint8_t stopwatch_running;
+    uint8_t sequence;           // +1 per save
+    uint32_t crc;               // CRC-32 of the bytes before it
+}BrownoutSnapshot;
+
+// Where BROWNOUT_INIT() found the state it restored
+typedef enum {
+    BROWNOUT_RESTORED_NONE,
+    BROWNOUT_RESTORED_BACKUP,
+    BROWNOUT_RESTORED_EEPROM
+}BrownoutRestore;
+
+typedef struct {
+    uint32_t saves;             // PVD trips handled since BROWNOUT_INIT()
+    uint32_t recoveries;        // VDD back above the level without a reset
+    uint32_t eeprom_writes;
+    uint32_t eeprom_skipped;    // Its bus or the chip was busy at the trip
+    uint32_t eeprom_failed;     // The page transfer failed on the bus (not in eeprom_writes)
+    uint32_t worst_backup_ns;   // Handler entry to the backup SRAM copy
+    uint32_t worst_eeprom_us;   // Handler entry to the EEPROM page sent (write cycle not included)
+    uint32_t over_holdup;       // Saves whose EEPROM copy can't finish within BROWNOUT_HOLDUP_US
+    BrownoutRestore restored;   // At this boot
+    uint32_t last_backup_ns;    // The previous boot's last save (from backup SRAM, 0 = none)
+    uint32_t last_eeprom_us;
+}BrownoutStats;
+
+/**
+ * @brief Restores the last snapshot and arms the PVD interrupt
+ * @return Where the restored state came from
+ */
+BrownoutRestore BROWNOUT_INIT(void);
+
+/**
+ * @brief Copies the counters and latencies
+ */
+void BROWNOUT_get_stats(BrownoutStats* stats);
+
+/**
+ * @brief Save latencies against the hold-up time over USART2
+ */
+void BROWNOUT_report(void);
+
+#endif
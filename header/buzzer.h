@@ -12,6 +12,18 @@
 #include <stm32f446xx.h>
 #include <stdint.h>
 
+/* PCM playback configuration */
+// Carrier resolution: ARR = 255 so an 8-bit sample maps straight onto CCR1
+// 45 MHz / 256 = ~175 kHz carrier, well above hearing range
+// (the carrier follows the APB2 timer clock, see CLOCK_set_profile)
+#define PCM_CARRIER_STEPS 256U
+
+// Samples per DMA buffer half (each DMA memory pointer covers one chunk)
+#define PCM_CHUNK_SAMPLES 256U
+
+// Value used to pad the last partial chunk (midscale = no movement)
+#define PCM_SILENCE 0x80U
+
 /* Function declarations */
 /**
  * @brief Initializes TIM1_CH1 on PA8 50% duty cycle
@@ -24,4 +36,33 @@ void BUZZER_INIT(void);
  */
 void update_buzzer_freq(uint32_t frequency);
 
+/**
+ * @brief Starts playback of an 8-bit unsigned PCM clip on PA8
+ * @details TIM1 runs as a PWM-DAC at the carrier frequency and the repetition
+ * counter raises one update event per sample. Each update event triggers
+ * the TIM1_UP stream (DMA2 Stream5, Channel 6, taken from dma.h by
+ * BUZZER_INIT) which copies the next sample into CCR1.
+ * The clip is streamed in PCM_CHUNK_SAMPLES chunks using the DMA double-buffer
+ * mode: each chunk is widened to half-words (CCR1 takes no byte writes) into
+ * the buffer that just finished, so the CPU only runs once per chunk, never
+ * per sample.
+ * Overrides any tone set with update_buzzer_freq().
+ * @param samples: Pointer to the clip (may live in flash), see tools/wav2c.py
+ * @param length: Number of samples in the clip
+ * @param sample_rate: Sample rate in Hz (roughly 700 Hz to 44 kHz)
+ * @return 1 if playback started, 0 if the arguments are out of range
+ */
+uint8_t BUZZER_pcm_play(const uint8_t* samples, uint32_t length, uint32_t sample_rate);
+
+/**
+ * @brief Checks if a PCM clip is still playing
+ * @return 1 while playing, 0 when idle
+ */
+uint8_t BUZZER_pcm_is_playing(void);
+
+/**
+ * @brief Stops PCM playback immediately and silences the buzzer
+ */
+void BUZZER_pcm_stop(void);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,154 @@
+/*
+* filename: clocktree.h
+* purpose: Compile-time model of the F446 clock tree (PLL, buses, flash, dividers)
+* author: Connor Ockerse
+* date: 10/19/2026
+* note: Every macro here is a constant expression when its arguments are,
+* so the same formula sets up the hardware at run time and is checked by
+* STATIC_ASSERT at build time. Given a target SYSCLK the solver picks:
+*
+*   PLL       M for a 2 MHz VCO input, the largest P that keeps the VCO
+*             at or below 432 MHz, N = SYSCLK * P / 2 MHz
+*   Buses     smallest APB dividers that respect PCLK1 <= 45 MHz and
+*             PCLK2 <= 90 MHz; timers run at 2x PCLK unless the divider is 1
+*   Flash     1 wait state per 30 MHz of HCLK (2.7-3.6 V)
+*   Regulator lowest scale that allows HCLK, over-drive above 168 MHz
+*
+* Driver dividers (timer PSC, USART BRR, I2C CCR/TRISE, ADC prescaler) come
+* with an error in ppm so each driver can assert the accuracy it needs at
+* every SYSCLK in CLOCK_SYSCLK_LIST (RccConfig.h).
+*/
+
+#ifndef CLOCKTREE_H
+#define CLOCKTREE_H
+
+#include <stdint.h>
+#include "staticassert.h"
+
+// === OSCILLATORS ===
+#define HSI_FREQUENCY 16000000U     // Reset clock
+#define HSE_FREQUENCY 8000000U      // Crystal on the board
+
+// === DATASHEET LIMITS (VDD 2.7-3.6 V) ===
+#define CLOCK_SYSCLK_MAX        180000000U
+#define CLOCK_PCLK1_MAX          45000000U
+#define CLOCK_PCLK2_MAX          90000000U
+#define CLOCK_VCO_INPUT_HZ        2000000U  // 1-2 MHz, 2 MHz for the least jitter
+#define CLOCK_VCO_MIN           100000000U
+#define CLOCK_VCO_MAX           432000000U
+#define CLOCK_FLASH_HZ_PER_WS    30000000U
+#define CLOCK_SCALE3_MAX        120000000U
+#define CLOCK_SCALE2_MAX        144000000U
+#define CLOCK_SCALE1_MAX        168000000U  // 180 MHz with over-drive
+#define CLOCK_ADC_MAX            36000000U
+
+// === PLL ===
+/// PLL_M: HSE down to the VCO input
+#define CLOCK_PLL_M (HSE_FREQUENCY / CLOCK_VCO_INPUT_HZ)
+
+/// PLL_P divider (2, 4, 6 or 8): the largest one the VCO can feed
+#define CLOCK_PLL_P_DIV(sysclk) \
+    (((uint64_t)(sysclk) * 8U <= CLOCK_VCO_MAX) ? 8U : \
+     ((uint64_t)(sysclk) * 6U <= CLOCK_VCO_MAX) ? 6U : \
+     ((uint64_t)(sysclk) * 4U <= CLOCK_VCO_MAX) ? 4U : 2U)
+
+/// PLL_P field in PLLCFGR (0: /2, 1: /4, 2: /6, 3: /8)
+#define CLOCK_PLL_P_FIELD(sysclk) ((CLOCK_PLL_P_DIV(sysclk) / 2U) - 1U)
+
+/// VCO output and the PLL_N that produces it
+#define CLOCK_VCO_HZ(sysclk) ((uint64_t)(sysclk) * CLOCK_PLL_P_DIV(sysclk))
+#define CLOCK_PLL_N(sysclk) ((uint32_t)(CLOCK_VCO_HZ(sysclk) / CLOCK_VCO_INPUT_HZ))
+
+// === BUSES (AHB prescaler is always 1) ===
+/// Smallest power-of-two divider (1..16) that keeps a bus at or under max
+#define CLOCK_APB_DIV(hclk, max) \
+    (((hclk) <= (max)) ? 1U : ((hclk) <= 2U * (max)) ? 2U : \
+     ((hclk) <= 4U * (max)) ? 4U : ((hclk) <= 8U * (max)) ? 8U : 16U)
+
+/// PPRE field for a divider (1: 0b000, 2: 0b100 ... 16: 0b111)
+#define CLOCK_PPRE_FIELD(div) \
+    (((div) == 1U) ? 0U : ((div) == 2U) ? 4U : ((div) == 4U) ? 5U : ((div) == 8U) ? 6U : 7U)
+
+#define CLOCK_APB1_DIV(sysclk) CLOCK_APB_DIV(sysclk, CLOCK_PCLK1_MAX)
+#define CLOCK_APB2_DIV(sysclk) CLOCK_APB_DIV(sysclk, CLOCK_PCLK2_MAX)
+#define CLOCK_PCLK1_HZ(sysclk) ((sysclk) / CLOCK_APB1_DIV(sysclk))
+#define CLOCK_PCLK2_HZ(sysclk) ((sysclk) / CLOCK_APB2_DIV(sysclk))
+
+/// Timer kernel clocks: PCLK x2 when the APB divider is not 1
+#define CLOCK_TIMER_HZ(pclk, div) (((div) == 1U) ? (pclk) : ((pclk) * 2U))
+#define CLOCK_APB1_TIMER_HZ(sysclk) CLOCK_TIMER_HZ(CLOCK_PCLK1_HZ(sysclk), CLOCK_APB1_DIV(sysclk))
+#define CLOCK_APB2_TIMER_HZ(sysclk) CLOCK_TIMER_HZ(CLOCK_PCLK2_HZ(sysclk), CLOCK_APB2_DIV(sysclk))
+
+// === FLASH AND REGULATOR ===
+/// Minimum flash wait states for an HCLK
+#define CLOCK_FLASH_WS(hclk) (((hclk) - 1U) / CLOCK_FLASH_HZ_PER_WS)
+
+/// PWR_CR VOS field (1: Scale 3, 2: Scale 2, 3: Scale 1)
+#define CLOCK_VOS(hclk) \
+    (((hclk) <= CLOCK_SCALE3_MAX) ? 1U : ((hclk) <= CLOCK_SCALE2_MAX) ? 2U : 3U)
+
+/// Over-drive needed (Scale 1 above 168 MHz)
+#define CLOCK_OVERDRIVE(hclk) (((hclk) > CLOCK_SCALE1_MAX) ? 1U : 0U)
+
+/// Checks a target SYSCLK can be built from HSE with the PLL
+#define CLOCK_ASSERT_SYSCLK(sysclk) \
+    STATIC_ASSERT(((sysclk) <= CLOCK_SYSCLK_MAX) && \
+                  ((HSE_FREQUENCY % CLOCK_VCO_INPUT_HZ) == 0U) && \
+                  (CLOCK_PLL_M >= 2U) && (CLOCK_PLL_M <= 63U) && \
+                  ((CLOCK_VCO_HZ(sysclk) % CLOCK_VCO_INPUT_HZ) == 0U) && \
+                  (CLOCK_VCO_HZ(sysclk) >= CLOCK_VCO_MIN) && \
+                  (CLOCK_VCO_HZ(sysclk) <= CLOCK_VCO_MAX) && \
+                  (CLOCK_PLL_N(sysclk) >= 50U) && (CLOCK_PLL_N(sysclk) <= 432U), \
+                  "SYSCLK can't be made exactly from HSE with the PLL")
+
+// === DRIVER DIVIDERS ===
+/// |src / div - target| in ppm of target
+#define CLOCK_DIV_ERROR_PPM(src, div, target) \
+    ((uint32_t)((((uint64_t)(src) > (uint64_t)(div) * (target)) ? \
+                 ((uint64_t)(src) - (uint64_t)(div) * (target)) : \
+                 ((uint64_t)(div) * (target) - (uint64_t)(src))) * 1000000U / \
+                ((uint64_t)(div) * (target))))
+
+/// Timer PSC for a tick rate (rounded)
+#define CLOCK_TIMER_PSC(timer_hz, tick_hz) ((((timer_hz) + ((tick_hz) / 2U)) / (tick_hz)) - 1U)
+#define CLOCK_TIMER_PPM(timer_hz, tick_hz) \
+    CLOCK_DIV_ERROR_PPM(timer_hz, CLOCK_TIMER_PSC(timer_hz, tick_hz) + 1U, tick_hz)
+
+/// Checks a 16-bit PSC reaches a tick rate within max_ppm
+#define CLOCK_ASSERT_TIMER(timer_hz, tick_hz, max_ppm) \
+    STATIC_ASSERT((CLOCK_TIMER_PSC(timer_hz, tick_hz) <= 0xFFFFU) && \
+                  (CLOCK_TIMER_PPM(timer_hz, tick_hz) <= (max_ppm)), \
+                  "timer tick out of range at a supported SYSCLK")
+
+/// USART BRR for a baud rate, 16x oversampling (rounded)
+#define CLOCK_USART_BRR(pclk, baud) (((pclk) + ((baud) / 2U)) / (baud))
+#define CLOCK_USART_PPM(pclk, baud) CLOCK_DIV_ERROR_PPM(pclk, CLOCK_USART_BRR(pclk, baud), baud)
+
+/// Checks the baud rate is reachable within max_ppm
+#define CLOCK_ASSERT_USART(pclk, baud, max_ppm) \
+    STATIC_ASSERT((CLOCK_USART_BRR(pclk, baud) >= 16U) && \
+                  (CLOCK_USART_BRR(pclk, baud) <= 0xFFFFU) && \
+                  (CLOCK_USART_PPM(pclk, baud) <= (max_ppm)), \
+                  "baud rate out of tolerance at a supported SYSCLK")
+
+/// I2C Standard Mode: Thigh = Tlow = CCR / PCLK1, rounded up so SCL never runs fast
+#define CLOCK_I2C_CCR(pclk, scl_hz) (((pclk) + (2U * (scl_hz)) - 1U) / (2U * (scl_hz)))
+#define CLOCK_I2C_FREQ(pclk) ((pclk) / 1000000U)
+#define CLOCK_I2C_TRISE(pclk) (CLOCK_I2C_FREQ(pclk) + 1U)   // 1000 ns max rise time
+#define CLOCK_I2C_PPM(pclk, scl_hz) CLOCK_DIV_ERROR_PPM(pclk, 2U * CLOCK_I2C_CCR(pclk, scl_hz), scl_hz)
+
+/// Checks PCLK1 can run Standard Mode at an SCL no faster than asked
+#define CLOCK_ASSERT_I2C(pclk, scl_hz, max_ppm) \
+    STATIC_ASSERT((CLOCK_I2C_FREQ(pclk) >= 2U) && (CLOCK_I2C_FREQ(pclk) <= 50U) && \
+                  (CLOCK_I2C_CCR(pclk, scl_hz) >= 4U) && \
+                  (CLOCK_I2C_CCR(pclk, scl_hz) <= 0xFFFU) && \
+                  (CLOCK_I2C_PPM(pclk, scl_hz) <= (max_ppm)), \
+                  "I2C timing out of range at a supported SYSCLK")
+
+/// ADCPRE field (0: /2, 1: /4, 2: /6, 3: /8): smallest that keeps ADCCLK <= 36 MHz
+#define CLOCK_ADC_PRE(pclk2) \
+    (((pclk2) <= 2U * CLOCK_ADC_MAX) ? 0U : ((pclk2) <= 4U * CLOCK_ADC_MAX) ? 1U : \
+     ((pclk2) <= 6U * CLOCK_ADC_MAX) ? 2U : 3U)
+#define CLOCK_ADC_HZ(pclk2) ((pclk2) / (2U * (CLOCK_ADC_PRE(pclk2) + 1U)))
+
+#endif
@@ -0,0 +1,163 @@
+/*
+* filename: config.h
+* purpose: Key/value settings in two internal flash sectors, read from a RAM cache
+* author: Connor Ockerse
+* date: 10/19/2026
+* note: Settings used to live on the 24C02C, one I2C transaction per access.
+* Here they are a log in internal flash (sectors CONFIG_SECTOR_A/B, the last
+* two 128 KiB sectors by default: an image under 384 KiB never reaches them,
+* a bigger one needs its linker script to stop at 0x08040000):
+*
+*   sector   word 0 magic (programmed last), word 1 generation
+*   record   header word: key | length << 16 | check << 24
+*            value, padded to whole words
+*            CRC-32 (crc.h) of header and value, programmed last
+*
+* A set appends a record; the newest record of a key wins and length 0
+* removes it. A record only counts once its CRC word is in, so a power cut
+* mid-write leaves the previous value. When the sector is full the live
+* values are copied into the other (erased) sector, which becomes current
+* when its magic word goes in: a power cut before that keeps the old one.
+*
+* CONFIG_INIT() loads every live value into RAM; CONFIG_get() is a lookup
+* and a copy from there (no flash read, no bus traffic).
+*
+* The F446 has a single flash bank: while a word is programmed or a sector
+* erased, instruction fetches stall, so no ISR (sonar capture, TIM6 tick)
+* runs until it is done. Words go in one at a time with interrupts enabled
+* between them, so a set holds the ISRs off for one word program at a time (16 us typical,
+* CONFIG_PROGRAM_MAX_US worst case), which must fit CONFIG_FLASH_BUDGET_US.
+* Erasing takes hundreds of milliseconds, so it never happens inside
+* CONFIG_set(): the sector emptied by a compaction is erased by
+* CONFIG_maintain() when the caller says the ISRs can take the stall.
+* WWDG_IRQHandler() can't run during it either, so once the WWDG is running
+* the stall allowed is also capped at WWDG_get_timeout_us() (refreshed just
+* before the erase): with the supervisor's ~47 ms that refuses every erase,
+* which would otherwise be a certain WWDG reset. CONFIG_INIT() therefore
+* erases a spare left dirty by a compaction; called before SUPERVISOR_INIT()
+* it always can, so a store that filled up is writable again after a reset
+* (the sets in between return CONFIG_ERR_FULL). The timebase keeps the
+* erase time: TIM5 counts on through the stall (the demo measures a 128 KiB
+* erase as 1002.2 ms).
+*
+* With CONFIG_EEPROM_MIRROR, keys registered with CONFIG_mirror() are also
+* written to the EEPROM as EEPROM_write_record() blocks for code that still
+* reads them there (and imported from it the first time).
+*/
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <stm32f446xx.h>
+#include <stdint.h>
+
+// === CONFIGURATION ===
+// The two sectors the store alternates between (0-3 are 16 KiB, 4 is 64 KiB, 5-7 are 128 KiB)
+#ifndef CONFIG_SECTOR_A
+#define CONFIG_SECTOR_A 6U
+#endif
+#ifndef CONFIG_SECTOR_B
+#define CONFIG_SECTOR_B 7U
+#endif
+
+// Keys held at once, and the longest value
+#define CONFIG_MAX_KEYS 16U
+#define CONFIG_MAX_VALUE 32U
+
+// Longest a single flash operation in CONFIG_set() may hold off the ISRs
+#ifndef CONFIG_FLASH_BUDGET_US
+#define CONFIG_FLASH_BUDGET_US 100U
+#endif
+
+// Datasheet worst cases (x32 parallelism, 2.7-3.6 V)
+#define CONFIG_PROGRAM_MAX_US 100U
+#define CONFIG_ERASE_16K_MAX_US 500000U
+#define CONFIG_ERASE_64K_MAX_US 1100000U
+#define CONFIG_ERASE_128K_MAX_US 2000000U
+
+#if CONFIG_FLASH_BUDGET_US < CONFIG_PROGRAM_MAX_US
+#error "CONFIG_FLASH_BUDGET_US is shorter than one word program"
+#endif
+
+// 1 = CONFIG_mirror() keys are also written to the EEPROM
+#ifndef CONFIG_EEPROM_MIRROR
+#define CONFIG_EEPROM_MIRROR 1
+#endif
+#define CONFIG_MIRROR_SLOTS 4U
+
+typedef enum {
+    CONFIG_OK,
+    CONFIG_ERR_LENGTH,      // Value empty or longer than CONFIG_MAX_VALUE
+    CONFIG_ERR_NO_KEY,      // Every CONFIG_MAX_KEYS slot is taken
+    CONFIG_ERR_FULL,        // Sector full and the other one not erased yet (CONFIG_maintain, CONFIG_INIT)
+    CONFIG_ERR_FLASH        // The flash reported a program error
+}ConfigStatus;
+
+// Counters since CONFIG_INIT()
+typedef struct {
+    uint32_t commits;           // Records written
+    uint32_t words;             // Words programmed
+    uint32_t compactions;
+    uint32_t erases;
+    uint32_t worst_stall_us;    // Longest single program (ISRs held off)
+    uint32_t over_budget;       // Programs longer than CONFIG_FLASH_BUDGET_US
+    uint32_t used_bytes;        // Of the current sector
+    uint32_t sector_bytes;
+}ConfigStats;
+
+/**
+ * @brief Loads the newest sector into the RAM cache
+ * @details Formats the store the first time and erases a spare a
+ * compaction left dirty, either of which stalls for a sector erase: call
+ * it at boot, before latency-critical ISRs start and before
+ * SUPERVISOR_INIT() (the WWDG refuses the spare's erase, as in CONFIG_maintain()).
+ */
+void CONFIG_INIT(void);
+
+/**
+ * @brief Copies a value out of the RAM cache
+ * @param data: Receives up to max bytes
+ * @return Length of the value (0 if the key isn't set)
+ */
+uint8_t CONFIG_get(uint16_t key, void* data, uint8_t max);
+
+/**
+ * @brief Stores a value (no write if it is unchanged)
+ * @details Appends one record, word by word, with interrupts enabled;
+ * compacts into the other sector when this one is full.
+ * @param len: 1 to CONFIG_MAX_VALUE bytes
+ */
+ConfigStatus CONFIG_set(uint16_t key, const void* data, uint8_t len);
+
+/**
+ * @brief Removes a key (a length 0 record)
+ */
+ConfigStatus CONFIG_remove(uint16_t key);
+
+/**
+ * @brief Erases the spare sector if that fits the stall the caller allows
+ * @details Never longer than the WWDG timeout while the WWDG runs.
+ * @param allowed_stall_us: How long the ISRs may be held off right now
+ * @return 1 if a sector was erased
+ */
+uint8_t CONFIG_maintain(uint32_t allowed_stall_us);
+
+/**
+ * @brief Also keeps a key in the EEPROM (EEPROM_write_record format)
+ * @details If the key isn't in flash yet and the EEPROM holds a valid
+ * record of len bytes there, it is imported.
+ * @return 1 if registered, 0 if every CONFIG_MIRROR_SLOTS slot is taken
+ */
+uint8_t CONFIG_mirror(uint16_t key, uint8_t eeprom_location, uint8_t len);
+
+/**
+ * @brief Copies the counters
+ */
+void CONFIG_get_stats(ConfigStats* stats);
+
+/**
+ * @brief Keys, sector use and flash stalls over USART2
+ */
+void CONFIG_report(void);
+
+#endif
@@ -0,0 +1,112 @@
+/*
+* filename: crc.h
+* purpose: CRC-32 on the STM32 CRC unit, CPU-fed or DMA-fed, with a software fallback
+* author: Connor Ockerse
+* date: 10/19/2026
+* note: The CRC unit computes the CRC-32 of the words written to its data
+* register: polynomial 0x04C11DB7, initial value 0xFFFFFFFF, each word taken
+* MSB first, no reflection and no final XOR (the STM32 "CRC-32/MPEG-2" flavor,
+* not the zlib one). Every function here gives that same value:
+*
+*   CRC_words()      CPU writes one word per DR access (~4 cycles a word)
+*   CRC_bytes()      Byte buffers: whole words as little-endian loads through
+*                    the unit, the last 1-3 bytes in software (8 bits each)
+*   CRC_start_dma()  A DMA2 stream (dma.h) feeds the unit memory-to-memory
+*                    while the CPU does something else; the callback gets
+*                    the result
+*   CRC_*_sw()       Table-driven software (16-entry nibble table), used
+*                    when the unit is taken and for CRC_HARDWARE = 0
+*
+* The unit holds one running CRC, so it is claimed per call. A caller that
+* finds it busy (a DMA in flight, or an ISR that interrupted a CPU-fed CRC)
+* gets the software result instead of waiting: same value, just slower.
+*
+* Call CRC_INIT() after BOARD_INIT() (CRC and DMA2 clocks). It takes one of
+* the DMA_REQ_MEM_TO_MEM streams.
+*/
+
+#ifndef CRC_H
+#define CRC_H
+
+#include <stm32f446xx.h>
+#include <stdint.h>
+
+// === CONFIGURATION ===
+// 1 = use the CRC unit and DMA, 0 = software only (same results)
+#ifndef CRC_HARDWARE
+#define CRC_HARDWARE 1
+#endif
+
+// Value of an empty buffer (the unit's reset value)
+#define CRC_INITIAL 0xFFFFFFFFU
+
+// Longest DMA feed (NDTR is 16 bits)
+#define CRC_DMA_MAX_WORDS 65535U
+
+// Called from the DMA interrupt with the CRC of the fed words
+typedef void (*CrcCallback)(uint32_t crc, void* arg);
+
+/**
+ * @brief Resets the CRC unit and takes a memory-to-memory DMA stream
+ */
+void CRC_INIT(void);
+
+/**
+ * @brief CRC of count 32-bit words through the CRC unit
+ * @details Falls back to CRC_words_sw() if the unit is taken.
+ * @param words: Source (word aligned)
+ * @param count: Number of words
+ * @return CRC-32 of the words
+ */
+uint32_t CRC_words(const uint32_t* words, uint32_t count);
+
+/**
+ * @brief CRC of a byte buffer (any length and alignment)
+ * @details Bytes are grouped into little-endian words, so on a word-aligned
+ * buffer of whole words this equals CRC_words() of the same memory.
+ * @param data: Source
+ * @param len: Number of bytes
+ * @return CRC-32 of the bytes
+ */
+uint32_t CRC_bytes(const uint8_t* data, uint32_t len);
+
+/**
+ * @brief Software CRC of count words (bit-identical to CRC_words())
+ */
+uint32_t CRC_words_sw(const uint32_t* words, uint32_t count);
+
+/**
+ * @brief Software CRC of a byte buffer (bit-identical to CRC_bytes())
+ */
+uint32_t CRC_bytes_sw(const uint8_t* data, uint32_t len);
+
+/**
+ * @brief Feeds count words to the CRC unit by DMA and returns at once
+ * @details The words must stay untouched until the callback ran. Without a
+ * free unit (or with CRC_HARDWARE = 0) the CRC is computed in software and
+ * the callback runs before this returns.
+ * @param words: Source (word aligned, in SRAM or flash)
+ * @param count: 1 to CRC_DMA_MAX_WORDS words
+ * @param callback: Gets the CRC (DMA interrupt context, or CRC_wait() after a timeout), may be 0
+ * @param arg: Passed to the callback
+ * @return 1 if the DMA was started, 0 if the result was already delivered
+ */
+uint8_t CRC_start_dma(const uint32_t* words, uint32_t count, CrcCallback callback, void* arg);
+
+/**
+ * @brief Checks whether a DMA feed is still running
+ * @return 1 if busy, 0 if idle
+ */
+uint8_t CRC_is_busy(void);
+
+/**
+ * @brief Waits until the DMA feed is done
+ * @details Call from thread code with interrupts enabled. Polls the feed
+ * (SPIN_CRC_DMA) for at most 16 cycles per word plus 1 ms. A feed still
+ * running then is stopped and its CRC computed in software; the callback
+ * gets that result from here instead of the DMA interrupt.
+ * @return CRC of the last DMA feed (valid after its callback)
+ */
+uint32_t CRC_wait(void);
+
+#endif
@@ -0,0 +1,123 @@
+/*
+* filename: datalog.h
+* purpose: Ring-buffered sensor log in the 24C02C, delta/varint compressed
+* author: Connor Ockerse
+* date: 10/19/2026
+* note: A plain record (Clock + three 16-bit readings) takes 13 bytes, so the
+* whole chip holds 19 of them. Here each EEPROM page of the log region is:
+*
+*   byte 0      sequence number (+1 per page, finds the newest at init)
+*   byte 1      bit 7 = keyframe page, bits 4:0 = payload bytes (1-14)
+*   bytes 2-15  payload
+*
+* A keyframe page starts with an absolute sample (time, sonar, light,
+* encoder as varints); every DATALOG_KEYFRAME_PAGES pages there is a new
+* one, so losing the oldest page to the ring (or a bad page) costs at most
+* the pages up to the next keyframe. Every other sample is one header byte
+*
+*   bit 7       1 = time step follows (varint), 0 = same step as last time
+*   bit 6       1 = sonar change follows (zigzag varint)
+*   bit 5       1 = encoder change follows (zigzag varint)
+*   bits 4:0    light change -15..+15, or -16 = zigzag varint follows
+*
+* plus whatever changed beyond that, so a steady sample rate with slowly
+* moving readings costs one byte: up to 14 samples a page where plain
+* records fit 1.2 (about 8x over the region for steady readings,
+* keyframes included). Samples collect in a RAM page that is written with a
+* single page write (one write cycle) when the next sample doesn't fit, or
+* by DATALOG_flush(). DATALOG_dump() reads the region back with sequential
+* reads and decodes it oldest first.
+*
+* Needs I2C_INIT() and the timebase; owns its EEPROM pages (DATALOG_clear()
+* them once before the first use, whatever was there could pass for a page).
+*/
+
+#ifndef DATALOG_H
+#define DATALOG_H
+
+#include <stm32f446xx.h>
+#include <stdint.h>
+#include "eeprom.h"
+
+// === CONFIGURATION ===
+// Log region: EEPROM pages DATALOG_FIRST_PAGE.. (0x40-0xFF by default)
+#ifndef DATALOG_FIRST_PAGE
+#define DATALOG_FIRST_PAGE 4U
+#endif
+#ifndef DATALOG_NUM_PAGES
+#define DATALOG_NUM_PAGES 12U
+#endif
+
+// Pages per keyframe (the most a lost page can take with it)
+#define DATALOG_KEYFRAME_PAGES 2U
+
+// Size of the same sample as a Clock and three raw readings
+#define DATALOG_RAW_BYTES 13U
+
+#if ((DATALOG_FIRST_PAGE + DATALOG_NUM_PAGES) * EEPROM_PAGE_BYTES) > EEPROM_NUM_BYTES
+#error "DATALOG region runs past the end of the EEPROM"
+#endif
+
+// One logged sample
+typedef struct {
+    uint32_t time_s;        // Caller's timestamp (e.g. seconds since boot or epoch)
+    uint16_t sonar_cm;
+    uint16_t light;
+    uint16_t encoder;
+}DatalogSample;
+
+// Counters since DATALOG_INIT()
+typedef struct {
+    uint32_t samples;       // Appended
+    uint32_t bytes;         // Payload bytes they took
+    uint32_t page_writes;   // Write cycles spent (full pages and flushes)
+    uint32_t write_errors;  // Page writes the bus failed (not in page_writes)
+}DatalogStats;
+
+// Called by DATALOG_dump() for each sample, oldest first
+typedef void (*DatalogVisitor)(const DatalogSample* sample, void* arg);
+
+/**
+ * @brief Finds the newest page of the region and appends after it
+ * @details The next sample starts a new page with a keyframe.
+ */
+void DATALOG_INIT(void);
+
+/**
+ * @brief Adds a sample to the RAM page
+ * @details Costs one page write when the page is full, nothing otherwise.
+ * A time step backwards or of more than ~24 days starts a new keyframe.
+ */
+void DATALOG_append(const DatalogSample* sample);
+
+/**
+ * @brief Writes the RAM page out now (one write cycle if it changed)
+ * @details Later samples keep filling the same page, which is rewritten
+ * when it's full.
+ */
+void DATALOG_flush(void);
+
+/**
+ * @brief Decodes every sample still in the log, oldest first
+ * @details Includes the RAM page. Pages without a keyframe before them
+ * (overwritten by the ring) are skipped.
+ * @return Number of samples visited
+ */
+uint32_t DATALOG_dump(DatalogVisitor visitor, void* arg);
+
+/**
+ * @brief Empties the log (one write cycle per page)
+ */
+void DATALOG_clear(void);
+
+/**
+ * @brief Copies the counters
+ */
+void DATALOG_get_stats(DatalogStats* stats);
+
+/**
+ * @brief Samples held, bytes per sample and the gain over plain records, over USART2
+ */
+void DATALOG_report(void);
+
+#endif
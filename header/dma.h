@@ -0,0 +1,176 @@
+/*
+* filename: dma.h
+* purpose: DMA1/DMA2 stream allocator with request routing and completion callbacks
+* author: Connor Ockerse
+* date: 10/19/2026
+* note: Every DMA user goes through here instead of picking a stream itself.
+* A static table in dma.c lists, for each request the board can make, the
+* streams and channels RM0390 (tables 28/29) wires it to:
+*
+*   handle = DMA_alloc(DMA_REQ_USART2_TX, "usart2");   // once, at init
+*
+*   DmaConfig cfg;
+*   DMA_config_init(&cfg, DMA_DIR_MEM_TO_PERIPH);
+*   cfg.peripheral = (uint32_t)(uintptr_t)&USART2->DR;
+*   cfg.memory0 = buffer;
+*   cfg.count = len;
+*   cfg.callback = tx_done;
+*   DMA_start(handle, &cfg);
+*
+* DMA_alloc() takes the first free stream on the request's list, so two
+* drivers can never program the same stream; when none is left it returns
+* DMA_NO_STREAM and counts a conflict (DMA_report() shows who holds what).
+*
+* The stream interrupts live here and call the owner's callback with
+* DMA_EVENT_HALF (half-transfer, if asked for), DMA_EVENT_DONE (whole
+* buffer; every buffer in circular and double-buffer mode) or
+* DMA_EVENT_ERROR (transfer or direct mode error: the hardware has already
+* stopped the stream). Callbacks run in interrupt context.
+*
+* Needs the DMA1/DMA2 clocks from BOARD_INIT().
+*/
+
+#ifndef DMA_H
+#define DMA_H
+
+#include <stm32f446xx.h>
+#include <stdint.h>
+
+// Streams of both controllers: handle = controller * 8 + stream
+#define DMA_NUM_STREAMS 16U
+
+// Returned by DMA_alloc() when every stream of the request is taken
+#define DMA_NO_STREAM 0xFFU
+
+// Everything the board can ask a stream for
+typedef enum {
+    DMA_REQ_MEM_TO_MEM,     // Any DMA2 stream (DMA1 can't do memory-to-memory)
+    DMA_REQ_ADC1,
+    DMA_REQ_I2C1_RX,
+    DMA_REQ_I2C1_TX,
+    DMA_REQ_USART2_RX,
+    DMA_REQ_USART2_TX,
+    DMA_REQ_TIM1_UP,
+    DMA_REQ_TIM1_CH1,
+    DMA_REQ_TIM3_UP,
+    DMA_REQ_TIM3_CH1,
+    DMA_REQ_TIM3_CH2,
+    DMA_REQ_TIM4_CH1,
+    DMA_NUM_REQUESTS
+}DmaRequest;
+
+typedef enum {
+    DMA_DIR_PERIPH_TO_MEM = 0,
+    DMA_DIR_MEM_TO_PERIPH = 1,
+    DMA_DIR_MEM_TO_MEM = 2      // peripheral = source, memory0 = destination
+}DmaDirection;
+
+typedef enum {
+    DMA_MODE_SINGLE,        // One buffer, then the stream stops
+    DMA_MODE_CIRCULAR,      // memory0 over and over
+    DMA_MODE_DOUBLE         // memory0 and memory1 in turn (refill with DMA_set_buffer)
+}DmaMode;
+
+typedef enum {
+    DMA_EVENT_HALF,
+    DMA_EVENT_DONE,
+    DMA_EVENT_ERROR
+}DmaEvent;
+
+// Called from the stream interrupt
+typedef void (*DmaCallback)(DmaEvent event, void* arg);
+
+// One transfer (fill with DMA_config_init() first)
+typedef struct {
+    uint32_t peripheral;        // PAR: register address (the source for memory-to-memory)
+    const void* memory0;        // M0AR
+    const void* memory1;        // M1AR (double-buffer mode only)
+    uint16_t count;             // Items per buffer (NDTR), in peripheral-size units
+    uint8_t periph_size;        // Bytes per item: 1, 2 or 4
+    uint8_t memory_size;
+    uint8_t periph_increment;   // 1 = walk the peripheral address too
+    uint8_t memory_increment;
+    uint8_t priority;           // 0 (low) to 3 (very high)
+    DmaDirection direction;
+    DmaMode mode;
+    DmaCallback callback;       // May be 0 (no interrupts)
+    void* arg;
+    uint8_t half_event;         // 1 = also report DMA_EVENT_HALF
+}DmaConfig;
+
+// Per-stream counters since DMA_alloc()
+typedef struct {
+    uint64_t bytes;             // Moved on the peripheral side
+    uint32_t buffers;           // Completed buffers (DMA_EVENT_DONE)
+    uint32_t errors;            // Transfer errors
+    uint32_t direct_errors;     // Direct mode errors
+    uint32_t fifo_errors;       // FIFO over/underruns (seen, not reported)
+}DmaStats;
+
+/**
+ * @brief Sets cfg to a single-shot byte transfer in direction, memory incremented
+ */
+void DMA_config_init(DmaConfig* cfg, DmaDirection direction);
+
+/**
+ * @brief Takes a free stream that can serve request
+ * @param request: What the stream will carry
+ * @param owner: Shown by DMA_report() (kept by pointer)
+ * @return Stream handle, DMA_NO_STREAM if every candidate is taken
+ */
+uint8_t DMA_alloc(DmaRequest request, const char* owner);
+
+/**
+ * @brief Stops the stream and gives it back
+ */
+void DMA_free(uint8_t handle);
+
+/**
+ * @brief Programs and enables the stream
+ * @details A transfer still running on it is stopped first. Direct mode is
+ * used unless the sizes differ or it is memory-to-memory (FIFO at 1/2).
+ * @return 1 if started, 0 for a bad handle or config
+ */
+uint8_t DMA_start(uint8_t handle, const DmaConfig* cfg);
+
+/**
+ * @brief Disables the stream and waits until it really stopped
+ */
+void DMA_stop(uint8_t handle);
+
+/**
+ * @brief Checks whether the stream is enabled
+ * @return 1 while transferring, 0 when stopped
+ */
+uint8_t DMA_is_busy(uint8_t handle);
+
+/**
+ * @brief Items left in the current buffer (NDTR)
+ */
+uint16_t DMA_remaining(uint8_t handle);
+
+/**
+ * @brief Buffer the stream is working on in double-buffer mode
+ * @return 0 for memory0, 1 for memory1
+ */
+uint8_t DMA_current_buffer(uint8_t handle);
+
+/**
+ * @brief Points the idle buffer of a double-buffer stream at new data
+ * @details Call from DMA_EVENT_DONE for the buffer that just finished,
+ * i.e. the one DMA_current_buffer() does not return.
+ * @param which: 0 for memory0, 1 for memory1
+ */
+void DMA_set_buffer(uint8_t handle, uint8_t which, const void* memory);
+
+/**
+ * @brief Copies the counters of a stream
+ */
+void DMA_get_stats(uint8_t handle, DmaStats* stats);
+
+/**
+ * @brief Allocated streams, their owners and counters, and conflicts over USART2
+ */
+void DMA_report(void);
+
+#endif
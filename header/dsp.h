@@ -0,0 +1,106 @@
+/*
+* filename: dsp.h
+* purpose: Block filters over 16-bit samples using the Cortex-M4 SIMD instructions
+* author: Connor Ockerse
+* date: 10/19/2026
+* note: Each kernel comes three ways:
+*
+*   DSP_x_scalar()  portable reference, one sample at a time
+*   DSP_x_simd()    two samples per instruction (__SMLAD, __SSUB16/__SEL)
+*   DSP_x()         whichever DSP_SIMD picks
+*
+* Both versions give bit-identical results (the SIMD accumulators wrap at
+* 32 bits, so the scalar ones do too). Samples are int16_t in memory and
+* are loaded two at a time, any alignment.
+*
+* Every kernel returns how many outputs it wrote; out never needs to be
+* larger than len. in and out may not overlap.
+*
+* The sim provides the intrinsics bit-exact but charges no cycles for
+* computation, so only the target tells the two versions apart on speed
+* (DSP_report()).
+*/
+
+#ifndef DSP_H
+#define DSP_H
+
+#include <stm32f446xx.h>
+#include <stdint.h>
+
+// === CONFIGURATION ===
+// 1 = DSP_x() runs the SIMD kernels, 0 = the scalar references
+#ifndef DSP_SIMD
+#if defined(__ARM_FEATURE_DSP)
+#define DSP_SIMD 1
+#else
+#define DSP_SIMD 0
+#endif
+#endif
+
+// Samples per block in DSP_bench()
+#define DSP_BENCH_BLOCK 64U
+
+typedef enum {
+    DSP_KERNEL_FIR,
+    DSP_KERNEL_MOVING_AVERAGE,
+    DSP_KERNEL_DECIMATE,
+    DSP_KERNEL_MEDIAN3,
+    DSP_NUM_KERNELS
+}DspKernel;
+
+// One kernel on one DSP_BENCH_BLOCK block, both ways
+typedef struct {
+    uint32_t scalar_cycles;
+    uint32_t simd_cycles;
+    uint32_t outputs;
+    uint8_t match;          // 1 = identical outputs
+}DspBench;
+
+/**
+ * @brief FIR filter over the samples that have a full window (Q15 taps)
+ * @details out[n] = sum(coeffs[k] * in[n + k]) >> 15, rounded and saturated;
+ * coeffs are in sample order (the oldest sample first). The sum of |coeffs|
+ * must stay below 65536 (a gain of 2) so the accumulator can't wrap.
+ * @return len - taps + 1 outputs (0 if len < taps)
+ */
+uint32_t DSP_fir_q15(const int16_t* in, int16_t* out, uint32_t len, const int16_t* coeffs, uint32_t taps);
+uint32_t DSP_fir_q15_scalar(const int16_t* in, int16_t* out, uint32_t len, const int16_t* coeffs, uint32_t taps);
+uint32_t DSP_fir_q15_simd(const int16_t* in, int16_t* out, uint32_t len, const int16_t* coeffs, uint32_t taps);
+
+/**
+ * @brief Mean of every window samples in a row (truncated toward zero)
+ * @return len - window + 1 outputs (0 if len < window or window is 0)
+ */
+uint32_t DSP_moving_average(const int16_t* in, int16_t* out, uint32_t len, uint32_t window);
+uint32_t DSP_moving_average_scalar(const int16_t* in, int16_t* out, uint32_t len, uint32_t window);
+uint32_t DSP_moving_average_simd(const int16_t* in, int16_t* out, uint32_t len, uint32_t window);
+
+/**
+ * @brief Keeps one mean per factor samples (boxcar filter, then downsample)
+ * @return len / factor outputs (a partial last group is ignored)
+ */
+uint32_t DSP_decimate(const int16_t* in, int16_t* out, uint32_t len, uint32_t factor);
+uint32_t DSP_decimate_scalar(const int16_t* in, int16_t* out, uint32_t len, uint32_t factor);
+uint32_t DSP_decimate_simd(const int16_t* in, int16_t* out, uint32_t len, uint32_t factor);
+
+/**
+ * @brief Median of every three samples in a row (drops single-sample spikes)
+ * @return len - 2 outputs (0 if len < 3)
+ */
+uint32_t DSP_median3(const int16_t* in, int16_t* out, uint32_t len);
+uint32_t DSP_median3_scalar(const int16_t* in, int16_t* out, uint32_t len);
+uint32_t DSP_median3_simd(const int16_t* in, int16_t* out, uint32_t len);
+
+/**
+ * @brief Runs a kernel both ways on a fixed pseudo-random block
+ * @details Times each with the DWT cycle counter (enabled if needed) and
+ * compares the outputs. Thread code only.
+ */
+void DSP_bench(DspKernel kernel, DspBench* result);
+
+/**
+ * @brief DSP_bench() of every kernel over USART2
+ */
+void DSP_report(void);
+
+#endif
@@ -3,6 +3,8 @@
 * purpose: Driver for 24C02C EEPROM
 * author: Connor Ockerse
 * date: 11/27/2025
+* note: On I2C1 next to the DS3231, or on I2C2 by itself with BOARD_I2C2
+* (BOARD_EEPROM_BUS in board.h).
 */
 
 #ifndef EEPROM_H
@@ -10,6 +12,7 @@
 
 #include <stm32f446xx.h>
 #include <stdint.h>
+#include "I2C.h"
 
 // Default I2C Address for 24C02C (A0, A1, A2 grounded)
 #define EEPROM_ADDRESS 0xA0 >> 1
@@ -17,31 +20,109 @@
 // max storage on 2402C EEPROM
 #define EEPROM_NUM_BYTES 256U
 
+// Page buffer of the 24C02C: one write cycle stores up to a whole page
+#define EEPROM_PAGE_BYTES 16U
+
+// Internal write cycle time after each byte or page write
+#define EEPROM_WRITE_CYCLE_MS 2U
+
+// CRC-32 stored after each record (crc.h)
+#define EEPROM_RECORD_CRC_BYTES 4U
+
+/**
+ * @brief Moves the driver to another I2C bus
+ * @details Starts out on BOARD_EEPROM_BUS; only needed for other wiring.
+ * @param bus: Bus the 24C02C is on (initialized with I2C_bus_init())
+ */
+void EEPROM_set_bus(I2CBus bus);
+
+/**
+ * @brief Bus the driver talks to
+ */
+I2CBus EEPROM_get_bus(void);
+
 /**
  * @brief Writes a single byte to the EEPROM
- * @details Includes the required 5ms write cycle delay automatically.
+ * @details Returns as soon as the byte is on the bus. The write cycle delay
+ * is handled automatically: the next EEPROM access sleeps (WFI) until the
+ * cycle is over instead of this call spinning for it.
  * @param address: Slave Address (usually 0b01010_0000)
  * @param memory_location: The address inside the EEPROM (0x00 to 0xFF)
  * @param data: The byte to write
+ * @return I2C_OK or what went wrong on the bus
  */
-void EEPROM_write(uint8_t saddr, uint8_t memory_location, uint8_t data);
+I2CStatus EEPROM_write(uint8_t saddr, uint8_t memory_location, uint8_t data);
 
 /**
  * @brief Reads a byte from a specific location via pointer
  * @param saddr: Slave Address
  * @param maddr: Memory Address to read from
- * @param data: Pointer to store the read value
+ * @param data: Pointer to store the read value (left alone if the bus fails)
+ * @return I2C_OK or what went wrong on the bus
  */
-void EEPROM_random_read(uint8_t saddr, uint8_t maddr, uint8_t* data);
+I2CStatus EEPROM_random_read(uint8_t saddr, uint8_t maddr, uint8_t* data);
 
 /**
  * @brief Reads a byte from a specific location and returns it directly
  * @param address: Slave Address
  * @param memory_location: Memory Address to read from
- * @return The data byte read from EEPROM
+ * @return The data byte read from EEPROM, 0xFF (erased) if the bus fails
  */
 uint8_t EEPROM_read_address(uint8_t saddr, uint8_t memory_location);
 
+/**
+ * @brief Writes up to a page of bytes with a single write cycle
+ * @details Same deferred wait as EEPROM_write(), but len bytes for the
+ * price of one cycle. The bytes must stay inside one EEPROM_PAGE_BYTES page
+ * (the chip would wrap to the start of the page).
+ * @param saddr: Slave Address
+ * @param memory_location: First cell
+ * @param data: The bytes to write
+ * @param len: 1 to EEPROM_PAGE_BYTES
+ * @return 1 if written, 0 if the bytes cross a page boundary or the bus failed
+ */
+uint8_t EEPROM_write_page(uint8_t saddr, uint8_t memory_location, const uint8_t* data, uint16_t len);
+
+/**
+ * @brief Reads consecutive cells in one transaction (sequential read)
+ * @details One address phase, then a byte per 9 SCL periods; the chip
+ * wraps from 0xFF to 0x00.
+ * @param saddr: Slave Address
+ * @param memory_location: First cell
+ * @param data: Receives len bytes
+ * @param len: Number of bytes (at least 1)
+ * @return I2C_OK or what went wrong on the bus (data is then incomplete)
+ */
+I2CStatus EEPROM_read_sequential(uint8_t saddr, uint8_t memory_location, uint8_t* data, uint16_t len);
+
+/**
+ * @brief Checks if the EEPROM is still in its internal write cycle
+ * @return 1 if busy, 0 if the next access will not have to wait
+ */
+uint8_t EEPROM_is_busy(void);
+
+/**
+ * @brief Writes a block followed by its CRC-32 (little-endian)
+ * @details Takes len + EEPROM_RECORD_CRC_BYTES cells from memory_location.
+ * @param saddr: Slave Address
+ * @param memory_location: First cell of the record
+ * @param data: The bytes to store
+ * @param len: Number of data bytes
+ * @return 1 if written, 0 if the record doesn't fit in the chip or a byte failed on the bus
+ */
+uint8_t EEPROM_write_record(uint8_t saddr, uint8_t memory_location, const uint8_t* data, uint16_t len);
+
+/**
+ * @brief Reads a block written by EEPROM_write_record() and checks its CRC
+ * @details data is filled even when the check fails.
+ * @param saddr: Slave Address
+ * @param memory_location: First cell of the record
+ * @param data: Receives len bytes
+ * @param len: Number of data bytes (as written)
+ * @return 1 if the CRC matches, 0 if the record is corrupt, doesn't fit or a read failed
+ */
+uint8_t EEPROM_read_record(uint8_t saddr, uint8_t memory_location, uint8_t* data, uint16_t len);
+
 /**
  * @brief Wipes the entire EEPROM (Writes 0x00 to all addresses)
  * @param saddr: Slave Address
@@ -6,7 +6,7 @@
 * * Connections:
 * CLK -> PB6 (TIM4_CH1)
 * DT  -> PB7 (TIM4_CH2)
-* SW  -> PB10 (encoder button)
+* SW  -> PB10 (encoder button; PC13 with BOARD_I2C2, see board.h)
 */
 
 #ifndef ENCODER_H
@@ -16,10 +16,14 @@
 #include <stm32f446xx.h>
 #include <stdint.h>
 
+// Presses waiting between the ISR, the debounce timer and the reader
+// (powers of two; see ring.h)
+#define ENCODER_EDGE_RING_SIZE 4U
+#define ENCODER_PRESS_RING_SIZE 8U
 
 /**
  * @brief Initializes TIM4 in Encoder Mode (PB6 & PB7)
- * and the button on PB10 as an interrupt
+ * and the button (BOARD_BUTTON_PIN) as an interrupt
  */
 void ENCODER_INIT(void);
 
@@ -29,6 +33,12 @@ void ENCODER_INIT(void);
  */
 uint16_t ENCODER_read(void);
 
+/**
+ * @brief Loads the encoder count (e.g. restored after a power loss)
+ * @param count: New raw count, turns carry on from it
+ */
+void ENCODER_write(uint16_t count);
+
 /**
  * @brief Knows if encoder was turned CW or CCW
  * @returns 1 for CCW, 0 for CW
@@ -36,9 +46,24 @@ uint16_t ENCODER_read(void);
 uint8_t ENCODER_raw_direction(void);
 
 /**
- * @brief Simple debounce routine for the encoder that utilizes TIM6 as way to track valid press 
+ * @brief Simple debounce routine for the encoder button
+ * @details The button EXTI arms a one-shot software timer; when it expires the
+ * pin is checked again. Does not spin and never touches the TIM6 count.
+ * Confirmed presses are queued, so each call takes at most one of them.
  * @returns 1 for valid debounce and 0 for invalid debounce 
  */
 uint8_t ENCODER_debounce(void);
 
+/**
+ * @brief Like ENCODER_debounce(), but also gives the press time
+ * @param press_time_ms: Timebase milliseconds of the press's first edge
+ * @return 1 if a confirmed press was taken, 0 if none is waiting
+ */
+uint8_t ENCODER_read_press(uint64_t* press_time_ms);
+
+/**
+ * @brief Presses dropped because a queue was full
+ */
+uint32_t ENCODER_get_overflows(void);
+
 #endif
\ No newline at end of file
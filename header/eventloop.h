@@ -0,0 +1,48 @@
+/*
+* filename: eventloop.h
+* purpose: Main event loop that runs due software timers and sleeps (WFI) when idle
+* author: Connor Ockerse
+* date: 10/19/2026
+* note: Replaces spinning in while(1). Work is registered as software timers
+* (swtimer.h). Any interrupt wakes the core, so ISRs that start a timer with
+* delay 0 get their deferred work run on the next pass. In tickless mode the
+* next timer deadline is armed as a TIM5 compare wakeup before sleeping, or
+* as an RTC wakeup when power.h picks Stop mode. Idle time includes Stop.
+* Each pass is timed by supervisor.h.
+*/
+
+#ifndef EVENTLOOP_H
+#define EVENTLOOP_H
+
+#include <stm32f446xx.h>
+#include <stdint.h>
+
+// Length of the CPU load measurement window
+#define EVENTLOOP_LOAD_WINDOW_MS 1000U
+
+/**
+ * @brief Runs one pass of the event loop
+ * @details Runs every due timer callback. If none ran, sleeps (POWER_idle())
+ * until the next interrupt. Call this inside any wait loop instead of spinning.
+ * @return Number of callbacks that ran
+ */
+uint32_t EVENTLOOP_poll(void);
+
+/**
+ * @brief Runs the event loop forever
+ */
+void EVENTLOOP_run(void);
+
+/**
+ * @brief CPU load over the last completed measurement window
+ * @return Busy time in tenths of a percent (0-1000)
+ */
+uint16_t EVENTLOOP_get_load(void);
+
+/**
+ * @brief Total time spent asleep in WFI since boot
+ * @return Idle time in microseconds
+ */
+uint64_t EVENTLOOP_get_idle_us(void);
+
+#endif
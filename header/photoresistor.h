@@ -12,6 +12,9 @@
 #include <stm32f446xx.h>
 #include <stdint.h>
 
+// Conversions per PHOTO_read_filtered() (median-of-3 eats two, the rest are averaged)
+#define PHOTO_FILTER_SAMPLES 18U
+
 /**
  * @brief Initializes ADC1 on Pin PA1 (ADC1_IN1)
  * @details Automatically configures prescalers based on system clock
@@ -25,4 +28,12 @@ void PHOTO_INIT(void);
  */
 uint16_t PHOTO_read(void);
 
+/**
+ * @brief Reads a block of PHOTO_FILTER_SAMPLES and filters it (dsp.h)
+ * @details Median-of-3 first, so single-conversion spikes never reach the
+ * mean, then one decimated mean of the remaining 16.
+ * @return 12-bit value, same scale as PHOTO_read()
+ */
+uint16_t PHOTO_read_filtered(void);
+
 #endif
\ No newline at end of file
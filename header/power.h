@@ -0,0 +1,135 @@
+/*
+* filename: power.h
+* purpose: Low-power idle: Sleep or Stop mode between events, with time and wakeup accounting
+* author: Connor Ockerse
+* date: 10/19/2026
+* note: EVENTLOOP_poll() hands every idle period to POWER_idle(), which picks
+* the deepest mode that keeps everything in flight working:
+*
+*   Sleep: WFI with every clock running. Any interrupt wakes the core and
+*          the timebase keeps counting. Used when the next timer is due
+*          within POWER_STOP_MIN_US or something is still running.
+*   Stop:  SLEEPDEEP + WFI. HSE, PLL and the bus clocks stop, so every timer
+*          (the TIM5 timebase too) holds its count. Only EXTI lines wake it:
+*            - EXTI0  DS3231 INT/SQW on PA0 (RTC_set_alarm)
+*            - EXTI10 encoder button on PB10, EXTI13 on PC13 with BOARD_I2C2 (ENCODER_INIT)
+*            - EXTI22 STM32 RTC wakeup timer, armed for the next timer deadline
+*
+* The STM32's own RTC runs from the LSI (already on for the IWDG) and keeps
+* counting through Stop. Its subsecond counter measures how long the core
+* was stopped, and that time is added back to the timebase before any ISR
+* runs. The core wakes on HSI; the clock profile in use before is restored
+* (HSE start + PLL lock, ~1.1 ms), so the wakeup timer fires that much
+* before the deadline. The LSI is only specified to 17-47 kHz, so POWER_INIT()
+* times it against the TIM5 timebase (TIM5_CH4 remapped to the LSI, ~4 ms)
+* and converts with the measured rate; what's left is the LSI's drift since
+* then (fine for timeouts, not for timekeeping: that's what the DS3231 is for).
+*
+* The window watchdog (supervisor.h) freezes in Stop but keeps counting in
+* Sleep, and only the event loop refreshes it, at the end of each pass. So
+* once it runs, no Sleep lasts longer than its timeout (~47 ms at PCLK1 =
+* 45 MHz) less POWER_WWDG_MARGIN_US: the TIM5 wakeup ends it early and the
+* loop makes an empty pass. Those wakeups cost Run time a timer-free Sleep
+* would not have; PowerStats.wwdg_wakeups counts them. Stop avoids them.
+*
+* Stop is skipped while the buzzer, stopwatch or sonar timer runs or someone
+* holds POWER_stop_lock(). A USART2 frame or I2C STOP still on the wire is
+* waited out first (at most one frame time).
+*
+* Call POWER_INIT() after BOOT_INIT(). Without it POWER_idle() is a plain WFI.
+*/
+
+#ifndef POWER_H
+#define POWER_H
+
+#include <stm32f446xx.h>
+#include <stdint.h>
+
+// === CONFIGURATION ===
+// Shortest idle period worth a Stop (the clock restore alone takes ~1.1 ms)
+#define POWER_STOP_MIN_US 5000U
+
+// Clock restore time assumed before the first Stop has measured it
+#define POWER_RESTORE_US 1500U
+
+// A Sleep ends this long before the WWDG early warning, for the loop to refresh it
+#define POWER_WWDG_MARGIN_US 1000U
+
+// 1 = low-power regulator and flash power-down in Stop (less current,
+// ~105 us regulator start-up), 0 = main regulator (~13 us)
+#ifndef POWER_STOP_LOW_POWER
+#define POWER_STOP_LOW_POWER 1
+#endif
+
+typedef enum {
+    POWER_MODE_RUN,
+    POWER_MODE_SLEEP,
+    POWER_MODE_STOP,
+    POWER_NUM_MODES
+}PowerMode;
+
+// What ended a Stop (several at once all count)
+typedef enum {
+    POWER_WAKE_TIMER,       // RTC wakeup timer (software timer deadline)
+    POWER_WAKE_ALARM,       // DS3231 alarm
+    POWER_WAKE_BUTTON,      // Encoder button
+    POWER_WAKE_OTHER,       // Any other interrupt
+    POWER_NUM_WAKE_SOURCES
+}PowerWakeSource;
+
+// Time in each mode since POWER_INIT() (the average current follows from
+// these and the datasheet currents of each mode)
+typedef struct {
+    uint64_t mode_us[POWER_NUM_MODES];      // Run is whatever isn't Sleep or Stop
+    uint32_t entries[POWER_NUM_MODES];      // Sleep and Stop entries
+    uint32_t wakeups[POWER_NUM_WAKE_SOURCES];
+    uint32_t wwdg_wakeups;                  // Sleeps cut short to refresh the WWDG
+    uint32_t latency_min_us;                // Stop exit until the profile clocks run
+    uint32_t latency_avg_us;
+    uint32_t latency_max_us;
+    uint32_t lsi_hz;                        // Measured at POWER_INIT() (32000 if it couldn't be)
+}PowerStats;
+
+/**
+ * @brief Starts the LSI-clocked RTC used for Stop mode wakeups and timing
+ * @details Time of day on the STM32 RTC starts at 00:00:00; only differences
+ * are used. Needs the PWR clock from BOARD_INIT() and, in tickless builds,
+ * the running TIM5 timebase to calibrate the LSI against.
+ */
+void POWER_INIT(void);
+
+/**
+ * @brief Sleeps until the next event, in Sleep or Stop mode
+ * @details Call with interrupts masked (the event loop does); pending
+ * interrupts still end the sleep and run once the caller unmasks. After a
+ * Stop the clock profile and the timebase are back before this returns.
+ * @param now_us: TIMEBASE_now_us() read after masking interrupts
+ * @param has_deadline: 1 if a software timer is waiting
+ * @param deadline_us: When it is due (timebase scale)
+ * @return TIMEBASE_now_us() after waking up
+ */
+uint64_t POWER_idle(uint64_t now_us, uint8_t has_deadline, uint64_t deadline_us);
+
+/**
+ * @brief Keeps the core out of Stop (nested)
+ * @details For work the automatic checks can't see, e.g. a driver waiting
+ * on a peripheral that needs its bus clock.
+ */
+void POWER_stop_lock(void);
+
+/**
+ * @brief Releases one POWER_stop_lock()
+ */
+void POWER_stop_unlock(void);
+
+/**
+ * @brief Copies the statistics (run time computed up to now)
+ */
+void POWER_get_stats(PowerStats* stats);
+
+/**
+ * @brief Prints time per mode, wakeups per source and Stop exit latency over USART2
+ */
+void POWER_report(void);
+
+#endif
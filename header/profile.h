@@ -0,0 +1,121 @@
+/*
+* filename: profile.h
+* purpose: DWT cycle-counter profiling of ISRs and marked code regions
+* author: Connor Ockerse
+* date: 10/19/2026
+* note: Uses the Cortex-M4 DWT CYCCNT (1 count = 1 CPU cycle). Every probe
+* feeds a fixed-bucket histogram (4 buckets per power of two, ~19% wide) with
+* exact min/max/mean, so percentiles are cheap and memory never grows.
+* Build with PROFILE_ENABLE = 0 and every probe compiles to nothing.
+*
+* Usage:
+*   PROFILE_BEGIN(PROFILE_USER_0);
+*   ... code to measure ...
+*   PROFILE_END(PROFILE_USER_0);
+*/
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stm32f446xx.h>
+#include <stdint.h>
+#include "RccConfig.h" // Needed for CLOCK_get_hclk
+
+// === CONFIGURATION ===
+// 1 = probes compiled in, 0 = removed completely
+#ifndef PROFILE_ENABLE
+#define PROFILE_ENABLE 0
+#endif
+
+// Histogram buckets per region (covers durations up to 2^25 cycles)
+#define PROFILE_NUM_BUCKETS 96U
+
+// Profiled ISRs and code regions
+typedef enum {
+    PROFILE_ISR_TIM3,           // Sonar echo capture
+    PROFILE_ISR_TIM5,           // Tickless timebase wrap / wakeup
+    PROFILE_ISR_EXTI15_10,      // Encoder button
+    PROFILE_ISR_DMA,            // Any DMA stream (buzzer refill, CRC feed, ...)
+    PROFILE_TIMERS,             // One SWTIMER_process pass that ran callbacks
+    PROFILE_USER_0,             // Free for ad-hoc measurements
+    PROFILE_USER_1,
+    PROFILE_USER_2,
+    PROFILE_USER_3,
+    PROFILE_NUM_IDS
+}ProfileId;
+
+// Summary of one histogram (all values in CPU cycles)
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint32_t mean;
+    uint32_t p50;
+    uint32_t p90;
+    uint32_t p99;
+}ProfileSummary;
+
+#if PROFILE_ENABLE
+
+/**
+ * @brief Enables the DWT cycle counter and clears all histograms
+ */
+void PROFILE_INIT(void);
+
+/**
+ * @brief Adds one duration sample to a region
+ * @param id: Region or ISR
+ * @param cycles: Measured duration in CPU cycles
+ */
+void PROFILE_record(ProfileId id, uint32_t cycles);
+
+/**
+ * @brief Adds one interrupt latency sample (event to ISR entry)
+ * @param id: ISR
+ * @param cycles: Latency in CPU cycles
+ */
+void PROFILE_record_latency(ProfileId id, uint32_t cycles);
+
+/**
+ * @brief Computes the statistics of one histogram
+ * @param id: Region or ISR
+ * @param latency: 0 = duration histogram, 1 = latency histogram
+ * @param summary: Filled with the result (percentiles are bucket upper bounds)
+ */
+void PROFILE_get_summary(ProfileId id, uint8_t latency, ProfileSummary* summary);
+
+/**
+ * @brief Clears all histograms
+ */
+void PROFILE_reset(void);
+
+/**
+ * @brief Prints every non-empty histogram over USART2
+ */
+void PROFILE_dump(void);
+
+// Current cycle count
+#define PROFILE_cycles() (DWT->CYCCNT)
+
+// Scoped probe: BEGIN and END must be in the same block
+#define PROFILE_BEGIN(id) uint32_t profile_start_##id = PROFILE_cycles()
+#define PROFILE_END(id)   PROFILE_record((id), PROFILE_cycles() - profile_start_##id)
+
+// Latency from a 1 MHz timer: ticks elapsed since the hardware event
+#define PROFILE_LATENCY_US_TICKS(id, ticks) \
+    PROFILE_record_latency((id), (uint32_t)(ticks) * (CLOCK_get_hclk() / 1000000U))
+
+#else
+
+#define PROFILE_INIT()                          ((void)0)
+#define PROFILE_record(id, cycles)              ((void)0)
+#define PROFILE_record_latency(id, cycles)      ((void)0)
+#define PROFILE_reset()                         ((void)0)
+#define PROFILE_dump()                          ((void)0)
+#define PROFILE_BEGIN(id)                       ((void)0)
+#define PROFILE_END(id)                         ((void)0)
+#define PROFILE_LATENCY_US_TICKS(id, ticks)     ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,81 @@
+/*
+* filename: ring.h
+* purpose: Wait-free single-producer/single-consumer ring buffer (header only)
+* author: Connor Ockerse
+* date: 10/19/2026
+* note: For handing samples from one ISR to thread code (or the reverse)
+* without masking interrupts. Only the producer writes head, only the
+* consumer writes tail, so neither side ever waits or retries:
+*
+*   RING_DEFINE(echo_ring, SonarEcho, 8);       // file scope, size 2^n
+*
+*   RING_push(&echo_ring, echo);                // producer (e.g. the ISR)
+*   while (RING_pop(&echo_ring, echo)) {...}    // consumer (thread)
+*
+* A full ring drops the new element and counts it in overflows, which only
+* the producer writes. head and tail are free-running 32-bit counts (the
+* mask picks the slot), so full and empty need no spare slot.
+* One producer and one consumer per ring: two ISRs pushing into the same ring
+* need a lock (see TRACE_record for that case).
+*/
+
+#ifndef RING_H
+#define RING_H
+
+#include <stm32f446xx.h>
+#include <stdint.h>
+#include "staticassert.h"
+
+#define RING_IS_POW2(size) (((size) != 0U) && (((size) & ((size) - 1U)) == 0U))
+
+/**
+ * @brief Defines a static ring of size elements of type (file scope)
+ * @details size must be a power of two, checked at build time.
+ */
+#define RING_DEFINE(name, type, size)                                       \
+    STATIC_ASSERT(RING_IS_POW2(size), #name ": size must be a power of two"); \
+    static struct {                                                         \
+        type slot[size];                                                    \
+        volatile uint32_t head;         /* Next slot to fill (producer) */  \
+        volatile uint32_t tail;         /* Next slot to read (consumer) */  \
+        volatile uint32_t overflows;    /* Pushes dropped on a full ring */ \
+    } name
+
+#define RING_SIZE(ring)     ((uint32_t)(sizeof((ring)->slot) / sizeof((ring)->slot[0])))
+#define RING_MASK(ring)     (RING_SIZE(ring) - 1U)
+
+// Elements waiting (either side; may be stale by the time it is used)
+#define RING_count(ring)    ((uint32_t)((ring)->head - (ring)->tail))
+#define RING_empty(ring)    (RING_count(ring) == 0U)
+#define RING_full(ring)     (RING_count(ring) >= RING_SIZE(ring))
+
+/**
+ * @brief Producer: queues a copy of value
+ * @details The element is written before head moves (DMB), so the consumer
+ * never sees a half-written slot.
+ * @return 1 if queued, 0 if the ring was full (counted in overflows)
+ */
+#define RING_push(ring, value)                                              \
+    (RING_full(ring)                                                        \
+        ? ((ring)->overflows++, 0U)                                         \
+        : ((ring)->slot[(ring)->head & RING_MASK(ring)] = (value),          \
+           __DMB(), (ring)->head++, 1U))
+
+/**
+ * @brief Consumer: takes the oldest element into out (an lvalue)
+ * @details The slot is read before tail moves (DMB), so the producer can't
+ * overwrite it while it is copied.
+ * @return 1 if out was written, 0 if the ring was empty
+ */
+#define RING_pop(ring, out)                                                 \
+    (RING_empty(ring)                                                       \
+        ? 0U                                                                \
+        : (__DMB(), (out) = (ring)->slot[(ring)->tail & RING_MASK(ring)],   \
+           __DMB(), (ring)->tail++, 1U))
+
+/**
+ * @brief Consumer: drops everything queued (the overflow count stays)
+ */
+#define RING_flush(ring)    ((void)((ring)->tail = (ring)->head))
+
+#endif
@@ -0,0 +1,100 @@
+/*
+* filename: seqlock.h
+* purpose: Sequence-lock snapshot of a value written by one ISR (header only)
+* author: Connor Ockerse
+* date: 10/19/2026
+* note: For "latest value" data wider than one word (a 64-bit timestamp with
+* a reading, say) that an ISR updates and thread code reads. The writer never
+* waits; a reader that raced a write copies again:
+*
+*   SEQLOCK_DEFINE(latest, SonarEcho);          // file scope
+*
+*   SEQLOCK_write(&latest, echo);               // writer (the ISR)
+*   SEQLOCK_read(&latest, echo);                // reader (thread)
+*
+* The sequence is odd while a write is in progress and moves by 2 per write,
+* so (sequence / 2) also counts the writes. Readers must not be able to
+* preempt the writer (thread reading an ISR's data is fine; an ISR reading
+* data a lower priority one writes would spin forever).
+*/
+
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stm32f446xx.h>
+#include <stdint.h>
+
+typedef struct {
+    volatile uint32_t sequence;     // Odd = write in progress
+}SeqLock;
+
+/**
+ * @brief Defines a static snapshot holding one value of type (file scope)
+ */
+#define SEQLOCK_DEFINE(name, type)                                          \
+    static struct {                                                         \
+        SeqLock lock;                                                       \
+        type value;                                                         \
+    } name
+
+/**
+ * @brief Writer: marks the start of an update
+ */
+static inline void SEQLOCK_write_begin(SeqLock* lock) {
+    lock->sequence++;
+    __DMB();    // Odd sequence visible before the data changes
+}
+
+/**
+ * @brief Writer: marks the end of an update
+ */
+static inline void SEQLOCK_write_end(SeqLock* lock) {
+    __DMB();    // Data complete before the sequence is even again
+    lock->sequence++;
+}
+
+/**
+ * @brief Reader: sequence to hand to SEQLOCK_read_retry() after copying
+ */
+static inline uint32_t SEQLOCK_read_begin(const SeqLock* lock) {
+    uint32_t sequence = lock->sequence;
+    __DMB();
+    return sequence;
+}
+
+/**
+ * @brief Reader: checks whether the copy just taken may be torn
+ * @param start: Value returned by SEQLOCK_read_begin()
+ * @return 1 if a write ran (or was running) during the copy, 0 if it is good
+ */
+static inline uint8_t SEQLOCK_read_retry(const SeqLock* lock, uint32_t start) {
+    __DMB();
+    return ((start & 1U) || (lock->sequence != start)) ? 1U : 0U;
+}
+
+/**
+ * @brief Writer: stores a copy of value
+ */
+#define SEQLOCK_write(snap, val) do {                                       \
+    SEQLOCK_write_begin(&(snap)->lock);                                     \
+    (snap)->value = (val);                                                  \
+    SEQLOCK_write_end(&(snap)->lock);                                       \
+} while (0)
+
+/**
+ * @brief Reader: copies a consistent value into out (an lvalue)
+ */
+#define SEQLOCK_read(snap, out) do {                                        \
+    uint32_t seqlock_start_;                                                \
+    do {                                                                    \
+        seqlock_start_ = SEQLOCK_read_begin(&(snap)->lock);                 \
+        (out) = (snap)->value;                                              \
+    } while (SEQLOCK_read_retry(&(snap)->lock, seqlock_start_));            \
+} while (0)
+
+/**
+ * @brief Number of writes so far (wraps at 2^31)
+ */
+#define SEQLOCK_writes(snap)    ((snap)->lock.sequence >> 1)
+
+#endif
@@ -14,10 +14,21 @@
 #include <stm32f446xx.h>
 #include <stdint.h>
 
+// Echoes queued for SONAR_read_echo() (power of two; one every 50 ms)
+#define SONAR_RING_SIZE 8U
+
+// One measured echo
+typedef struct {
+    uint64_t time_us;   // Falling edge on the timebase
+    uint16_t width_us;  // Echo pulse width (58 us per cm)
+}SonarEcho;
+
 /**
  * @brief Initializes TIM3 for Sonar (PWM Trig + Input Capture Echo)
- * @details Configures PB4 as PWM Output, PB5 as Capture Input
- * Uses CLOCK_FREQUENCY to automatically set 1us timer tick.
+ * @details Configures CH1 (PB4) as PWM Output, CH2 (PB5) as Capture Input;
+ * the pins themselves are set up by BOARD_INIT (board.h)
+ * Sets a 1us timer tick from the APB1 timer clock and keeps it across
+ * CLOCK_set_profile() changes.
  */
 void SONAR_INIT(void);
 
@@ -27,4 +38,33 @@ void SONAR_INIT(void);
  */
 uint16_t SONAR_get_distance(void);
 
+/**
+ * @brief Copies the most recent echo (never torn, see seqlock.h)
+ * @return 1 if an echo has been measured yet, 0 if not (echo zeroed)
+ */
+uint8_t SONAR_get_latest(SonarEcho* echo);
+
+/**
+ * @brief Takes the oldest echo not read yet
+ * @details Single consumer. Echoes that arrive while SONAR_RING_SIZE are
+ * waiting are dropped and counted by SONAR_get_overflows().
+ * @return 1 if echo was written, 0 if none is waiting
+ */
+uint8_t SONAR_read_echo(SonarEcho* echo);
+
+/**
+ * @brief Takes every queued echo as a spike-filtered distance
+ * @details Median-of-3 over the echo stream (dsp.h), so a single stray echo
+ * never shows up; each output is one echo late. Uses the same queue as
+ * SONAR_read_echo(), so use one or the other.
+ * @param cm: Room for SONAR_RING_SIZE distances in centimeters
+ * @return Distances written (one per echo taken)
+ */
+uint32_t SONAR_read_filtered(uint16_t* cm);
+
+/**
+ * @brief Echoes dropped because the queue was full
+ */
+uint32_t SONAR_get_overflows(void);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,142 @@
+/*
+* filename: spinwait.h
+* purpose: Instrumented busy-wait primitive with per-site accounting and timeouts
+* author: Connor Ockerse
+* date: 10/19/2026
+* note: Every hardware polling loop in the drivers goes through SPIN_WHILE so
+* we know where the CPU burns time. Each wait site records how often it ran,
+* how many polls it took and how many cycles (DWT CYCCNT) it cost.
+* SPIN_report() ranks the sites by total cycles.
+*
+* Usage (replaces "while(cond);"):
+*   SPIN_WHILE(SPIN_USART_TXE, !(USART2->SR & (1 << 7)));
+*   SPIN_WHILE_OR(SPIN_I2C_START, !(I2C1->SR1 & 1), return 0);
+*/
+
+#ifndef SPINWAIT_H
+#define SPINWAIT_H
+
+#include <stm32f446xx.h>
+#include <stdint.h>
+
+// === CONFIGURATION ===
+// 1 = account every wait, 0 = no stats (the timeouts stay: I2C relies on them)
+#ifndef SPIN_ACCOUNTING
+#define SPIN_ACCOUNTING 1
+#endif
+
+// Every polling loop in the tree
+typedef enum {
+    SPIN_RCC_HSE,           // SysClockConfig: HSE ready
+    SPIN_RCC_PLL,           // SysClockConfig: PLL lock
+    SPIN_RCC_SWS,           // SysClockConfig: PLL selected as SYSCLK
+    SPIN_RCC_PLL_OFF,       // CLOCK_set_profile: PLL stopped
+    SPIN_PWR_OD,            // CLOCK_set_profile: over-drive ready
+    SPIN_PWR_ODSW,          // CLOCK_set_profile: over-drive switched in
+    SPIN_I2C_BUSY,          // I2C.c: bus busy
+    SPIN_I2C_START,         // I2C.c: START sent (SB)
+    SPIN_I2C_ADDR,          // I2C.c: address ACKed (ADDR)
+    SPIN_I2C_TXE,           // I2C.c: data register empty
+    SPIN_I2C_BTF,           // I2C.c: byte transfer finished
+    SPIN_I2C_RXNE,          // I2C.c: byte received
+    SPIN_I2C_RECOVER,       // I2C.c: half SCL period of a bus recovery
+    SPIN_USART_TXE,         // usart.c: transmit register empty
+    SPIN_USART_TC,          // usart.c: last frame sent (before a reclock)
+    SPIN_ADC_EOC,           // photoresistor.c: conversion done
+    SPIN_IWDG_SR,           // watchdog.c: PR/RLR update done
+    SPIN_DMA_DISABLE,       // buzzer.c: DMA stream disabled
+    SPIN_RCC_LSI,           // power.c: LSI ready (RTC clock)
+    SPIN_RTC_INIT,          // power.c: RTC init mode entered
+    SPIN_RTC_WUTWF,         // power.c: RTC wakeup timer writable
+    SPIN_POWER_DRAIN,       // power.c: USART2 frame / I2C STOP done before Stop
+    SPIN_LSI_CAPTURE,       // power.c: LSI edge captured on TIM5_CH4 (calibration)
+    SPIN_FLASH_BSY,         // config.c: flash program/erase done
+    SPIN_CRC_DMA,           // crc.c: DMA feed done (CRC_wait)
+    SPIN_NUM_SITES
+}SpinSite;
+
+// Accumulated cost of one wait site
+typedef struct {
+    uint32_t calls;         // Number of waits
+    uint32_t spins;         // Total loop iterations (condition polls)
+    uint64_t cycles;        // Total CPU cycles spent waiting
+    uint32_t max_cycles;    // Longest single wait
+    uint32_t timeouts;      // Waits abandoned because of the timeout
+}SpinStats;
+
+// State of one wait in progress (lives on the caller's stack)
+typedef struct {
+    SpinSite site;
+    uint32_t start;
+    uint32_t spins;
+    uint8_t timed_out;
+}SpinProbe;
+
+#if SPIN_ACCOUNTING
+
+/**
+ * @brief Waits while cond is true, runs on_timeout if the site's budget ran out
+ * @details The condition is polled exactly as in a plain while loop. An
+ * interrupt longer than the budget between a poll and the budget check
+ * (another bus served from an ISR, say) would look like a timeout, so cond
+ * gets one last poll before the wait gives up.
+ */
+#define SPIN_WHILE_OR(site, cond, on_timeout)                   \
+    do {                                                        \
+        SpinProbe spin_probe_;                                  \
+        SPIN_begin(&spin_probe_, (site));                       \
+        while ((cond) && SPIN_continue(&spin_probe_)) {}        \
+        if (spin_probe_.timed_out && !(cond)) {                 \
+            spin_probe_.timed_out = 0;                          \
+        }                                                       \
+        if (SPIN_end(&spin_probe_)) { on_timeout; }             \
+    } while (0)
+
+#else
+
+// Deadline only: a cycle count read per poll, nothing recorded
+#define SPIN_WHILE_OR(site, cond, on_timeout)                   \
+    do {                                                        \
+        uint32_t spin_start_ = SPIN_now();                      \
+        uint8_t spin_expired_ = 0;                              \
+        while ((cond) && !(spin_expired_ = SPIN_expired((site), spin_start_))) {} \
+        if (spin_expired_ && (cond)) { on_timeout; }            \
+    } while (0)
+
+#endif
+
+/**
+ * @brief Waits while cond is true (gives up silently on timeout)
+ */
+#define SPIN_WHILE(site, cond) SPIN_WHILE_OR(site, cond, (void)0)
+
+/**
+ * @brief Sets the timeout of a wait site
+ * @param site: Wait site
+ * @param cycles: Budget in CPU cycles, 0 = wait forever (default)
+ */
+void SPIN_set_timeout(SpinSite site, uint32_t cycles);
+
+/**
+ * @brief Copies the statistics of one wait site
+ */
+void SPIN_get_stats(SpinSite site, SpinStats* stats);
+
+/**
+ * @brief Clears the statistics of every wait site
+ */
+void SPIN_reset(void);
+
+/**
+ * @brief Prints the wait sites ranked by total cycles over USART2
+ */
+void SPIN_report(void);
+
+// === USED BY THE MACROS ONLY ===
+void SPIN_begin(SpinProbe* probe, SpinSite site);
+uint8_t SPIN_continue(SpinProbe* probe);
+uint8_t SPIN_end(SpinProbe* probe);
+uint32_t SPIN_now(void);
+uint8_t SPIN_expired(SpinSite site, uint32_t start);
+
+#endif
@@ -0,0 +1,20 @@
+/*
+* filename: staticassert.h
+* purpose: Build-time assertion usable from both the firmware and the simulator
+* author: Connor Ockerse
+* date: 10/19/2026
+* note: Firmware builds as C11 (_Static_assert), the host simulator compiles
+* the same sources as C++ (static_assert). Use STATIC_ASSERT at file or block
+* scope; msg is a string literal shown when cond is false.
+*/
+
+#ifndef STATICASSERT_H
+#define STATICASSERT_H
+
+#ifdef __cplusplus
+#define STATIC_ASSERT(cond, msg) static_assert(cond, msg)
+#else
+#define STATIC_ASSERT(cond, msg) _Static_assert(cond, msg)
+#endif
+
+#endif
@@ -0,0 +1,132 @@
+/*
+* filename: stats.h
+* purpose: Incremental min/max/mean/stddev of sensor streams over 1 s, 1 min and 1 h
+* author: Connor Ockerse
+* date: 10/19/2026
+* note: Each stream keeps a fixed amount of state whatever the sample rate:
+*
+*   second: Welford accumulator of the samples since the last full second
+*           (count, mean and sum of squared deviations in fixed point, plus
+*           min and max), O(1) per sample
+*   minute: the last STATS_SLOTS closed seconds in a ring. Every second the
+*           oldest one leaves and the new one joins the window aggregate
+*           (Chan's merge and its inverse); min and max come from two
+*           monotonic deques over the ring, so nothing is ever rescanned
+*   hour:   the same over the last STATS_SLOTS closed minutes. A minute is
+*           rolled up from the minute window each time its ring wraps.
+*
+* Removing a slot from the aggregate rounds a little, so the aggregate is
+* rebuilt from its ring every time the ring wraps (STATS_SLOTS merges once
+* per STATS_SLOTS rolls), which also makes each rolled-up minute exact.
+*
+* Means and deviations are Q8 fixed point (value * 256). Samples are clamped
+* to +-32767 and sums stay in range up to ~1 kHz per stream.
+*
+*   static StatsStream light_stats;
+*   STATS_register(&light_stats, "light");      // after STATS_INIT()
+*   STATS_add(&light_stats, PHOTO_read());      // thread code
+*/
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stm32f446xx.h>
+#include <stdint.h>
+
+// === CONFIGURATION ===
+// Sub-windows per window: 60 seconds in a minute, 60 minutes in an hour
+#define STATS_SLOTS 60U
+
+// Length of the finest window
+#define STATS_SECOND_MS 1000U
+
+// Largest sample magnitude kept (larger ones are clamped)
+#define STATS_SAMPLE_LIMIT 32767
+
+typedef enum {
+    STATS_WINDOW_SECOND,    // Last closed second
+    STATS_WINDOW_MINUTE,    // Last STATS_SLOTS closed seconds
+    STATS_WINDOW_HOUR,      // Last STATS_SLOTS closed minutes
+    STATS_NUM_WINDOWS
+}StatsWindow;
+
+// Running aggregate (Welford / Chan)
+typedef struct {
+    uint32_t count;
+    int32_t min;
+    int32_t max;
+    int32_t mean_q8;        // Mean * 256
+    int64_t m2_q8;          // Sum of squared deviations * 256
+}StatsAcc;
+
+// Monotonic deque of ring slots (front = oldest kept)
+typedef struct {
+    uint8_t slot[STATS_SLOTS];
+    uint8_t head;
+    uint8_t len;
+}StatsDeque;
+
+// One sliding window over STATS_SLOTS closed sub-windows
+typedef struct {
+    StatsAcc slot[STATS_SLOTS];
+    StatsAcc window;        // Aggregate of every slot in the ring
+    StatsDeque min_q;       // Increasing minima
+    StatsDeque max_q;       // Decreasing maxima
+    uint8_t next;           // Slot the next sub-window goes to
+    uint8_t used;
+}StatsLevel;
+
+typedef struct StatsStream {
+    const char* name;
+    StatsAcc second;        // Open second
+    StatsAcc last_second;
+    StatsLevel minute;
+    StatsLevel hour;
+    struct StatsStream* next;
+}StatsStream;
+
+// What STATS_get() returns
+typedef struct {
+    uint32_t count;
+    int32_t min;
+    int32_t max;
+    int32_t mean_q8;
+    uint32_t stddev_q8;     // Population standard deviation * 256
+}StatsSummary;
+
+/**
+ * @brief Starts the 1 s roll timer (needs the software timers running)
+ */
+void STATS_INIT(void);
+
+/**
+ * @brief Clears a stream and adds it to the roll
+ * @param stream: Caller-owned state (static)
+ * @param name: Shown by STATS_report() (kept by pointer)
+ */
+void STATS_register(StatsStream* stream, const char* name);
+
+/**
+ * @brief Adds one sample to the open second (O(1), thread code only)
+ */
+void STATS_add(StatsStream* stream, int32_t sample);
+
+/**
+ * @brief Closes the open second of every stream and rolls the windows
+ * @details Called by the STATS_INIT() timer; exposed for callers that keep
+ * their own time.
+ */
+void STATS_roll(void);
+
+/**
+ * @brief Summary of a window
+ * @return 1 if it holds samples, 0 if it is empty (summary zeroed)
+ */
+uint8_t STATS_get(const StatsStream* stream, StatsWindow window, StatsSummary* summary);
+
+/**
+ * @brief Prints every window of every stream over USART2
+ */
+void STATS_report(void);
+
+#endif
@@ -22,13 +22,13 @@
 #define STEP4 0b1001
 
 /**
- * @brief Initializes GPIO Port B Pins 0-3 as Outputs.
+ * @brief Turns every coil off (PB0-PB3 are made outputs by BOARD_INIT).
  */
 void STEPPER_INIT(void);
 
 /**
  * @brief Sets a target for the motor to move towards.
- * @details This function returns INSTANTLY. It just sets variables.
+ * @details This function returns INSTANTLY. It arms a periodic software timer.
  * @param steps: How many steps to take
  * @param direction: STEP_CW or STEP_CCW
  * @param delay_ms: Speed (ms between steps)
@@ -36,12 +36,34 @@ void STEPPER_INIT(void);
 void STEPPER_set_target(uint32_t steps, uint8_t direction, uint32_t delay_ms);
 
 /**
- * @brief The "Worker" function. Call this constantly in your main while(1) loop.
- * @details Checks the time. If enough time has passed, it takes ONE step.
+ * @brief Reports if the motor is still moving.
+ * @details Steps are paced by a software timer (swtimer.h) and taken by the
+ * event loop. This also services due timers so legacy polling loops work.
  * @return 1 if motor is moving, 0 if idle/finished.
  */
 uint8_t STEPPER_update(void);
 
+/**
+ * @brief Abandons the move and turns every coil off.
+ * @details Safe from an interrupt (e.g. on power failure): the position
+ * stays the one of the last step taken.
+ */
+void STEPPER_stop(void);
+
+/**
+ * @brief Reads the motor position.
+ * @return Steps taken from home (CW positive, CCW negative)
+ */
+int32_t STEPPER_get_position(void);
+
+/**
+ * @brief Sets the motor position (e.g. restored after a power loss).
+ * @details Also lines the coil sequence up with it, so the next step
+ * continues from the pattern the motor stopped on.
+ * @param steps: Steps from home
+ */
+void STEPPER_set_position(int32_t steps);
+
 /**
  * @brief simulates the movement of wagging by moving stepper motor back and forth
  */
@@ -11,9 +11,14 @@
 #include <stm32f446xx.h>
 #include <stdint.h>
 
+// TIM2 tick rate: a 1 kHz tick needs PSC > 65535 once the APB1 timers run at
+// 90 MHz, so the counter runs at 2 kHz and STOPWATCH_read() halves it
+#define STOPWATCH_TICK_HZ 2000U
+
 /**
- * @brief Initializes TIM2 as a free-running 32-bit millisecond counter.
- * @details Uses CLOCK_FREQUENCY to set 1 tick = 1 millisecond.
+ * @brief Initializes TIM2 as a free-running 32-bit counter.
+ * @details Sets STOPWATCH_TICK_HZ from the APB1 timer clock and keeps it
+ * across CLOCK_set_profile() changes.
  */
 void STOPWATCH_INIT(void);
 
@@ -24,7 +29,7 @@ void STOPWATCH_start(void);
 
 /**
  * @brief Reads the current elapsed time in milliseconds.
- * @return Time in ms (0 to ~4.2 billion ms / ~49 days)
+ * @return Time in ms (0 to ~2.1 billion ms / ~24 days)
  */
 uint32_t STOPWATCH_read(void);
 
@@ -33,4 +38,22 @@ uint32_t STOPWATCH_read(void);
  */
 void STOPWATCH_stop(void);
 
+/**
+ * @brief Continues counting from the current time (no reset).
+ */
+void STOPWATCH_resume(void);
+
+/**
+ * @brief Reports if the stopwatch is counting.
+ * @return 1 if running, 0 if stopped
+ */
+uint8_t STOPWATCH_is_running(void);
+
+/**
+ * @brief Loads the elapsed time (e.g. restored after a power loss).
+ * @details Running or stopped stays as it was.
+ * @param ms: Elapsed time in ms
+ */
+void STOPWATCH_set(uint32_t ms);
+
 #endif
\ No newline at end of file
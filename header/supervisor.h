@@ -0,0 +1,148 @@
+/*
+* filename: supervisor.h
+* purpose: Main loop latency supervisor on the window and independent watchdogs
+* author: Connor Ockerse
+* date: 10/19/2026
+* note: The IWDG (watchdog.h) only catches a dead loop after WDT_TIMEOUT_MS.
+* The supervisor catches a slow one:
+*
+*   Loop:  EVENTLOOP_poll() marks every pass (the timer callbacks it runs).
+*          Pass times go into a power-of-two histogram for percentiles and
+*          the worst case. The WWDG is refreshed after each pass, and from
+*          its own early wakeup interrupt only while a pass is running for
+*          less than SUPERVISOR_LOOP_BUDGET_MS (the WWDG timeout is
+*          shorter). POWER_idle() ends every Sleep in time for the next pass
+*          to refresh it. If the interrupt finds a pass over budget, or no
+*          pass at all (a hang in an ISR or between passes), it writes a
+*          snapshot to backup SRAM and lets the WWDG reset the chip one
+*          count (< 1 ms) later.
+*   Tasks: Each registered task calls SUPERVISOR_checkin() once per
+*          iteration of its own work. The IWDG is kicked every
+*          SUPERVISOR_KICK_MS only while every task checked in within its
+*          budget; the first miss also leaves a snapshot.
+*
+* The snapshot survives the reset (backup SRAM keeps its contents as long
+* as VDD or VBAT is there) and SUPERVISOR_INIT() of the next boot picks it
+* up. The WWDG is frozen in Stop mode, so Stop needs no special care. It
+* starts with the first pass: work that blocks before EVENTLOOP_run() is
+* not timed, but once the loop runs nothing may block outside it for longer
+* than the WWDG timeout.
+*
+* Call SUPERVISOR_INIT() after BOOT_INIT(); it takes over WDT_kick().
+*/
+
+#ifndef SUPERVISOR_H
+#define SUPERVISOR_H
+
+#include <stm32f446xx.h>
+#include <stdint.h>
+
+// === CONFIGURATION ===
+// Longest allowed event loop pass (callbacks without going back to sleep)
+#define SUPERVISOR_LOOP_BUDGET_MS 100U
+
+// How often the IWDG is kicked (well inside WDT_TIMEOUT_MS)
+#define SUPERVISOR_KICK_MS 1000U
+
+// Registered tasks at most
+#define SUPERVISOR_MAX_TASKS 8U
+
+// Pass time histogram: bucket i holds [2^(i-1), 2^i) us, the last one the rest
+#define SUPERVISOR_HIST_BUCKETS 24U
+
+// Marks a valid snapshot in backup SRAM ("SUPV")
+#define SUPERVISOR_SNAPSHOT_MAGIC 0x53555056U
+
+// Returned by SUPERVISOR_register() when the table is full
+#define SUPERVISOR_NO_TASK 0xFFU
+
+// Why a snapshot was taken
+typedef enum {
+    SUPERVISOR_MISS_LOOP,   // An event loop pass ran over budget (WWDG reset follows)
+    SUPERVISOR_MISS_TASK,   // A task missed its check-in (IWDG kicks stop)
+    SUPERVISOR_MISS_STALL,  // No pass for a WWDG timeout (WWDG reset follows)
+    SUPERVISOR_NUM_MISSES
+}SupervisorMiss;
+
+// What the chip looked like at the miss (kept in backup SRAM)
+typedef struct {
+    uint32_t magic;                             // SUPERVISOR_SNAPSHOT_MAGIC
+    uint32_t reason;                            // SupervisorMiss
+    uint32_t task;                              // Late task, SUPERVISOR_NO_TASK for the loop
+    uint32_t time_ms;                           // Timebase at the miss
+    uint32_t pass_us;                           // Age of the running pass (MISS_STALL: since the last one)
+    uint32_t worst_pass_us;                     // Worst finished pass before it
+    uint32_t passes;                            // Finished passes before it
+    uint32_t sysclk_hz;
+    uint32_t task_age_ms[SUPERVISOR_MAX_TASKS]; // Since each task's last check-in
+}SupervisorSnapshot;
+
+// Event loop pass times since SUPERVISOR_INIT()
+typedef struct {
+    uint32_t passes;
+    uint32_t worst_us;
+    uint32_t p50_us;        // Percentiles are bucket upper bounds (2^n - 1 us)
+    uint32_t p90_us;
+    uint32_t p99_us;
+}SupervisorStats;
+
+/**
+ * @brief Starts the WWDG, the IWDG kick timer and reads the last snapshot
+ * @details Needs the WWDG and backup SRAM clocks from BOARD_INIT() and the
+ * IWDG running (BOOT_INIT()). The WWDG can't be stopped afterwards.
+ */
+void SUPERVISOR_INIT(void);
+
+/**
+ * @brief Adds a task that must check in at least every budget_ms
+ * @details Its first deadline counts from now.
+ * @param name: Shown by SUPERVISOR_report() (kept by pointer)
+ * @param budget_ms: Longest allowed time between two check-ins
+ * @return Task handle for SUPERVISOR_checkin(), SUPERVISOR_NO_TASK if full
+ */
+uint8_t SUPERVISOR_register(const char* name, uint32_t budget_ms);
+
+/**
+ * @brief Marks one iteration of a task as done
+ * @param task: Handle from SUPERVISOR_register()
+ */
+void SUPERVISOR_checkin(uint8_t task);
+
+/**
+ * @brief Start of an event loop pass (called by EVENTLOOP_poll())
+ * @details Nests: only the outermost pass is timed.
+ */
+void SUPERVISOR_pass_begin(void);
+
+/**
+ * @brief End of an event loop pass (called by EVENTLOOP_poll())
+ * @details Records the pass time and refreshes the WWDG.
+ */
+void SUPERVISOR_pass_end(void);
+
+/**
+ * @brief Checks every task against its budget
+ * @return 1 if all checked in on time, 0 otherwise
+ */
+uint8_t SUPERVISOR_healthy(void);
+
+/**
+ * @brief Computes the pass time statistics
+ */
+void SUPERVISOR_get_stats(SupervisorStats* stats);
+
+/**
+ * @brief Snapshot the previous boot left in backup SRAM
+ * @return 1 if there was one (copied to snapshot), 0 otherwise
+ */
+uint8_t SUPERVISOR_get_snapshot(SupervisorSnapshot* snapshot);
+
+/**
+ * @brief Prints pass times, task check-ins and the last snapshot over USART2
+ * @details Blocks for the whole text (~0.3 s at 9600 baud), longer than
+ * the WWDG timeout and the pass budget: call it before the event loop's
+ * first pass starts the WWDG, not from the loop.
+ */
+void SUPERVISOR_report(void);
+
+#endif
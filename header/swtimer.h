@@ -0,0 +1,74 @@
+/*
+* filename: swtimer.h
+* purpose: Hashed timer wheel for one-shot and periodic software timers
+* author: Connor Ockerse
+* date: 10/19/2026
+* note: Runs on the timebase milliseconds (see timebase.h). Timers are hashed
+* into SWTIMER_WHEEL_SLOTS buckets by their deadline, so start and cancel are
+* O(1). Callbacks run in thread context from SWTIMER_process(), which the
+* event loop (eventloop.h) calls for you.
+*/
+
+#ifndef SWTIMER_H
+#define SWTIMER_H
+
+#include <stm32f446xx.h>
+#include <stdint.h>
+
+// Number of wheel buckets (must be a power of two)
+// One revolution = 64 ms, longer timers just wait extra revolutions
+#define SWTIMER_WHEEL_SLOTS 64U
+
+typedef void (*SWTimerCallback)(void* arg);
+
+// Timer object: owned by the caller (usually static), never copied once started
+typedef struct SWTimer {
+    struct SWTimer* next;       // Bucket list links (private)
+    struct SWTimer* prev;
+    uint64_t expiry_ms;         // Absolute deadline on the monotonic timebase
+    uint32_t period_ms;         // 0 = one-shot
+    SWTimerCallback callback;
+    void* arg;
+    uint8_t active;
+}SWTimer;
+
+/**
+ * @brief Starts (or restarts) a software timer
+ * @details O(1). Safe to call from ISRs and from timer callbacks.
+ * @param timer: Timer object to arm
+ * @param delay_ms: Time until the first expiry (0 = next processing pass)
+ * @param period_ms: Repeat period, 0 for a one-shot timer
+ * @param callback: Function to run when the timer expires
+ * @param arg: Passed to the callback unchanged
+ */
+void SWTIMER_start(SWTimer* timer, uint32_t delay_ms, uint32_t period_ms,
+                   SWTimerCallback callback, void* arg);
+
+/**
+ * @brief Stops a timer if it is running
+ * @details O(1). Safe to call from ISRs and from timer callbacks.
+ */
+void SWTIMER_cancel(SWTimer* timer);
+
+/**
+ * @brief Checks if a timer is armed
+ * @return 1 if the timer will still fire, 0 otherwise
+ */
+uint8_t SWTIMER_is_active(SWTimer* timer);
+
+/**
+ * @brief Runs the callbacks of every timer that is due
+ * @details Thread context only. Re-entrant calls (from a callback) return 0.
+ * @return Number of callbacks that ran
+ */
+uint32_t SWTIMER_process(void);
+
+/**
+ * @brief Finds the earliest pending deadline
+ * @details O(number of active timers). Meant for idle/sleep decisions only.
+ * @param deadline_ms: Filled with the earliest deadline if one exists
+ * @return 1 if any timer is active, 0 if the wheel is empty
+ */
+uint8_t SWTIMER_next_deadline(uint64_t* deadline_ms);
+
+#endif
@@ -0,0 +1,71 @@
+/*
+* filename: timebase.h
+* purpose: Monotonic 64-bit microsecond timebase (tickless, on TIM5)
+* author: Connor Ockerse
+* date: 10/19/2026
+* note: Unlike TIM6_get_count(), this time can never be reset, so elapsed-time
+* math on it is always valid. TIM6_INIT() starts it.
+*
+* TIM5 (32-bit, APB1) free-runs at 1 MHz and only interrupts when it wraps
+* (every ~71 minutes) or when a wakeup deadline armed with
+* TIMEBASE_set_wakeup() is reached. TIM2 stays free for the stopwatch.
+* The counter keeps going while the ISRs are held off (a flash erase, masked
+* interrupts), so no time is lost to them.
+*
+* There used to be a ticked option counting 1 ms TIM6 interrupts. Ticks due
+* while the ISR could not run collapsed into one, and the 16-bit basic TIM6
+* can't carry a longer stall itself, so it was removed.
+*/
+
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <stm32f446xx.h>
+#include <stdint.h>
+
+/**
+ * @brief Starts the free-running TIM5 counter
+ * @details Called by TIM6_INIT().
+ */
+void TIMEBASE_INIT(void);
+
+/**
+ * @brief Reads the time since boot in microseconds
+ * @details Lock-free and wrap-safe. Safe to call from thread or ISR context,
+ * including from ISRs of higher priority than the timer and with interrupts
+ * masked (a pending, not yet serviced overflow is accounted for).
+ * @return Monotonic time in microseconds (wraps after ~584,000 years)
+ */
+uint64_t TIMEBASE_now_us(void);
+
+/**
+ * @brief Reads the time since boot in milliseconds
+ * @details Same guarantees as TIMEBASE_now_us().
+ * @return Monotonic time in milliseconds
+ */
+uint64_t TIMEBASE_now_ms(void);
+
+/**
+ * @brief Requests an interrupt (wakeup from WFI) at a given time
+ * @details Arms the TIM5 CC1 compare; a deadline that already passed fires
+ * at once. Only the most recent request is kept.
+ * @param deadline_us: Absolute time on the TIMEBASE_now_us() scale
+ */
+void TIMEBASE_set_wakeup(uint64_t deadline_us);
+
+/**
+ * @brief Sleeps (WFI) until the given time
+ * @details Thread context only. Other interrupts still run while waiting.
+ * @param deadline_us: Absolute time on the TIMEBASE_now_us() scale
+ */
+void TIMEBASE_sleep_until(uint64_t deadline_us);
+
+/**
+ * @brief Adds time the timebase did not see (its timer was stopped)
+ * @details For Stop mode exits, with interrupts masked. Adds the full
+ * amount to TIM5.
+ * @param us: Microseconds to add
+ */
+void TIMEBASE_advance_us(uint64_t us);
+
+#endif
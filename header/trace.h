@@ -0,0 +1,84 @@
+/*
+* filename: trace.h
+* purpose: Capture of raw sensor inputs over USART2 for replay on the host
+* author: Connor Ockerse
+* date: 10/19/2026
+* note: The drivers log what they see from the outside world (echo widths,
+* ADC samples, encoder counts, button edges) with a microsecond timestamp.
+* Records are queued from thread or ISR context and streamed out by a
+* periodic software timer, so the event loop must be running.
+* sim/sim_replay feeds a captured stream back into the same code, and
+* tools/trace.py converts it to and from CSV.
+* Build with TRACE_ENABLE = 0 and every probe compiles to nothing.
+*
+* Stream format (all integers LEB128 varints, 7 bits per byte, LSB first):
+*   "TRC1"                          once, at TRACE_INIT
+*   tag, delta_us, value            per record
+* tag = 0xA0 | TraceSource, delta_us = time since the previous record
+* (or since TRACE_INIT for the first one). Text printed by other code lands
+* between records; readers skip bytes until the next tag.
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stm32f446xx.h>
+#include <stdint.h>
+
+// === CONFIGURATION ===
+// 1 = probes compiled in, 0 = removed completely
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE 0
+#endif
+
+// Records buffered between flushes (power of two)
+#define TRACE_QUEUE_SIZE 64U
+
+// How often the queue is written out
+#define TRACE_FLUSH_MS 20U
+
+// Stream marker and record tag
+#define TRACE_MAGIC "TRC1"
+#define TRACE_TAG 0xA0U
+
+// What a record holds
+typedef enum {
+    TRACE_SONAR,        // Echo pulse width in us (TIM3 capture)
+    TRACE_ADC,          // Photoresistor sample (12-bit)
+    TRACE_ENCODER,      // TIM4 count, logged when it changed
+    TRACE_BUTTON,       // Button level after an edge (0 = pressed)
+    TRACE_DROPPED,      // Records lost to a full queue since the last flush
+    TRACE_NUM_SOURCES
+}TraceSource;
+
+#if TRACE_ENABLE
+
+/**
+ * @brief Sets up USART2, writes the stream marker and starts the periodic flush
+ * @details Call after the timebase (TIM6_INIT).
+ */
+void TRACE_INIT(void);
+
+/**
+ * @brief Queues one timestamped record
+ * @details Safe from ISRs. A full queue drops the record and counts it.
+ * @param source: Which input the value came from
+ * @param value: Raw value as the driver saw it
+ */
+void TRACE_record(TraceSource source, uint32_t value);
+
+/**
+ * @brief Writes every queued record over USART2 (blocking)
+ * @details Thread context only. Called by the flush timer.
+ */
+void TRACE_flush(void);
+
+#else
+
+#define TRACE_INIT()                    ((void)0)
+#define TRACE_record(source, value)     ((void)0)
+#define TRACE_flush()                   ((void)0)
+
+#endif
+
+#endif
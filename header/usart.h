@@ -18,7 +18,8 @@
 /* Function declarations */
 /** * 
  * @brief Initializes USART2 peripheral for serial communication
- * @details Enables GPIOA/USART2 clocks, configures PA2(TX)/PA3(RX), and sets baud rate
+ * @details Sets the baud rate and enables TX. Clocks and PA2 (TX) come
+ * from BOARD_INIT (board.h).
  */
 void USART_INIT(void);
 
@@ -34,4 +35,12 @@ void USART2_write_char(uint8_t ch);
  */
 void USART2_write(char *line);
 
+/**
+ * @brief Sends a telemetry line followed by its CRC-32 as " *XXXXXXXX\r\n"
+ * @details The CRC (crc.h, CRC_bytes()) covers the characters of line
+ * only, so the receiver recomputes it over everything before " *".
+ * @param line: Pointer to the null-terminated line (without line ending)
+ */
+void USART2_write_frame(char *line);
+
 #endif
\ No newline at end of file
@@ -5,6 +5,10 @@
 * date: 11/28/2025
 * * NOTE: The IWDG runs on the 32 kHz LSI clock. 
 * It is independent of the main system PLL.
+* The window watchdog (WWDG_*) runs on PCLK1 / 4096 / 8 instead: its
+* timeout is at most 64 counts (~47 ms at PCLK1 = 45 MHz), it raises an
+* early wakeup interrupt one count before it resets, and it holds its count
+* in Stop mode. supervisor.h uses it for main loop deadlines.
 */
 
 #ifndef WATCHDOG_H
@@ -24,10 +28,62 @@
  */
 void WDT_INIT(void);
 
+/**
+ * @brief First half of WDT_INIT(): starts the LSI and writes PR/RLR
+ * @details Returns without waiting for the ~5 LSI cycles (~160 us) the
+ * values take to reach the watchdog, so other init can run meanwhile. The
+ * watchdog already counts with its reset settings until WDT_wait_ready().
+ */
+void WDT_start(void);
+
+/**
+ * @brief Second half of WDT_INIT(): waits for PR/RLR to apply, then kicks
+ */
+void WDT_wait_ready(void);
+
 /**
  * @brief "Kicks" the dog (Reloads the counter).
  * @details Call this frequently in main loop to prevent system reset.
  */
 void WDT_kick(void);
 
+// === WINDOW WATCHDOG ===
+// WDGTB: counter clock = PCLK1 / 4096 / 2^WWDG_PRESCALER_SHIFT
+#define WWDG_PRESCALER_SHIFT 3U
+
+// Counts between a refresh and the reset (T = 0x3F + counts, 0x40 = early warning)
+#define WWDG_MAX_COUNTS 64U
+
+/**
+ * @brief Starts the window watchdog with the early wakeup interrupt on
+ * @details Cannot be stopped again (only a reset does). The timeout is
+ * rounded down to whole counts and recomputed after CLOCK_set_profile().
+ * WWDG_IRQHandler() must refresh it or let the reset happen. It keeps
+ * counting in Sleep (power.h wakes the loop in time to refresh it).
+ * @param timeout_us: Time from a refresh to the reset
+ */
+void WWDG_start(uint32_t timeout_us);
+
+/**
+ * @brief Reloads the window watchdog counter (ISR safe)
+ */
+void WWDG_refresh(void);
+
+/**
+ * @brief Clears the early wakeup flag (call from WWDG_IRQHandler)
+ */
+void WWDG_clear_warning(void);
+
+/**
+ * @brief Timeout actually in use, after rounding to whole counts
+ * @return Microseconds from a refresh to the reset, 0 if not started
+ */
+uint32_t WWDG_get_timeout_us(void);
+
+/**
+ * @brief Time left before the early wakeup interrupt, from the live count
+ * @return Microseconds (the current count counts whole), 0 if not started
+ */
+uint32_t WWDG_get_remaining_us(void);
+
 #endif
\ No newline at end of file
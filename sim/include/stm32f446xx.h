@@ -0,0 +1,337 @@
+/*
+* filename: stm32f446xx.h (host simulator version)
+* purpose: Drop-in replacement for the device header used by the host build
+* author: Connor Ockerse
+* date: 10/19/2026
+* note: Only used by sim/Makefile. The driver sources are compiled unchanged
+* as C++ so every register field can be a SimReg: a 32-bit cell whose reads
+* and writes are routed to a behavioral model (sim/sim_periph.cpp etc.) and
+* cost simulated CPU time. Register layouts and names follow CMSIS, so
+* offsets and bit positions are the real ones.
+*/
+
+#ifndef STM32F446XX_H
+#define STM32F446XX_H
+
+#ifndef __cplusplus
+#error "The simulator device header must be compiled as C++ (see sim/Makefile)"
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+// === REGISTER CELL ===
+
+struct SimReg;
+uint32_t SIM_reg_read(SimReg* reg);
+void SIM_reg_write(SimReg* reg, uint32_t value);
+
+// One 32-bit memory-mapped register. "value" is the raw storage that the
+// models use directly; the operators are the CPU's view and have side effects.
+struct SimReg {
+    uint32_t value;
+
+    operator uint32_t() { return SIM_reg_read(this); }
+    SimReg& operator=(uint32_t v) { SIM_reg_write(this, v); return *this; }
+    SimReg& operator=(SimReg& other) { SIM_reg_write(this, SIM_reg_read(&other)); return *this; }
+    SimReg& operator|=(uint32_t v) { SIM_reg_write(this, SIM_reg_read(this) | v); return *this; }
+    SimReg& operator&=(uint32_t v) { SIM_reg_write(this, SIM_reg_read(this) & v); return *this; }
+    SimReg& operator^=(uint32_t v) { SIM_reg_write(this, SIM_reg_read(this) ^ v); return *this; }
+    SimReg& operator+=(uint32_t v) { SIM_reg_write(this, SIM_reg_read(this) + v); return *this; }
+};
+
+#define __IO
+#define __I
+#define __O
+
+// === INTERRUPT NUMBERS ===
+
+typedef enum {
+    WWDG_IRQn               = 0,
+    PVD_IRQn                = 1,
+    TAMP_STAMP_IRQn         = 2,
+    RTC_WKUP_IRQn           = 3,
+    FLASH_IRQn              = 4,
+    RCC_IRQn                = 5,
+    EXTI0_IRQn              = 6,
+    EXTI1_IRQn              = 7,
+    EXTI2_IRQn              = 8,
+    EXTI3_IRQn              = 9,
+    EXTI4_IRQn              = 10,
+    DMA1_Stream0_IRQn       = 11,
+    DMA1_Stream1_IRQn       = 12,
+    DMA1_Stream2_IRQn       = 13,
+    DMA1_Stream3_IRQn       = 14,
+    DMA1_Stream4_IRQn       = 15,
+    DMA1_Stream5_IRQn       = 16,
+    DMA1_Stream6_IRQn       = 17,
+    ADC_IRQn                = 18,
+    EXTI9_5_IRQn            = 23,
+    TIM1_BRK_TIM9_IRQn      = 24,
+    TIM1_UP_TIM10_IRQn      = 25,
+    TIM1_TRG_COM_TIM11_IRQn = 26,
+    TIM1_CC_IRQn            = 27,
+    TIM2_IRQn               = 28,
+    TIM3_IRQn               = 29,
+    TIM4_IRQn               = 30,
+    I2C1_EV_IRQn            = 31,
+    I2C1_ER_IRQn            = 32,
+    I2C2_EV_IRQn            = 33,
+    I2C2_ER_IRQn            = 34,
+    USART2_IRQn             = 38,
+    EXTI15_10_IRQn          = 40,
+    RTC_Alarm_IRQn          = 41,
+    DMA1_Stream7_IRQn       = 47,
+    TIM5_IRQn               = 50,
+    TIM6_DAC_IRQn           = 54,
+    TIM7_IRQn               = 55,
+    DMA2_Stream0_IRQn       = 56,
+    DMA2_Stream1_IRQn       = 57,
+    DMA2_Stream2_IRQn       = 58,
+    DMA2_Stream3_IRQn       = 59,
+    DMA2_Stream4_IRQn       = 60,
+    DMA2_Stream5_IRQn       = 68,
+    DMA2_Stream6_IRQn       = 69,
+    DMA2_Stream7_IRQn       = 70,
+    I2C3_EV_IRQn            = 72,
+    I2C3_ER_IRQn            = 73,
+    FPU_IRQn                = 81,
+    SIM_NUM_IRQS            = 97
+} IRQn_Type;
+
+// === PERIPHERAL REGISTER BLOCKS (CMSIS layout) ===
+
+typedef struct {
+    SimReg MODER, OTYPER, OSPEEDR, PUPDR, IDR, ODR, BSRR, LCKR, AFR[2];
+} GPIO_TypeDef;
+
+typedef struct {
+    SimReg CR, PLLCFGR, CFGR, CIR, AHB1RSTR, AHB2RSTR, AHB3RSTR, RESERVED0;
+    SimReg APB1RSTR, APB2RSTR, RESERVED1[2], AHB1ENR, AHB2ENR, AHB3ENR, RESERVED2;
+    SimReg APB1ENR, APB2ENR, RESERVED3[2], AHB1LPENR, AHB2LPENR, AHB3LPENR, RESERVED4;
+    SimReg APB1LPENR, APB2LPENR, RESERVED5[2], BDCR, CSR, RESERVED6[2];
+    SimReg SSCGR, PLLI2SCFGR, PLLSAICFGR, DCKCFGR, CKGATENR, DCKCFGR2;
+} RCC_TypeDef;
+
+typedef struct {
+    SimReg CR, CSR;
+} PWR_TypeDef;
+
+typedef struct {
+    SimReg ACR, KEYR, OPTKEYR, SR, CR, OPTCR;
+} FLASH_TypeDef;
+
+typedef struct {
+    SimReg IMR, EMR, RTSR, FTSR, SWIER, PR;
+} EXTI_TypeDef;
+
+typedef struct {
+    SimReg MEMRMP, PMC, EXTICR[4], RESERVED[2], CMPCR, RESERVED1[2], CFGR;
+} SYSCFG_TypeDef;
+
+typedef struct {
+    SimReg CR1, CR2, SMCR, DIER, SR, EGR, CCMR1, CCMR2, CCER, CNT, PSC, ARR, RCR;
+    SimReg CCR1, CCR2, CCR3, CCR4, BDTR, DCR, DMAR, OR;
+} TIM_TypeDef;
+
+typedef struct {
+    SimReg CR1, CR2, OAR1, OAR2, DR, SR1, SR2, CCR, TRISE, FLTR;
+} I2C_TypeDef;
+
+typedef struct {
+    SimReg SR, DR, BRR, CR1, CR2, CR3, GTPR;
+} USART_TypeDef;
+
+typedef struct {
+    SimReg SR, CR1, CR2, SMPR1, SMPR2, JOFR1, JOFR2, JOFR3, JOFR4, HTR, LTR;
+    SimReg SQR1, SQR2, SQR3, JSQR, JDR1, JDR2, JDR3, JDR4, DR;
+} ADC_TypeDef;
+
+typedef struct {
+    SimReg CSR, CCR, CDR;
+} ADC_Common_TypeDef;
+
+typedef struct {
+    SimReg KR, PR, RLR, SR;
+} IWDG_TypeDef;
+
+typedef struct {
+    SimReg CR, CFR, SR;
+} WWDG_TypeDef;
+
+typedef struct {
+    SimReg TR, DR, CR, ISR, PRER, WUTR, CALIBR, ALRMAR, ALRMBR, WPR, SSR, SHIFTR;
+    SimReg TSTR, TSDR, TSSSR, CALR, TAFCR, ALRMASSR, ALRMBSSR, RESERVED7, BKP0R;
+    SimReg BKP1R, BKP2R, BKP3R, BKP4R, BKP5R, BKP6R, BKP7R, BKP8R, BKP9R;
+    SimReg BKP10R, BKP11R, BKP12R, BKP13R, BKP14R, BKP15R, BKP16R, BKP17R;
+    SimReg BKP18R, BKP19R;
+} RTC_TypeDef;
+
+typedef struct {
+    SimReg CR, NDTR, PAR, M0AR, M1AR, FCR;
+} DMA_Stream_TypeDef;
+
+typedef struct {
+    SimReg LISR, HISR, LIFCR, HIFCR;
+} DMA_TypeDef;
+
+typedef struct {
+    SimReg DR, IDR, CR;
+} CRC_TypeDef;
+
+// Core peripherals
+typedef struct {
+    SimReg CTRL, CYCCNT, CPICNT, EXCCNT, SLEEPCNT, LSUCNT, FOLDCNT, PCSR;
+} DWT_Type;
+
+typedef struct {
+    SimReg DHCSR, DCRSR, DCRDR, DEMCR;
+} CoreDebug_Type;
+
+typedef struct {
+    SimReg CPUID, ICSR, VTOR, AIRCR, SCR, CCR, SHP[12], SHCSR, CFSR, HFSR, DFSR;
+    SimReg MMFAR, BFAR, AFSR;
+} SCB_Type;
+
+typedef struct {
+    SimReg CTRL, LOAD, VAL, CALIB;
+} SysTick_Type;
+
+// === PERIPHERAL INSTANCES ===
+
+extern GPIO_TypeDef sim_GPIOA, sim_GPIOB, sim_GPIOC;
+extern RCC_TypeDef sim_RCC;
+extern PWR_TypeDef sim_PWR;
+extern FLASH_TypeDef sim_FLASH;
+extern EXTI_TypeDef sim_EXTI;
+extern SYSCFG_TypeDef sim_SYSCFG;
+extern TIM_TypeDef sim_TIM1, sim_TIM2, sim_TIM3, sim_TIM4, sim_TIM5, sim_TIM6;
+extern I2C_TypeDef sim_I2C1, sim_I2C2, sim_I2C3;
+extern USART_TypeDef sim_USART2;
+extern ADC_TypeDef sim_ADC1;
+extern ADC_Common_TypeDef sim_ADC123_COMMON;
+extern IWDG_TypeDef sim_IWDG;
+extern WWDG_TypeDef sim_WWDG;
+extern RTC_TypeDef sim_RTC;
+extern DMA_TypeDef sim_DMA1, sim_DMA2;
+extern DMA_Stream_TypeDef sim_DMA1_Stream[8], sim_DMA2_Stream[8];
+extern CRC_TypeDef sim_CRC;
+extern DWT_Type sim_DWT;
+extern CoreDebug_Type sim_CoreDebug;
+extern SCB_Type sim_SCB;
+extern SysTick_Type sim_SysTick;
+
+#define GPIOA           (&sim_GPIOA)
+#define GPIOB           (&sim_GPIOB)
+#define GPIOC           (&sim_GPIOC)
+#define RCC             (&sim_RCC)
+#define PWR             (&sim_PWR)
+#define FLASH           (&sim_FLASH)
+#define EXTI            (&sim_EXTI)
+#define SYSCFG          (&sim_SYSCFG)
+#define TIM1            (&sim_TIM1)
+#define TIM2            (&sim_TIM2)
+#define TIM3            (&sim_TIM3)
+#define TIM4            (&sim_TIM4)
+#define TIM5            (&sim_TIM5)
+#define TIM6            (&sim_TIM6)
+#define I2C1            (&sim_I2C1)
+#define I2C2            (&sim_I2C2)
+#define I2C3            (&sim_I2C3)
+#define USART2          (&sim_USART2)
+#define ADC1            (&sim_ADC1)
+#define ADC123_COMMON   (&sim_ADC123_COMMON)
+#define IWDG            (&sim_IWDG)
+#define WWDG            (&sim_WWDG)
+#define RTC             (&sim_RTC)
+#define DMA1            (&sim_DMA1)
+#define DMA2            (&sim_DMA2)
+#define DMA1_Stream0    (&sim_DMA1_Stream[0])
+#define DMA1_Stream1    (&sim_DMA1_Stream[1])
+#define DMA1_Stream2    (&sim_DMA1_Stream[2])
+#define DMA1_Stream3    (&sim_DMA1_Stream[3])
+#define DMA1_Stream4    (&sim_DMA1_Stream[4])
+#define DMA1_Stream5    (&sim_DMA1_Stream[5])
+#define DMA1_Stream6    (&sim_DMA1_Stream[6])
+#define DMA1_Stream7    (&sim_DMA1_Stream[7])
+#define DMA2_Stream0    (&sim_DMA2_Stream[0])
+#define DMA2_Stream1    (&sim_DMA2_Stream[1])
+#define DMA2_Stream2    (&sim_DMA2_Stream[2])
+#define DMA2_Stream3    (&sim_DMA2_Stream[3])
+#define DMA2_Stream4    (&sim_DMA2_Stream[4])
+#define DMA2_Stream5    (&sim_DMA2_Stream[5])
+#define DMA2_Stream6    (&sim_DMA2_Stream[6])
+#define DMA2_Stream7    (&sim_DMA2_Stream[7])
+#define CRC             (&sim_CRC)
+#define DWT             (&sim_DWT)
+#define CoreDebug       (&sim_CoreDebug)
+#define SCB             (&sim_SCB)
+#define SysTick         (&sim_SysTick)
+
+// Raw memory regions (host arrays; the non-PIE build keeps them below 4 GB)
+extern uint8_t sim_bkpsram[4096];
+#define BKPSRAM_BASE    ((uint32_t)(uintptr_t)sim_bkpsram)
+extern uint8_t sim_flash[0x80000];
+#define FLASH_BASE      ((uint32_t)(uintptr_t)sim_flash)
+
+// === CMSIS CORE FUNCTIONS ===
+
+void NVIC_EnableIRQ(IRQn_Type irq);
+void NVIC_DisableIRQ(IRQn_Type irq);
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority);
+uint32_t NVIC_GetPriority(IRQn_Type irq);
+void NVIC_SetPendingIRQ(IRQn_Type irq);
+void NVIC_ClearPendingIRQ(IRQn_Type irq);
+uint32_t NVIC_GetPendingIRQ(IRQn_Type irq);
+
+void __disable_irq(void);
+void __enable_irq(void);
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t primask);
+uint32_t __get_IPSR(void);
+void __WFI(void);
+void __WFE(void);
+void __SEV(void);
+void __NOP(void);
+// Compiler barriers only, like the CMSIS ones ("memory" clobber); the host
+// runs ISRs synchronously so no hardware fence is needed
+static inline void __DSB(void) { __asm__ volatile("" ::: "memory"); }
+static inline void __ISB(void) { __asm__ volatile("" ::: "memory"); }
+static inline void __DMB(void) { __asm__ volatile("" ::: "memory"); }
+static inline uint32_t __CLZ(uint32_t value) { return value ? (uint32_t)__builtin_clz(value) : 32U; }
+
+// === DSP EXTENSION (CMSIS SIMD intrinsics, bit-exact) ===
+// APSR.GE: set per byte by __SSUB16, read by __SEL
+inline uint32_t sim_apsr_ge = 0;
+
+static inline int32_t sim_lo16(uint32_t x) { return (int16_t)(x & 0xFFFFU); }
+static inline int32_t sim_hi16(uint32_t x) { return (int16_t)(x >> 16); }
+static inline uint32_t sim_pack16(int32_t lo, int32_t hi) {
+    return ((uint32_t)lo & 0xFFFFU) | ((uint32_t)hi << 16);
+}
+
+static inline uint32_t __SADD16(uint32_t x, uint32_t y) {
+    return sim_pack16(sim_lo16(x) + sim_lo16(y), sim_hi16(x) + sim_hi16(y));
+}
+static inline uint32_t __SSUB16(uint32_t x, uint32_t y) {
+    int32_t lo = sim_lo16(x) - sim_lo16(y);
+    int32_t hi = sim_hi16(x) - sim_hi16(y);
+    sim_apsr_ge = ((lo >= 0) ? 0x3U : 0U) | ((hi >= 0) ? 0xCU : 0U);
+    return sim_pack16(lo, hi);
+}
+static inline uint32_t __SEL(uint32_t x, uint32_t y) {
+    uint32_t result = 0;
+    for (uint32_t i = 0; i < 4; i++) {
+        result |= (((sim_apsr_ge >> i) & 1U) ? x : y) & (0xFFU << (8 * i));
+    }
+    return result;
+}
+static inline uint32_t __SMLAD(uint32_t x, uint32_t y, uint32_t acc) {
+    return acc + (uint32_t)(sim_lo16(x) * sim_lo16(y)) + (uint32_t)(sim_hi16(x) * sim_hi16(y));
+}
+static inline int32_t __SSAT(int32_t value, uint32_t bits) {
+    int32_t max = (int32_t)((1U << (bits - 1)) - 1U);
+    return (value > max) ? max : (value < -max - 1) ? (-max - 1) : value;
+}
+
+#endif
@@ -0,0 +1,405 @@
+/*
+* filename: sim.h
+* purpose: Host peripheral simulator: time, events, interrupts and device models
+* author: Connor Ockerse
+* date: 10/19/2026
+* note: The firmware drivers are compiled unchanged against
+* sim/include/stm32f446xx.h. Every register access costs SIM_ACCESS_CYCLES
+* CPU cycles of simulated time; code between accesses is free. Time only
+* moves through register accesses, WFI and SIM_advance(), so runs are fully
+* deterministic.
+*
+* Time unit: 1/5.04 GHz. Every clock this board can produce (8, 16, 45, 84,
+* 90, 168, 180 MHz, 32 kHz LSI, I2C and UART bit rates) divides it exactly,
+* so no rounding drift builds up. 2^64 units is ~116 years.
+*/
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stm32f446xx.h>
+#include <stdint.h>
+#include <functional>
+
+// === TIME ===
+
+typedef uint64_t SimTime;
+
+#define SIM_UNITS_PER_SEC   5040000000ULL
+#define SIM_NS(x)           ((SimTime)(x) * 5040ULL / 1000ULL)
+#define SIM_US(x)           ((SimTime)(x) * 5040ULL)
+#define SIM_MS(x)           ((SimTime)(x) * 5040000ULL)
+#define SIM_SEC(x)          ((SimTime)(x) * SIM_UNITS_PER_SEC)
+
+// CPU cycles charged for each peripheral register access
+#define SIM_ACCESS_CYCLES   2U
+
+/**
+ * @brief Current simulated time
+ */
+SimTime SIM_now(void);
+
+/**
+ * @brief Simulated time in microseconds (for reports)
+ */
+double SIM_now_us(void);
+
+/**
+ * @brief CPU cycles executed since boot (what DWT->CYCCNT counts)
+ */
+uint64_t SIM_cycles(void);
+
+/**
+ * @brief Charges CPU cycles: time moves, due events run, interrupts are taken
+ */
+void SIM_cpu_cycles(uint32_t cycles);
+
+/**
+ * @brief Lets time pass with the CPU idle but awake (runs events and ISRs)
+ */
+void SIM_advance(SimTime duration);
+
+/**
+ * @brief Stops the program (exit code 0) once simulated time reaches the limit
+ * @param limit: Absolute time, 0 = no limit
+ */
+void SIM_set_time_limit(SimTime limit);
+
+/**
+ * @brief Resets simulated time, events, interrupts and every model
+ */
+void SIM_reset(void);
+
+/**
+ * @brief Called instead of exiting when a watchdog resets the chip
+ * @param handler: Gets the reset source (e.g. "IWDG"); null = print and exit(3)
+ */
+void SIM_set_reset_handler(std::function<void(const char*)> handler);
+
+/**
+ * @brief Resets the chip from a model (watchdog expiry etc.)
+ */
+void SIM_system_reset(const char* reason);
+
+// === EVENTS ===
+
+typedef uint64_t SimEventId;
+
+/**
+ * @brief Runs fn when simulated time reaches at (same-time events run in order)
+ * @return Handle for SIM_cancel
+ */
+SimEventId SIM_schedule(SimTime at, std::function<void()> fn);
+
+/**
+ * @brief Cancels a scheduled event (no effect if it already ran)
+ */
+void SIM_cancel(SimEventId id);
+
+// === INTERRUPTS ===
+
+/**
+ * @brief Adds a level source for an interrupt line (line is high if any source is)
+ */
+void SIM_irq_add_source(IRQn_Type irq, std::function<bool()> level);
+
+/**
+ * @brief Takes pending interrupts now if priorities and PRIMASK allow it
+ */
+void SIM_check_interrupts(void);
+
+// === REGISTER MODELS ===
+
+// Behavior of one peripheral register block. The default is plain storage.
+class SimModel {
+public:
+    virtual ~SimModel() {}
+    virtual uint32_t read(SimReg* reg, uint32_t offset) { (void)offset; return reg->value; }
+    virtual void write(SimReg* reg, uint32_t offset, uint32_t value) { (void)offset; reg->value = value; }
+    virtual void reset(void) {}
+};
+
+/**
+ * @brief Attaches a model to a register block
+ * @param name: Short name used in reports (e.g. "I2C1")
+ */
+void SIM_map_block(const char* name, void* base, uint32_t size, SimModel* model);
+
+// Register access counters of one block
+typedef struct {
+    const char* name;
+    uint64_t reads;
+    uint64_t writes;
+} SimBlockStats;
+
+/**
+ * @brief Copies the access counters of every mapped block
+ * @return Number of blocks written to stats (at most max)
+ */
+uint32_t SIM_get_block_stats(SimBlockStats* stats, uint32_t max);
+
+/**
+ * @brief Clears all register access counters
+ */
+void SIM_clear_block_stats(void);
+
+// === CLOCK TREE (from the RCC model) ===
+
+uint32_t SIM_clock_sysclk(void);
+uint32_t SIM_clock_hclk(void);
+uint32_t SIM_clock_pclk1(void);
+uint32_t SIM_clock_pclk2(void);
+uint32_t SIM_clock_timer(TIM_TypeDef* tim);
+
+/**
+ * @brief Duration of n cycles of a clock in simulator units
+ */
+SimTime SIM_clock_period(uint32_t hz, uint64_t cycles);
+
+/**
+ * @brief Sets the LSI rate (a part's own, anywhere in 17-47 kHz)
+ * @details The RTC calendar keeps what it counted so far and continues at
+ * the new rate. Waits already scheduled (RTC wakeup, IWDG expiry) keep their
+ * old length until the firmware re-arms them. Stays across resets.
+ */
+void SIM_set_lsi_hz(uint32_t hz);
+
+// === BOARD I/O ===
+
+/**
+ * @brief Drives an input pin from outside (buttons, alarm lines)
+ * @details Updates IDR and raises the EXTI line if configured for that edge.
+ */
+void SIM_gpio_set_input(GPIO_TypeDef* port, uint8_t pin, uint8_t level);
+
+/**
+ * @brief Level of an output pin (ODR)
+ */
+uint8_t SIM_gpio_get_output(GPIO_TypeDef* port, uint8_t pin);
+
+/**
+ * @brief Rotates the encoder by a number of counts (negative = CCW)
+ */
+void SIM_encoder_turn(int32_t counts);
+
+/**
+ * @brief Sets the analog input of an ADC channel
+ * @param value: 12-bit conversion result (0-4095)
+ */
+void SIM_adc_set(uint8_t channel, uint16_t value);
+
+/**
+ * @brief Everything the firmware printed on USART2 so far
+ */
+const char* SIM_usart_output(void);
+
+/**
+ * @brief Number of bytes in SIM_usart_output (binary output may contain 0)
+ */
+uint32_t SIM_usart_output_length(void);
+
+/**
+ * @brief Clears the captured USART2 output
+ */
+void SIM_usart_clear(void);
+
+/**
+ * @brief Also echo USART2 output to stdout as it is sent
+ */
+void SIM_usart_echo(uint8_t enable);
+
+/**
+ * @brief Sets the supply voltage
+ * @details The PVD compares against it; below 1.7 V the chip resets with
+ * reason "PDR". Every reset brings VDD back to 3.3 V.
+ */
+void SIM_set_vdd_mv(uint32_t mv);
+
+/**
+ * @brief Moves VDD in a straight line to mv over duration (1 us steps)
+ */
+void SIM_vdd_ramp(uint32_t mv, SimTime duration);
+
+/**
+ * @brief When the PVD output last went high (VDD fell below the PVD level)
+ */
+SimTime SIM_pvd_trip_time(void);
+
+// Internal flash activity since start-up (the array survives resets)
+typedef struct {
+    uint64_t words;         // Words programmed
+    uint64_t erases;        // Sectors erased
+    uint64_t errors;        // Writes rejected (locked, PG not set)
+    SimTime worst_stall;    // Longest busy period (fetches and interrupts wait)
+} SimFlashStats;
+
+void SIM_flash_get_stats(SimFlashStats* stats);
+
+// === I2C BUS DEVICES ===
+
+// A slave on a simulated I2C bus
+class SimI2CDevice {
+public:
+    virtual ~SimI2CDevice() {}
+    virtual uint8_t address(void) = 0;          // 7-bit address
+    virtual bool start(bool read) = 0;          // Addressed: return ACK
+    virtual bool write(uint8_t byte) = 0;       // Byte from master: return ACK
+    virtual uint8_t read(void) = 0;             // Byte to master
+    virtual void stop(void) {}
+    virtual void reset(void) {}
+};
+
+/**
+ * @brief Connects a device to the bus of an I2C controller
+ */
+void SIM_i2c_attach(I2C_TypeDef* bus, SimI2CDevice* device);
+
+/**
+ * @brief Detaches every device from a bus
+ */
+void SIM_i2c_detach_all(I2C_TypeDef* bus);
+
+/**
+ * @brief Detaches one device from a bus (to attach it to another)
+ */
+void SIM_i2c_detach(I2C_TypeDef* bus, SimI2CDevice* device);
+
+/**
+ * @brief Controller of a driver bus handle
+ * @param index: 0 = I2C1, 1 = I2C2 (the order of I2CBus), 2 = I2C3 (not wired on this board)
+ */
+I2C_TypeDef* SIM_i2c_bus(uint32_t index);
+
+/**
+ * @brief A slave stuck mid-byte pulls SDA low
+ * @details The bus stays BUSY and no START gets out until SCL (as a GPIO)
+ * has risen clocks times; 0 = it never lets go.
+ */
+void SIM_i2c_hold_sda(I2C_TypeDef* bus, uint32_t clocks);
+
+// Bus traffic counters of one I2C controller
+typedef struct {
+    uint64_t starts;        // START + repeated START conditions
+    uint64_t stops;
+    uint64_t bytes;         // Bytes on the wire including address bytes
+    uint64_t nacks;
+    SimTime busy_time;      // Time between START and STOP
+} SimI2CStats;
+
+void SIM_i2c_get_stats(I2C_TypeDef* bus, SimI2CStats* stats);
+void SIM_i2c_clear_stats(I2C_TypeDef* bus);
+
+// === DEVICE MODELS (sim_devices.cpp) ===
+
+// DS3231 RTC: BCD time registers that keep running, alarms, INT/SQW pin
+class SimDS3231 : public SimI2CDevice {
+public:
+    SimDS3231();
+    uint8_t address(void) { return 0x68; }
+    bool start(bool read);
+    bool write(uint8_t byte);
+    uint8_t read(void);
+    void stop(void);
+    void reset(void);
+
+    // Sets the time (decimal values) and restarts the countdown chain
+    void set_time(uint8_t year, uint8_t month, uint8_t date, uint8_t day,
+                  uint8_t hours, uint8_t minutes, uint8_t seconds);
+    uint8_t reg(uint8_t index);             // Raw register (after catching up)
+    void set_int_pin(GPIO_TypeDef* port, uint8_t pin);
+
+private:
+    void catch_up(void);                    // Apply elapsed whole seconds
+    void tick_second(void);
+    void check_alarms(void);
+    void update_int_pin(void);
+
+    uint8_t regs[0x13];
+    uint8_t buffer[7];                      // Time snapshot taken at START
+    uint8_t pointer;
+    bool first_byte;
+    SimTime last_second;
+    GPIO_TypeDef* int_port;
+    uint8_t int_pin;
+    SimEventId second_event;                // Keeps time moving for the INT pin
+};
+
+// 24C02C EEPROM: 256 bytes, 16-byte page buffer, write cycle with busy NACK;
+// the cells survive SIM_reset()
+class SimEEPROM24C02 : public SimI2CDevice {
+public:
+    SimEEPROM24C02();
+    uint8_t address(void) { return 0x50; }
+    bool start(bool read);
+    bool write(uint8_t byte);
+    uint8_t read(void);
+    void stop(void);
+    void reset(void);
+
+    uint8_t peek(uint8_t addr) { return memory[addr]; }
+    void poke(uint8_t addr, uint8_t value) { memory[addr] = value; }
+    bool busy(void);
+    uint64_t write_cycles(void) { return cycles; }
+
+    SimTime write_cycle_time;               // tWC (default 1.5 ms)
+
+private:
+    uint8_t memory[256];
+    uint8_t page[16];
+    uint16_t page_mask;                     // Bytes loaded in the page buffer
+    uint8_t pointer;
+    bool first_byte;
+    bool writing;
+    SimTime busy_until;
+    uint64_t cycles;
+};
+
+// HC-SR04: answers each TIM3 CH1 trigger pulse with an echo on TIM3 CH2
+class SimHCSR04 {
+public:
+    SimHCSR04();
+    void set_distance_cm(uint32_t cm);      // 0 = no echo (timeout pulse)
+    uint32_t distance_cm(void) { return distance; }
+    void on_trigger(SimTime falling_edge);  // Called by the TIM3 model
+    void reset(void);
+
+    // Optional: the echo width of every ping comes from this instead
+    std::function<uint32_t(void)> next_width_us;
+
+private:
+    uint32_t distance;
+};
+
+SimDS3231* SIM_ds3231(void);
+SimEEPROM24C02* SIM_eeprom(void);
+SimHCSR04* SIM_sonar(void);
+
+/**
+ * @brief Sets the board up: resets everything and attaches the DS3231 and
+ * 24C02C to their buses (I2C1, or I2C2 for the 24C02C with BOARD_I2C2) and
+ * the HC-SR04 to TIM3
+ */
+void SIM_board_init(void);
+
+/**
+ * @brief Power cycle: SIM_board_init() after putting the drivers' RAM back
+ * the way the C startup leaves it (.data reloaded, .bss cleared)
+ * @details SIM_board_init() alone is a reset with RAM kept. Backup SRAM
+ * and the external parts' memories survive both.
+ */
+void SIM_power_on(void);
+
+/**
+ * @brief Calls listener with every item a memory-to-peripheral DMA stream
+ * writes to its peripheral (PSIZE bytes, zero-extended)
+ * @details Only requests the simulator models reach a stream: TIM1_UP on
+ * DMA2 Stream5. Kept across SIM_reset; pass an empty function to remove it.
+ * @param dma DMA1 or DMA2
+ * @param stream 0 to 7
+ */
+void SIM_dma_set_write_listener(DMA_TypeDef* dma, uint8_t stream, std::function<void(uint32_t)> listener);
+
+// Used by the timer model to reach the input capture logic
+void SIM_timer_capture(TIM_TypeDef* tim, uint8_t channel, uint8_t rising);
+
+#endif
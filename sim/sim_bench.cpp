@@ -0,0 +1,276 @@
+/*
+* filename: sim_bench.cpp
+* purpose: Measures what each driver API costs on the simulated board
+* author: Connor Ockerse
+* date: 10/19/2026
+* note: Every case runs once on a quiet board (no write cycle, transfer or
+* STOP still in flight) and prints one CSV row:
+*
+*   api           driver call that was measured
+*   i2c_starts    START + repeated START conditions (all I2C buses)
+*   i2c_stops     STOP conditions = complete transactions
+*   i2c_bytes     bytes on the wire including address bytes
+*   i2c_nacks     bytes the slave did not acknowledge
+*   bus_us        time the I2C buses were busy (START to STOP, summed)
+*   reg_reads     peripheral register reads (every block, DWT included)
+*   reg_writes    peripheral register writes
+*   spin_waits    SPIN_WHILE loops entered
+*   spin_polls    SPIN_WHILE condition polls
+*   cpu_cycles    CPU cycles from call to return
+*   sim_us        simulated time from call to return
+*
+* Nothing depends on the host, so two runs of the same tree print the same
+* bytes. bench_baseline.csv holds the numbers of the committed drivers;
+* "make bench" diffs against it.
+*/
+
+#include "sim.h"
+
+#include <stdio.h>
+
+#include "board.h"
+#include "RccConfig.h"
+#include "TIM6.h"
+#include "timebase.h"
+#include "usart.h"
+#include "I2C.h"
+#include "RTC.h"
+#include "eeprom.h"
+#include "sonar.h"
+#include "photoresistor.h"
+#include "config.h"
+#include "encoder.h"
+#include "stopwatch.h"
+#include "watchdog.h"
+#include "spinwait.h"
+
+// === CASES ===
+// Wrappers give every API the same signature; results go to a sink so the
+// calls can't be dropped.
+
+static volatile uint32_t sink;
+
+static void bench_BOARD_INIT(void)        { BOARD_INIT(); }
+static void bench_SysClockConfig(void)    { SysClockConfig(); }
+static void bench_TIM6_INIT(void)         { TIM6_INIT(); }
+static void bench_USART_INIT(void)        { USART_INIT(); }
+static void bench_I2C_INIT(void)          { I2C_INIT(); }
+
+static void bench_I2C_byteWrite(void)     { I2C_byteWrite(BOARD_RTC_BUS, RTC_ADDRESS, SECOND_ADDRESS, 0x30); }
+static void bench_I2C_byteRead(void) {
+    uint8_t data;
+    I2C_byteRead(BOARD_RTC_BUS, RTC_ADDRESS, SECOND_ADDRESS, &data);
+    sink = data;
+}
+
+static void bench_RTC_read_second(void)   { sink = RTC_read_second(); }
+static void bench_RTC_read_clock(void) {
+    Clock t;
+    RTC_read_clock(&t);
+    sink = t.seconds;
+}
+static void bench_RTC_write_second(void)  { RTC_write_second(15); }
+static void bench_RTC_write_clock(void) {
+    Clock t;
+    t.seconds = 56;
+    t.minutes = 34;
+    t.hours = 12;
+    t.day = 2;
+    t.date = 19;
+    t.month = 10;
+    t.year = 26;
+    RTC_write_clock(&t);
+}
+static void bench_RTC_print_clock(void)   { RTC_print_clock(); }
+
+static void bench_EEPROM_write(void)      { EEPROM_write(EEPROM_ADDRESS, 0x10, 0x5A); }
+static void bench_EEPROM_read_address(void) { sink = EEPROM_read_address(EEPROM_ADDRESS, 0x10); }
+static void bench_EEPROM_is_busy(void)    { sink = EEPROM_is_busy(); }
+static void bench_EEPROM_clear(void)      { EEPROM_clear(EEPROM_ADDRESS); }
+static void bench_EEPROM_write_page(void) {
+    uint8_t page[EEPROM_PAGE_BYTES] = { 0 };
+    EEPROM_write_page(EEPROM_ADDRESS, 0x10, page, EEPROM_PAGE_BYTES);
+}
+static void bench_EEPROM_read_sequential(void) {
+    uint8_t page[EEPROM_PAGE_BYTES];
+    EEPROM_read_sequential(EEPROM_ADDRESS, 0x10, page, EEPROM_PAGE_BYTES);
+    sink = page[0];
+}
+
+static void bench_USART2_write_char(void) { USART2_write_char('x'); }
+static void bench_USART2_write(void)      { USART2_write((char*)"12:34:56 19/10/26\r\n"); }
+
+static void bench_PHOTO_INIT(void)        { PHOTO_INIT(); }
+static void bench_PHOTO_read(void)        { sink = PHOTO_read(); }
+
+static void bench_ENCODER_INIT(void)      { ENCODER_INIT(); }
+static void bench_ENCODER_read(void)      { sink = ENCODER_read(); }
+static void bench_ENCODER_debounce(void)  { sink = ENCODER_debounce(); }
+
+static void bench_STOPWATCH_INIT(void)    { STOPWATCH_INIT(); }
+static void bench_STOPWATCH_start(void)   { STOPWATCH_start(); }
+static void bench_STOPWATCH_read(void)    { sink = STOPWATCH_read(); }
+static void bench_STOPWATCH_stop(void)    { STOPWATCH_stop(); }
+
+static void bench_TIMEBASE_now_us(void)   { sink = (uint32_t)TIMEBASE_now_us(); }
+static void bench_TIM6_get_count(void)    { sink = TIM6_get_count(); }
+static void bench_TIM6_delay(void)        { TIM6_delay(1); }
+static void bench_CLOCK_180MHZ(void)      { CLOCK_set_profile(CLOCK_PROFILE_180MHZ); }
+static void bench_CLOCK_45MHZ(void)       { CLOCK_set_profile(CLOCK_PROFILE_45MHZ); }
+
+static void bench_CONFIG_INIT(void)       { CONFIG_INIT(); }
+static void bench_CONFIG_set(void) {
+    uint32_t value = 0x12345678U;
+    CONFIG_set(0x0001, &value, sizeof(value));
+}
+static void bench_CONFIG_get(void) {
+    uint32_t value = 0;
+    CONFIG_get(0x0001, &value, sizeof(value));
+    sink = value;
+}
+
+// The sonar keeps TIM3 interrupts running, so it goes after everything else
+static void bench_SONAR_INIT(void)        { SONAR_INIT(); }
+static void bench_SONAR_get_distance(void) { sink = SONAR_get_distance(); }
+
+static void bench_WDT_INIT(void)          { WDT_INIT(); }
+static void bench_WDT_kick(void)          { WDT_kick(); }
+
+typedef struct {
+    const char* name;
+    void (*run)(void);
+} BenchCase;
+
+// Run in this order: the INIT cases bring the board up for the rest
+static const BenchCase cases[] = {
+    { "BOARD_INIT",           bench_BOARD_INIT },
+    { "SysClockConfig",       bench_SysClockConfig },
+    { "TIM6_INIT",            bench_TIM6_INIT },
+    { "USART_INIT",           bench_USART_INIT },
+    { "I2C_INIT",             bench_I2C_INIT },
+    { "I2C_byteWrite",        bench_I2C_byteWrite },
+    { "I2C_byteRead",         bench_I2C_byteRead },
+    { "RTC_read_second",      bench_RTC_read_second },
+    { "RTC_read_clock",       bench_RTC_read_clock },
+    { "RTC_write_second",     bench_RTC_write_second },
+    { "RTC_write_clock",      bench_RTC_write_clock },
+    { "RTC_print_clock",      bench_RTC_print_clock },
+    { "EEPROM_write",         bench_EEPROM_write },
+    { "EEPROM_read_address",  bench_EEPROM_read_address },
+    { "EEPROM_is_busy",       bench_EEPROM_is_busy },
+    { "EEPROM_clear",         bench_EEPROM_clear },
+    { "EEPROM_write_page",    bench_EEPROM_write_page },
+    { "EEPROM_read_sequential", bench_EEPROM_read_sequential },
+    { "USART2_write_char",    bench_USART2_write_char },
+    { "USART2_write",         bench_USART2_write },
+    { "PHOTO_INIT",           bench_PHOTO_INIT },
+    { "PHOTO_read",           bench_PHOTO_read },
+    { "ENCODER_INIT",         bench_ENCODER_INIT },
+    { "ENCODER_read",         bench_ENCODER_read },
+    { "ENCODER_debounce",     bench_ENCODER_debounce },
+    { "STOPWATCH_INIT",       bench_STOPWATCH_INIT },
+    { "STOPWATCH_start",      bench_STOPWATCH_start },
+    { "STOPWATCH_read",       bench_STOPWATCH_read },
+    { "STOPWATCH_stop",       bench_STOPWATCH_stop },
+    { "TIMEBASE_now_us",      bench_TIMEBASE_now_us },
+    { "TIM6_get_count",       bench_TIM6_get_count },
+    { "TIM6_delay(1)",        bench_TIM6_delay },
+    { "CLOCK_set_profile(180MHz)", bench_CLOCK_180MHZ },
+    { "CLOCK_set_profile(45MHz)",  bench_CLOCK_45MHZ },
+    { "CONFIG_INIT",          bench_CONFIG_INIT },
+    { "CONFIG_set",           bench_CONFIG_set },
+    { "CONFIG_get",           bench_CONFIG_get },
+    { "SONAR_INIT",           bench_SONAR_INIT },
+    { "SONAR_get_distance",   bench_SONAR_get_distance },
+    { "WDT_INIT",             bench_WDT_INIT },
+    { "WDT_kick",             bench_WDT_kick },
+};
+
+#define BENCH_NUM_CASES (sizeof(cases) / sizeof(cases[0]))
+
+// Long enough for an EEPROM write cycle, a USART frame and a STOP to finish
+#define BENCH_SETTLE SIM_MS(10)
+
+// Upper bound on mapped register blocks
+#define BENCH_MAX_BLOCKS 64U
+
+// === MEASUREMENT ===
+
+typedef struct {
+    uint64_t reads;
+    uint64_t writes;
+} RegisterCount;
+
+static RegisterCount count_registers(void) {
+    SimBlockStats blocks[BENCH_MAX_BLOCKS];
+    uint32_t n = SIM_get_block_stats(blocks, BENCH_MAX_BLOCKS);
+    RegisterCount count = { 0, 0 };
+    for (uint32_t i = 0; i < n; i++) {
+        count.reads += blocks[i].reads;
+        count.writes += blocks[i].writes;
+    }
+    return count;
+}
+
+static void run_case(const BenchCase* bench) {
+    // 1. Start from a quiet board with every counter at zero
+    SIM_advance(BENCH_SETTLE);
+    for (uint32_t i = 0; i < I2C_NUM_BUSES; i++) {
+        SIM_i2c_clear_stats(SIM_i2c_bus(i));
+    }
+    SIM_clear_block_stats();
+    SPIN_reset();
+
+    // 2. Call the API
+    SimTime start_time = SIM_now();
+    uint64_t start_cycles = SIM_cycles();
+    bench->run();
+    SimTime elapsed = SIM_now() - start_time;
+    uint64_t cycles = SIM_cycles() - start_cycles;
+
+    // 3. Register and wait counters cover exactly the call
+    RegisterCount registers = count_registers();
+    uint64_t waits = 0;
+    uint64_t polls = 0;
+    for (int site = 0; site < SPIN_NUM_SITES; site++) {
+        SpinStats stats;
+        SPIN_get_stats((SpinSite)site, &stats);
+        waits += stats.calls;
+        polls += stats.spins;
+    }
+
+    // 4. The final STOP can still be on the wire when the driver returns
+    SIM_advance(BENCH_SETTLE);
+    SimI2CStats bus = SimI2CStats();
+    SimI2CStats one;
+    for (uint32_t i = 0; i < I2C_NUM_BUSES; i++) {
+        SIM_i2c_get_stats(SIM_i2c_bus(i), &one);
+        bus.starts += one.starts;
+        bus.stops += one.stops;
+        bus.bytes += one.bytes;
+        bus.nacks += one.nacks;
+        bus.busy_time += one.busy_time;
+    }
+
+    printf("%s,%lu,%lu,%lu,%lu,%.2f,%lu,%lu,%lu,%lu,%lu,%.2f\n", bench->name,
+           (unsigned long)bus.starts, (unsigned long)bus.stops,
+           (unsigned long)bus.bytes, (unsigned long)bus.nacks,
+           (double)bus.busy_time / (double)SIM_US(1),
+           (unsigned long)registers.reads, (unsigned long)registers.writes,
+           (unsigned long)waits, (unsigned long)polls,
+           (unsigned long)cycles, (double)elapsed / (double)SIM_US(1));
+}
+
+int main(void) {
+    SIM_board_init();
+    SIM_ds3231()->set_time(26, 10, 19, 2, 12, 34, 56);
+    SIM_adc_set(1, 3000);
+    SIM_sonar()->set_distance_cm(42);
+
+    printf("api,i2c_starts,i2c_stops,i2c_bytes,i2c_nacks,bus_us,"
+           "reg_reads,reg_writes,spin_waits,spin_polls,cpu_cycles,sim_us\n");
+    for (uint32_t i = 0; i < BENCH_NUM_CASES; i++) {
+        run_case(&cases[i]);
+    }
+    return 0;
+}
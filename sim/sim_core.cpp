@@ -0,0 +1,581 @@
+/*
+* filename: sim_core.cpp
+* purpose: Simulator kernel: time, event queue, NVIC, register dispatch, CPU intrinsics
+* author: Connor Ockerse
+* date: 10/19/2026
+*/
+
+#include "sim.h"
+#include "sim_internal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <vector>
+
+// === TIME ===
+
+static SimTime now_time = 0;
+static uint64_t cycle_count = 0;
+static SimTime cycle_residue = 0;       // Units not yet worth a whole cycle
+static SimTime time_limit = 0;
+
+static std::function<void(const char*)> reset_handler;
+
+// Moves the clock forward (never back: nested ISRs may already be past t)
+static void set_now(SimTime t) {
+    if (t <= now_time) {
+        return;
+    }
+
+    if (time_limit && (t >= time_limit)) {
+        t = time_limit;
+    }
+
+    SimTime unit = SIM_UNITS_PER_SEC / SIM_clock_hclk();
+    cycle_residue += t - now_time;
+    cycle_count += cycle_residue / unit;
+    cycle_residue %= unit;
+    now_time = t;
+
+    if (time_limit && (now_time >= time_limit)) {
+        fflush(stdout);
+        printf("\nsim: time limit reached at %.3f ms\n", (double)now_time / (double)SIM_MS(1));
+        fflush(stdout);
+        exit(0);
+    }
+}
+
+SimTime SIM_now(void) {
+    return now_time;
+}
+
+double SIM_now_us(void) {
+    return (double)now_time / (double)SIM_US(1);
+}
+
+uint64_t SIM_cycles(void) {
+    return cycle_count;
+}
+
+void SIM_set_time_limit(SimTime limit) {
+    time_limit = limit;
+}
+
+SimTime SIM_clock_period(uint32_t hz, uint64_t cycles) {
+    // Exact for every clock that divides 5.04 GHz, rounded up otherwise
+    return (SimTime)((cycles * SIM_UNITS_PER_SEC + hz - 1) / hz);
+}
+
+void SIM_set_reset_handler(std::function<void(const char*)> handler) {
+    reset_handler = handler;
+}
+
+void SIM_system_reset(const char* reason) {
+    if (reset_handler) {
+        reset_handler(reason);
+        return;
+    }
+    fflush(stdout);
+    fprintf(stderr, "\nsim: system reset (%s) at %.3f ms\n", reason,
+            (double)now_time / (double)SIM_MS(1));
+    exit(3);
+}
+
+// === EVENTS ===
+
+typedef std::pair<SimTime, SimEventId> EventKey;
+
+static std::map<EventKey, std::function<void()> > events;
+static std::map<SimEventId, SimTime> event_times;
+static SimEventId next_event_id = 1;
+
+SimEventId SIM_schedule(SimTime at, std::function<void()> fn) {
+    if (at < now_time) {
+        at = now_time;
+    }
+    SimEventId id = next_event_id++;
+    events[EventKey(at, id)] = fn;
+    event_times[id] = at;
+    return id;
+}
+
+void SIM_cancel(SimEventId id) {
+    std::map<SimEventId, SimTime>::iterator it = event_times.find(id);
+    if (it == event_times.end()) {
+        return;
+    }
+    events.erase(EventKey(it->second, id));
+    event_times.erase(it);
+}
+
+// Runs events up to and including target, taking interrupts after each one
+static void run_until(SimTime target) {
+    while (!events.empty() && (events.begin()->first.first <= target)) {
+        std::map<EventKey, std::function<void()> >::iterator it = events.begin();
+        SimTime at = it->first.first;
+        std::function<void()> fn = it->second;
+        event_times.erase(it->first.second);
+        events.erase(it);
+
+        set_now(at);
+        fn();
+        SIM_check_interrupts();
+    }
+    set_now(target);
+}
+
+void SIM_cpu_cycles(uint32_t cycles) {
+    run_until(now_time + (SimTime)cycles * (SIM_UNITS_PER_SEC / SIM_clock_hclk()));
+    SIM_check_interrupts();
+}
+
+void SIM_advance(SimTime duration) {
+    run_until(now_time + duration);
+    SIM_check_interrupts();
+}
+
+// === INTERRUPTS ===
+
+typedef void (*IrqHandler)(void);
+
+// Firmware handlers (weak: unused ones stay null)
+#define SIM_WEAK __attribute__((weak))
+void WWDG_IRQHandler(void) SIM_WEAK;
+void PVD_IRQHandler(void) SIM_WEAK;
+void RTC_WKUP_IRQHandler(void) SIM_WEAK;
+void FLASH_IRQHandler(void) SIM_WEAK;
+void RCC_IRQHandler(void) SIM_WEAK;
+void EXTI0_IRQHandler(void) SIM_WEAK;
+void EXTI1_IRQHandler(void) SIM_WEAK;
+void EXTI2_IRQHandler(void) SIM_WEAK;
+void EXTI3_IRQHandler(void) SIM_WEAK;
+void EXTI4_IRQHandler(void) SIM_WEAK;
+void DMA1_Stream0_IRQHandler(void) SIM_WEAK;
+void DMA1_Stream1_IRQHandler(void) SIM_WEAK;
+void DMA1_Stream2_IRQHandler(void) SIM_WEAK;
+void DMA1_Stream3_IRQHandler(void) SIM_WEAK;
+void DMA1_Stream4_IRQHandler(void) SIM_WEAK;
+void DMA1_Stream5_IRQHandler(void) SIM_WEAK;
+void DMA1_Stream6_IRQHandler(void) SIM_WEAK;
+void DMA1_Stream7_IRQHandler(void) SIM_WEAK;
+void ADC_IRQHandler(void) SIM_WEAK;
+void EXTI9_5_IRQHandler(void) SIM_WEAK;
+void TIM1_UP_TIM10_IRQHandler(void) SIM_WEAK;
+void TIM1_CC_IRQHandler(void) SIM_WEAK;
+void TIM2_IRQHandler(void) SIM_WEAK;
+void TIM3_IRQHandler(void) SIM_WEAK;
+void TIM4_IRQHandler(void) SIM_WEAK;
+void I2C1_EV_IRQHandler(void) SIM_WEAK;
+void I2C1_ER_IRQHandler(void) SIM_WEAK;
+void I2C2_EV_IRQHandler(void) SIM_WEAK;
+void I2C2_ER_IRQHandler(void) SIM_WEAK;
+void USART2_IRQHandler(void) SIM_WEAK;
+void EXTI15_10_IRQHandler(void) SIM_WEAK;
+void RTC_Alarm_IRQHandler(void) SIM_WEAK;
+void TIM5_IRQHandler(void) SIM_WEAK;
+void TIM6_DAC_IRQHandler(void) SIM_WEAK;
+void TIM7_IRQHandler(void) SIM_WEAK;
+void DMA2_Stream0_IRQHandler(void) SIM_WEAK;
+void DMA2_Stream1_IRQHandler(void) SIM_WEAK;
+void DMA2_Stream2_IRQHandler(void) SIM_WEAK;
+void DMA2_Stream3_IRQHandler(void) SIM_WEAK;
+void DMA2_Stream4_IRQHandler(void) SIM_WEAK;
+void DMA2_Stream5_IRQHandler(void) SIM_WEAK;
+void DMA2_Stream6_IRQHandler(void) SIM_WEAK;
+void DMA2_Stream7_IRQHandler(void) SIM_WEAK;
+void I2C3_EV_IRQHandler(void) SIM_WEAK;
+void I2C3_ER_IRQHandler(void) SIM_WEAK;
+
+static IrqHandler irq_handler(int irq) {
+    switch (irq) {
+        case WWDG_IRQn:               return WWDG_IRQHandler;
+        case PVD_IRQn:                return PVD_IRQHandler;
+        case RTC_WKUP_IRQn:           return RTC_WKUP_IRQHandler;
+        case FLASH_IRQn:              return FLASH_IRQHandler;
+        case RCC_IRQn:                return RCC_IRQHandler;
+        case EXTI0_IRQn:              return EXTI0_IRQHandler;
+        case EXTI1_IRQn:              return EXTI1_IRQHandler;
+        case EXTI2_IRQn:              return EXTI2_IRQHandler;
+        case EXTI3_IRQn:              return EXTI3_IRQHandler;
+        case EXTI4_IRQn:              return EXTI4_IRQHandler;
+        case DMA1_Stream0_IRQn:       return DMA1_Stream0_IRQHandler;
+        case DMA1_Stream1_IRQn:       return DMA1_Stream1_IRQHandler;
+        case DMA1_Stream2_IRQn:       return DMA1_Stream2_IRQHandler;
+        case DMA1_Stream3_IRQn:       return DMA1_Stream3_IRQHandler;
+        case DMA1_Stream4_IRQn:       return DMA1_Stream4_IRQHandler;
+        case DMA1_Stream5_IRQn:       return DMA1_Stream5_IRQHandler;
+        case DMA1_Stream6_IRQn:       return DMA1_Stream6_IRQHandler;
+        case DMA1_Stream7_IRQn:       return DMA1_Stream7_IRQHandler;
+        case ADC_IRQn:                return ADC_IRQHandler;
+        case EXTI9_5_IRQn:            return EXTI9_5_IRQHandler;
+        case TIM1_UP_TIM10_IRQn:      return TIM1_UP_TIM10_IRQHandler;
+        case TIM1_CC_IRQn:            return TIM1_CC_IRQHandler;
+        case TIM2_IRQn:               return TIM2_IRQHandler;
+        case TIM3_IRQn:               return TIM3_IRQHandler;
+        case TIM4_IRQn:               return TIM4_IRQHandler;
+        case I2C1_EV_IRQn:            return I2C1_EV_IRQHandler;
+        case I2C1_ER_IRQn:            return I2C1_ER_IRQHandler;
+        case I2C2_EV_IRQn:            return I2C2_EV_IRQHandler;
+        case I2C2_ER_IRQn:            return I2C2_ER_IRQHandler;
+        case USART2_IRQn:             return USART2_IRQHandler;
+        case EXTI15_10_IRQn:          return EXTI15_10_IRQHandler;
+        case RTC_Alarm_IRQn:          return RTC_Alarm_IRQHandler;
+        case TIM5_IRQn:               return TIM5_IRQHandler;
+        case TIM6_DAC_IRQn:           return TIM6_DAC_IRQHandler;
+        case TIM7_IRQn:               return TIM7_IRQHandler;
+        case DMA2_Stream0_IRQn:       return DMA2_Stream0_IRQHandler;
+        case DMA2_Stream1_IRQn:       return DMA2_Stream1_IRQHandler;
+        case DMA2_Stream2_IRQn:       return DMA2_Stream2_IRQHandler;
+        case DMA2_Stream3_IRQn:       return DMA2_Stream3_IRQHandler;
+        case DMA2_Stream4_IRQn:       return DMA2_Stream4_IRQHandler;
+        case DMA2_Stream5_IRQn:       return DMA2_Stream5_IRQHandler;
+        case DMA2_Stream6_IRQn:       return DMA2_Stream6_IRQHandler;
+        case DMA2_Stream7_IRQn:       return DMA2_Stream7_IRQHandler;
+        case I2C3_EV_IRQn:            return I2C3_EV_IRQHandler;
+        case I2C3_ER_IRQn:            return I2C3_ER_IRQHandler;
+        default:                      return 0;
+    }
+}
+
+typedef struct {
+    bool enabled;
+    bool pending;           // Set by software (NVIC_SetPendingIRQ)
+    bool active;
+    uint32_t priority;
+    std::vector<std::function<bool()> > sources;
+} SimIrq;
+
+static SimIrq irqs[SIM_NUM_IRQS];
+static uint32_t primask = 0;
+static uint32_t ipsr = 0;
+static uint32_t exec_priority = 0x100;      // Thread mode: below every IRQ
+static bool event_register = false;         // WFE/SEV latch
+static uint64_t irq_entries = 0;            // Exceptions taken so far (ends a sleep)
+
+// Exception entry/exit cost (stacking + tail) in CPU cycles
+#define SIM_IRQ_ENTRY_CYCLES 12U
+#define SIM_IRQ_EXIT_CYCLES  10U
+
+void SIM_irq_add_source(IRQn_Type irq, std::function<bool()> level) {
+    irqs[irq].sources.push_back(level);
+}
+
+static bool irq_level(int irq) {
+    if (irqs[irq].pending) {
+        return true;
+    }
+    for (size_t i = 0; i < irqs[irq].sources.size(); i++) {
+        if (irqs[irq].sources[i]()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Highest priority interrupt that could preempt the running code, -1 if none
+static int irq_best(void) {
+    int best = -1;
+    for (int i = 0; i < SIM_NUM_IRQS; i++) {
+        if (!irqs[i].enabled || irqs[i].active || (irqs[i].priority >= exec_priority)) {
+            continue;
+        }
+        if ((best >= 0) && (irqs[i].priority >= irqs[best].priority)) {
+            continue;
+        }
+        if (irq_level(i)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+void SIM_check_interrupts(void) {
+    // Vector fetches wait for a flash program/erase to finish
+    if (sim_flash_stalled()) {
+        return;
+    }
+    while (!primask) {
+        int irq = irq_best();
+        if (irq < 0) {
+            return;
+        }
+
+        IrqHandler handler = irq_handler(irq);
+        if (!handler) {
+            fflush(stdout);
+            fprintf(stderr, "sim: IRQ %d enabled but the firmware has no handler\n", irq);
+            exit(4);
+        }
+
+        uint32_t saved_priority = exec_priority;
+        uint32_t saved_ipsr = ipsr;
+        irqs[irq].active = true;
+        irqs[irq].pending = false;
+        irq_entries++;
+        exec_priority = irqs[irq].priority;
+        ipsr = (uint32_t)irq + 16U;
+
+        run_until(now_time + (SimTime)SIM_IRQ_ENTRY_CYCLES * (SIM_UNITS_PER_SEC / SIM_clock_hclk()));
+        handler();
+        run_until(now_time + (SimTime)SIM_IRQ_EXIT_CYCLES * (SIM_UNITS_PER_SEC / SIM_clock_hclk()));
+
+        irqs[irq].active = false;
+        exec_priority = saved_priority;
+        ipsr = saved_ipsr;
+    }
+}
+
+// WFI wakes on any interrupt that would preempt, even with PRIMASK set
+static bool wake_pending(void) {
+    uint32_t saved = primask;
+    primask = 0;
+    int irq = irq_best();
+    primask = saved;
+    return irq >= 0;
+}
+
+// An interrupt taken while time runs forward also ends the sleep
+static void sleep_until_wakeup(void) {
+    uint64_t entries = irq_entries;
+    while (!wake_pending() && (irq_entries == entries)) {
+        if (events.empty()) {
+            fflush(stdout);
+            fprintf(stderr, "sim: WFI at %.3f ms with nothing left to wake the core\n",
+                    (double)now_time / (double)SIM_MS(1));
+            exit(5);
+        }
+        run_until(events.begin()->first.first);
+    }
+}
+
+// === NVIC / CORE INTRINSICS ===
+
+void NVIC_EnableIRQ(IRQn_Type irq) {
+    SIM_cpu_cycles(SIM_ACCESS_CYCLES);
+    irqs[irq].enabled = true;
+    SIM_check_interrupts();
+}
+
+void NVIC_DisableIRQ(IRQn_Type irq) {
+    SIM_cpu_cycles(SIM_ACCESS_CYCLES);
+    irqs[irq].enabled = false;
+}
+
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority) {
+    SIM_cpu_cycles(SIM_ACCESS_CYCLES);
+    irqs[irq].priority = priority & 0xF;
+}
+
+uint32_t NVIC_GetPriority(IRQn_Type irq) {
+    return irqs[irq].priority;
+}
+
+void NVIC_SetPendingIRQ(IRQn_Type irq) {
+    SIM_cpu_cycles(SIM_ACCESS_CYCLES);
+    irqs[irq].pending = true;
+    SIM_check_interrupts();
+}
+
+void NVIC_ClearPendingIRQ(IRQn_Type irq) {
+    SIM_cpu_cycles(SIM_ACCESS_CYCLES);
+    irqs[irq].pending = false;
+}
+
+uint32_t NVIC_GetPendingIRQ(IRQn_Type irq) {
+    return irq_level(irq) ? 1U : 0U;
+}
+
+void __disable_irq(void) {
+    primask = 1;
+}
+
+void __enable_irq(void) {
+    primask = 0;
+    SIM_check_interrupts();
+}
+
+uint32_t __get_PRIMASK(void) {
+    return primask;
+}
+
+void __set_PRIMASK(uint32_t value) {
+    primask = value & 1U;
+    SIM_check_interrupts();
+}
+
+uint32_t __get_IPSR(void) {
+    return ipsr;
+}
+
+void __NOP(void) {
+    SIM_cpu_cycles(1);
+}
+
+void __WFI(void) {
+    SIM_cpu_cycles(1);
+
+    // SLEEPDEEP without PDDS is Stop mode: clocks off until an EXTI line fires
+    bool stop = (SCB->SCR.value & (1 << 2)) && !(PWR->CR.value & (1 << 1));
+    if (stop) {
+        sim_stop_enter();
+    }
+    sleep_until_wakeup();
+    if (stop) {
+        run_until(now_time + sim_stop_wakeup_time());
+        sim_stop_exit();
+    }
+    SIM_check_interrupts();
+}
+
+void __WFE(void) {
+    SIM_cpu_cycles(1);
+    if (event_register) {
+        event_register = false;
+        return;
+    }
+    sleep_until_wakeup();
+    SIM_check_interrupts();
+}
+
+void __SEV(void) {
+    event_register = true;
+}
+
+// === REGISTER DISPATCH ===
+
+typedef struct {
+    const char* name;
+    uint8_t* base;
+    uint32_t size;
+    SimModel* model;
+    uint64_t reads;
+    uint64_t writes;
+} SimBlock;
+
+static std::vector<SimBlock> blocks;
+static size_t last_block = 0;
+
+void SIM_map_block(const char* name, void* base, uint32_t size, SimModel* model) {
+    SimBlock block = { name, (uint8_t*)base, size, model, 0, 0 };
+    blocks.push_back(block);
+}
+
+static SimBlock* find_block(SimReg* reg) {
+    uint8_t* addr = (uint8_t*)reg;
+
+    if (last_block < blocks.size()) {
+        SimBlock* b = &blocks[last_block];
+        if ((addr >= b->base) && (addr < (b->base + b->size))) {
+            return b;
+        }
+    }
+    for (size_t i = 0; i < blocks.size(); i++) {
+        if ((addr >= blocks[i].base) && (addr < (blocks[i].base + blocks[i].size))) {
+            last_block = i;
+            return &blocks[i];
+        }
+    }
+
+    fflush(stdout);
+    fprintf(stderr, "sim: access to unmapped register %p (SIM_board_init not called?)\n", (void*)reg);
+    exit(6);
+}
+
+uint32_t SIM_reg_read(SimReg* reg) {
+    SIM_cpu_cycles(SIM_ACCESS_CYCLES);
+    SimBlock* b = find_block(reg);
+    b->reads++;
+    return b->model->read(reg, (uint32_t)((uint8_t*)reg - b->base));
+}
+
+void SIM_reg_write(SimReg* reg, uint32_t value) {
+    SIM_cpu_cycles(SIM_ACCESS_CYCLES);
+    SimBlock* b = find_block(reg);
+    b->writes++;
+    b->model->write(reg, (uint32_t)((uint8_t*)reg - b->base), value);
+    SIM_check_interrupts();
+}
+
+// Bus master access (DMA): registers go to their model, anything else is
+// host memory. No CPU cycles and no access counts.
+static SimBlock* find_block_quiet(uint8_t* addr) {
+    for (size_t i = 0; i < blocks.size(); i++) {
+        if ((addr >= blocks[i].base) && (addr < (blocks[i].base + blocks[i].size))) {
+            return &blocks[i];
+        }
+    }
+    return 0;
+}
+
+uint32_t sim_bus_read(uint32_t address, uint32_t size) {
+    uint8_t* addr = (uint8_t*)(uintptr_t)address;
+    SimBlock* b = find_block_quiet(addr);
+    if (b) {
+        return b->model->read((SimReg*)addr, (uint32_t)(addr - b->base));
+    }
+    uint32_t value = 0;
+    memcpy(&value, addr, size);
+    return value;
+}
+
+void sim_bus_write(uint32_t address, uint32_t value, uint32_t size) {
+    uint8_t* addr = (uint8_t*)(uintptr_t)address;
+    SimBlock* b = find_block_quiet(addr);
+    if (b) {
+        b->model->write((SimReg*)addr, (uint32_t)(addr - b->base), value);
+        return;
+    }
+    memcpy(addr, &value, size);
+}
+
+uint32_t SIM_get_block_stats(SimBlockStats* stats, uint32_t max) {
+    uint32_t n = 0;
+    for (size_t i = 0; (i < blocks.size()) && (n < max); i++) {
+        stats[n].name = blocks[i].name;
+        stats[n].reads = blocks[i].reads;
+        stats[n].writes = blocks[i].writes;
+        n++;
+    }
+    return n;
+}
+
+void SIM_clear_block_stats(void) {
+    for (size_t i = 0; i < blocks.size(); i++) {
+        blocks[i].reads = 0;
+        blocks[i].writes = 0;
+    }
+}
+
+// === RESET ===
+
+void SIM_reset(void) {
+    events.clear();
+    event_times.clear();
+    now_time = 0;
+    cycle_count = 0;
+    cycle_residue = 0;
+
+    for (int i = 0; i < SIM_NUM_IRQS; i++) {
+        irqs[i].enabled = false;
+        irqs[i].pending = false;
+        irqs[i].active = false;
+        irqs[i].priority = 0;
+    }
+    primask = 0;
+    ipsr = 0;
+    exec_priority = 0x100;
+    event_register = false;
+
+    // Registers back to zero, then each model applies its reset values
+    for (size_t i = 0; i < blocks.size(); i++) {
+        memset(blocks[i].base, 0, blocks[i].size);
+        blocks[i].reads = 0;
+        blocks[i].writes = 0;
+    }
+    for (size_t i = 0; i < blocks.size(); i++) {
+        blocks[i].model->reset();
+    }
+    sim_devices_reset();
+}
@@ -0,0 +1,879 @@
+/*
+* filename: sim_demo.cpp
+* purpose: Runs the unmodified drivers against the simulated board and prints what they see
+* author: Connor Ockerse
+* date: 10/19/2026
+*/
+
+#include "sim.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "board.h"
+#include "RccConfig.h"
+#include "TIM6.h"
+#include "timebase.h"
+#include "usart.h"
+#include "I2C.h"
+#include "RTC.h"
+#include "eeprom.h"
+#include "sonar.h"
+#include "photoresistor.h"
+#include "encoder.h"
+#include "stopwatch.h"
+#include "watchdog.h"
+#include "swtimer.h"
+#include "eventloop.h"
+#include "power.h"
+#include "supervisor.h"
+#include "crc.h"
+#include "dma.h"
+#include "stats.h"
+#include "dsp.h"
+#include "datalog.h"
+#include "config.h"
+#include "stepper.h"
+#include "brownout.h"
+#include "buzzer.h"
+
+static uint32_t ticks_seen = 0;
+
+static void count_tick(void* arg) {
+    (void)arg;
+    ticks_seen++;
+}
+
+static uint8_t sample_task;
+
+static void sample_tick(void* arg) {
+    (void)arg;
+    PHOTO_read();
+    SUPERVISOR_checkin(sample_task);
+}
+
+static void stall(void* arg) {
+    (void)arg;
+    TIM6_delay(150);                // A callback that hogs the loop
+}
+
+static uint32_t crc_block[256];    // 1 KiB CRC test block
+static volatile uint32_t crc_from_dma = 0;
+
+static void crc_done(uint32_t crc, void* arg) {
+    (void)arg;
+    crc_from_dma = crc;
+}
+
+static uint32_t dma_events[3];
+
+// What the buzzer's stream wrote to TIM1->CCR1
+static uint8_t pcm_clip[600];
+static uint32_t pcm_writes = 0, pcm_bad = 0, pcm_max = 0;
+static double pcm_first_us = 0;
+
+static void check_pcm_write(uint32_t value) {
+    uint32_t expect = (pcm_writes < sizeof(pcm_clip)) ? pcm_clip[pcm_writes] : PCM_SILENCE;
+    if (pcm_writes == 0) {
+        pcm_first_us = SIM_now_us();
+    }
+    pcm_bad += (value != expect);
+    pcm_max = (value > pcm_max) ? value : pcm_max;
+    pcm_writes++;
+}
+
+static void count_dma_event(DmaEvent event, void* arg) {
+    (void)arg;
+    dma_events[event]++;
+}
+
+// Everything appended to the log, to check the dump against
+static DatalogSample logged[400];
+static uint32_t dump_first = 0, dump_count = 0, dump_bad = 0;
+
+static void check_dump(const DatalogSample* sample, void* arg) {
+    (void)arg;
+    const DatalogSample* want = &logged[dump_first + dump_count++];
+    if ((sample->time_s != want->time_s) || (sample->sonar_cm != want->sonar_cm) ||
+        (sample->light != want->light) || (sample->encoder != want->encoder)) {
+        dump_bad++;
+    }
+}
+
+// Sensor streams for the statistics section
+static StatsStream light_stats, distance_stats, speed_stats;
+static uint32_t stats_ticks = 0;
+static uint16_t last_count = 0;
+
+static void stats_sample(void* arg) {
+    (void)arg;
+    // Light ramps up and down, the target drifts, the knob turns faster and slower
+    uint32_t phase = stats_ticks % 200U;
+    SIM_adc_set(1, (uint16_t)(1000U + 10U * ((phase < 100U) ? phase : (200U - phase))));
+    SIM_sonar()->set_distance_cm(80 + (stats_ticks / 10U) % 40U);
+    SIM_encoder_turn((int32_t)(stats_ticks % 7U) - 2);
+    stats_ticks++;
+
+    STATS_add(&light_stats, PHOTO_read());
+    STATS_add(&distance_stats, SONAR_get_distance());
+    uint16_t count = ENCODER_read();
+    STATS_add(&speed_stats, (int16_t)(count - last_count) * 10);   // Counts per second
+    last_count = count;
+    WDT_kick();
+}
+
+// A 1 ms tick keeps the loop waking (a reset can't end a WFI by itself)
+static SWTimer wake;
+
+static void run_loop_ms(uint32_t ms) {
+    uint64_t start_us = TIMEBASE_now_us();
+    SWTIMER_start(&wake, 1, 1, [](void*) {}, 0);
+    while (TIMEBASE_now_us() - start_us < ms * 1000ULL) {
+        EVENTLOOP_poll();
+    }
+    SWTIMER_cancel(&wake);
+}
+
+// Supply runs down from 3.3 V through the PVD level (2.9 V) to the power-down
+// reset (1.7 V), taking BROWNOUT_HOLDUP_US for the last part
+static SimTime power_fail(void) {
+    const char* reason = 0;
+    SWTIMER_start(&wake, 1, 1, [](void*) {}, 0);
+    SIM_set_reset_handler([&](const char* why) { reason = why; });
+    SIM_vdd_ramp(1600, SIM_US(BROWNOUT_HOLDUP_US) * 1700U / 1200U);
+    while (reason == 0) {
+        EVENTLOOP_poll();
+    }
+    SIM_set_reset_handler(0);
+    SWTIMER_cancel(&wake);
+    return SIM_now() - SIM_pvd_trip_time();
+}
+
+// Power back: the chip and the drivers' RAM start over
+static void power_up(void) {
+    SIM_power_on();
+    BOARD_INIT();
+    SysClockConfig();
+    TIM6_INIT();
+    USART_INIT();
+    I2C_INIT();
+    STEPPER_INIT();
+    ENCODER_INIT();
+    STOPWATCH_INIT();
+}
+
+// Moves the 24C02C, model and driver, to another bus (BOARD_I2C2 builds it on I2C2)
+static void move_eeprom(I2CBus bus) {
+    SIM_i2c_detach(SIM_i2c_bus(EEPROM_get_bus()), SIM_eeprom());
+    SIM_i2c_attach(SIM_i2c_bus(bus), SIM_eeprom());
+    I2C_bus_init(bus);
+    EEPROM_set_bus(bus);
+}
+
+static void print_motion(const char* label) {
+    printf("  %-26s stepper %ld, encoder %u, stopwatch %lu ms (%s)\n", label,
+           (long)STEPPER_get_position(), ENCODER_read(), (unsigned long)STOPWATCH_read(),
+           STOPWATCH_is_running() ? "running" : "stopped");
+}
+
+static void print_clock(const char* label) {
+    Clock t;
+    RTC_read_clock(&t);
+    printf("  %-22s %02d:%02d:%02d %02d/%02d/%02d (day %d)\n", label,
+           t.hours, t.minutes, t.seconds, t.date, t.month, t.year, t.day);
+}
+
+int main(void) {
+    SIM_board_init();
+
+    // --- Clocks ---
+    BOARD_INIT();
+    SysClockConfig();
+    printf("clock: SYSCLK %lu Hz after %.1f us (HSE start-up + PLL lock)\n",
+           (unsigned long)SIM_clock_sysclk(), SIM_now_us());
+
+    TIM6_INIT();
+    USART_INIT();
+    I2C_INIT();
+
+    // --- DS3231 ---
+    printf("rtc:\n");
+    SIM_ds3231()->set_time(26, 10, 19, 2, 12, 34, 56);
+    print_clock("set by the model");
+    TIM6_delay(2000);
+    print_clock("2 s later");
+
+    Clock rollover;
+    rollover.seconds = 58;
+    rollover.minutes = 59;
+    rollover.hours = 23;
+    rollover.day = 7;
+    rollover.date = 31;
+    rollover.month = 12;
+    rollover.year = 99;
+    RTC_write_clock(&rollover);
+    print_clock("written by the driver");
+    TIM6_delay(2500);
+    print_clock("year rollover");
+
+    SIM_usart_clear();
+    RTC_print_clock();
+    TIM6_delay(30);                 // Let the last characters leave the shift register
+    printf("  USART2 says: %s", SIM_usart_output());
+
+    // --- 24C02C ---
+    printf("eeprom:\n");
+    uint64_t start_us = TIMEBASE_now_us();
+    for (uint8_t i = 0; i < 16; i++) {
+        EEPROM_write(EEPROM_ADDRESS, i, (uint8_t)(i * 3));
+    }
+    printf("  16 byte writes took %lu us (each waits out the previous write cycle)\n",
+           (unsigned long)(TIMEBASE_now_us() - start_us));
+    TIM6_delay(1);                  // STOP of the last write is on the wire now
+    printf("  1 ms later: chip busy %d (ACK polling would NACK), driver busy %d\n",
+           SIM_eeprom()->busy() ? 1 : 0, EEPROM_is_busy());
+    printf("  read back:");
+    for (uint8_t i = 0; i < 16; i++) {
+        printf(" %u", EEPROM_read_address(EEPROM_ADDRESS, i));
+    }
+    printf("\n  untouched cell 0x80 reads 0x%02X (erased), %lu write cycles\n",
+           EEPROM_read_address(EEPROM_ADDRESS, 0x80), (unsigned long)SIM_eeprom()->write_cycles());
+
+    SimI2CStats i2c;
+    SIM_i2c_get_stats(SIM_i2c_bus(EEPROM_get_bus()), &i2c);
+    printf("  %s so far: %lu STARTs, %lu STOPs, %lu bytes, %lu NACKs, %.1f ms busy\n",
+           I2C_bus_name(EEPROM_get_bus()), (unsigned long)i2c.starts, (unsigned long)i2c.stops, (unsigned long)i2c.bytes,
+           (unsigned long)i2c.nacks, (double)i2c.busy_time / (double)SIM_MS(1));
+
+    // --- CRC ---
+    printf("crc:\n");
+    CRC_INIT();
+    for (uint32_t i = 0; i < 256; i++) {
+        crc_block[i] = i * 0x9E3779B9U;
+    }
+    uint32_t crc_sw = CRC_words_sw(crc_block, 256);     // Free here: only register accesses cost cycles
+    uint64_t unit_cycles = SIM_cycles();
+    uint32_t crc_hw = CRC_words(crc_block, 256);
+    unit_cycles = SIM_cycles() - unit_cycles;
+    uint64_t dma_start = SIM_cycles();
+    CRC_start_dma(crc_block, 256, crc_done, 0);
+    uint64_t dma_cycles = SIM_cycles() - dma_start;
+    CRC_wait();
+    printf("  1 KiB: software %08lX, unit %08lX (%lu cycles), DMA %08lX (%lu cycles to start)\n",
+           (unsigned long)crc_sw, (unsigned long)crc_hw, (unsigned long)unit_cycles,
+           (unsigned long)crc_from_dma, (unsigned long)dma_cycles);
+    const uint8_t* odd = (const uint8_t*)crc_block + 1;
+    printf("  1021 bytes at an odd address: unit %08lX, software %08lX (%s)\n",
+           (unsigned long)CRC_bytes(odd, 1021), (unsigned long)CRC_bytes_sw(odd, 1021),
+           (CRC_bytes(odd, 1021) == CRC_bytes_sw(odd, 1021)) ? "match" : "MISMATCH");
+
+    uint8_t settings[12] = { 'B', 'R', 'I', 'G', 'H', 'T', '=', '7', '5', ';', 0, 1 };
+    uint8_t settings_back[12];
+    EEPROM_write_record(EEPROM_ADDRESS, 0x40, settings, sizeof(settings));
+    uint8_t valid = EEPROM_read_record(EEPROM_ADDRESS, 0x40, settings_back, sizeof(settings_back));
+    EEPROM_write(EEPROM_ADDRESS, 0x43, 'g');     // One flipped cell
+    uint8_t corrupt = EEPROM_read_record(EEPROM_ADDRESS, 0x40, settings_back, sizeof(settings_back));
+    printf("  eeprom record: valid %u, after a flipped byte %u\n", valid, corrupt);
+
+    SIM_usart_clear();
+    USART2_write_frame((char*)"T=21.5,L=3000");
+    TIM6_delay(30);
+    printf("  USART2 frame: %s", SIM_usart_output());
+
+    // --- DMA streams ---
+    printf("dma:\n");
+    uint8_t tim4_ch1 = DMA_alloc(DMA_REQ_TIM4_CH1, "encoder");
+    uint8_t i2c_rx = DMA_alloc(DMA_REQ_I2C1_RX, "eeprom");
+    uint8_t usart_rx = DMA_alloc(DMA_REQ_USART2_RX, "console");
+    printf("  TIM4_CH1 -> stream %u, I2C1_RX -> %u (S0 taken), USART2_RX -> %s\n", tim4_ch1,
+           i2c_rx, (usart_rx == DMA_NO_STREAM) ? "none (its only stream is taken)" : "?");
+    uint8_t copier = DMA_alloc(DMA_REQ_MEM_TO_MEM, "demo");
+    static uint32_t copy[256];
+    DmaConfig copy_cfg;
+    DMA_config_init(&copy_cfg, DMA_DIR_MEM_TO_MEM);
+    copy_cfg.peripheral = (uint32_t)(uintptr_t)crc_block;
+    copy_cfg.memory0 = copy;
+    copy_cfg.count = 256;
+    copy_cfg.periph_size = 4;
+    copy_cfg.memory_size = 4;
+    copy_cfg.callback = count_dma_event;
+    copy_cfg.half_event = 1;
+    DMA_start(copier, &copy_cfg);
+    while (DMA_is_busy(copier)) {
+        TIM6_delay(1);
+    }
+    printf("  1 KiB copy on stream %u: %u half, %u done, CRC %s\n", copier,
+           (unsigned)dma_events[DMA_EVENT_HALF], (unsigned)dma_events[DMA_EVENT_DONE],
+           (CRC_words(copy, 256) == crc_hw) ? "matches" : "DIFFERS");
+    SIM_usart_clear();
+    DMA_report();
+    TIM6_delay(60);
+    printf("%s", SIM_usart_output());
+    DMA_free(tim4_ch1);
+    DMA_free(i2c_rx);
+    DMA_free(copier);
+
+    // PCM clip through the double-buffered TIM1_UP stream
+    BUZZER_INIT();
+    for (uint32_t i = 0; i < sizeof(pcm_clip); i++) {
+        pcm_clip[i] = (uint8_t)(i * 7);
+    }
+    SIM_dma_set_write_listener(DMA2, 5, check_pcm_write);
+    double pcm_start_us = SIM_now_us();
+    BUZZER_pcm_play(pcm_clip, sizeof(pcm_clip), 8000);
+    while (BUZZER_pcm_is_playing() && SIM_now_us() - pcm_start_us < 200000) {
+        TIM6_delay(1);
+    }
+    SIM_dma_set_write_listener(DMA2, 5, std::function<void(uint32_t)>());
+    printf("  PCM 600 samples @ 8 kHz: %lu CCR1 writes (3 chunks), %lu wrong, max %lu, "
+           "first after %.1f us (one sample 125 us)\n",
+           (unsigned long)pcm_writes, (unsigned long)pcm_bad, (unsigned long)pcm_max,
+           pcm_first_us - pcm_start_us);
+
+    // --- Compressed EEPROM log ---
+    printf("datalog:\n");
+    DATALOG_clear();                                // First use of the region
+    DATALOG_INIT();
+    uint64_t worst_append_us = 0;
+    for (uint32_t i = 0; i < 400; i++) {
+        // 1 Hz: light drifts, the target moves now and then, the knob turns sometimes
+        DatalogSample* s = &logged[i];
+        s->time_s = 1000000U + i + ((i >= 250U) ? 60U : 0U);      // A 1 min gap
+        s->light = (uint16_t)(2000 + (i % 64U) * 3U - ((i / 64U) % 2U) * 100U);
+        s->sonar_cm = (uint16_t)(120 + ((i / 40U) % 3U) * 15U);
+        s->encoder = (uint16_t)(i / 25U);
+        uint64_t t0 = TIMEBASE_now_us();
+        DATALOG_append(s);
+        uint64_t took = TIMEBASE_now_us() - t0;
+        worst_append_us = (took > worst_append_us) ? took : worst_append_us;
+    }
+    DatalogStats log_stats;
+    DATALOG_get_stats(&log_stats);
+    uint32_t held = DATALOG_dump(check_dump, 0);    // Counts first
+    dump_first = 400U - held;
+    dump_count = dump_bad = 0;
+    DATALOG_dump(check_dump, 0);
+    printf("  400 samples: %lu page writes, worst append %lu us; last %lu held in %u bytes "
+           "(%u as plain records), %lu wrong\n",
+           (unsigned long)log_stats.page_writes, (unsigned long)worst_append_us, (unsigned long)held,
+           (unsigned)(DATALOG_NUM_PAGES * EEPROM_PAGE_BYTES),
+           (unsigned)((DATALOG_NUM_PAGES * EEPROM_PAGE_BYTES) / DATALOG_RAW_BYTES),
+           (unsigned long)dump_bad);
+    SIM_usart_clear();
+    DATALOG_report();
+    TIM6_delay(20);
+    printf("  %s", SIM_usart_output());
+    DATALOG_flush();
+    DATALOG_INIT();                                 // As after a reset
+    dump_count = dump_bad = 0;
+    uint32_t after_init = DATALOG_dump(check_dump, 0);
+    printf("  after flush + DATALOG_INIT: %lu samples read back, %lu wrong\n",
+           (unsigned long)after_init, (unsigned long)dump_bad);
+
+    // --- Settings in internal flash ---
+    printf("config:\n");
+    uint32_t legacy = 1500;                         // Written by an older firmware
+    EEPROM_write_record(EEPROM_ADDRESS, 0x20, (const uint8_t*)&legacy, sizeof(legacy));
+    CONFIG_INIT();
+    CONFIG_mirror(0x0010, 0x20, sizeof(legacy));
+    uint32_t threshold = 0;
+    CONFIG_get(0x0010, &threshold, sizeof(threshold));
+    printf("  key 0x0010 imported from the EEPROM: %lu\n", (unsigned long)threshold);
+    uint16_t steps = 200;
+    threshold = 1800;
+    CONFIG_set(0x0001, "robot-7", 8);
+    CONFIG_set(0x0002, &steps, sizeof(steps));
+    CONFIG_set(0x0010, &threshold, sizeof(threshold));
+    ConfigStats cfg;
+    CONFIG_get_stats(&cfg);
+    CONFIG_set(0x0002, &steps, sizeof(steps));      // Unchanged: no write
+    ConfigStats cfg_again;
+    CONFIG_get_stats(&cfg_again);
+    uint32_t eeprom_copy = 0;
+    EEPROM_read_record(EEPROM_ADDRESS, 0x20, (uint8_t*)&eeprom_copy, sizeof(eeprom_copy));
+    SimFlashStats flash;
+    SIM_flash_get_stats(&flash);
+    printf("  3 sets: %lu words, worst stall %lu us (flash busy %.1f us, budget %u us, %lu over); "
+           "same value again: %lu words; EEPROM copy %lu\n",
+           (unsigned long)cfg.words, (unsigned long)cfg.worst_stall_us,
+           (double)flash.worst_stall / (double)SIM_US(1), (unsigned)CONFIG_FLASH_BUDGET_US,
+           (unsigned long)cfg.over_budget, (unsigned long)(cfg_again.words - cfg.words),
+           (unsigned long)eeprom_copy);
+    uint64_t cfg_start = SIM_cycles();
+    char name[8] = {0};
+    CONFIG_get(0x0001, name, sizeof(name));
+    printf("  CONFIG_get: %lu cycles\n", (unsigned long)(SIM_cycles() - cfg_start));
+    CONFIG_INIT();                                  // As after a reset
+    steps = 0;
+    threshold = 0;
+    memset(name, 0, sizeof(name));
+    CONFIG_get(0x0001, name, sizeof(name));
+    CONFIG_get(0x0002, &steps, sizeof(steps));
+    CONFIG_get(0x0010, &threshold, sizeof(threshold));
+    printf("  after CONFIG_INIT: name %s, steps %u, threshold %lu\n", name, (unsigned)steps,
+           (unsigned long)threshold);
+    uint32_t sets = 0;
+    ConfigStatus cfg_status = CONFIG_OK;
+    for (uint32_t i = 0; (cfg_status == CONFIG_OK) && (i < 40000U); i++) {
+        cfg_status = CONFIG_set(0x0003, &i, sizeof(i));
+        sets += (cfg_status == CONFIG_OK);
+    }
+    CONFIG_get_stats(&cfg);
+    CONFIG_get(0x0002, &steps, sizeof(steps));
+    printf("  %lu sets of a counter: %lu compaction, then %s (spare not erased); steps still %u\n",
+           (unsigned long)sets, (unsigned long)cfg.compactions,
+           (cfg_status == CONFIG_ERR_FULL) ? "CONFIG_ERR_FULL" : "?", (unsigned)steps);
+    uint8_t refused = CONFIG_maintain(CONFIG_FLASH_BUDGET_US);
+    uint64_t erase_start = TIMEBASE_now_us();
+    CONFIG_INIT();                                  // As after a reset: erases the spare
+    CONFIG_get_stats(&cfg);
+    printf("  CONFIG_maintain(%u us) erased %u; CONFIG_INIT after a reset: %lu erase in %.1f ms, "
+           "next set %s\n",
+           (unsigned)CONFIG_FLASH_BUDGET_US, refused, (unsigned long)cfg.erases,
+           (double)(TIMEBASE_now_us() - erase_start) / 1000.0,
+           (CONFIG_set(0x0003, &sets, sizeof(sets)) == CONFIG_OK) ? "OK" : "failed");
+    SIM_usart_clear();
+    CONFIG_report();
+    TIM6_delay(30);
+    printf("%s", SIM_usart_output());
+
+    // --- HC-SR04 ---
+    printf("sonar:\n");
+    SONAR_INIT();
+    SIM_sonar()->set_distance_cm(42);
+    TIM6_delay(120);
+    printf("  target at 42 cm -> SONAR_get_distance() = %u cm\n", SONAR_get_distance());
+    SIM_sonar()->set_distance_cm(250);
+    TIM6_delay(120);
+    printf("  target at 250 cm -> SONAR_get_distance() = %u cm\n", SONAR_get_distance());
+    SonarEcho echo;
+    uint32_t echoes = 0;
+    while (SONAR_read_echo(&echo)) {
+        echoes++;
+    }
+    printf("  queue: %lu echoes, newest %u us at %.1f ms, %lu dropped\n",
+           (unsigned long)echoes, echo.width_us, (double)echo.time_us / 1000.0,
+           (unsigned long)SONAR_get_overflows());
+
+    // --- ADC ---
+    printf("photoresistor:\n");
+    PHOTO_INIT();
+    SIM_adc_set(1, 3000);
+    uint64_t adc_start = SIM_cycles();
+    uint16_t light = PHOTO_read();
+    printf("  PA1 at 3000 -> PHOTO_read() = %u (%lu cycles)\n", light,
+           (unsigned long)(SIM_cycles() - adc_start));
+
+    // --- DSP kernels ---
+    printf("dsp:\n");
+    static const char* const kernel_names[DSP_NUM_KERNELS] = { "fir8", "movavg8", "decim4", "median3" };
+    for (uint32_t k = 0; k < DSP_NUM_KERNELS; k++) {
+        DspBench bench;
+        DSP_bench((DspKernel)k, &bench);
+        printf("  %-8s %2lu outputs of a %u-sample block, SIMD vs scalar: %s\n", kernel_names[k],
+               (unsigned long)bench.outputs, (unsigned)DSP_BENCH_BLOCK,
+               bench.match ? "identical" : "DIFFERENT");
+    }
+    SIM_adc_set(1, 2500);
+    printf("  PA1 at 2500 -> PHOTO_read_filtered() = %u\n", PHOTO_read_filtered());
+
+    uint16_t filtered[SONAR_RING_SIZE];
+    SONAR_read_filtered(filtered);                  // Drop what queued up so far
+    SIM_sonar()->set_distance_cm(100);
+    TIM6_delay(120);
+    SIM_sonar()->set_distance_cm(30);               // One stray echo
+    TIM6_delay(50);
+    SIM_sonar()->set_distance_cm(100);
+    TIM6_delay(120);
+    uint32_t distances = SONAR_read_filtered(filtered);
+    printf("  sonar 100 cm with one 30 cm echo ->");
+    for (uint32_t i = 0; i < distances; i++) {
+        printf(" %u", filtered[i]);
+    }
+    printf(" cm\n");
+
+    // --- Encoder ---
+    printf("encoder:\n");
+    ENCODER_INIT();
+    SIM_encoder_turn(8);
+    printf("  +8 counts -> %u (dir %u)\n", ENCODER_read(), ENCODER_raw_direction());
+    SIM_encoder_turn(-3);
+    printf("  -3 counts -> %u (dir %u)\n", ENCODER_read(), ENCODER_raw_direction());
+    SIM_gpio_set_input(BOARD_BUTTON_PORT, BOARD_BUTTON_PIN, 0);
+    TIM6_delay(5);
+    uint8_t early = ENCODER_debounce();
+    TIM6_delay(20);
+    uint8_t confirmed = ENCODER_debounce();
+    SIM_gpio_set_input(BOARD_BUTTON_PORT, BOARD_BUTTON_PIN, 1);
+    printf("  button: %u after 5 ms, %u after 25 ms\n", early, confirmed);
+
+    // --- Stopwatch ---
+    printf("stopwatch:\n");
+    STOPWATCH_INIT();
+    STOPWATCH_start();
+    TIM6_delay(250);
+    printf("  250 ms delay -> %lu ms\n", (unsigned long)STOPWATCH_read());
+    STOPWATCH_stop();
+
+    // --- Clock scaling ---
+    printf("clock scaling:\n");
+    STOPWATCH_start();
+    CLOCK_set_profile(CLOCK_PROFILE_180MHZ);
+    printf("  180 MHz profile: SYSCLK %lu Hz, PCLK1 %lu Hz, PCLK2 %lu Hz\n",
+           (unsigned long)SIM_clock_sysclk(), (unsigned long)SIM_clock_pclk1(),
+           (unsigned long)SIM_clock_pclk2());
+    SIM_usart_clear();
+    USART2_write((char*)"burst\r\n");
+    TIM6_delay(5);
+    printf("  USART2 says: %s", SIM_usart_output());
+    uint64_t before_us = TIMEBASE_now_us();
+    uint32_t before_ms = STOPWATCH_read();
+    TIM6_delay(100);
+    printf("  100 ms delay -> timebase +%lu ms, stopwatch +%lu ms\n",
+           (unsigned long)((TIMEBASE_now_us() - before_us) / 1000U),
+           (unsigned long)(STOPWATCH_read() - before_ms));
+    SIM_sonar()->set_distance_cm(250);              // The DSP section left it at 100 cm
+    TIM6_delay(120);
+    printf("  target at 250 cm -> SONAR_get_distance() = %u cm\n", SONAR_get_distance());
+    print_clock("RTC at 180 MHz");
+    CLOCK_set_profile(CLOCK_PROFILE_45MHZ);
+    TIM6_delay(120);
+    printf("  back to %lu Hz: sonar %u cm, stopwatch %lu ms\n",
+           (unsigned long)SIM_clock_sysclk(), SONAR_get_distance(),
+           (unsigned long)STOPWATCH_read());
+    STOPWATCH_stop();
+
+    // --- Low power ---
+    printf("low power:\n");
+    TIM3->CR1 &= ~1U;                   // Sonar off: a running timer keeps the core out of Stop
+    SIM_set_lsi_hz(36000);              // A fast part: 12.5% off the nominal 32 kHz
+    POWER_INIT();
+    Clock now;
+    RTC_read_clock(&now);
+    RTC_set_alarm(now.hours, now.minutes, (uint8_t)((now.seconds + 2) % 60));
+    SWTimer tick;
+    SWTIMER_start(&tick, 500, 500, count_tick, 0);
+    SimTime press = SIM_now() + SIM_MS(1300);
+    SIM_schedule(press, []() { SIM_gpio_set_input(BOARD_BUTTON_PORT, BOARD_BUTTON_PIN, 0); });
+    SIM_schedule(press + SIM_MS(40), []() { SIM_gpio_set_input(BOARD_BUTTON_PORT, BOARD_BUTTON_PIN, 1); });
+
+    uint64_t loop_us = TIMEBASE_now_us();
+    double start_sim_us = SIM_now_us();
+    uint8_t alarm = 0, button = 0;
+    while (ticks_seen < 6) {
+        EVENTLOOP_poll();
+        alarm |= RTC_alarm_fired();
+        button |= ENCODER_debounce();
+    }
+    SWTIMER_cancel(&tick);
+    printf("  6 ticks of 500 ms: alarm %u, button %u, timebase %.3f ms vs %.3f ms simulated\n",
+           alarm, button, (double)(TIMEBASE_now_us() - loop_us) / 1000.0,
+           (SIM_now_us() - start_sim_us) / 1000.0);
+    printf("  SYSCLK %lu Hz after the last wakeup\n", (unsigned long)SIM_clock_sysclk());
+    SIM_usart_clear();
+    POWER_report();
+    TIM6_delay(200);
+    printf("%s", SIM_usart_output());
+    RTC_disable_alarm();
+    SIM_set_lsi_hz(32000);
+    POWER_INIT();
+    PowerStats power;
+    POWER_get_stats(&power);
+    printf("  LSI back at 32 kHz: POWER_INIT measures %lu Hz\n", (unsigned long)power.lsi_hz);
+
+    // --- Watchdog ---
+    printf("watchdog:\n");
+    WDT_INIT();
+    for (int i = 0; i < 3; i++) {
+        TIM6_delay(20000);
+        WDT_kick();
+    }
+    printf("  kicked every 20 s for 60 s, still running at %.1f s\n", SIM_now_us() / 1e6);
+
+    // --- Windowed statistics ---
+    printf("stats:\n");
+    TIM3->CR1 |= 1U;                    // Sonar back on
+    STATS_INIT();
+    STATS_register(&light_stats, "light");
+    STATS_register(&distance_stats, "distance");
+    STATS_register(&speed_stats, "speed");
+    last_count = ENCODER_read();
+    SWTimer sampler;
+    SWTIMER_start(&sampler, 100, 100, stats_sample, 0);
+    uint64_t stats_us = TIMEBASE_now_us();
+    while (TIMEBASE_now_us() - stats_us < 150000000U) {
+        EVENTLOOP_poll();
+    }
+    SWTIMER_cancel(&sampler);
+    printf("  150 s at 10 Hz, %lu bytes per stream:\n", (unsigned long)sizeof(StatsStream));
+    SIM_usart_clear();
+    STATS_report();
+    TIM6_delay(800);
+    printf("%s", SIM_usart_output());
+
+    // --- Loop supervisor ---
+    printf("supervisor:\n");
+    SUPERVISOR_INIT();
+    sample_task = SUPERVISOR_register("sample", 300);
+    SWTimer sample;
+    SWTIMER_start(&sample, 100, 100, sample_tick, 0);
+    PowerStats sleep_before, sleep_after;
+    TIM3->CR1 &= ~1U;                   // Sonar off and Stop locked: only the timer ends a Sleep
+    POWER_stop_lock();
+    POWER_get_stats(&sleep_before);
+    uint64_t supervised_us = TIMEBASE_now_us();
+    while (TIMEBASE_now_us() - supervised_us < 2000000U) {
+        EVENTLOOP_poll();
+    }
+    POWER_get_stats(&sleep_after);
+    POWER_stop_unlock();
+    TIM3->CR1 |= 1U;
+    SupervisorStats loop_stats;
+    SUPERVISOR_get_stats(&loop_stats);
+    printf("  2 s: %lu passes, p50 <= %lu us, p99 <= %lu us, worst %lu us, healthy %u\n",
+           (unsigned long)loop_stats.passes, (unsigned long)loop_stats.p50_us,
+           (unsigned long)loop_stats.p99_us, (unsigned long)loop_stats.worst_us,
+           SUPERVISOR_healthy());
+    printf("  100 ms timer in Sleep: %lu sleeps ended early to refresh the WWDG\n",
+           (unsigned long)(sleep_after.wwdg_wakeups - sleep_before.wwdg_wakeups));
+
+    const char* reset_reason = 0;
+    double reset_us = 0;
+    SIM_set_reset_handler([&](const char* reason) {
+        reset_reason = reason;
+        reset_us = SIM_now_us();
+    });
+    SWTimer hog;
+    double hog_us = SIM_now_us() + 10000.0;
+    SWTIMER_start(&hog, 10, 0, stall, 0);
+    while (reset_reason == 0) {
+        EVENTLOOP_poll();
+    }
+    SWTIMER_cancel(&sample);
+    SIM_set_reset_handler(0);
+    printf("  150 ms callback -> %s reset %.1f ms into it (WWDG timeout %lu us)\n",
+           reset_reason, (reset_us - hog_us) / 1000.0, (unsigned long)WWDG_get_timeout_us());
+
+    // Reboot: backup SRAM keeps the snapshot
+    double before_reset_us = SIM_now_us();
+    uint64_t before_reset_cycles = SIM_cycles();
+    // (only the chip: the drivers' RAM isn't cleared, so no BOOT_INIT here)
+    SIM_board_init();
+    BOARD_INIT();
+    SysClockConfig();
+    TIM6_INIT();
+    USART_INIT();
+    SUPERVISOR_INIT();
+    SupervisorSnapshot snap;
+    if (SUPERVISOR_get_snapshot(&snap)) {
+        printf("  after reboot: snapshot reason %lu, pass %lu us at %lu ms, %lu passes before\n",
+               (unsigned long)snap.reason, (unsigned long)snap.pass_us,
+               (unsigned long)snap.time_ms, (unsigned long)snap.passes);
+    }
+    SIM_usart_clear();
+    SUPERVISOR_report();                            // Before the first pass starts the WWDG
+    TIM6_delay(50);
+    printf("%s", SIM_usart_output());
+
+    // A hang between passes gets no refresh from the early warning either
+    SUPERVISOR_pass_begin();                        // One empty pass: the WWDG runs
+    SUPERVISOR_pass_end();
+    reset_reason = 0;
+    SIM_set_reset_handler([&](const char* reason) {
+        if (!reset_reason) {
+            reset_reason = reason;
+            reset_us = SIM_now_us();
+        }
+    });
+    double blocked_us = SIM_now_us();
+    TIM6_delay(100);                                // Blocks outside EVENTLOOP_poll()
+    SIM_set_reset_handler(0);
+    printf("  100 ms block outside the loop -> %s reset %.1f ms into it\n",
+           reset_reason ? reset_reason : "no", (reset_us - blocked_us) / 1000.0);
+    SIM_board_init();
+    BOARD_INIT();
+    SysClockConfig();
+    TIM6_INIT();
+    USART_INIT();
+    SUPERVISOR_INIT();
+    if (SUPERVISOR_get_snapshot(&snap)) {
+        printf("  after reboot: snapshot reason %lu, %lu us since the last pass\n",
+               (unsigned long)snap.reason, (unsigned long)snap.pass_us);
+    }
+    before_reset_us += SIM_now_us();
+    before_reset_cycles += SIM_cycles();
+
+    // --- Power-fail snapshot ---
+    printf("brownout:\n");
+    before_reset_us += SIM_now_us();
+    before_reset_cycles += SIM_cycles();
+    power_up();                                     // Cold start, nothing to restore
+    BROWNOUT_INIT();
+    STEPPER_set_target(1000, STEP_CW, 2);
+    STOPWATCH_start();
+    SIM_encoder_turn(21);
+    run_loop_ms(40);
+    SIM_vdd_ramp(2800, SIM_US(500));                // A dip that recovers
+    run_loop_ms(1);
+    SIM_vdd_ramp(3300, SIM_US(500));
+    run_loop_ms(10);
+    printf("  dip to 2.8 V and back: motor stopped at %ld, EEPROM page reads 0x%02X again\n",
+           (long)STEPPER_get_position(),
+           EEPROM_read_address(EEPROM_ADDRESS, BROWNOUT_EEPROM_PAGE * EEPROM_PAGE_BYTES));
+    SIM_usart_clear();
+    BROWNOUT_report();
+    TIM6_delay(40);
+    printf("%s", SIM_usart_output());
+
+    STEPPER_set_target(1000, STEP_CCW, 2);
+    SIM_encoder_turn(-5);
+    run_loop_ms(30);
+    SimTime holdup = power_fail();
+    print_motion("at the power-down reset:");
+    printf("  PVD trip to reset %.1f ms\n", (double)holdup / (double)SIM_MS(1));
+    before_reset_us += SIM_now_us();
+    before_reset_cycles += SIM_cycles();
+    power_up();
+    print_motion("after power-up:");
+    BrownoutRestore restored = BROWNOUT_INIT();
+    print_motion(restored == BROWNOUT_RESTORED_BACKUP ? "restored (backup SRAM):" : "restored (?):");
+    BrownoutStats brownout;
+    BROWNOUT_get_stats(&brownout);
+    printf("  that save: %lu ns to backup SRAM, %lu us to the EEPROM page\n",
+           (unsigned long)brownout.last_backup_ns, (unsigned long)brownout.last_eeprom_us);
+
+    STEPPER_set_target(1000, STEP_CW, 2);
+    run_loop_ms(20);
+    power_fail();
+    print_motion("no coin cell, at reset:");
+    memset(sim_bkpsram, 0, sizeof(sim_bkpsram));    // Backup SRAM lost with VDD
+    before_reset_us += SIM_now_us();
+    before_reset_cycles += SIM_cycles();
+    power_up();
+    restored = BROWNOUT_INIT();
+    print_motion(restored == BROWNOUT_RESTORED_EEPROM ? "restored (EEPROM page):" : "restored (?):");
+
+    // --- Second I2C bus ---
+    // PVD trip in the middle of reading the DS3231: the snapshot's EEPROM page
+    // has to wait for a bus of its own
+    printf("i2c buses:\n");
+    static const I2CBus eeprom_buses[] = { I2C_BUS1, I2C_BUS2 };
+    for (int i = 0; i < 2; i++) {
+        BrownoutStats before;
+        BrownoutStats after;
+        Clock t;
+        move_eeprom(eeprom_buses[i]);
+        BROWNOUT_get_stats(&before);
+        SimTime read_start = SIM_now();
+        SIM_schedule(read_start + SIM_US(1000), []() { SIM_set_vdd_mv(2800); });
+        RTC_read_clock(&t);
+        double read_ms = (double)(SIM_now() - read_start) / (double)SIM_MS(1);
+        BROWNOUT_get_stats(&after);
+        SIM_set_vdd_mv(3300);
+        run_loop_ms(10);
+        I2CStats rtc_stats;
+        I2C_get_stats(BOARD_RTC_BUS, &rtc_stats);
+        printf("  24C02C on %s: EEPROM page %s, DS3231 read in %.2f ms (%lu timeouts on %s)\n",
+               I2C_bus_name(eeprom_buses[i]),
+               (after.eeprom_writes > before.eeprom_writes) ? "written" : "skipped (bus busy)",
+               read_ms, (unsigned long)rtc_stats.timeouts, I2C_bus_name(BOARD_RTC_BUS));
+    }
+    move_eeprom(BOARD_EEPROM_BUS);
+
+    // --- I2C faults ---
+    printf("i2c:\n");
+    uint8_t reg = 0;
+    SimTime fault_start = SIM_now();
+    I2CStatus status = I2C_byteRead(BOARD_RTC_BUS, 0x3C, 0x00, &reg);        // Nothing at 0x3C
+    printf("  no device at 0x3C: %s after %.1f us\n", I2C_status_name(status),
+           (double)(SIM_now() - fault_start) / (double)SIM_US(1));
+
+    SIM_i2c_hold_sda(SIM_i2c_bus(BOARD_RTC_BUS), 5);                      // Slave reset mid-read, 5 bits to go
+    fault_start = SIM_now();
+    status = I2C_byteRead(BOARD_RTC_BUS, RTC_ADDRESS, SECOND_ADDRESS, &reg);
+    double stuck_us = (double)(SIM_now() - fault_start) / (double)SIM_US(1);
+    I2CStatus retry = I2C_byteRead(BOARD_RTC_BUS, RTC_ADDRESS, SECOND_ADDRESS, &reg);
+    printf("  SDA held for 5 clocks: %s after %.1f us (bound %lu us), retry %s\n",
+           I2C_status_name(status), stuck_us, (unsigned long)I2C_WORST_CASE_US(8),
+           I2C_status_name(retry));
+
+    // Burst reads of 1, 2 (POS) and 3+ bytes (BTF): only the bytes asked for are clocked in
+    static const uint16_t burst_lengths[4] = { 1, 2, 3, 16 };
+    printf("  burst reads:");
+    for (uint32_t i = 0; i < 4; i++) {
+        uint8_t burst[16];
+        uint16_t len = burst_lengths[i];
+        SIM_i2c_clear_stats(SIM_i2c_bus(EEPROM_get_bus()));
+        I2CStatus burst_status = EEPROM_read_sequential(EEPROM_ADDRESS, 0x40, burst, len);
+        SimI2CStats burst_stats;
+        SIM_i2c_get_stats(SIM_i2c_bus(EEPROM_get_bus()), &burst_stats);
+        uint8_t same = 1;
+        for (uint16_t j = 0; j < len; j++) {
+            same &= (burst[j] == SIM_eeprom()->peek((uint8_t)(0x40 + j))) ? 1 : 0;
+        }
+        printf(" %u B %s %s %lu on the wire%s", len, I2C_status_name(burst_status),
+               same ? "match," : "differ,", (unsigned long)burst_stats.bytes, (i < 3) ? ";" : "\n");
+    }
+
+    // Parts off the bus: the drivers hand the NACK up instead of made-up data
+    SIM_i2c_detach(SIM_i2c_bus(RTC_get_bus()), SIM_ds3231());
+    SIM_i2c_detach(SIM_i2c_bus(EEPROM_get_bus()), SIM_eeprom());
+    BrownoutStats before_trip, after_trip;
+    BROWNOUT_get_stats(&before_trip);
+    TIM6_delay(1);                                  // BUSY drops a little after the STOP
+    SIM_set_vdd_mv(2800);
+    TIM6_delay(5);
+    BROWNOUT_get_stats(&after_trip);
+    SIM_set_vdd_mv(3300);
+    run_loop_ms(10);
+    Clock gone_clock;
+    I2CStatus clock_status = RTC_read_clock(&gone_clock);
+    uint8_t gone_page[EEPROM_PAGE_BYTES];
+    memset(gone_page, 0x5A, sizeof(gone_page));
+    uint8_t page_written = EEPROM_write_page(EEPROM_ADDRESS, 0x00, gone_page, sizeof(gone_page));
+    SIM_i2c_attach(SIM_i2c_bus(RTC_get_bus()), SIM_ds3231());
+    SIM_i2c_attach(SIM_i2c_bus(EEPROM_get_bus()), SIM_eeprom());
+    printf("  DS3231 and 24C02C off the bus: RTC_read_clock %s (seconds %u), EEPROM_write_page %u, "
+           "brownout page %lu failed / %lu written\n",
+           I2C_status_name(clock_status), gone_clock.seconds, page_written,
+           (unsigned long)(after_trip.eeprom_failed - before_trip.eeprom_failed),
+           (unsigned long)(after_trip.eeprom_writes - before_trip.eeprom_writes));
+
+    // An alarm while the DS3231 is off the bus is reported once A1F clears
+    Clock alarm_clock;
+    RTC_read_clock(&alarm_clock);
+    uint32_t alarm_at = (alarm_clock.hours * 3600U + alarm_clock.minutes * 60U +
+                         alarm_clock.seconds + 2U) % 86400U;
+    RTC_set_alarm((uint8_t)(alarm_at / 3600U), (uint8_t)((alarm_at / 60U) % 60U), (uint8_t)(alarm_at % 60U));
+    SIM_i2c_detach(SIM_i2c_bus(RTC_get_bus()), SIM_ds3231());
+    run_loop_ms(2100);
+    uint8_t fired_off = RTC_alarm_fired();
+    uint8_t fired_retry = RTC_alarm_fired();
+    SIM_i2c_attach(SIM_i2c_bus(RTC_get_bus()), SIM_ds3231());
+    uint8_t fired_on = RTC_alarm_fired();
+    uint8_t fired_again = RTC_alarm_fired();
+    printf("  alarm with the DS3231 off the bus: fired %u, %u; back on: %u, then %u (INT/SQW %s)\n",
+           fired_off, fired_retry, fired_on, fired_again,
+           (GPIOA->IDR & (1 << 0)) ? "released" : "still low");
+    RTC_disable_alarm();
+
+    SIM_i2c_hold_sda(SIM_i2c_bus(BOARD_RTC_BUS), 0);                      // Never lets go
+    double worst_us = 0;
+    for (int i = 0; i < 3; i++) {
+        fault_start = SIM_now();
+        status = I2C_byteWrite(BOARD_RTC_BUS, RTC_ADDRESS, SECOND_ADDRESS, 0);
+        double took_us = (double)(SIM_now() - fault_start) / (double)SIM_US(1);
+        worst_us = (took_us > worst_us) ? took_us : worst_us;
+    }
+    I2CStats i2c_stats;
+    I2C_get_stats(BOARD_RTC_BUS, &i2c_stats);
+    printf("  SDA held for good: 3 writes %s, worst %.1f us (bound %lu us)\n",
+           I2C_status_name(status), worst_us, (unsigned long)I2C_WORST_CASE_US(6));
+    printf("  %lu NACKs, %lu timeouts, %lu recoveries (%lu with SDA still low)\n",
+           (unsigned long)i2c_stats.nacks, (unsigned long)i2c_stats.timeouts,
+           (unsigned long)i2c_stats.recoveries, (unsigned long)i2c_stats.recovery_failed);
+
+    printf("done: %.3f ms simulated, %llu CPU cycles\n", (before_reset_us + SIM_now_us()) / 1000.0,
+           (unsigned long long)(before_reset_cycles + SIM_cycles()));
+    return 0;
+}
@@ -0,0 +1,432 @@
+/*
+* filename: sim_devices.cpp
+* purpose: Behavioral models of the board's external parts: DS3231, 24C02C, HC-SR04
+* author: Connor Ockerse
+* date: 10/19/2026
+*/
+
+#include "sim.h"
+#include "sim_internal.h"
+#include "board.h"
+
+#include <string.h>
+#include <vector>
+
+// Echo starts this long after the trigger falls (8-cycle 40 kHz burst + margin)
+#define SONAR_ECHO_DELAY_US     460U
+// Echo width when nothing reflects the burst
+#define SONAR_TIMEOUT_US        38000U
+// Round trip time per centimeter
+#define SONAR_US_PER_CM         58U
+
+static uint8_t to_bcd(uint32_t value) {
+    return (uint8_t)(((value / 10) << 4) | (value % 10));
+}
+
+static uint32_t from_bcd(uint8_t value) {
+    return ((value >> 4) * 10U) + (value & 0x0F);
+}
+
+// === DS3231 ===
+
+// Register map
+#define DS_SECONDS  0x00
+#define DS_MINUTES  0x01
+#define DS_HOURS    0x02
+#define DS_DAY      0x03
+#define DS_DATE     0x04
+#define DS_MONTH    0x05
+#define DS_YEAR     0x06
+#define DS_ALARM1   0x07
+#define DS_ALARM2   0x0B
+#define DS_CONTROL  0x0E
+#define DS_STATUS   0x0F
+#define DS_NUM_REGS 0x13
+
+SimDS3231::SimDS3231() : int_port(0), int_pin(0), second_event(0) {
+    reset();
+}
+
+void SimDS3231::reset(void) {
+    memset(regs, 0, sizeof(regs));
+    regs[DS_DAY] = 0x01;
+    regs[DS_DATE] = 0x01;
+    regs[DS_MONTH] = 0x01;
+    regs[DS_CONTROL] = 0x1C;        // INTCN, RS2, RS1
+    regs[DS_STATUS] = 0x88;         // OSF (oscillator was stopped), EN32kHz
+    regs[0x11] = 0x19;              // 25.00 C
+    pointer = 0;
+    first_byte = false;
+    last_second = SIM_now();
+    second_event = 0;               // The event queue was cleared by SIM_reset
+    memcpy(buffer, regs, sizeof(buffer));
+}
+
+void SimDS3231::set_int_pin(GPIO_TypeDef* port, uint8_t pin) {
+    int_port = port;
+    int_pin = pin;
+    update_int_pin();
+}
+
+void SimDS3231::set_time(uint8_t year, uint8_t month, uint8_t date, uint8_t day,
+                         uint8_t hours, uint8_t minutes, uint8_t seconds) {
+    regs[DS_SECONDS] = to_bcd(seconds);
+    regs[DS_MINUTES] = to_bcd(minutes);
+    regs[DS_HOURS] = to_bcd(hours);
+    regs[DS_DAY] = to_bcd(day);
+    regs[DS_DATE] = to_bcd(date);
+    regs[DS_MONTH] = to_bcd(month);
+    regs[DS_YEAR] = to_bcd(year);
+    regs[DS_STATUS] &= ~0x80;
+    last_second = SIM_now();
+}
+
+uint8_t SimDS3231::reg(uint8_t index) {
+    catch_up();
+    return regs[index % DS_NUM_REGS];
+}
+
+void SimDS3231::catch_up(void) {
+    while (SIM_now() >= (last_second + SIM_SEC(1))) {
+        last_second += SIM_SEC(1);
+        tick_second();
+    }
+}
+
+static uint32_t days_in_month(uint32_t month, uint32_t year) {
+    static const uint8_t days[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    if ((month == 2) && ((year % 4) == 0)) {
+        return 29;                  // 2000-2099: every 4th year
+    }
+    return days[(month - 1) % 12];
+}
+
+void SimDS3231::tick_second(void) {
+    uint32_t sec = from_bcd(regs[DS_SECONDS] & 0x7F) + 1;
+    if (sec < 60) {
+        regs[DS_SECONDS] = to_bcd(sec);
+        check_alarms();
+        return;
+    }
+    regs[DS_SECONDS] = 0;
+
+    uint32_t min = from_bcd(regs[DS_MINUTES] & 0x7F) + 1;
+    if (min < 60) {
+        regs[DS_MINUTES] = to_bcd(min);
+        check_alarms();
+        return;
+    }
+    regs[DS_MINUTES] = 0;
+
+    bool rolled_day;
+    uint8_t hours = regs[DS_HOURS];
+    if (hours & 0x40) {
+        // 12-hour mode: 11 -> 12 flips AM/PM, 12 -> 1
+        uint32_t hour = from_bcd(hours & 0x1F);
+        bool pm = hours & 0x20;
+        rolled_day = false;
+        if (hour == 11) {
+            rolled_day = pm;
+            pm = !pm;
+            hour = 12;
+        } else if (hour == 12) {
+            hour = 1;
+        } else {
+            hour++;
+        }
+        regs[DS_HOURS] = (uint8_t)(0x40 | (pm ? 0x20 : 0) | to_bcd(hour));
+    } else {
+        uint32_t hour = from_bcd(hours & 0x3F) + 1;
+        rolled_day = (hour >= 24);
+        regs[DS_HOURS] = rolled_day ? 0 : to_bcd(hour);
+    }
+    if (!rolled_day) {
+        check_alarms();
+        return;
+    }
+
+    regs[DS_DAY] = (uint8_t)((regs[DS_DAY] % 7) + 1);
+
+    uint32_t year = from_bcd(regs[DS_YEAR]);
+    uint32_t month = from_bcd(regs[DS_MONTH] & 0x1F);
+    uint32_t date = from_bcd(regs[DS_DATE] & 0x3F) + 1;
+    uint8_t century = regs[DS_MONTH] & 0x80;
+    if (date > days_in_month(month, year)) {
+        date = 1;
+        month++;
+        if (month > 12) {
+            month = 1;
+            year++;
+            if (year > 99) {
+                year = 0;
+                century ^= 0x80;
+            }
+        }
+    }
+    regs[DS_DATE] = to_bcd(date);
+    regs[DS_MONTH] = (uint8_t)(century | to_bcd(month));
+    regs[DS_YEAR] = to_bcd(year);
+    check_alarms();
+}
+
+void SimDS3231::check_alarms(void) {
+    uint8_t sec = regs[DS_SECONDS];
+    uint8_t min = regs[DS_MINUTES];
+    uint8_t hour = regs[DS_HOURS];
+    uint8_t day = regs[DS_DAY];
+    uint8_t date = regs[DS_DATE];
+
+    // Alarm 1: a set mask bit (bit 7) means "don't care"
+    const uint8_t* a1 = &regs[DS_ALARM1];
+    bool a1_day = (a1[3] & 0x40) ? ((a1[3] & 0x0F) == day) : ((a1[3] & 0x3F) == date);
+    if (((a1[0] & 0x80) || ((a1[0] & 0x7F) == sec)) &&
+        ((a1[1] & 0x80) || ((a1[1] & 0x7F) == min)) &&
+        ((a1[2] & 0x80) || ((a1[2] & 0x7F) == hour)) &&
+        ((a1[3] & 0x80) || a1_day)) {
+        regs[DS_STATUS] |= 0x01;        // A1F
+    }
+
+    // Alarm 2: matched once per minute (at seconds = 0)
+    const uint8_t* a2 = &regs[DS_ALARM2];
+    bool a2_day = (a2[2] & 0x40) ? ((a2[2] & 0x0F) == day) : ((a2[2] & 0x3F) == date);
+    if ((sec == 0) &&
+        ((a2[0] & 0x80) || ((a2[0] & 0x7F) == min)) &&
+        ((a2[1] & 0x80) || ((a2[1] & 0x7F) == hour)) &&
+        ((a2[2] & 0x80) || a2_day)) {
+        regs[DS_STATUS] |= 0x02;        // A2F
+    }
+
+    update_int_pin();
+}
+
+void SimDS3231::update_int_pin(void) {
+    uint8_t control = regs[DS_CONTROL];
+    uint8_t status = regs[DS_STATUS];
+    bool active = (control & 0x04) &&
+                  (((status & 0x01) && (control & 0x01)) || ((status & 0x02) && (control & 0x02)));
+
+    if (int_port) {
+        SIM_gpio_set_input(int_port, int_pin, active ? 0 : 1);  // Open drain, active low
+
+        // Keep time moving while someone listens to the pin
+        if (second_event) {
+            SIM_cancel(second_event);
+            second_event = 0;
+        }
+        if (control & 0x03) {
+            second_event = SIM_schedule(last_second + SIM_SEC(1), [this]() {
+                second_event = 0;
+                catch_up();
+                update_int_pin();
+            });
+        }
+    }
+}
+
+bool SimDS3231::start(bool read) {
+    // Time registers are latched into a read buffer at every START
+    catch_up();
+    memcpy(buffer, regs, sizeof(buffer));
+    first_byte = !read;
+    return true;
+}
+
+bool SimDS3231::write(uint8_t byte) {
+    if (first_byte) {
+        first_byte = false;
+        pointer = byte % DS_NUM_REGS;
+        return true;
+    }
+
+    catch_up();
+    if (pointer == DS_STATUS) {
+        // OSF, A2F, A1F can only be cleared; EN32kHz is read/write
+        regs[DS_STATUS] = (uint8_t)((regs[DS_STATUS] & byte & 0x83) |
+                                    (byte & 0x08) | (regs[DS_STATUS] & 0x04));
+        update_int_pin();
+    } else if (pointer < 0x11) {
+        regs[pointer] = byte;
+        if (pointer == DS_SECONDS) {
+            last_second = SIM_now();    // Writing seconds restarts the countdown chain
+        }
+        if (pointer == DS_CONTROL) {
+            update_int_pin();
+        }
+    }
+    pointer = (uint8_t)((pointer + 1) % DS_NUM_REGS);
+    return true;
+}
+
+uint8_t SimDS3231::read(void) {
+    uint8_t value = (pointer <= DS_YEAR) ? buffer[pointer] : regs[pointer];
+    pointer = (uint8_t)((pointer + 1) % DS_NUM_REGS);
+    return value;
+}
+
+void SimDS3231::stop(void) {
+    first_byte = false;
+}
+
+// === 24C02C ===
+
+SimEEPROM24C02::SimEEPROM24C02() : write_cycle_time(SIM_US(1500)) {
+    memset(memory, 0xFF, sizeof(memory));       // Shipped erased
+    reset();
+}
+
+// The cells are non-volatile: a reset (power cycle) keeps them
+void SimEEPROM24C02::reset(void) {
+    page_mask = 0;
+    pointer = 0;
+    first_byte = false;
+    writing = false;
+    busy_until = 0;
+    cycles = 0;
+}
+
+bool SimEEPROM24C02::busy(void) {
+    return SIM_now() < busy_until;
+}
+
+bool SimEEPROM24C02::start(bool read) {
+    // No ACK during the internal write cycle (acknowledge polling)
+    if (busy()) {
+        return false;
+    }
+    // A repeated START abandons a page that was not ended by STOP
+    page_mask = 0;
+    writing = false;
+    first_byte = !read;
+    return true;
+}
+
+bool SimEEPROM24C02::write(uint8_t byte) {
+    if (first_byte) {
+        first_byte = false;
+        pointer = byte;
+        return true;
+    }
+
+    // Data goes into the page buffer; the address rolls over inside the page
+    page[pointer & 0x0F] = byte;
+    page_mask |= (uint16_t)(1U << (pointer & 0x0F));
+    pointer = (uint8_t)((pointer & 0xF0) | ((pointer + 1) & 0x0F));
+    writing = true;
+    return true;
+}
+
+uint8_t SimEEPROM24C02::read(void) {
+    uint8_t value = memory[pointer];
+    pointer++;                          // Sequential reads wrap at the end of memory
+    return value;
+}
+
+void SimEEPROM24C02::stop(void) {
+    if (writing && page_mask) {
+        // STOP starts the self-timed write cycle for the loaded bytes
+        uint8_t base = pointer & 0xF0;
+        for (uint8_t i = 0; i < 16; i++) {
+            if (page_mask & (1U << i)) {
+                memory[base + i] = page[i];
+            }
+        }
+        busy_until = SIM_now() + write_cycle_time;
+        cycles++;
+    }
+    page_mask = 0;
+    writing = false;
+    first_byte = false;
+}
+
+// === HC-SR04 ===
+
+static SimTime sonar_busy_until = 0;
+
+SimHCSR04::SimHCSR04() : distance(100) {}
+
+void SimHCSR04::reset(void) {
+    distance = 100;
+    sonar_busy_until = 0;
+}
+
+void SimHCSR04::set_distance_cm(uint32_t cm) {
+    distance = cm;
+}
+
+void SimHCSR04::on_trigger(SimTime falling_edge) {
+    // Triggers during an echo are ignored
+    if (falling_edge < sonar_busy_until) {
+        return;
+    }
+
+    uint32_t width_us;
+    if (next_width_us) {
+        width_us = next_width_us();
+    } else {
+        width_us = distance ? (distance * SONAR_US_PER_CM) : SONAR_TIMEOUT_US;
+    }
+
+    SimTime rise = falling_edge + SIM_US(SONAR_ECHO_DELAY_US);
+    SimTime fall = rise + SIM_US(width_us);
+    sonar_busy_until = fall;
+    SIM_schedule(rise, []() { SIM_timer_capture(TIM3, 2, 1); });
+    SIM_schedule(fall, []() { SIM_timer_capture(TIM3, 2, 0); });
+}
+
+// === BOARD ===
+
+static SimDS3231 ds3231;
+static SimEEPROM24C02 eeprom;
+static SimHCSR04 sonar;
+
+SimDS3231* SIM_ds3231(void) {
+    return &ds3231;
+}
+
+SimEEPROM24C02* SIM_eeprom(void) {
+    return &eeprom;
+}
+
+SimHCSR04* SIM_sonar(void) {
+    return &sonar;
+}
+
+void sim_devices_reset(void) {
+    ds3231.reset();
+    eeprom.reset();
+    sonar.reset();
+}
+
+void SIM_board_init(void) {
+    static bool wired = false;
+
+    sim_models_init();
+    if (!wired) {
+        wired = true;
+        SIM_i2c_attach(SIM_i2c_bus(BOARD_RTC_BUS), &ds3231);
+        SIM_i2c_attach(SIM_i2c_bus(BOARD_EEPROM_BUS), &eeprom);
+        ds3231.set_int_pin(GPIOA, 0);
+
+        // TIM3 CH1 in PWM mode 1 drives the trigger pin: it falls at the compare match
+        sim_timer_set_compare_listener(TIM3, 1, [](SimTime at) {
+            uint32_t oc1m = (TIM3->CCMR1.value >> 4) & 7;
+            if ((TIM3->CCER.value & 1) && (oc1m == 6)) {
+                sonar.on_trigger(at);
+            }
+        });
+    }
+    SIM_reset();
+}
+
+// The drivers' .data/.bss, renamed by the Makefile so the linker brackets them
+extern "C" char __start_sim_driver_data[], __stop_sim_driver_data[];
+extern "C" char __start_sim_driver_bss[], __stop_sim_driver_bss[];
+
+// Load image of the drivers' .data, taken before main() runs any of them
+static std::vector<char> driver_data_image(__start_sim_driver_data, __stop_sim_driver_data);
+
+void SIM_power_on(void) {
+    memcpy(__start_sim_driver_data, driver_data_image.data(), driver_data_image.size());
+    memset(__start_sim_driver_bss, 0, (size_t)(__stop_sim_driver_bss - __start_sim_driver_bss));
+    SIM_board_init();
+}
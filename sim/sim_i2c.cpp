@@ -0,0 +1,485 @@
+/*
+* filename: sim_i2c.cpp
+* purpose: I2C master controller model (I2C1-3) and the bus its devices sit on
+* author: Connor Ockerse
+* date: 10/19/2026
+* note: Follows the STM32F4 event sequence the drivers poll for:
+* START -> SB, address -> ADDR (or AF on NACK), TXE/BTF while sending,
+* RXNE/BTF while receiving, STOP/START requests taking effect after the byte
+* on the wire. POS makes the ACK bit apply one byte later; a receiver's DR
+* and shift register keep their bytes through the STOP. A byte (8 bits +
+* ACK) takes 9 SCL periods, and one SCL period is 2 x CCR PCLK1 cycles
+* (standard mode, Thigh = Tlow = CCR x Tpclk1).
+* Flags clear the way the reference manual says: SB by SR1 read + DR write,
+* ADDR by SR1 read + SR2 read, RXNE by DR read, error flags by writing 0.
+* SIM_i2c_hold_sda() models a slave stuck mid-byte: SDA stays low (BUSY,
+* no START) until SCL, driven as a GPIO, has clocked its bits out.
+*/
+
+#include "sim.h"
+#include "sim_internal.h"
+
+#include <vector>
+
+I2C_TypeDef sim_I2C1, sim_I2C2, sim_I2C3;
+
+// SR1 / SR2 bits
+#define I2C_SB      (1U << 0)
+#define I2C_ADDR    (1U << 1)
+#define I2C_BTF     (1U << 2)
+#define I2C_RXNE    (1U << 6)
+#define I2C_TXE     (1U << 7)
+#define I2C_AF      (1U << 10)
+#define I2C_MSL     (1U << 0)
+#define I2C_BUSY    (1U << 1)
+#define I2C_TRA     (1U << 2)
+
+class I2CModel : public SimModel {
+public:
+    I2CModel(I2C_TypeDef* i2c, GPIO_TypeDef* scl_port, uint8_t scl_pin, GPIO_TypeDef* sda_port, uint8_t sda_pin)
+        : i2c(i2c), scl_port(scl_port), scl_pin(scl_pin), sda_port(sda_port), sda_pin(sda_pin),
+          sda_held(false), held_clocks(0) {}
+
+    void reset(void) {
+        i2c->TRISE.value = 0x0002;
+        target = 0;
+        reading = false;
+        shifting = false;
+        tx_held = false;
+        rx_held = false;
+        rx_stopped = false;
+        pos_ack = true;
+        start_pending = false;
+        stop_pending = false;
+        sr1_read = false;
+        phase_event = 0;
+        busy_since = 0;
+        stats = SimI2CStats();
+        sda_held = false;                       // GPIO reset lets go of the pin too
+    }
+
+    // clocks = 0: held for good
+    void hold_sda(uint32_t clocks) {
+        sda_held = true;
+        held_clocks = clocks;
+        sim_gpio_drive(sda_port, sda_pin, 0);
+        sim_gpio_set_listener(scl_port, scl_pin, [this](bool level) {
+            if (level && sda_held && held_clocks && (--held_clocks == 0)) {
+                sda_held = false;
+                sim_gpio_drive(sda_port, sda_pin, -1);
+            }
+        });
+        i2c->SR2.value |= I2C_BUSY;
+    }
+
+    uint32_t read(SimReg* reg, uint32_t offset) {
+        (void)offset;
+        if (reg == &i2c->SR1) {
+            sr1_read = true;
+            return reg->value;
+        }
+        if (reg == &i2c->SR2) {
+            uint32_t value = reg->value;
+            if ((i2c->SR1.value & I2C_ADDR) && sr1_read) {
+                sr1_read = false;
+                i2c->SR1.value &= ~I2C_ADDR;
+                address_cleared();
+            }
+            return value;
+        }
+        if (reg == &i2c->DR) {
+            uint32_t value = reg->value;
+            if (reading) {
+                read_dr();
+            }
+            return value;
+        }
+        return reg->value;
+    }
+
+    void write(SimReg* reg, uint32_t offset, uint32_t value) {
+        (void)offset;
+        if (reg == &i2c->CR1) {
+            write_cr1(value);
+        } else if (reg == &i2c->DR) {
+            i2c->DR.value = value & 0xFF;
+            write_dr((uint8_t)value);
+        } else if (reg == &i2c->SR1) {
+            i2c->SR1.value &= (value | 0xFFU);  // Error flags are rc_w0
+        } else if (reg == &i2c->SR2) {
+            return;                             // Read-only
+        } else {
+            reg->value = value;
+        }
+    }
+
+    std::vector<SimI2CDevice*> devices;
+    SimI2CStats stats;
+
+private:
+    SimTime bit_time(void) {
+        uint32_t ccr = i2c->CCR.value & 0xFFF;
+        return SIM_clock_period(SIM_clock_pclk1(), 2ULL * ((ccr < 4) ? 4 : ccr));
+    }
+
+    SimTime byte_time(void) {
+        return 9 * bit_time();
+    }
+
+    void schedule(SimTime delay, std::function<void()> fn) {
+        phase_event = SIM_schedule(SIM_now() + delay, [this, fn]() {
+            phase_event = 0;
+            fn();
+        });
+    }
+
+    // --- Control ---
+
+    void write_cr1(uint32_t value) {
+        uint32_t old = i2c->CR1.value;
+        i2c->CR1.value = value;
+
+        if (value & (1 << 15)) {
+            software_reset();
+            i2c->CR1.value = value & (1U << 15);    // Everything else held in reset
+            return;
+        }
+        if (!(value & 1)) {
+            // PE off: the controller lets go of the bus
+            if (old & 1) {
+                abort_transfer();
+            }
+            return;
+        }
+        if ((value & (1 << 8)) && !(old & (1 << 8))) {
+            request_start();
+        }
+        if ((value & (1 << 9)) && !(old & (1 << 9))) {
+            request_stop();
+        }
+    }
+
+    void software_reset(void) {
+        abort_transfer();
+        for (SimReg* r = &i2c->CR1; r <= &i2c->FLTR; r++) {
+            r->value = 0;
+        }
+        i2c->TRISE.value = 0x0002;
+        if (sda_held) {
+            i2c->SR2.value |= I2C_BUSY;         // SDA low: the bus still looks busy
+        }
+    }
+
+    void abort_transfer(void) {
+        if (phase_event) {
+            SIM_cancel(phase_event);
+            phase_event = 0;
+        }
+        if (target) {
+            target->stop();
+            target = 0;
+        }
+        if (i2c->SR2.value & I2C_BUSY) {
+            stats.busy_time += SIM_now() - busy_since;
+        }
+        i2c->SR1.value = 0;
+        i2c->SR2.value = 0;
+        reading = false;
+        shifting = false;
+        tx_held = false;
+        rx_held = false;
+        start_pending = false;
+        stop_pending = false;
+    }
+
+    void request_start(void) {
+        if (sda_held) {
+            return;                             // Waits for a bus that never frees up
+        }
+        if (!(i2c->SR2.value & I2C_BUSY)) {
+            busy_since = SIM_now();
+            i2c->SR2.value |= I2C_BUSY;
+            schedule(bit_time(), [this]() { generate_start(); });
+        } else if (shifting) {
+            start_pending = true;               // After the byte on the wire
+        } else {
+            schedule(bit_time(), [this]() { generate_start(); });
+        }
+    }
+
+    void request_stop(void) {
+        if (shifting) {
+            stop_pending = true;
+        } else {
+            schedule(bit_time(), [this]() { generate_stop(); });
+        }
+    }
+
+    void generate_start(void) {
+        stats.starts++;
+        i2c->CR1.value &= ~(1U << 8);
+        i2c->SR1.value &= ~(I2C_BTF | I2C_TXE | I2C_RXNE);
+        i2c->SR1.value |= I2C_SB;
+        i2c->SR2.value |= I2C_BUSY | I2C_MSL;
+        sr1_read = false;
+        reading = false;
+        rx_held = false;
+        tx_held = false;
+    }
+
+    void generate_stop(void) {
+        stats.stops++;
+        stats.busy_time += SIM_now() - busy_since;
+        i2c->CR1.value &= ~(1U << 9);
+        i2c->SR1.value &= ~(I2C_SB | I2C_ADDR | I2C_TXE);
+        if (!reading) {
+            i2c->SR1.value &= ~I2C_BTF;         // A receiver keeps DR and the shift register
+        }
+        i2c->SR2.value &= ~(I2C_BUSY | I2C_MSL | I2C_TRA);
+        if (sda_held) {
+            i2c->SR2.value |= I2C_BUSY;         // The STOP can't get SDA up
+        }
+        if (target) {
+            target->stop();
+            target = 0;
+        }
+        reading = false;
+        tx_held = false;
+    }
+
+    // Runs a pending STOP or repeated START once the byte on the wire is done
+    void byte_finished(void) {
+        shifting = false;
+        if (stop_pending) {
+            stop_pending = false;
+            start_pending = false;
+            schedule(bit_time(), [this]() { generate_stop(); });
+        } else if (start_pending) {
+            start_pending = false;
+            schedule(bit_time(), [this]() { generate_start(); });
+        }
+    }
+
+    // --- Address phase ---
+
+    void write_dr(uint8_t value) {
+        if (i2c->SR1.value & I2C_SB) {
+            if (!sr1_read) {
+                return;                         // SB not acknowledged yet
+            }
+            i2c->SR1.value &= ~I2C_SB;
+            sr1_read = false;
+            send_address(value);
+        } else if ((i2c->SR2.value & I2C_TRA) && !reading) {
+            i2c->SR1.value &= ~I2C_BTF;
+            if (!shifting) {
+                send_byte(value);
+            } else {
+                tx_held = true;
+                tx_byte = value;
+                i2c->SR1.value &= ~I2C_TXE;
+            }
+        }
+    }
+
+    void send_address(uint8_t value) {
+        shifting = true;
+        schedule(byte_time(), [this, value]() {
+            stats.bytes++;
+            target = 0;
+            for (size_t i = 0; i < devices.size(); i++) {
+                if (devices[i]->address() == (value >> 1)) {
+                    target = devices[i];
+                    break;
+                }
+            }
+
+            bool read = value & 1;
+            if (target && target->start(read)) {
+                reading = read;
+                i2c->SR1.value |= I2C_ADDR;
+                if (read) {
+                    i2c->SR2.value &= ~I2C_TRA;
+                } else {
+                    i2c->SR2.value |= I2C_TRA;
+                }
+            } else {
+                target = 0;
+                stats.nacks++;
+                i2c->SR1.value |= I2C_AF;
+            }
+            byte_finished();
+        });
+    }
+
+    void address_cleared(void) {
+        if (reading) {
+            rx_stopped = false;
+            pos_ack = true;
+            receive_byte();
+        } else {
+            i2c->SR1.value |= I2C_TXE;
+        }
+    }
+
+    // --- Transmitter ---
+
+    void send_byte(uint8_t value) {
+        shifting = true;
+        schedule(byte_time(), [this, value]() {
+            stats.bytes++;
+            bool ack = target && target->write(value);
+            if (!ack) {
+                stats.nacks++;
+                i2c->SR1.value |= I2C_AF;
+                tx_held = false;
+            } else if (tx_held && !stop_pending && !start_pending) {
+                tx_held = false;
+                i2c->SR1.value |= I2C_TXE;
+                byte_finished();
+                send_byte(tx_byte);
+                return;
+            } else {
+                i2c->SR1.value |= I2C_BTF;      // Clock stretched until DR is written
+            }
+            byte_finished();
+        });
+    }
+
+    // --- Receiver ---
+
+    void receive_byte(void) {
+        shifting = true;
+        uint8_t value = target ? target->read() : 0xFF;
+        schedule(byte_time(), [this, value]() {
+            stats.bytes++;
+            // ACK is sampled at the 9th clock; with POS it was meant for the
+            // byte after the one in the shift register, so this one gets the last sample
+            bool ack_bit = (i2c->CR1.value & (1 << 10)) != 0;
+            bool ack = (i2c->CR1.value & (1 << 11)) ? pos_ack : ack_bit;
+            pos_ack = ack_bit;
+
+            if (!(i2c->SR1.value & I2C_RXNE)) {
+                i2c->DR.value = value;
+                i2c->SR1.value |= I2C_RXNE;
+            } else {
+                rx_held = true;
+                rx_byte = value;
+                i2c->SR1.value |= I2C_BTF;
+            }
+
+            if (!ack) {
+                rx_stopped = true;              // NACK: slave stops sending
+            }
+            bool more = ack && !rx_held && !stop_pending && !start_pending;
+            byte_finished();
+            if (more) {
+                receive_byte();
+            }
+        });
+    }
+
+    void read_dr(void) {
+        if (rx_held) {
+            i2c->DR.value = rx_byte;
+            rx_held = false;
+            i2c->SR1.value &= ~I2C_BTF;
+            if (!rx_stopped && !shifting && (i2c->SR2.value & I2C_BUSY)) {
+                receive_byte();
+            }
+        } else {
+            i2c->SR1.value &= ~I2C_RXNE;
+        }
+    }
+
+    I2C_TypeDef* i2c;
+    SimI2CDevice* target;       // Device that ACKed its address
+    bool reading;               // Master receiver
+    bool shifting;              // A byte is on the wire
+    bool tx_held;               // Byte waiting in DR behind the shift register
+    uint8_t tx_byte;
+    bool rx_held;               // Byte waiting in the shift register (BTF)
+    uint8_t rx_byte;
+    bool rx_stopped;            // Last byte was NACKed
+    bool pos_ack;               // ACK sampled at the last byte (applies to this one with POS)
+    bool start_pending;
+    bool stop_pending;
+    bool sr1_read;              // SR1 read since the last flag clear
+    SimEventId phase_event;
+    SimTime busy_since;
+    GPIO_TypeDef* scl_port;
+    uint8_t scl_pin;
+    GPIO_TypeDef* sda_port;
+    uint8_t sda_pin;
+    bool sda_held;              // A slave pulls SDA low
+    uint32_t held_clocks;       // SCL rising edges until it lets go
+};
+
+// SCL / SDA of each controller
+static I2CModel i2c1_model(I2C1, GPIOB, 8, GPIOB, 9);
+static I2CModel i2c2_model(I2C2, GPIOB, 10, GPIOC, 12);
+static I2CModel i2c3_model(I2C3, GPIOA, 8, GPIOC, 9);
+
+static I2CModel* i2c_model(I2C_TypeDef* bus) {
+    if (bus == I2C2) return &i2c2_model;
+    if (bus == I2C3) return &i2c3_model;
+    return &i2c1_model;
+}
+
+void SIM_i2c_attach(I2C_TypeDef* bus, SimI2CDevice* device) {
+    i2c_model(bus)->devices.push_back(device);
+}
+
+void SIM_i2c_hold_sda(I2C_TypeDef* bus, uint32_t clocks) {
+    i2c_model(bus)->hold_sda(clocks);
+}
+
+void SIM_i2c_detach_all(I2C_TypeDef* bus) {
+    i2c_model(bus)->devices.clear();
+}
+
+void SIM_i2c_detach(I2C_TypeDef* bus, SimI2CDevice* device) {
+    std::vector<SimI2CDevice*>& devices = i2c_model(bus)->devices;
+    for (size_t i = 0; i < devices.size(); i++) {
+        if (devices[i] == device) {
+            devices.erase(devices.begin() + (long)i);
+            return;
+        }
+    }
+}
+
+I2C_TypeDef* SIM_i2c_bus(uint32_t index) {
+    static I2C_TypeDef* const buses[] = { I2C1, I2C2, I2C3 };
+    return (index < 3U) ? buses[index] : I2C1;
+}
+
+void SIM_i2c_get_stats(I2C_TypeDef* bus, SimI2CStats* stats) {
+    *stats = i2c_model(bus)->stats;
+}
+
+void SIM_i2c_clear_stats(I2C_TypeDef* bus) {
+    i2c_model(bus)->stats = SimI2CStats();
+}
+
+void sim_i2c_models_init(void) {
+    SIM_map_block("I2C1", &sim_I2C1, sizeof(sim_I2C1), &i2c1_model);
+    SIM_map_block("I2C2", &sim_I2C2, sizeof(sim_I2C2), &i2c2_model);
+    SIM_map_block("I2C3", &sim_I2C3, sizeof(sim_I2C3), &i2c3_model);
+
+    static I2C_TypeDef* const buses[3] = { I2C1, I2C2, I2C3 };
+    static const IRQn_Type ev_irq[3] = { I2C1_EV_IRQn, I2C2_EV_IRQn, I2C3_EV_IRQn };
+    static const IRQn_Type er_irq[3] = { I2C1_ER_IRQn, I2C2_ER_IRQn, I2C3_ER_IRQn };
+    for (int i = 0; i < 3; i++) {
+        I2C_TypeDef* bus = buses[i];
+        SIM_irq_add_source(ev_irq[i], [bus]() {
+            uint32_t sr1 = bus->SR1.value;
+            uint32_t cr2 = bus->CR2.value;
+            bool event = (cr2 & (1 << 9)) && (sr1 & (I2C_SB | I2C_ADDR | I2C_BTF));
+            bool buffer = (cr2 & (1 << 9)) && (cr2 & (1 << 10)) && (sr1 & (I2C_TXE | I2C_RXNE));
+            return event || buffer;
+        });
+        SIM_irq_add_source(er_irq[i], [bus]() {
+            return (bus->CR2.value & (1 << 8)) && (bus->SR1.value & 0xDF00);
+        });
+    }
+}
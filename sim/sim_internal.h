@@ -0,0 +1,89 @@
+/*
+* filename: sim_internal.h
+* purpose: Hooks shared between the simulator modules (not for test code)
+* author: Connor Ockerse
+* date: 10/19/2026
+*/
+
+#ifndef SIM_INTERNAL_H
+#define SIM_INTERNAL_H
+
+#include "sim.h"
+
+/**
+ * @brief Maps every register block to its model (once)
+ */
+void sim_models_init(void);
+
+/**
+ * @brief Maps the I2C controllers (called by sim_models_init)
+ */
+void sim_i2c_models_init(void);
+
+/**
+ * @brief Re-times every clocked model after an RCC change
+ */
+void sim_clock_changed(void);
+
+/**
+ * @brief Stop mode entry: every timer holds its count
+ */
+void sim_stop_enter(void);
+
+/**
+ * @brief Time from the wakeup event to the first instruction (LPDS dependent)
+ */
+SimTime sim_stop_wakeup_time(void);
+
+/**
+ * @brief Stop mode exit: SYSCLK back on HSI, timers count again
+ */
+void sim_stop_exit(void);
+
+/**
+ * @brief Calls listener(time) when the channel's compare match happens
+ * @details Used for output signals such as the HC-SR04 trigger pulse.
+ */
+void sim_timer_set_compare_listener(TIM_TypeDef* tim, uint8_t channel,
+                                    std::function<void(SimTime)> listener);
+
+/**
+ * @brief Calls listener on every update event that requests DMA (UDE)
+ */
+void sim_timer_set_update_listener(TIM_TypeDef* tim, std::function<void()> listener);
+
+/**
+ * @brief Calls listener(level) whenever the level of a pin changes
+ * @details Used for lines a device watches, such as SCL during a recovery.
+ */
+void sim_gpio_set_listener(GPIO_TypeDef* port, uint8_t pin, std::function<void(bool)> listener);
+
+/**
+ * @brief Drives a pin from outside, or lets go of it (level -1)
+ */
+void sim_gpio_drive(GPIO_TypeDef* port, uint8_t pin, int8_t level);
+
+/**
+ * @brief DMA-side read of 1, 2 or 4 bytes at a 32-bit address
+ * @details Registers are dispatched to their model (a whole register per
+ * access); anything else is host memory. Costs no CPU cycles.
+ */
+uint32_t sim_bus_read(uint32_t address, uint32_t size);
+
+/**
+ * @brief DMA-side write of 1, 2 or 4 bytes at a 32-bit address
+ */
+void sim_bus_write(uint32_t address, uint32_t value, uint32_t size);
+
+/**
+ * @brief True while the flash is programming or erasing
+ * @details Code runs from flash, so no interrupt is taken until it's done.
+ */
+bool sim_flash_stalled(void);
+
+/**
+ * @brief Resets the DS3231, 24C02C and HC-SR04 models
+ */
+void sim_devices_reset(void);
+
+#endif
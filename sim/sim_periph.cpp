@@ -0,0 +1,1968 @@
+/*
+* filename: sim_periph.cpp
+* purpose: Behavioral models of the on-chip peripherals used by the drivers
+* author: Connor Ockerse
+* date: 10/19/2026
+* note: Models cover what the drivers rely on, not the whole reference manual:
+* - RCC: HSE/PLL/LSI start-up delays, SYSCLK switch, bus prescalers
+* - PWR/FLASH: over-drive handshake; every clock change is checked against
+*   the flash wait states, regulator scale and bus limits (exit code 7)
+* - PVD: VDD against the PLS level (2.0-2.9 V) on EXTI line 16; below
+*   SIM_PDR_MV the chip resets ("PDR")
+* - GPIO/EXTI/SYSCFG: pin levels with pulls, BSRR, edge detection
+* - TIM1-6: up-counting with PSC/ARR/RCR shadow registers, compare and
+*   capture flags, encoder mode (TIM4), one-pulse mode
+* - ADC1: single software-triggered conversions with real sampling time
+* - USART2: TX holding + shift register timed from BRR
+* - IWDG: LSI-timed countdown that resets the chip
+* - WWDG: PCLK1/4096 countdown with the early wakeup interrupt at 0x40,
+*   reset at 0x3F or on a refresh outside the window
+* - RTC: LSI-clocked time of day (TR/SSR) and wakeup timer on EXTI line 22,
+*   behind the DBP bit and the WPR key sequence
+* - Stop mode: timers hold their count, SYSCLK comes back on HSI
+* - DWT: CYCCNT follows the simulated CPU cycles
+* - FLASH: KEYR unlock, word programming (bits only go 1 -> 0) and sector
+*   erase with datasheet typical times; while busy no interrupt is taken.
+*   Programs are seen on the next FLASH register access (stores to the
+*   array are plain memory), so drivers must poll SR after each write
+* - CRC: CRC-32 (0x04C11DB7, MSB first) over each word written to DR
+* - DMA1/2: memory-to-memory streams copy through the bus (registers
+*   included) and raise TCIF. Memory-to-peripheral streams move one item
+*   per request (only TIM1_UP -> DMA2 Stream5 is wired), with NDTR, HTIF/
+*   TCIF, circular and double-buffer (CT) like the hardware; an item always
+*   takes PSIZE bytes of memory, which is what the FIFO packs when MSIZE
+*   is smaller
+* Everything else (SCB, SysTick, ...) is plain storage.
+*/
+
+#include "sim.h"
+#include "sim_internal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+// === REGISTER STORAGE ===
+
+GPIO_TypeDef sim_GPIOA, sim_GPIOB, sim_GPIOC;
+RCC_TypeDef sim_RCC;
+PWR_TypeDef sim_PWR;
+FLASH_TypeDef sim_FLASH;
+EXTI_TypeDef sim_EXTI;
+SYSCFG_TypeDef sim_SYSCFG;
+TIM_TypeDef sim_TIM1, sim_TIM2, sim_TIM3, sim_TIM4, sim_TIM5, sim_TIM6;
+USART_TypeDef sim_USART2;
+ADC_TypeDef sim_ADC1;
+ADC_Common_TypeDef sim_ADC123_COMMON;
+IWDG_TypeDef sim_IWDG;
+WWDG_TypeDef sim_WWDG;
+RTC_TypeDef sim_RTC;
+DMA_TypeDef sim_DMA1, sim_DMA2;
+DMA_Stream_TypeDef sim_DMA1_Stream[8], sim_DMA2_Stream[8];
+CRC_TypeDef sim_CRC;
+DWT_Type sim_DWT;
+CoreDebug_Type sim_CoreDebug;
+SCB_Type sim_SCB;
+SysTick_Type sim_SysTick;
+uint8_t sim_bkpsram[4096];
+uint8_t sim_flash[0x80000];
+
+// Oscillator start-up times
+#define SIM_HSI_HZ          16000000U
+#define SIM_HSE_HZ          8000000U
+#define SIM_HSE_STARTUP     SIM_US(1000)
+#define SIM_PLL_LOCK        SIM_US(100)
+#define SIM_LSI_STARTUP     SIM_US(40)
+#define SIM_OD_READY        SIM_US(50)
+#define SIM_ODSW_READY      SIM_US(20)
+
+// LSI rate (SIM_set_lsi_hz): nominal 32 kHz, parts range over 17-47 kHz
+static uint32_t sim_lsi_hz = 32000U;
+
+// DMA memory-to-memory: HCLK cycles per item (read + write; the CRC unit
+// holds the bus for 4 cycles per word)
+#define SIM_DMA_M2M_CYCLES  5U
+
+// Flash program/erase (datasheet typical, x32 parallelism)
+#define SIM_FLASH_PROGRAM       SIM_US(16)      // Per word
+#define SIM_FLASH_ERASE_16K     SIM_MS(250)
+#define SIM_FLASH_ERASE_64K     SIM_MS(550)
+#define SIM_FLASH_ERASE_128K    SIM_MS(1000)
+
+// Supply: start-up VDD and the power-down reset level
+#define SIM_VDD_MV              3300U
+#define SIM_PDR_MV              1700U
+
+// Stop mode exit until the first instruction (datasheet tWUSTOP, approximate)
+#define SIM_STOP_WAKEUP_MAIN    SIM_US(13)      // Main regulator
+#define SIM_STOP_WAKEUP_LP      SIM_US(105)     // Low-power regulator (LPDS)
+
+static void check_clock_limits(const char* cause);
+
+// === RCC ===
+
+class RccModel : public SimModel {
+public:
+    void reset(void) {
+        RCC->CR.value = 0x00000083;             // HSION, HSIRDY
+        RCC->PLLCFGR.value = 0x24003010;
+        RCC->CSR.value = 0x0E000000;            // Reset flags (POR)
+        PWR->CSR.value = (1 << 14);             // VOSRDY
+    }
+
+    void write(SimReg* reg, uint32_t offset, uint32_t value) {
+        (void)offset;
+        if (reg == &RCC->CR) {
+            write_cr(value);
+        } else if (reg == &RCC->CFGR) {
+            write_cfgr(value);
+        } else if (reg == &RCC->CSR) {
+            write_csr(value);
+        } else if (reg == &RCC->BDCR) {
+            // Backup domain: writable only with DBP set
+            if (PWR->CR.value & (1 << 8)) {
+                reg->value = value;
+            }
+        } else {
+            reg->value = value;
+            if (reg == &RCC->PLLCFGR) {
+                sim_clock_changed();
+            }
+        }
+    }
+
+private:
+    void write_cr(uint32_t value) {
+        const uint32_t ready_bits = (1 << 1) | (1 << 17) | (1 << 25) | (1 << 27);
+        uint32_t old = RCC->CR.value;
+
+        // The PLL can't be stopped while it is the system clock
+        if (((RCC->CFGR.value >> 2) & 3) == 2) {
+            value |= (old & (1 << 24));
+        }
+        RCC->CR.value = (value & ~ready_bits) | (old & ready_bits);
+
+        // HSE on: ready after the crystal starts
+        if ((value & (1 << 16)) && !(old & (1 << 16))) {
+            SIM_schedule(SIM_now() + SIM_HSE_STARTUP, []() {
+                if (RCC->CR.value & (1 << 16)) {
+                    RCC->CR.value |= (1 << 17);
+                }
+            });
+        } else if (!(value & (1 << 16))) {
+            RCC->CR.value &= ~(1U << 17);
+        }
+
+        // PLL on: ready after lock
+        if ((value & (1 << 24)) && !(old & (1 << 24))) {
+            SIM_schedule(SIM_now() + SIM_PLL_LOCK, []() {
+                if (RCC->CR.value & (1 << 24)) {
+                    RCC->CR.value |= (1 << 25);
+                }
+            });
+        } else if (!(value & (1 << 24))) {
+            RCC->CR.value &= ~(1U << 25);
+        }
+    }
+
+    void write_cfgr(uint32_t value) {
+        uint32_t sws = RCC->CFGR.value & (3 << 2);
+        uint32_t sw = value & 3;
+        RCC->CFGR.value = (value & ~(3U << 2)) | sws;
+
+        // SYSCLK switches once the requested source is ready
+        bool ready = (sw == 0) ||
+                     ((sw == 1) && (RCC->CR.value & (1 << 17))) ||
+                     ((sw == 2) && (RCC->CR.value & (1 << 25)));
+        if (ready) {
+            RCC->CFGR.value = (RCC->CFGR.value & ~(3U << 2)) | (sw << 2);
+        }
+        sim_clock_changed();
+        check_clock_limits("RCC_CFGR write");
+    }
+
+    void write_csr(uint32_t value) {
+        uint32_t old = RCC->CSR.value;
+        RCC->CSR.value = (value & ~((1U << 1) | (1U << 24))) | (old & (1 << 1));
+
+        // RMVF clears the reset flags
+        if (value & (1 << 24)) {
+            RCC->CSR.value &= 0x00FFFFFF;
+        }
+
+        if ((value & 1) && !(old & 1)) {
+            SIM_schedule(SIM_now() + SIM_LSI_STARTUP, []() {
+                if (RCC->CSR.value & 1) {
+                    RCC->CSR.value |= (1 << 1);
+                }
+            });
+        } else if (!(value & 1)) {
+            RCC->CSR.value &= ~(1U << 1);
+        }
+    }
+};
+
+uint32_t SIM_clock_sysclk(void) {
+    uint32_t cfgr = RCC->CFGR.value;
+    switch ((cfgr >> 2) & 3) {
+        case 1:
+            return SIM_HSE_HZ;
+        case 2: {
+            uint32_t pll = RCC->PLLCFGR.value;
+            uint64_t src = (pll & (1 << 22)) ? SIM_HSE_HZ : SIM_HSI_HZ;
+            uint32_t m = pll & 0x3F;
+            uint32_t n = (pll >> 6) & 0x1FF;
+            uint32_t p = 2 * (((pll >> 16) & 3) + 1);
+            if ((m == 0) || (n == 0)) {
+                return SIM_HSI_HZ;
+            }
+            return (uint32_t)(src * n / m / p);
+        }
+        default:
+            return SIM_HSI_HZ;
+    }
+}
+
+uint32_t SIM_clock_hclk(void) {
+    static const uint16_t ahb_div[8] = { 2, 4, 8, 16, 64, 128, 256, 512 };
+    uint32_t hpre = (RCC->CFGR.value >> 4) & 0xF;
+    return (hpre < 8) ? SIM_clock_sysclk() : (SIM_clock_sysclk() / ahb_div[hpre - 8]);
+}
+
+static uint32_t apb_div(uint32_t ppre) {
+    return (ppre < 4) ? 1 : (2U << (ppre - 4));
+}
+
+uint32_t SIM_clock_pclk1(void) {
+    return SIM_clock_hclk() / apb_div((RCC->CFGR.value >> 10) & 7);
+}
+
+uint32_t SIM_clock_pclk2(void) {
+    return SIM_clock_hclk() / apb_div((RCC->CFGR.value >> 13) & 7);
+}
+
+uint32_t SIM_clock_timer(TIM_TypeDef* tim) {
+    // Timers on a divided APB bus run at twice the bus clock
+    if (tim == TIM1) {
+        uint32_t div = apb_div((RCC->CFGR.value >> 13) & 7);
+        return (div == 1) ? SIM_clock_pclk2() : (2 * SIM_clock_pclk2());
+    }
+    uint32_t div = apb_div((RCC->CFGR.value >> 10) & 7);
+    return (div == 1) ? SIM_clock_pclk1() : (2 * SIM_clock_pclk1());
+}
+
+// === PWR / FLASH ===
+
+// Over-drive handshake: ODEN -> ODRDY, then ODSWEN -> ODSWRDY. Also the
+// supply: the PVD compares VDD against the PLS level (PVDO, EXTI line 16)
+class PwrModel : public SimModel {
+public:
+    PwrModel() : vdd_mv(SIM_VDD_MV), pvdo(false), trip_time(0) {}
+
+    void reset(void) {
+        vdd_mv = SIM_VDD_MV;                    // Powered up again
+        pvdo = false;
+    }
+
+    void write(SimReg* reg, uint32_t offset, uint32_t value) {
+        (void)offset;
+        if (reg != &PWR->CR) {
+            reg->value = value;
+            return;
+        }
+        uint32_t old = PWR->CR.value;
+        PWR->CR.value = value;
+        update_pvd();
+
+        if ((value & (1 << 16)) && !(old & (1 << 16))) {
+            SIM_schedule(SIM_now() + SIM_OD_READY, []() {
+                if (PWR->CR.value & (1 << 16)) {
+                    PWR->CSR.value |= (1 << 16);
+                }
+            });
+        } else if (!(value & (1 << 16))) {
+            PWR->CSR.value &= ~((1U << 16) | (1U << 17));
+        }
+
+        if ((value & (1 << 17)) && !(old & (1 << 17)) && (PWR->CSR.value & (1 << 16))) {
+            SIM_schedule(SIM_now() + SIM_ODSW_READY, []() {
+                if (PWR->CR.value & (1 << 17)) {
+                    PWR->CSR.value |= (1 << 17);
+                }
+            });
+        } else if (!(value & (1 << 17))) {
+            PWR->CSR.value &= ~(1U << 17);
+        }
+        check_clock_limits("PWR_CR write");
+    }
+
+    void set_vdd(uint32_t mv) {
+        uint32_t old = vdd_mv;
+        vdd_mv = mv;
+        update_pvd();
+        if ((mv < SIM_PDR_MV) && (old >= SIM_PDR_MV)) {
+            SIM_system_reset("PDR");
+        }
+    }
+
+    uint32_t vdd_mv;
+    bool pvdo;
+    SimTime trip_time;                          // PVDO last went high
+
+private:
+    // PVDO = PVDE and VDD below the PLS level; edges go to EXTI line 16
+    void update_pvd(void) {
+        static const uint16_t levels_mv[8] = { 2000, 2100, 2300, 2500, 2600, 2700, 2800, 2900 };
+        uint32_t level_mv = levels_mv[(PWR->CR.value >> 5) & 7U];
+        bool below = (PWR->CR.value & (1 << 4)) && (vdd_mv < level_mv);
+        if (below == pvdo) {
+            return;
+        }
+        pvdo = below;
+        if (below) {
+            PWR->CSR.value |= (1 << 2);
+            trip_time = SIM_now();
+        } else {
+            PWR->CSR.value &= ~(1U << 2);
+        }
+        uint32_t trigger = below ? EXTI->RTSR.value : EXTI->FTSR.value;
+        if (trigger & (1U << 16)) {
+            EXTI->PR.value |= (1U << 16);
+        }
+    }
+};
+
+// Wait states, plus the program/erase interface over sim_flash
+class FlashModel : public SimModel {
+public:
+    FlashModel() : busy_from(0), busy_until(0), key_step(0) {
+        memset(sim_flash, 0xFF, sizeof(sim_flash));     // Shipped erased
+        memcpy(shadow, sim_flash, sizeof(shadow));
+        memset(&stats, 0, sizeof(stats));
+    }
+
+    void reset(void) {
+        FLASH->CR.value = 1U << 31;                     // LOCK
+        busy_from = busy_until = 0;
+        key_step = 0;
+        memcpy(shadow, sim_flash, sizeof(shadow));      // Whatever got stored stays
+    }
+
+    uint32_t read(SimReg* reg, uint32_t offset) {
+        (void)offset;
+        if (reg == &FLASH->SR) {
+            sync();
+            if (busy()) {
+                FLASH->SR.value |= (1U << 16);          // BSY
+            } else {
+                FLASH->SR.value &= ~(1U << 16);
+            }
+        }
+        return reg->value;
+    }
+
+    void write(SimReg* reg, uint32_t offset, uint32_t value) {
+        (void)offset;
+        if (reg == &FLASH->ACR) {
+            reg->value = value;
+            check_clock_limits("FLASH_ACR write");
+        } else if (reg == &FLASH->KEYR) {
+            // 0x45670123 then 0xCDEF89AB unlocks CR
+            if ((key_step == 0) && (value == 0x45670123U)) {
+                key_step = 1;
+            } else if ((key_step == 1) && (value == 0xCDEF89ABU)) {
+                FLASH->CR.value &= ~(1U << 31);
+                key_step = 0;
+            } else {
+                key_step = 0;
+            }
+        } else if (reg == &FLASH->SR) {
+            FLASH->SR.value &= ~(value & 0xF3U);        // rc_w1 flags
+        } else if (reg == &FLASH->CR) {
+            sync();
+            if (FLASH->CR.value & (1U << 31)) {
+                if (!(value & (1U << 31))) {
+                    return;                             // Locked: ignored
+                }
+            }
+            FLASH->CR.value = value & ~(1U << 16);      // STRT reads back 0
+            if ((value & (1U << 16)) && (value & (1U << 1)) && !(value & (1U << 31))) {
+                erase((value >> 3) & 0xFU);
+            }
+        } else {
+            reg->value = value;
+        }
+    }
+
+    bool busy(void) {
+        return SIM_now() < busy_until;
+    }
+
+    SimFlashStats stats;
+
+private:
+    static uint32_t sector_offset(uint32_t n) {
+        return (n < 4) ? (n * 0x4000U) : (n == 4) ? 0x10000U : ((n - 4) * 0x20000U);
+    }
+    static uint32_t sector_size(uint32_t n) {
+        return (n < 4) ? 0x4000U : (n == 4) ? 0x10000U : 0x20000U;
+    }
+
+    void occupy(SimTime duration) {
+        busy_from = SIM_now();
+        busy_until = busy_from + duration;
+        if (duration > stats.worst_stall) {
+            stats.worst_stall = duration;
+        }
+        SIM_schedule(busy_until, []() {});              // Lets the held interrupts in
+    }
+
+    // Picks up words the CPU stored into the array since the last look
+    void sync(void) {
+        if (busy() || !memcmp(shadow, sim_flash, sizeof(shadow))) {
+            return;
+        }
+        bool allowed = !(FLASH->CR.value & (1U << 31)) && (FLASH->CR.value & (1U << 0));
+        uint32_t words = 0;
+        for (uint32_t i = 0; i < sizeof(shadow); i += 4) {
+            uint32_t now_word, old_word;
+            memcpy(&now_word, &sim_flash[i], 4);
+            memcpy(&old_word, &shadow[i], 4);
+            if (now_word == old_word) {
+                continue;
+            }
+            if (!allowed) {
+                memcpy(&sim_flash[i], &old_word, 4);
+                FLASH->SR.value |= (1U << 7);           // PGSERR
+                stats.errors++;
+                continue;
+            }
+            now_word &= old_word;                       // Programming only clears bits
+            memcpy(&sim_flash[i], &now_word, 4);
+            memcpy(&shadow[i], &now_word, 4);
+            words++;
+        }
+        if (words) {
+            stats.words += words;
+            occupy(SIM_FLASH_PROGRAM * words);
+        }
+    }
+
+    void erase(uint32_t sector) {
+        if (sector > 7) {
+            return;
+        }
+        uint32_t size = sector_size(sector);
+        occupy((size == 0x4000U) ? SIM_FLASH_ERASE_16K : (size == 0x10000U) ? SIM_FLASH_ERASE_64K
+                                                                              : SIM_FLASH_ERASE_128K);
+        memset(&sim_flash[sector_offset(sector)], 0xFF, size);
+        memset(&shadow[sector_offset(sector)], 0xFF, size);
+        stats.erases++;
+    }
+
+    uint8_t shadow[sizeof(sim_flash)];      // What the cells really hold
+    SimTime busy_from;
+    SimTime busy_until;
+    uint32_t key_step;
+};
+
+// What the silicon would not survive (datasheet limits at 2.7-3.6 V)
+static void check_clock_limits(const char* cause) {
+    uint32_t hclk = SIM_clock_hclk();
+    uint32_t ws_needed = (hclk - 1) / 30000000U;
+    uint32_t ws = FLASH->ACR.value & 0xF;
+    bool overdrive = PWR->CSR.value & (1 << 17);
+    uint32_t vos = (PWR->CR.value >> 14) & 3;
+    uint32_t vos_max = (vos == 3) ? (overdrive ? 180000000U : 168000000U)
+                     : (vos == 2) ? (overdrive ? 168000000U : 144000000U)
+                     : 120000000U;
+
+    const char* problem = 0;
+    if (ws < ws_needed) {
+        problem = "not enough flash wait states";
+    } else if (hclk > vos_max) {
+        problem = "HCLK above the regulator scale (or over-drive) limit";
+    } else if (SIM_clock_pclk1() > 45000000U) {
+        problem = "PCLK1 above 45 MHz";
+    } else if (SIM_clock_pclk2() > 90000000U) {
+        problem = "PCLK2 above 90 MHz";
+    }
+    if (problem) {
+        fflush(stdout);
+        fprintf(stderr, "sim: %s after %s (HCLK %lu Hz, %lu WS, VOS %lu, OD %d)\n",
+                problem, cause, (unsigned long)hclk, (unsigned long)ws,
+                (unsigned long)vos, overdrive ? 1 : 0);
+        exit(7);
+    }
+}
+
+// === GPIO / EXTI ===
+
+static void exti_edge(uint8_t port_index, uint8_t pin, bool rising);
+
+class GpioModel : public SimModel {
+public:
+    GpioModel(GPIO_TypeDef* port, uint8_t index) : port(port), index(index) {}
+
+    void reset(void) {
+        if (port == GPIOA) {
+            port->MODER.value = 0xA8000000;     // Debug pins
+            port->PUPDR.value = 0x64000000;
+        } else if (port == GPIOB) {
+            port->MODER.value = 0x00000280;
+            port->PUPDR.value = 0x00000100;
+            port->OSPEEDR.value = 0x000000C0;
+        }
+        for (int i = 0; i < 16; i++) {
+            external[i] = -1;
+        }
+        levels = compute_levels();
+        port->IDR.value = levels;
+    }
+
+    uint32_t read(SimReg* reg, uint32_t offset) {
+        (void)offset;
+        if (reg == &port->IDR) {
+            port->IDR.value = compute_levels();
+        } else if (reg == &port->BSRR) {
+            return 0;
+        }
+        return reg->value;
+    }
+
+    void write(SimReg* reg, uint32_t offset, uint32_t value) {
+        (void)offset;
+        if (reg == &port->BSRR) {
+            // Set wins over reset
+            port->ODR.value = (port->ODR.value & ~(value >> 16)) | (value & 0xFFFF);
+        } else if (reg == &port->IDR) {
+            return;                             // Read-only
+        } else {
+            reg->value = value;
+        }
+        update();
+    }
+
+    void set_input(uint8_t pin, int8_t level) {
+        external[pin] = level;
+        update();
+    }
+
+    // Detects edges and forwards them to EXTI
+    void update(void) {
+        uint32_t now_levels = compute_levels();
+        uint32_t changed = now_levels ^ levels;
+        levels = now_levels;
+        port->IDR.value = now_levels;
+        for (uint8_t pin = 0; pin < 16; pin++) {
+            if (changed & (1U << pin)) {
+                exti_edge(index, pin, (now_levels >> pin) & 1);
+                if (listener[pin]) {
+                    listener[pin]((now_levels >> pin) & 1);
+                }
+            }
+        }
+    }
+
+    std::function<void(bool)> listener[16];
+
+private:
+    uint32_t compute_levels(void) {
+        uint32_t result = 0;
+        for (int pin = 0; pin < 16; pin++) {
+            uint32_t mode = (port->MODER.value >> (pin * 2)) & 3;
+            uint32_t pull = (port->PUPDR.value >> (pin * 2)) & 3;
+            uint32_t level;
+            bool open_drain = (port->OTYPER.value >> pin) & 1;
+            if ((mode == 1) && !(open_drain && ((port->ODR.value >> pin) & 1))) {
+                level = (port->ODR.value >> pin) & 1;   // Push-pull, or open drain pulling low
+            } else if ((mode == 1) && (external[pin] < 0)) {
+                level = 1;                      // Released open drain: external pull-up
+            } else if (external[pin] >= 0) {
+                level = (uint32_t)external[pin];
+            } else {
+                level = (pull == 1) ? 1 : 0;
+            }
+            result |= level << pin;
+        }
+        return result;
+    }
+
+    GPIO_TypeDef* port;
+    uint8_t index;
+    int8_t external[16];                        // -1 = not driven from outside
+    uint32_t levels;
+};
+
+static GpioModel gpio_a(GPIOA, 0), gpio_b(GPIOB, 1), gpio_c(GPIOC, 2);
+
+class ExtiModel : public SimModel {
+public:
+    void write(SimReg* reg, uint32_t offset, uint32_t value) {
+        (void)offset;
+        if (reg == &EXTI->PR) {
+            EXTI->PR.value &= ~value;           // rc_w1
+        } else if (reg == &EXTI->SWIER) {
+            EXTI->PR.value |= value & ~EXTI->SWIER.value;
+            EXTI->SWIER.value = value;
+        } else {
+            reg->value = value;
+        }
+    }
+};
+
+static void exti_edge(uint8_t port_index, uint8_t pin, bool rising) {
+    uint32_t select = (SYSCFG->EXTICR[pin / 4].value >> ((pin % 4) * 4)) & 0xF;
+    if (select != port_index) {
+        return;
+    }
+    uint32_t trigger = rising ? EXTI->RTSR.value : EXTI->FTSR.value;
+    if (trigger & (1U << pin)) {
+        EXTI->PR.value |= (1U << pin);
+    }
+}
+
+static GpioModel* gpio_model(GPIO_TypeDef* port) {
+    return (port == GPIOA) ? &gpio_a : (port == GPIOB) ? &gpio_b : &gpio_c;
+}
+
+void SIM_gpio_set_input(GPIO_TypeDef* port, uint8_t pin, uint8_t level) {
+    gpio_model(port)->set_input(pin, level ? 1 : 0);
+}
+
+void sim_gpio_drive(GPIO_TypeDef* port, uint8_t pin, int8_t level) {
+    gpio_model(port)->set_input(pin, level);
+}
+
+void sim_gpio_set_listener(GPIO_TypeDef* port, uint8_t pin, std::function<void(bool)> listener) {
+    gpio_model(port)->listener[pin] = listener;
+}
+
+uint8_t SIM_gpio_get_output(GPIO_TypeDef* port, uint8_t pin) {
+    return (uint8_t)((port->ODR.value >> pin) & 1);
+}
+
+// === TIMERS ===
+
+class TimerModel : public SimModel {
+public:
+    TimerModel(TIM_TypeDef* tim, bool wide, bool advanced)
+        : tim(tim), wide(wide), advanced(advanced) {}
+
+    void reset(void) {
+        tim->ARR.value = wide ? 0xFFFFFFFF : 0xFFFF;
+        psc_active = 0;
+        arr_active = tim->ARR.value;
+        rep_counter = 0;
+        running = false;
+        stopped = false;
+        base_time = 0;
+        base_cnt = 0;
+        refresh_tick();
+        update_event = 0;
+        for (int i = 0; i < 4; i++) {
+            compare_event[i] = 0;
+            ic_edges[i] = 0;
+        }
+        lsi_event = 0;
+    }
+
+    uint32_t read(SimReg* reg, uint32_t offset) {
+        (void)offset;
+        if (reg == &tim->CNT) {
+            tim->CNT.value = current_cnt();
+        } else if (reg == &tim->EGR) {
+            return 0;
+        } else {
+            // Reading CCRx of an input channel clears its capture flag
+            int ch = ccr_channel(reg);
+            if ((ch > 0) && is_input(ch)) {
+                tim->SR.value &= ~(1U << ch);
+            }
+        }
+        return reg->value;
+    }
+
+    void write(SimReg* reg, uint32_t offset, uint32_t value) {
+        (void)offset;
+        if (reg == &tim->CR1) {
+            write_cr1(value);
+        } else if (reg == &tim->SR) {
+            tim->SR.value &= value;             // rc_w0
+        } else if (reg == &tim->EGR) {
+            write_egr(value);
+        } else if (reg == &tim->CNT) {
+            rebase();
+            base_cnt = value & mask();
+            base_time = SIM_now();
+            tim->CNT.value = base_cnt;
+            reschedule();
+        } else if (reg == &tim->PSC) {
+            tim->PSC.value = value & 0xFFFF;    // Preloaded: applies at next update
+        } else if (reg == &tim->ARR) {
+            tim->ARR.value = value & mask();
+            if (!(tim->CR1.value & (1 << 7))) {
+                rebase();
+                arr_active = tim->ARR.value;
+                if (base_cnt > arr_active) {
+                    base_cnt = 0;
+                }
+                reschedule();
+            }
+        } else if (reg == &tim->RCR) {
+            tim->RCR.value = value & 0xFF;
+        } else {
+            reg->value = (ccr_channel(reg) > 0) ? (value & mask()) : value;
+            reschedule();
+        }
+        if (reg == &tim->CCER) {
+            for (int ch = 1; ch <= 4; ch++) {
+                if (!(value & (1U << ((ch - 1) * 4)))) {
+                    ic_edges[ch - 1] = 0;       // CCxE = 0 resets the input prescaler
+                }
+            }
+        }
+        follow_lsi();
+    }
+
+    // Counter value now
+    uint32_t current_cnt(void) {
+        if (!counting()) {
+            return base_cnt;
+        }
+        uint64_t ticks = (SIM_now() - base_time) / tick_units();
+        return (uint32_t)((base_cnt + ticks) % ((uint64_t)arr_active + 1));
+    }
+
+    // Re-anchors the count at the last tick (clock or configuration change)
+    void rebase(void) {
+        if (counting()) {
+            SimTime tick = tick_units();
+            uint64_t ticks = (SIM_now() - base_time) / tick;
+            uint64_t n = base_cnt + ticks;
+            uint64_t period = (uint64_t)arr_active + 1;
+            uint64_t wraps = n / period;
+            rep_counter -= (uint32_t)((wraps < rep_counter) ? wraps : rep_counter);
+            base_cnt = (uint32_t)(n % period);
+            base_time += ticks * tick;
+        }
+    }
+
+    void clock_changed(void) {
+        // Count what elapsed at the old rate, then continue at the new one
+        rebase();
+        refresh_tick();
+        reschedule();
+    }
+
+    void capture(uint8_t ch, bool rising) {
+        if (!is_input(ch) || !(tim->CCER.value & (1U << ((ch - 1) * 4)))) {
+            return;
+        }
+        bool p = tim->CCER.value & (1U << ((ch - 1) * 4 + 1));
+        bool np = tim->CCER.value & (1U << ((ch - 1) * 4 + 3));
+        bool match = (p && np) || (rising ? !p : p);
+        if (!match) {
+            return;
+        }
+        uint32_t psc = 1U << ((ccmr_field(ch) >> 2) & 3);      // ICxPSC: every 1, 2, 4, 8 edges
+        if (++ic_edges[ch - 1] < psc) {
+            return;
+        }
+        ic_edges[ch - 1] = 0;
+        ccr(ch)->value = current_cnt();
+        if (tim->SR.value & (1U << ch)) {
+            tim->SR.value |= (1U << (ch + 8));  // Overcapture
+        }
+        tim->SR.value |= (1U << ch);
+    }
+
+    void turn(int32_t counts) {
+        if (!encoder_mode() || !(tim->CR1.value & 1)) {
+            return;
+        }
+        int64_t period = (int64_t)arr_active + 1;
+        int64_t n = (int64_t)base_cnt + counts;
+        if ((n < 0) || (n >= period)) {
+            tim->SR.value |= 1;                 // Wrapped: update event
+        }
+        n %= period;
+        if (n < 0) {
+            n += period;
+        }
+        base_cnt = (uint32_t)n;
+        tim->CNT.value = base_cnt;
+        if (counts < 0) {
+            tim->CR1.value |= (1 << 4);         // DIR = down
+        } else {
+            tim->CR1.value &= ~(1U << 4);
+        }
+    }
+
+    // Stop mode gates the kernel clock: the count holds, no events
+    void set_stopped(bool stop) {
+        if (stop) {
+            rebase();
+            stopped = true;
+        } else {
+            stopped = false;
+            base_time = SIM_now();
+        }
+        reschedule();
+    }
+
+    std::function<void(SimTime)> compare_listener[4];
+    std::function<void()> update_listener;
+
+private:
+    uint32_t mask(void) {
+        return wide ? 0xFFFFFFFF : 0xFFFF;
+    }
+
+    bool encoder_mode(void) {
+        uint32_t sms = tim->SMCR.value & 7;
+        return (sms >= 1) && (sms <= 3);
+    }
+
+    bool counting(void) {
+        return running && !stopped && !encoder_mode();
+    }
+
+    SimTime tick_units(void) {
+        return tick;
+    }
+
+    void refresh_tick(void) {
+        tick = SIM_clock_period(SIM_clock_timer(tim), (uint64_t)psc_active + 1);
+    }
+
+    SimReg* ccr(int ch) {
+        return &tim->CCR1 + (ch - 1);
+    }
+
+    int ccr_channel(SimReg* reg) {
+        if ((reg >= &tim->CCR1) && (reg <= &tim->CCR4)) {
+            return (int)(reg - &tim->CCR1) + 1;
+        }
+        return 0;
+    }
+
+    uint32_t ccmr_field(int ch) {
+        uint32_t ccmr = (ch <= 2) ? tim->CCMR1.value : tim->CCMR2.value;
+        return (ccmr >> (((ch - 1) % 2) * 8)) & 0xFF;
+    }
+
+    bool is_input(int ch) {
+        return (ccmr_field(ch) & 3) != 0;
+    }
+
+    void write_cr1(uint32_t value) {
+        bool was_on = tim->CR1.value & 1;
+        bool on = value & 1;
+
+        if (was_on && !on) {
+            rebase();
+            running = false;
+        }
+        tim->CR1.value = value;
+        if (!was_on && on) {
+            running = true;
+            base_time = SIM_now();
+        }
+        reschedule();
+    }
+
+    void write_egr(uint32_t value) {
+        if (value & 1) {
+            // UG: reinitialize the counter and load the shadow registers
+            base_cnt = 0;
+            base_time = SIM_now();
+            load_shadows();
+
+            // URS: only a real overflow raises the flag and the DMA request
+            if (!(tim->CR1.value & (1 << 2))) {
+                tim->SR.value |= 1;
+                if ((tim->DIER.value & (1 << 8)) && update_listener) {
+                    update_listener();
+                }
+            }
+        }
+        for (int ch = 1; ch <= 4; ch++) {
+            if (value & (1U << ch)) {
+                tim->SR.value |= (1U << ch);
+            }
+        }
+        reschedule();
+    }
+
+    void load_shadows(void) {
+        psc_active = tim->PSC.value;
+        arr_active = tim->ARR.value;
+        rep_counter = advanced ? tim->RCR.value : 0;
+        refresh_tick();
+    }
+
+    // Update event at the end of the repetition count
+    void on_update(void) {
+        update_event = 0;
+        base_cnt = 0;
+        base_time = SIM_now();
+        load_shadows();
+        tim->SR.value |= 1;
+
+        if ((tim->DIER.value & (1 << 8)) && update_listener) {
+            update_listener();
+        }
+        if (tim->CR1.value & (1 << 3)) {
+            // One-pulse mode stops at the update event
+            tim->CR1.value &= ~1U;
+            running = false;
+        }
+        reschedule();
+    }
+
+    void on_compare(int ch) {
+        compare_event[ch - 1] = 0;
+        tim->SR.value |= (1U << ch);
+        if (compare_listener[ch - 1]) {
+            compare_listener[ch - 1](SIM_now());
+        }
+        reschedule_compare(ch);
+    }
+
+    void reschedule(void) {
+        if (update_event) {
+            SIM_cancel(update_event);
+            update_event = 0;
+        }
+        for (int ch = 1; ch <= 4; ch++) {
+            reschedule_compare(ch);
+        }
+        if (!counting()) {
+            return;
+        }
+
+        // UEV after the remaining repetitions: counter wraps (rep + 1) times
+        uint64_t period = (uint64_t)arr_active + 1;
+        uint64_t n = period * ((uint64_t)rep_counter + 1);
+        SimTime at = base_time + (n - base_cnt) * tick_units();
+        update_event = SIM_schedule(at, [this]() { on_update(); });
+    }
+
+    // TIM5 only: TI4_RMP = 01 feeds the LSI to channel 4 (LSI calibration)
+    bool lsi_input(void) {
+        return (tim == TIM5) && (((tim->OR.value >> 6) & 3) == 1) && is_input(4) &&
+               (tim->CCER.value & (1U << 12)) && (RCC->CSR.value & (1 << 1));
+    }
+
+    // LSI rising edges, on a grid from time 0, only while someone captures them
+    void follow_lsi(void) {
+        if (lsi_event || !lsi_input()) {
+            return;
+        }
+        SimTime period = SIM_clock_period(sim_lsi_hz, 1);
+        lsi_event = SIM_schedule((SIM_now() / period + 1) * period, [this]() {
+            lsi_event = 0;
+            if (lsi_input()) {
+                capture(4, true);
+                follow_lsi();
+            }
+        });
+    }
+
+    void reschedule_compare(int ch) {
+        if (compare_event[ch - 1]) {
+            SIM_cancel(compare_event[ch - 1]);
+            compare_event[ch - 1] = 0;
+        }
+        if (!counting() || is_input(ch)) {
+            return;
+        }
+
+        // Only compares someone can observe are scheduled (interrupt or listener)
+        bool wanted = (tim->DIER.value & (1U << ch)) || compare_listener[ch - 1];
+        uint32_t value = ccr(ch)->value;
+        if (!wanted || (value > arr_active)) {
+            return;
+        }
+
+        SimTime tick = tick_units();
+        uint64_t period = (uint64_t)arr_active + 1;
+        uint64_t now_n = base_cnt + (SIM_now() - base_time) / tick;
+        uint64_t n = now_n - (now_n % period) + value;
+        if (n <= now_n) {
+            n += period;
+        }
+        SimTime at = base_time + (n - base_cnt) * tick;
+        compare_event[ch - 1] = SIM_schedule(at, [this, ch]() { on_compare(ch); });
+    }
+
+    TIM_TypeDef* tim;
+    bool wide;                  // 32-bit counter (TIM2, TIM5)
+    bool advanced;              // Has a repetition counter (TIM1)
+
+    uint32_t psc_active;        // Shadow registers
+    uint32_t arr_active;
+    uint32_t rep_counter;
+    SimTime tick;               // Duration of one count at the current clock
+    bool running;
+    bool stopped;               // Core in Stop mode
+    SimTime base_time;          // Time at which the counter was base_cnt
+    uint32_t base_cnt;
+    SimEventId update_event;
+    SimEventId compare_event[4];
+    uint32_t ic_edges[4];       // Edges counted towards the next capture (ICxPSC)
+    SimEventId lsi_event;       // Next LSI edge on TIM5_CH4
+};
+
+static TimerModel tim1_model(TIM1, false, true);
+static TimerModel tim2_model(TIM2, true, false);
+static TimerModel tim3_model(TIM3, false, false);
+static TimerModel tim4_model(TIM4, false, false);
+static TimerModel tim5_model(TIM5, true, false);
+static TimerModel tim6_model(TIM6, false, false);
+
+static TimerModel* timer_model(TIM_TypeDef* tim) {
+    if (tim == TIM1) return &tim1_model;
+    if (tim == TIM2) return &tim2_model;
+    if (tim == TIM3) return &tim3_model;
+    if (tim == TIM4) return &tim4_model;
+    if (tim == TIM5) return &tim5_model;
+    return &tim6_model;
+}
+
+void SIM_timer_capture(TIM_TypeDef* tim, uint8_t channel, uint8_t rising) {
+    timer_model(tim)->capture(channel, rising != 0);
+}
+
+void sim_timer_set_compare_listener(TIM_TypeDef* tim, uint8_t channel,
+                                    std::function<void(SimTime)> listener) {
+    timer_model(tim)->compare_listener[channel - 1] = listener;
+}
+
+void sim_timer_set_update_listener(TIM_TypeDef* tim, std::function<void()> listener) {
+    timer_model(tim)->update_listener = listener;
+}
+
+void SIM_encoder_turn(int32_t counts) {
+    tim4_model.turn(counts);
+}
+
+// === ADC ===
+
+static uint16_t adc_inputs[19];
+
+class AdcModel : public SimModel {
+public:
+    void reset(void) {
+        conversion = 0;
+    }
+
+    uint32_t read(SimReg* reg, uint32_t offset) {
+        (void)offset;
+        if (reg == &ADC1->DR) {
+            ADC1->SR.value &= ~(1U << 1);       // Reading DR clears EOC
+        }
+        return reg->value;
+    }
+
+    void write(SimReg* reg, uint32_t offset, uint32_t value) {
+        (void)offset;
+        if (reg == &ADC1->SR) {
+            ADC1->SR.value &= value;            // rc_w0
+        } else if (reg == &ADC1->CR2) {
+            ADC1->CR2.value = value & ~(1U << 30);
+            if ((value & (1U << 30)) && (value & 1)) {
+                start();
+            }
+        } else {
+            reg->value = value;
+        }
+    }
+
+private:
+    void start(void) {
+        static const uint16_t sample_cycles[8] = { 3, 15, 28, 56, 84, 112, 144, 480 };
+        uint32_t channel = ADC1->SQR3.value & 0x1F;
+        uint32_t smp = (channel < 10) ? (ADC1->SMPR2.value >> (channel * 3))
+                                      : (ADC1->SMPR1.value >> ((channel - 10) * 3));
+        uint32_t adcpre = (ADC123_COMMON->CCR.value >> 16) & 3;
+        uint32_t adc_clock = SIM_clock_pclk2() / (2 * (adcpre + 1));
+
+        // Sampling + 12 cycles of successive approximation
+        ADC1->SR.value |= (1 << 4);             // STRT
+        if (conversion) {
+            SIM_cancel(conversion);
+        }
+        conversion = SIM_schedule(SIM_now() + SIM_clock_period(adc_clock, sample_cycles[smp & 7] + 12U),
+            [this, channel]() {
+                conversion = 0;
+                ADC1->DR.value = adc_inputs[(channel < 19) ? channel : 0] & 0xFFF;
+                ADC1->SR.value |= (1 << 1);     // EOC
+            });
+    }
+
+    SimEventId conversion;
+};
+
+void SIM_adc_set(uint8_t channel, uint16_t value) {
+    if (channel < 19) {
+        adc_inputs[channel] = value;
+    }
+}
+
+// === USART2 ===
+
+static std::string usart_output;
+static bool usart_echo = false;
+
+class UsartModel : public SimModel {
+public:
+    void reset(void) {
+        USART2->SR.value = 0x00C0;              // TXE, TC
+        shifting = false;
+        holding = false;
+    }
+
+    void write(SimReg* reg, uint32_t offset, uint32_t value) {
+        (void)offset;
+        if (reg == &USART2->SR) {
+            // Only TC, RXNE, LBD and CTS can be cleared
+            USART2->SR.value &= (value | ~0x0360U);
+        } else if (reg == &USART2->DR) {
+            write_dr(value);
+        } else {
+            reg->value = value;
+        }
+    }
+
+private:
+    void write_dr(uint32_t value) {
+        USART2->DR.value = value & 0x1FF;
+        if ((USART2->CR1.value & ((1 << 13) | (1 << 3))) != ((1 << 13) | (1 << 3))) {
+            return;                             // UE and TE needed
+        }
+        USART2->SR.value &= ~(1U << 6);         // TC
+        if (!shifting) {
+            shift((uint8_t)value);
+        } else {
+            held = (uint8_t)value;
+            holding = true;
+            USART2->SR.value &= ~(1U << 7);     // TXE
+        }
+    }
+
+    // Start bit + 8 data bits + stop bit, one bit = BRR clocks (16x oversampling)
+    void shift(uint8_t byte) {
+        uint32_t brr = USART2->BRR.value ? USART2->BRR.value : 1;
+        shifting = true;
+        SIM_schedule(SIM_now() + SIM_clock_period(SIM_clock_pclk1(), 10ULL * brr), [this, byte]() {
+            usart_output.push_back((char)byte);
+            if (usart_echo) {
+                fputc(byte, stdout);
+            }
+            if (holding) {
+                holding = false;
+                USART2->SR.value |= (1 << 7);
+                shift(held);
+            } else {
+                shifting = false;
+                USART2->SR.value |= (1 << 6);
+            }
+        });
+    }
+
+    bool shifting;
+    bool holding;
+    uint8_t held;
+};
+
+const char* SIM_usart_output(void) {
+    return usart_output.c_str();
+}
+
+uint32_t SIM_usart_output_length(void) {
+    return (uint32_t)usart_output.size();
+}
+
+void SIM_usart_clear(void) {
+    usart_output.clear();
+}
+
+void SIM_usart_echo(uint8_t enable) {
+    usart_echo = enable != 0;
+}
+
+// === IWDG ===
+
+class IwdgModel : public SimModel {
+public:
+    void reset(void) {
+        IWDG->RLR.value = 0xFFF;
+        started = false;
+        unlocked = false;
+        pr_active = 0;
+        rlr_active = 0xFFF;
+        expiry = 0;
+    }
+
+    uint32_t read(SimReg* reg, uint32_t offset) {
+        (void)offset;
+        return (reg == &IWDG->KR) ? 0 : reg->value;
+    }
+
+    void write(SimReg* reg, uint32_t offset, uint32_t value) {
+        (void)offset;
+        if (reg == &IWDG->KR) {
+            write_key(value & 0xFFFF);
+        } else if ((reg == &IWDG->PR) || (reg == &IWDG->RLR)) {
+            if (!unlocked) {
+                return;
+            }
+            bool is_pr = (reg == &IWDG->PR);
+            reg->value = value & (is_pr ? 7 : 0xFFF);
+            uint32_t flag = is_pr ? 1 : 2;      // PVU / RVU
+            IWDG->SR.value |= flag;
+
+            // The new value reaches the LSI domain after 5 LSI cycles
+            SIM_schedule(SIM_now() + SIM_clock_period(sim_lsi_hz, 5), [this, is_pr, flag]() {
+                IWDG->SR.value &= ~flag;
+                if (is_pr) {
+                    pr_active = IWDG->PR.value;
+                } else {
+                    rlr_active = IWDG->RLR.value;
+                }
+            });
+        }
+    }
+
+private:
+    void write_key(uint32_t key) {
+        unlocked = (key == 0x5555);
+        if (key == 0xCCCC) {
+            started = true;
+            reload();
+        } else if ((key == 0xAAAA) && started) {
+            reload();
+        }
+    }
+
+    void reload(void) {
+        if (expiry) {
+            SIM_cancel(expiry);
+        }
+        uint64_t lsi_cycles = ((uint64_t)rlr_active + 1) * (4U << pr_active);
+        expiry = SIM_schedule(SIM_now() + SIM_clock_period(sim_lsi_hz, lsi_cycles), [this]() {
+            expiry = 0;
+            SIM_system_reset("IWDG");
+        });
+    }
+
+    bool started;
+    bool unlocked;
+    uint32_t pr_active;
+    uint32_t rlr_active;
+    SimEventId expiry;
+};
+
+// === WWDG ===
+
+class WwdgModel : public SimModel {
+public:
+    void reset(void) {
+        WWDG->CR.value = 0x7F;
+        WWDG->CFR.value = 0x7F;
+        load = 0x7F;
+        load_time = 0;
+        frozen = false;
+        ewi_event = 0;                          // The event queue was cleared by SIM_reset
+        reset_event = 0;
+    }
+
+    uint32_t read(SimReg* reg, uint32_t offset) {
+        (void)offset;
+        if (reg == &WWDG->CR) {
+            reg->value = (reg->value & (1 << 7)) | counter();
+        }
+        return reg->value;
+    }
+
+    void write(SimReg* reg, uint32_t offset, uint32_t value) {
+        (void)offset;
+        if (reg == &WWDG->CR) {
+            bool active = WWDG->CR.value & (1 << 7);
+            // Refresh while the counter is above the window: reset
+            if (active && (counter() > (WWDG->CFR.value & 0x7F))) {
+                SIM_system_reset("WWDG window");
+                return;
+            }
+            WWDG->CR.value = (value & (1 << 7)) | (active ? (1 << 7) : 0) | (value & 0x7F);
+            if (WWDG->CR.value & (1 << 7)) {
+                if (!(value & (1 << 6))) {
+                    SIM_system_reset("WWDG");   // T6 clear: immediate reset
+                    return;
+                }
+                rebase(value & 0x7F);
+            }
+        } else if (reg == &WWDG->SR) {
+            reg->value &= value & 1;            // EWIF: rc_w0
+        } else {
+            reg->value = value & 0x3FF;
+            if (reg == &WWDG->CFR) {
+                rebase(counter());              // New WDGTB
+            }
+        }
+    }
+
+    // PCLK1 changed or stopped (Stop mode): keep the count, redo the timing
+    void clock_changed(void) {
+        rebase(counter());
+    }
+
+    void set_stopped(bool stopped) {
+        uint32_t count = counter();
+        frozen = stopped;
+        rebase(count);
+    }
+
+private:
+    SimTime count_period(void) {
+        uint32_t tb = (WWDG->CFR.value >> 7) & 3;
+        return SIM_clock_period(SIM_clock_pclk1(), 4096ULL << tb);
+    }
+
+    uint32_t counter(void) {
+        if (!(WWDG->CR.value & (1 << 7)) || frozen) {
+            return load;
+        }
+        uint64_t counts = (SIM_now() - load_time) / count_period();
+        return (counts >= load) ? 0 : (uint32_t)(load - counts);
+    }
+
+    void rebase(uint32_t value) {
+        load = value & 0x7F;
+        load_time = SIM_now();
+        if (ewi_event) {
+            SIM_cancel(ewi_event);
+            ewi_event = 0;
+        }
+        if (reset_event) {
+            SIM_cancel(reset_event);
+            reset_event = 0;
+        }
+        if (!(WWDG->CR.value & (1 << 7)) || frozen) {
+            return;
+        }
+        SimTime period = count_period();
+        if (load >= 0x40) {
+            ewi_event = SIM_schedule(load_time + (load - 0x40) * period, [this]() {
+                ewi_event = 0;
+                WWDG->SR.value |= 1;            // EWIF
+            });
+        }
+        reset_event = SIM_schedule(load_time + (load - 0x3F) * period, [this]() {
+            reset_event = 0;
+            SIM_system_reset("WWDG");
+        });
+    }
+
+    uint32_t load;          // Counter value at load_time
+    SimTime load_time;
+    bool frozen;
+    SimEventId ewi_event;
+    SimEventId reset_event;
+};
+
+// === RTC ===
+
+// Time of day and wakeup timer on the LSI (RTCSEL = 10); the date is storage
+class RtcModel : public SimModel {
+public:
+    void reset(void) {
+        RTC->ISR.value = 0x00000007;            // ALRAWF, ALRBWF, WUTWF
+        RTC->PRER.value = 0x007F00FF;
+        RTC->WUTR.value = 0x0000FFFF;
+        unlock_step = 0;
+        counting = false;
+        base_time = 0;
+        base_ticks = 0;
+        wakeup_event = 0;                       // The event queue was cleared by SIM_reset
+    }
+
+    // Counts what elapsed at the old LSI rate before it changes
+    void lsi_changed(void) {
+        if (counting && clocked()) {
+            SimTime period = SIM_clock_period(sim_lsi_hz, (uint64_t)prediv_a() + 1);
+            uint64_t n = (SIM_now() - base_time) / period;
+            base_ticks += n;
+            base_time += n * period;
+        }
+    }
+
+    uint32_t read(SimReg* reg, uint32_t offset) {
+        (void)offset;
+        uint32_t period = prediv_s() + 1;
+        if (RTC->ISR.value & (1 << 7)) {
+            return reg->value;                  // Init mode: TR holds what was written
+        }
+        if (reg == &RTC->TR) {
+            uint32_t sec = (uint32_t)((ticks() / period) % 86400U);
+            reg->value = (bcd(sec / 3600) << 16) | (bcd((sec / 60) % 60) << 8) | bcd(sec % 60);
+        } else if (reg == &RTC->SSR) {
+            reg->value = prediv_s() - (uint32_t)(ticks() % period);
+        }
+        return reg->value;
+    }
+
+    void write(SimReg* reg, uint32_t offset, uint32_t value) {
+        (void)offset;
+        if (!(PWR->CR.value & (1 << 8))) {
+            return;                             // DBP: backup domain write protected
+        }
+        if (reg == &RTC->WPR) {
+            // 0xCA then 0x53 unlocks, anything else locks again
+            uint32_t key = value & 0xFF;
+            unlock_step = (key == 0xCA) ? 1 : ((key == 0x53) && (unlock_step == 1)) ? 2 : 0;
+        } else if (reg == &RTC->ISR) {
+            write_isr(value);
+        } else if (reg >= &RTC->BKP0R) {
+            reg->value = value;                 // Backup registers are not behind WPR
+        } else if (unlock_step != 2) {
+            return;
+        } else if (reg == &RTC->CR) {
+            write_cr(value);
+        } else if ((reg == &RTC->TR) || (reg == &RTC->DR) || (reg == &RTC->PRER)) {
+            if (RTC->ISR.value & (1 << 6)) {    // INITF
+                reg->value = value;
+            }
+        } else if (reg == &RTC->WUTR) {
+            if (RTC->ISR.value & (1 << 2)) {    // WUTWF
+                reg->value = value & 0xFFFF;
+            }
+        } else {
+            reg->value = value;
+        }
+    }
+
+private:
+    static uint32_t bcd(uint32_t value) {
+        return ((value / 10) << 4) | (value % 10);
+    }
+
+    static uint32_t from_bcd(uint32_t value) {
+        return ((value >> 4) * 10U) + (value & 0xF);
+    }
+
+    uint32_t prediv_s(void) {
+        return RTC->PRER.value & 0x7FFF;
+    }
+
+    uint32_t prediv_a(void) {
+        return (RTC->PRER.value >> 16) & 0x7F;
+    }
+
+    bool clocked(void) {
+        uint32_t bdcr = RCC->BDCR.value;
+        return (bdcr & (1 << 15)) && (((bdcr >> 8) & 3) == 2) && (RCC->CSR.value & (1 << 1));
+    }
+
+    // ck_apre periods since midnight
+    uint64_t ticks(void) {
+        if (!counting || !clocked()) {
+            return base_ticks;
+        }
+        SimTime period = SIM_clock_period(sim_lsi_hz, (uint64_t)prediv_a() + 1);
+        return base_ticks + (SIM_now() - base_time) / period;
+    }
+
+    void write_isr(uint32_t value) {
+        // Event flags: rc_w0, allowed without the key
+        RTC->ISR.value &= ~(~value & 0x3F00U);
+        if (unlock_step != 2) {
+            return;
+        }
+
+        bool was_init = RTC->ISR.value & (1 << 7);
+        if ((value & (1 << 7)) && !was_init) {
+            // Calendar stops; INITF after 2 RTCCLK cycles
+            base_ticks = ticks();
+            counting = false;
+            RTC->ISR.value |= (1 << 7);
+            SIM_schedule(SIM_now() + SIM_clock_period(sim_lsi_hz, 2), []() {
+                if (RTC->ISR.value & (1 << 7)) {
+                    RTC->ISR.value |= (1 << 6);
+                }
+            });
+        } else if (!(value & (1 << 7)) && was_init) {
+            // Leaving init mode loads TR and restarts the subsecond count
+            uint32_t tr = RTC->TR.value;
+            uint32_t sec = from_bcd((tr >> 16) & 0x3F) * 3600U +
+                           from_bcd((tr >> 8) & 0x7F) * 60U + from_bcd(tr & 0x7F);
+            base_ticks = (uint64_t)sec * (prediv_s() + 1);
+            base_time = SIM_now();
+            counting = true;
+            RTC->ISR.value &= ~((1U << 7) | (1U << 6));
+        }
+    }
+
+    void write_cr(uint32_t value) {
+        uint32_t old = RTC->CR.value;
+        RTC->CR.value = value;
+        if (!((old ^ value) & (1 << 10))) {
+            return;
+        }
+        if (value & (1 << 10)) {
+            // WUTE: the down-counter starts from WUTR
+            RTC->ISR.value &= ~(1U << 2);
+            schedule_wakeup();
+        } else {
+            if (wakeup_event) {
+                SIM_cancel(wakeup_event);
+                wakeup_event = 0;
+            }
+            // WUTWF after 2 RTCCLK cycles
+            SIM_schedule(SIM_now() + SIM_clock_period(sim_lsi_hz, 2), []() {
+                if (!(RTC->CR.value & (1 << 10))) {
+                    RTC->ISR.value |= (1 << 2);
+                }
+            });
+        }
+    }
+
+    // WUTF every WUTR + 1 wakeup clock periods, also raising EXTI line 22
+    void schedule_wakeup(void) {
+        if (!clocked()) {
+            return;
+        }
+        uint32_t wucksel = RTC->CR.value & 7;
+        uint64_t reload = (uint64_t)RTC->WUTR.value + 1;
+        uint64_t lsi_cycles;
+        if (wucksel < 4) {
+            lsi_cycles = reload * (16U >> wucksel);             // RTC/16 ... RTC/2
+        } else {
+            if (wucksel >= 6) {
+                reload += 0x10000;                              // ck_spre, WUT + 2^16
+            }
+            lsi_cycles = reload * (prediv_a() + 1) * (prediv_s() + 1);
+        }
+        wakeup_event = SIM_schedule(SIM_now() + SIM_clock_period(sim_lsi_hz, lsi_cycles), [this]() {
+            wakeup_event = 0;
+            RTC->ISR.value |= (1 << 10);        // WUTF
+            if (EXTI->RTSR.value & (1U << 22)) {
+                EXTI->PR.value |= (1U << 22);
+            }
+            schedule_wakeup();
+        });
+    }
+
+    uint32_t unlock_step;       // WPR keys seen (2 = unlocked)
+    bool counting;              // Calendar running (left init mode once)
+    SimTime base_time;          // Time at which the calendar was base_ticks
+    uint64_t base_ticks;
+    SimEventId wakeup_event;
+};
+
+// === CRC ===
+
+class CrcModel : public SimModel {
+public:
+    void reset(void) {
+        CRC->DR.value = 0xFFFFFFFF;
+    }
+
+    void write(SimReg* reg, uint32_t offset, uint32_t value) {
+        (void)offset;
+        if (reg == &CRC->DR) {
+            uint32_t crc = CRC->DR.value ^ value;
+            for (int i = 0; i < 32; i++) {
+                crc = (crc & 0x80000000U) ? ((crc << 1) ^ 0x04C11DB7U) : (crc << 1);
+            }
+            CRC->DR.value = crc;
+        } else if (reg == &CRC->CR) {
+            if (value & 1) {
+                CRC->DR.value = 0xFFFFFFFF;     // RESET (reads back 0)
+            }
+        } else {
+            reg->value = value & 0xFF;          // IDR
+        }
+    }
+};
+
+// === DMA ===
+
+// One controller: the flag registers and its eight streams
+class DmaModel : public SimModel {
+public:
+    DmaModel(DMA_TypeDef* dma, DMA_Stream_TypeDef* streams) : dma(dma), streams(streams) {}
+
+    void reset(void) {
+        for (int i = 0; i < 8; i++) {
+            done_event[i] = 0;                  // The event queue was cleared by SIM_reset
+            offset[i] = 0;
+        }
+    }
+
+    // A peripheral's DMA request: one item of a memory-to-peripheral stream
+    void request(uint32_t stream) {
+        DMA_Stream_TypeDef* s = &streams[stream];
+        uint32_t cr = s->CR.value;
+        if (!(cr & 1) || (((cr >> 6) & 3) != 1)) {
+            return;                             // Off, or not memory-to-peripheral
+        }
+        uint32_t size = 1U << ((cr >> 11) & 3);             // PSIZE
+        uint32_t memory = ((cr & (1 << 19)) ? s->M1AR.value : s->M0AR.value) + offset[stream];
+        uint32_t value = sim_bus_read(memory, size);
+        sim_bus_write(s->PAR.value, value, size);
+        if (write_listener[stream]) {
+            write_listener[stream](value);
+        }
+        offset[stream] += (cr & (1 << 10)) ? size : 0;       // MINC
+
+        uint32_t left = (s->NDTR.value & 0xFFFF) - 1;
+        s->NDTR.value = left;
+        if (left == reload[stream] / 2) {
+            set_flags(stream, 1 << 4);                      // HTIF
+        }
+        if (left == 0) {
+            set_flags(stream, 1 << 5);                      // TCIF
+            offset[stream] = 0;
+            if (cr & (1 << 8)) {
+                s->NDTR.value = reload[stream];             // CIRC: start over
+                if (cr & (1 << 18)) {
+                    s->CR.value ^= (1U << 19);              // DBM: other buffer (CT)
+                }
+            } else {
+                s->CR.value &= ~1U;
+            }
+        }
+    }
+
+    std::function<void(uint32_t)> write_listener[8];
+
+    void write(SimReg* reg, uint32_t offset, uint32_t value) {
+        (void)offset;
+        if (reg == &dma->LIFCR) {
+            dma->LISR.value &= ~value;
+        } else if (reg == &dma->HIFCR) {
+            dma->HISR.value &= ~value;
+        } else if ((reg == &dma->LISR) || (reg == &dma->HISR)) {
+            return;                             // Read-only
+        } else if (is_stream_cr(reg)) {
+            write_cr((uint32_t)((DMA_Stream_TypeDef*)reg - streams), value);
+        } else {
+            reg->value = value;
+        }
+    }
+
+    // Flags of a stream: TCIF, HTIF, TEIF, DMEIF, FEIF shifted into place
+    uint32_t flags(uint32_t stream) {
+        static const uint8_t shift[4] = { 0, 6, 16, 22 };
+        uint32_t isr = (stream < 4) ? dma->LISR.value : dma->HISR.value;
+        return (isr >> shift[stream & 3]) & 0x3D;
+    }
+
+private:
+    bool is_stream_cr(SimReg* reg) {
+        uint8_t* addr = (uint8_t*)reg;
+        uint8_t* base = (uint8_t*)streams;
+        return (addr >= base) && (addr < base + 8 * sizeof(DMA_Stream_TypeDef)) &&
+               (((addr - base) % sizeof(DMA_Stream_TypeDef)) == 0);
+    }
+
+    void set_flags(uint32_t stream, uint32_t bits) {
+        static const uint8_t shift[4] = { 0, 6, 16, 22 };
+        SimReg* isr = (stream < 4) ? &dma->LISR : &dma->HISR;
+        isr->value |= bits << shift[stream & 3];
+    }
+
+    void write_cr(uint32_t stream, uint32_t value) {
+        DMA_Stream_TypeDef* s = &streams[stream];
+        bool was_on = s->CR.value & 1;
+        s->CR.value = value;
+
+        if (was_on && !(value & 1) && done_event[stream]) {
+            SIM_cancel(done_event[stream]);     // Aborted: nothing moved
+            done_event[stream] = 0;
+        }
+        if (!was_on && (value & 1)) {
+            reload[stream] = s->NDTR.value & 0xFFFF;
+            offset[stream] = 0;
+        }
+        // Only memory-to-memory streams move data here (DIR = 10)
+        if (was_on || !(value & 1) || (((value >> 6) & 3) != 2)) {
+            return;
+        }
+        uint32_t items = s->NDTR.value & 0xFFFF;
+        SimTime at = SIM_now() + SIM_clock_period(SIM_clock_hclk(), (uint64_t)items * SIM_DMA_M2M_CYCLES);
+        done_event[stream] = SIM_schedule(at, [this, stream]() { complete(stream); });
+    }
+
+    void complete(uint32_t stream) {
+        DMA_Stream_TypeDef* s = &streams[stream];
+        uint32_t cr = s->CR.value;
+        uint32_t size = 1U << ((cr >> 11) & 3);             // PSIZE (source)
+        uint32_t src = s->PAR.value;
+        uint32_t dst = s->M0AR.value;
+
+        done_event[stream] = 0;
+        for (uint32_t n = s->NDTR.value & 0xFFFF; n; n--) {
+            sim_bus_write(dst, sim_bus_read(src, size), size);
+            src += (cr & (1 << 9)) ? size : 0;              // PINC
+            dst += (cr & (1 << 10)) ? size : 0;             // MINC
+        }
+        s->NDTR.value = 0;
+        s->CR.value &= ~1U;                                 // EN clears at the end
+        set_flags(stream, (1 << 5) | (1 << 4));             // TCIF, HTIF
+    }
+
+    DMA_TypeDef* dma;
+    DMA_Stream_TypeDef* streams;
+    SimEventId done_event[8];
+    uint32_t reload[8];                     // NDTR at enable (circular reload)
+    uint32_t offset[8];                     // Memory bytes used of the current buffer
+};
+
+// === DWT ===
+
+class DwtModel : public SimModel {
+public:
+    void reset(void) {
+        DWT->CTRL.value = 0x40000000;           // NUMCOMP = 4
+        origin = 0;
+        frozen = 0;
+    }
+
+    uint32_t read(SimReg* reg, uint32_t offset) {
+        (void)offset;
+        if (reg == &DWT->CYCCNT) {
+            DWT->CYCCNT.value = count();
+        }
+        return reg->value;
+    }
+
+    void write(SimReg* reg, uint32_t offset, uint32_t value) {
+        (void)offset;
+        if (reg == &DWT->CYCCNT) {
+            frozen = value;
+            origin = SIM_cycles() - value;
+        } else if (reg == &DWT->CTRL) {
+            bool was_on = DWT->CTRL.value & 1;
+            if (was_on && !(value & 1)) {
+                frozen = count();
+            } else if (!was_on && (value & 1)) {
+                origin = SIM_cycles() - frozen;
+            }
+            DWT->CTRL.value = value;
+        } else {
+            reg->value = value;
+        }
+    }
+
+private:
+    uint32_t count(void) {
+        return (DWT->CTRL.value & 1) ? (uint32_t)(SIM_cycles() - origin) : frozen;
+    }
+
+    uint64_t origin;
+    uint32_t frozen;
+};
+
+// === PLAIN STORAGE WITH RESET VALUES ===
+
+class CoreModel : public SimModel {
+public:
+    void reset(void) {
+        SCB->CPUID.value = 0x410FC241;          // Cortex-M4 r0p1
+    }
+};
+
+// === MODEL TABLE ===
+
+static RccModel rcc_model;
+static ExtiModel exti_model;
+static AdcModel adc_model;
+static UsartModel usart_model;
+static PwrModel pwr_model;
+static FlashModel flash_model;
+static IwdgModel iwdg_model;
+static WwdgModel wwdg_model;
+static RtcModel rtc_model;
+static DwtModel dwt_model;
+static CoreModel core_model;
+static CrcModel crc_model;
+static DmaModel dma1_model(&sim_DMA1, sim_DMA1_Stream);
+static DmaModel dma2_model(&sim_DMA2, sim_DMA2_Stream);
+static SimModel storage;
+
+void sim_clock_changed(void) {
+    tim1_model.clock_changed();
+    tim2_model.clock_changed();
+    tim3_model.clock_changed();
+    tim4_model.clock_changed();
+    tim5_model.clock_changed();
+    tim6_model.clock_changed();
+    wwdg_model.clock_changed();
+}
+
+void sim_stop_enter(void) {
+    tim1_model.set_stopped(true);
+    tim2_model.set_stopped(true);
+    tim3_model.set_stopped(true);
+    tim4_model.set_stopped(true);
+    tim5_model.set_stopped(true);
+    tim6_model.set_stopped(true);
+    wwdg_model.set_stopped(true);
+}
+
+SimTime sim_stop_wakeup_time(void) {
+    return (PWR->CR.value & (1 << 0)) ? SIM_STOP_WAKEUP_LP : SIM_STOP_WAKEUP_MAIN;
+}
+
+void sim_stop_exit(void) {
+    // SYSCLK restarts on HSI; HSE, PLL and over-drive were switched off
+    RCC->CR.value &= ~((1U << 16) | (1U << 17) | (1U << 24) | (1U << 25));
+    RCC->CFGR.value &= ~0xFU;
+    PWR->CR.value &= ~((1U << 16) | (1U << 17));
+    PWR->CSR.value &= ~((1U << 16) | (1U << 17));
+
+    tim1_model.set_stopped(false);
+    tim2_model.set_stopped(false);
+    tim3_model.set_stopped(false);
+    tim4_model.set_stopped(false);
+    tim5_model.set_stopped(false);
+    tim6_model.set_stopped(false);
+    wwdg_model.set_stopped(false);
+    sim_clock_changed();
+}
+
+void SIM_dma_set_write_listener(DMA_TypeDef* dma, uint8_t stream, std::function<void(uint32_t)> listener) {
+    DmaModel* model = (dma == DMA2) ? &dma2_model : &dma1_model;
+    model->write_listener[stream & 7] = listener;
+}
+
+void SIM_set_lsi_hz(uint32_t hz) {
+    rtc_model.lsi_changed();
+    sim_lsi_hz = hz;
+}
+
+void SIM_set_vdd_mv(uint32_t mv) {
+    pwr_model.set_vdd(mv);
+}
+
+void SIM_vdd_ramp(uint32_t mv, SimTime duration) {
+    int64_t from = pwr_model.vdd_mv;
+    uint64_t steps = duration / SIM_US(1);
+    if (steps == 0) {
+        SIM_set_vdd_mv(mv);
+        return;
+    }
+    SimTime start = SIM_now();
+    for (uint64_t i = 1; i <= steps; i++) {
+        uint32_t level = (uint32_t)(from + ((int64_t)mv - from) * (int64_t)i / (int64_t)steps);
+        SIM_schedule(start + SIM_US(i), [level]() { SIM_set_vdd_mv(level); });
+    }
+}
+
+SimTime SIM_pvd_trip_time(void) {
+    return pwr_model.trip_time;
+}
+
+bool sim_flash_stalled(void) {
+    return flash_model.busy();
+}
+
+void SIM_flash_get_stats(SimFlashStats* stats) {
+    *stats = flash_model.stats;
+}
+
+void sim_models_init(void) {
+    static bool mapped = false;
+    if (mapped) {
+        return;
+    }
+    mapped = true;
+
+    // RCC first: every clock query reads it
+    SIM_map_block("RCC", &sim_RCC, sizeof(sim_RCC), &rcc_model);
+    SIM_map_block("PWR", &sim_PWR, sizeof(sim_PWR), &pwr_model);
+    SIM_map_block("FLASH", &sim_FLASH, sizeof(sim_FLASH), &flash_model);
+    SIM_map_block("GPIOA", &sim_GPIOA, sizeof(sim_GPIOA), &gpio_a);
+    SIM_map_block("GPIOB", &sim_GPIOB, sizeof(sim_GPIOB), &gpio_b);
+    SIM_map_block("GPIOC", &sim_GPIOC, sizeof(sim_GPIOC), &gpio_c);
+    SIM_map_block("EXTI", &sim_EXTI, sizeof(sim_EXTI), &exti_model);
+    SIM_map_block("SYSCFG", &sim_SYSCFG, sizeof(sim_SYSCFG), &storage);
+    SIM_map_block("TIM1", &sim_TIM1, sizeof(sim_TIM1), &tim1_model);
+    SIM_map_block("TIM2", &sim_TIM2, sizeof(sim_TIM2), &tim2_model);
+    SIM_map_block("TIM3", &sim_TIM3, sizeof(sim_TIM3), &tim3_model);
+    SIM_map_block("TIM4", &sim_TIM4, sizeof(sim_TIM4), &tim4_model);
+    SIM_map_block("TIM5", &sim_TIM5, sizeof(sim_TIM5), &tim5_model);
+    SIM_map_block("TIM6", &sim_TIM6, sizeof(sim_TIM6), &tim6_model);
+    SIM_map_block("USART2", &sim_USART2, sizeof(sim_USART2), &usart_model);
+    SIM_map_block("ADC1", &sim_ADC1, sizeof(sim_ADC1), &adc_model);
+    SIM_map_block("ADC", &sim_ADC123_COMMON, sizeof(sim_ADC123_COMMON), &storage);
+    SIM_map_block("IWDG", &sim_IWDG, sizeof(sim_IWDG), &iwdg_model);
+    SIM_map_block("WWDG", &sim_WWDG, sizeof(sim_WWDG), &wwdg_model);
+    SIM_map_block("RTC", &sim_RTC, sizeof(sim_RTC), &rtc_model);
+    SIM_map_block("DMA1", &sim_DMA1, sizeof(sim_DMA1), &dma1_model);
+    SIM_map_block("DMA2", &sim_DMA2, sizeof(sim_DMA2), &dma2_model);
+    SIM_map_block("DMA1_S", sim_DMA1_Stream, sizeof(sim_DMA1_Stream), &dma1_model);
+    SIM_map_block("DMA2_S", sim_DMA2_Stream, sizeof(sim_DMA2_Stream), &dma2_model);
+    SIM_map_block("CRC", &sim_CRC, sizeof(sim_CRC), &crc_model);
+    SIM_map_block("DWT", &sim_DWT, sizeof(sim_DWT), &dwt_model);
+    SIM_map_block("DEBUG", &sim_CoreDebug, sizeof(sim_CoreDebug), &storage);
+    SIM_map_block("SCB", &sim_SCB, sizeof(sim_SCB), &core_model);
+    SIM_map_block("SYSTICK", &sim_SysTick, sizeof(sim_SysTick), &storage);
+    sim_i2c_models_init();
+
+    // DMA requests: TIM1_UP is DMA2 Stream5 channel 6
+    sim_timer_set_update_listener(TIM1, []() {
+        if (((sim_DMA2_Stream[5].CR.value >> 25) & 7) == 6) {
+            dma2_model.request(5);
+        }
+    });
+
+    // Interrupt lines
+    SIM_irq_add_source(TIM1_UP_TIM10_IRQn, []() { return (TIM1->SR.value & TIM1->DIER.value & 1) != 0; });
+    SIM_irq_add_source(TIM1_CC_IRQn, []() { return (TIM1->SR.value & TIM1->DIER.value & 0x1E) != 0; });
+    SIM_irq_add_source(TIM2_IRQn, []() { return (TIM2->SR.value & TIM2->DIER.value & 0x1F) != 0; });
+    SIM_irq_add_source(TIM3_IRQn, []() { return (TIM3->SR.value & TIM3->DIER.value & 0x1F) != 0; });
+    SIM_irq_add_source(TIM4_IRQn, []() { return (TIM4->SR.value & TIM4->DIER.value & 0x1F) != 0; });
+    SIM_irq_add_source(TIM5_IRQn, []() { return (TIM5->SR.value & TIM5->DIER.value & 0x1F) != 0; });
+    SIM_irq_add_source(TIM6_DAC_IRQn, []() { return (TIM6->SR.value & TIM6->DIER.value & 1) != 0; });
+    SIM_irq_add_source(ADC_IRQn, []() {
+        return (ADC1->SR.value & (1 << 1)) && (ADC1->CR1.value & (1 << 5));
+    });
+    SIM_irq_add_source(USART2_IRQn, []() {
+        uint32_t sr = USART2->SR.value;
+        uint32_t cr1 = USART2->CR1.value;
+        return ((sr & cr1) & ((1 << 7) | (1 << 6) | (1 << 5))) != 0;
+    });
+
+    static const IRQn_Type exti_low[5] = { EXTI0_IRQn, EXTI1_IRQn, EXTI2_IRQn, EXTI3_IRQn, EXTI4_IRQn };
+    for (uint32_t line = 0; line < 5; line++) {
+        SIM_irq_add_source(exti_low[line], [line]() {
+            return (EXTI->PR.value & EXTI->IMR.value & (1U << line)) != 0;
+        });
+    }
+    SIM_irq_add_source(EXTI9_5_IRQn, []() { return (EXTI->PR.value & EXTI->IMR.value & 0x03E0) != 0; });
+    SIM_irq_add_source(EXTI15_10_IRQn, []() { return (EXTI->PR.value & EXTI->IMR.value & 0xFC00) != 0; });
+    // DMA streams: TCIF/HTIF/TEIF/DMEIF against TCIE/HTIE/TEIE/DMEIE (CR bits 4-1)
+    static const IRQn_Type dma1_irqs[8] = {
+        DMA1_Stream0_IRQn, DMA1_Stream1_IRQn, DMA1_Stream2_IRQn, DMA1_Stream3_IRQn,
+        DMA1_Stream4_IRQn, DMA1_Stream5_IRQn, DMA1_Stream6_IRQn, DMA1_Stream7_IRQn };
+    static const IRQn_Type dma2_irqs[8] = {
+        DMA2_Stream0_IRQn, DMA2_Stream1_IRQn, DMA2_Stream2_IRQn, DMA2_Stream3_IRQn,
+        DMA2_Stream4_IRQn, DMA2_Stream5_IRQn, DMA2_Stream6_IRQn, DMA2_Stream7_IRQn };
+    for (uint32_t i = 0; i < 8; i++) {
+        SIM_irq_add_source(dma1_irqs[i], [i]() {
+            return (dma1_model.flags(i) & 0x3C & (sim_DMA1_Stream[i].CR.value << 1)) != 0;
+        });
+        SIM_irq_add_source(dma2_irqs[i], [i]() {
+            return (dma2_model.flags(i) & 0x3C & (sim_DMA2_Stream[i].CR.value << 1)) != 0;
+        });
+    }
+    SIM_irq_add_source(WWDG_IRQn, []() { return ((WWDG->SR.value & 1) && (WWDG->CFR.value & (1 << 9))) != 0; });
+    SIM_irq_add_source(PVD_IRQn, []() { return (EXTI->PR.value & EXTI->IMR.value & (1U << 16)) != 0; });
+    SIM_irq_add_source(RTC_WKUP_IRQn, []() { return (EXTI->PR.value & EXTI->IMR.value & (1U << 22)) != 0; });
+}
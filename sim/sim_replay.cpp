@@ -0,0 +1,218 @@
+/*
+* filename: sim_replay.cpp
+* purpose: Feeds a captured sensor trace (trace.h) into the firmware's own main()
+* author: Connor Ockerse
+* date: 10/19/2026
+* note: Every record becomes a stimulus on the simulated board at the same
+* spacing it was captured with:
+*   TRACE_SONAR    width of the next echo the HC-SR04 model sends back
+*   TRACE_ADC      level on PA1 from that moment on
+*   TRACE_ENCODER  encoder turned to that count
+*   TRACE_BUTTON   button pin (BOARD_BUTTON_PIN) driven to that level
+* The first record lands REPLAY_LEAD_MS after reset so the firmware is
+* initialized by then. Simulated time does not wait for the host, so a
+* replay runs as fast as the host allows and gives the same result every
+* time. Firmware built with TRACE_ENABLE = 1 captures again while it
+* replays; pass an output file to keep that capture for comparison.
+*
+*   sim_replay capture.bin [recapture.bin]
+*/
+
+#include "sim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "board.h"
+#include "trace.h"
+
+// src/main.c, renamed by the Makefile
+int firmware_main(void);
+
+// Time from reset to the first record
+#define REPLAY_LEAD_MS 100U
+
+// Simulated time kept running after the last record
+#define REPLAY_TAIL_MS 100U
+
+// Latest an echo can end after its trigger (460 us delay + 38 ms timeout)
+#define REPLAY_ECHO_WINDOW_MS 40U
+
+typedef struct {
+    uint64_t time_us;       // Since TRACE_INIT
+    uint8_t source;
+    uint32_t value;
+} ReplayRecord;
+
+// Echo widths in capture order, and when each echo ended (replay time)
+static std::vector<std::pair<SimTime, uint32_t> > echoes;
+static size_t next_echo = 0;
+static uint32_t last_echo_us = 0;
+
+static const char* recapture_path = 0;
+
+// === TRACE DECODING ===
+
+static bool read_varint(const std::vector<uint8_t>& data, size_t* pos, uint64_t* value) {
+    *value = 0;
+    for (uint32_t shift = 0; (*pos < data.size()) && (shift < 64); shift += 7) {
+        uint8_t byte = data[(*pos)++];
+        *value |= (uint64_t)(byte & 0x7FU) << shift;
+        if (!(byte & 0x80U)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Decodes a stream, skipping any text printed between records
+static bool decode(const std::vector<uint8_t>& data, std::vector<ReplayRecord>* records) {
+    // 1. Find the stream marker
+    const char* magic = TRACE_MAGIC;
+    size_t magic_len = strlen(magic);
+    size_t pos = 0;
+    while ((pos + magic_len <= data.size()) && memcmp(&data[pos], magic, magic_len) != 0) {
+        pos++;
+    }
+    if (pos + magic_len > data.size()) {
+        return false;
+    }
+    pos += magic_len;
+
+    // 2. Records: tag, delta, value
+    uint64_t time_us = 0;
+    while (pos < data.size()) {
+        uint8_t tag = data[pos++];
+        if (((tag & 0xF0U) != TRACE_TAG) || ((tag & 0x0FU) >= TRACE_NUM_SOURCES)) {
+            continue;
+        }
+        uint64_t delta, value;
+        if (!read_varint(data, &pos, &delta) || !read_varint(data, &pos, &value)) {
+            break;      // Capture cut off mid-record
+        }
+        time_us += delta;
+
+        ReplayRecord record = { time_us, (uint8_t)(tag & 0x0FU), (uint32_t)value };
+        records->push_back(record);
+    }
+    return true;
+}
+
+// === STIMULI ===
+
+// Called by the HC-SR04 model for every trigger pulse
+static uint32_t replay_echo_width(void) {
+    // Echoes that ended before this trigger belonged to earlier pings
+    SimTime now = SIM_now();
+    while ((next_echo < echoes.size()) && (echoes[next_echo].first <= now)) {
+        next_echo++;
+    }
+    // No echo recorded for this ping: the target didn't move
+    if ((next_echo < echoes.size()) &&
+        (echoes[next_echo].first <= now + SIM_MS(REPLAY_ECHO_WINDOW_MS))) {
+        last_echo_us = echoes[next_echo].second;
+        next_echo++;
+    }
+    return last_echo_us;
+}
+
+static void schedule(const std::vector<ReplayRecord>& records, SimTime start) {
+    uint16_t encoder_count = 0;
+    uint32_t counts[TRACE_NUM_SOURCES] = { 0 };
+
+    for (size_t i = 0; i < records.size(); i++) {
+        const ReplayRecord& record = records[i];
+        SimTime at = start + (SimTime)record.time_us * SIM_US(1);
+        uint32_t value = record.value;
+        counts[record.source]++;
+
+        switch (record.source) {
+            case TRACE_SONAR:
+                echoes.push_back(std::make_pair(at, value));
+                break;
+            case TRACE_ADC:
+                SIM_schedule(at, [value]() { SIM_adc_set(1, (uint16_t)value); });
+                break;
+            case TRACE_ENCODER: {
+                // Counts wrap at 16 bits: turn by the shortest way round
+                int16_t turn = (int16_t)(uint16_t)(value - encoder_count);
+                encoder_count = (uint16_t)value;
+                SIM_schedule(at, [turn]() { SIM_encoder_turn(turn); });
+                break;
+            }
+            case TRACE_BUTTON:
+                SIM_schedule(at, [value]() { SIM_gpio_set_input(BOARD_BUTTON_PORT, BOARD_BUTTON_PIN, value ? 1 : 0); });
+                break;
+            case TRACE_DROPPED:
+                printf("replay: capture lost %lu records at %.3f ms\n",
+                       (unsigned long)value, record.time_us / 1000.0);
+                break;
+        }
+    }
+
+    printf("replay: %lu sonar, %lu adc, %lu encoder, %lu button records over %.3f ms\n",
+           (unsigned long)counts[TRACE_SONAR], (unsigned long)counts[TRACE_ADC],
+           (unsigned long)counts[TRACE_ENCODER], (unsigned long)counts[TRACE_BUTTON],
+           records.empty() ? 0.0 : records.back().time_us / 1000.0);
+}
+
+// Runs on every exit path, including the time limit
+static void save_recapture(void) {
+    FILE* file = fopen(recapture_path, "wb");
+    if (!file) {
+        fprintf(stderr, "replay: can't write %s\n", recapture_path);
+        return;
+    }
+    fwrite(SIM_usart_output(), 1, SIM_usart_output_length(), file);
+    fclose(file);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s capture.bin [recapture.bin]\n", argv[0]);
+        return 2;
+    }
+
+    // 1. Load and decode the capture
+    FILE* file = fopen(argv[1], "rb");
+    if (!file) {
+        fprintf(stderr, "replay: can't open %s\n", argv[1]);
+        return 2;
+    }
+    std::vector<uint8_t> data;
+    int byte;
+    while ((byte = fgetc(file)) != EOF) {
+        data.push_back((uint8_t)byte);
+    }
+    fclose(file);
+
+    std::vector<ReplayRecord> records;
+    if (!decode(data, &records)) {
+        fprintf(stderr, "replay: no %s marker in %s\n", TRACE_MAGIC, argv[1]);
+        return 2;
+    }
+
+    // 2. Board with the capture scheduled on it
+    SIM_board_init();
+    SimTime start = SIM_now() + SIM_MS(REPLAY_LEAD_MS);
+    schedule(records, start);
+    SIM_sonar()->next_width_us = replay_echo_width;
+
+    SimTime end = start + SIM_MS(REPLAY_TAIL_MS);
+    if (!records.empty()) {
+        end += (SimTime)records.back().time_us * SIM_US(1);
+    }
+    SIM_set_time_limit(end);
+
+    if (argc > 2) {
+        recapture_path = argv[2];
+        atexit(save_recapture);
+    }
+
+    // 3. Run the firmware until the capture is used up
+    int status = firmware_main();
+    printf("replay: main() returned %d at %.3f ms\n", status, SIM_now_us() / 1000.0);
+    return status;
+}
@@ -0,0 +1,27 @@
+/*
+* filename: sim_runner.cpp
+* purpose: Runs the firmware's own main() on the simulated board for a fixed time
+* author: Connor Ockerse
+* date: 10/19/2026
+*/
+
+#include "sim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// src/main.c, renamed by the Makefile
+int firmware_main(void);
+
+int main(int argc, char** argv) {
+    // Simulated milliseconds to run (main() itself never returns)
+    unsigned long run_ms = (argc > 1) ? strtoul(argv[1], 0, 10) : 3000UL;
+
+    SIM_board_init();
+    SIM_usart_echo(1);
+    SIM_set_time_limit(SIM_MS(run_ms));
+
+    int status = firmware_main();
+    printf("\nsim: main() returned %d at %.3f ms\n", status, SIM_now_us() / 1000.0);
+    return status;
+}
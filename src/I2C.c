@@ -1,132 +1,430 @@
 /*
 * filename: i2c.c
-* purpose: implementation of I2C1 driver
+* purpose: implementation of the I2C1-3 driver
 * author: Connor Ockerse
 * date: 11/27/2025
 */
 
 #include "I2C.h"
 #include "RccConfig.h"
+#include "board.h"
+#include "spinwait.h"
 
-void I2C_INIT(void){
-    // 1. Enable Clocks
-    RCC->AHB1ENR |= (1 << 1);          // Enable GPIOB Clock (Bit 1)
-    RCC->APB1ENR |= (1 << 21);         // Enable I2C1 Clock (Bit 21)
-
-    // 2. Configure GPIO Pins (PB8=SCL, PB9=SDA)
-    // Set to Alternate Function Mode (10)
-    GPIOB->MODER &= ~((3 << 16) | (3 << 18));
-    GPIOB->MODER |=  ((2 << 16) | (2 << 18));
-    
-    // Set Output Type to Open Drain (Critical for I2C)
-    GPIOB->OTYPER |= ((1 << 8) | (1 << 9));
-    
-    // Set Speed to High Speed (optional but recommended)
-    GPIOB->OSPEEDR |= ((3 << 16) | (3 << 18));
-    
-    // === EXTERNAL PULL-UPS USED ===
-    // Disable Internal Pull-Ups/Pull-Downs (00)
-    GPIOB->PUPDR &= ~((3 << 16) | (3 << 18));
+// Standard Mode SCL, never faster and at most 1% slower at any SYSCLK
+#define I2C_SCL_HZ 100000U
+#define I2C_SCL_MAX_PPM 10000U
+#define I2C_CLOCK_CHECK(sysclk) CLOCK_ASSERT_I2C(CLOCK_PCLK1_HZ(sysclk), I2C_SCL_HZ, I2C_SCL_MAX_PPM);
+CLOCK_SYSCLK_LIST(I2C_CLOCK_CHECK)
 
-    // Set Alternate Function to AF4 (I2C1)
-    // AFR[1] handles pins 8-15
-    GPIOB->AFR[1] &= ~((0xF << 0) | (0xF << 4)); // Clear PB8, PB9
-    GPIOB->AFR[1] |=  ((4 << 0) | (4 << 4));     // Set AF4
+// SR1 error flags: BERR, ARLO, AF (rc_w0)
+#define I2C_SR1_ERRORS ((1U << 8) | (1U << 9) | (1U << 10))
 
-    // 3. Reset I2C
-    I2C1->CR1 |= (1 << 15);  // SWRST (Software Reset)
-    I2C1->CR1 &= ~(1 << 15); // Clear Reset
+// Controller and pins of a bus (the pins are driven by hand during a recovery)
+typedef struct {
+    I2C_TypeDef* regs;
+    GPIO_TypeDef* scl_port;
+    GPIO_TypeDef* sda_port;
+    uint8_t scl_pin;
+    uint8_t sda_pin;
+}I2CWiring;
+
+static const I2CWiring wiring[I2C_NUM_BUSES] = {
+    { I2C1, GPIOB, GPIOB, 8U,  9U  },       // PB8 / PB9
+    { I2C2, GPIOB, GPIOC, 10U, 12U },       // PB10 / PC12
+};
+
+// Ends the transaction on the first wait that fails
+#define I2C_WAIT(bus, site, flag)                               \
+    do {                                                        \
+        I2CStatus wait_status_ = I2C_wait((bus), (site), (flag)); \
+        if (wait_status_ != I2C_OK) { return wait_status_; }    \
+    } while (0)
+
+#define I2C_WAIT_IDLE(bus)                                      \
+    SPIN_WHILE_OR(SPIN_I2C_BUSY, wiring[bus].regs->SR2 & (1 << 1), return I2C_fail((bus), I2C_ERR_TIMEOUT))
+
+static I2CStats stats[I2C_NUM_BUSES];
+static uint8_t enabled = 0;                 // Bit per bus brought up by I2C_bus_init()
+
+// Standard Mode (100kHz) timing from the current PCLK1 (PE must be 0)
+static void I2C_set_timing(I2C_TypeDef* i2c){
+    uint32_t pclk1 = CLOCK_get_pclk1();
 
-    // 4. Configure I2C Timing (Standard Mode 100kHz)
-    // CLOCK_FREQUENCY from RccConfig.h
-    
     // FREQ[5:0]: Input Clock Frequency in MHz
-    uint32_t pclk1_mhz = CLOCK_FREQUENCY / 1000000;
-    I2C1->CR2 = pclk1_mhz; 
+    i2c->CR2 = CLOCK_I2C_FREQ(pclk1);
 
     // CCR: Clock Control Register
     // Formula: Thigh = Tlow = CCR * TPCLK1
     // Target: 100kHz (Period = 10us). Thigh + Tlow = 10us.
-    // Thigh = 5us.
-    // CCR = 5us / (1 / PCLK1_MHz) = 5 * PCLK1_MHz
-    I2C1->CCR = 5 * pclk1_mhz; // Standard Mode
+    // CCR = PCLK1 / (2 * 100kHz), rounded up
+    i2c->CCR = CLOCK_I2C_CCR(pclk1, I2C_SCL_HZ); // Standard Mode
 
     // TRISE: Max Rise Time
     // Max rise time in SM is 1000ns.
     // TRISE = (1us / TPCLK1) + 1 = PCLK1_MHz + 1
-    I2C1->TRISE = pclk1_mhz + 1;
+    i2c->TRISE = CLOCK_I2C_TRISE(pclk1);
+}
+
+// I2C_WAIT_US on every I2C wait site, in cycles of the current SYSCLK
+static void I2C_set_budget(void){
+    uint32_t cycles = (CLOCK_get_sysclk() / 1000000U) * I2C_WAIT_US;
+    for (uint32_t site = SPIN_I2C_BUSY; site <= SPIN_I2C_RXNE; site++) {
+        SPIN_set_timeout((SpinSite)site, cycles);
+    }
+}
+
+// Lets the STOPs in flight finish, then retimes every bus with its peripheral off
+static void I2C_reclock(ClockEvent event){
+    for (uint32_t bus = 0; bus < I2C_NUM_BUSES; bus++) {
+        I2C_TypeDef* i2c = wiring[bus].regs;
+        if (!(enabled & (1U << bus))) {
+            continue;
+        }
+        if (event == CLOCK_PRE_CHANGE) {
+            SPIN_WHILE(SPIN_I2C_BUSY, i2c->SR2 & (1 << 1));
+        } else {
+            i2c->CR1 &= ~(1 << 0); // PE off: CCR/TRISE are only writable now
+            I2C_set_timing(i2c);
+            i2c->CR1 |= (1 << 0);
+        }
+    }
+    if (event != CLOCK_PRE_CHANGE) {
+        I2C_set_budget();
+    }
+}
+
+// Leaves the bus usable for the next transaction and counts the failure
+static I2CStatus I2C_fail(I2CBus bus, I2CStatus status){
+    I2C_TypeDef* i2c = wiring[bus].regs;
+
+    // 1. Error flags are cleared by writing 0
+    i2c->SR1 &= ~I2C_SR1_ERRORS;
+
+    // 2. NACK: we still own the bus, so STOP. ARLO: the peripheral dropped
+    // to slave mode and let go already. Anything else: recover the bus
+    if (status == I2C_ERR_NACK) {
+        stats[bus].nacks++;
+        i2c->CR1 |= (1 << 9);
+    } else if (status == I2C_ERR_ARLO) {
+        stats[bus].arbitration_lost++;
+    } else {
+        if (status == I2C_ERR_BUS) {
+            stats[bus].bus_errors++;
+        } else {
+            stats[bus].timeouts++;
+        }
+        I2C_recover(bus);
+    }
+
+    // 3. Re-enable ACK for future transfers (default state), POS off
+    i2c->CR1 = (i2c->CR1 | (1 << 10)) & ~(1U << 11);
+    return status;
+}
+
+// Waits for an SR1 event; an error flag ends the wait early
+static I2CStatus I2C_wait(I2CBus bus, SpinSite site, uint32_t flag){
+    I2C_TypeDef* i2c = wiring[bus].regs;
+    uint32_t sr1 = 0;
+    SPIN_WHILE_OR(site, !((sr1 = i2c->SR1) & (flag | I2C_SR1_ERRORS)), return I2C_fail(bus, I2C_ERR_TIMEOUT));
+    if (sr1 & (1 << 9)) {
+        return I2C_fail(bus, I2C_ERR_ARLO);
+    }
+    if (sr1 & (1 << 8)) {
+        return I2C_fail(bus, I2C_ERR_BUS);
+    }
+    if (sr1 & (1 << 10)) {
+        return I2C_fail(bus, I2C_ERR_NACK);
+    }
+    return I2C_OK;
+}
+
+// Half an SCL period on the cycle counter (the peripheral is off)
+static void I2C_half_bit(void){
+    uint32_t cycles = CLOCK_get_sysclk() / (2U * I2C_SCL_HZ);
+    uint32_t start = DWT->CYCCNT;
+    SPIN_WHILE(SPIN_I2C_RECOVER, (DWT->CYCCNT - start) < cycles);
+}
+
+// MODER field of one pin: 1 = output (recovery), 2 = AF4 (the peripheral)
+static void I2C_pin_mode(GPIO_TypeDef* port, uint8_t pin, uint32_t mode){
+    port->MODER = (port->MODER & ~(3U << (2U * pin))) | (mode << (2U * pin));
+}
+
+void I2C_INIT(void){
+    for (uint32_t bus = 0; bus < I2C_NUM_BUSES; bus++) {
+        if (BOARD_I2C_BUSES & (1U << bus)) {
+            I2C_bus_init((I2CBus)bus);
+        }
+    }
+}
+
+void I2C_bus_init(I2CBus bus){
+    I2C_TypeDef* i2c = wiring[bus].regs;
+
+    // 1. The controller clock and its SCL / SDA pins come from BOARD_INIT:
+    // AF4, open drain, high speed, external pull-ups
+
+    // 2. Reset I2C
+    i2c->CR1 |= (1 << 15);  // SWRST (Software Reset)
+    i2c->CR1 &= ~(1 << 15); // Clear Reset
+
+    // 3. Configure I2C Timing (Standard Mode 100kHz)
+    // PCLK1 from RccConfig.h
+    I2C_set_timing(i2c);
+
+    // 4. Enable I2C Peripheral
+    i2c->CR1 |= (1 << 0); // PE (Peripheral Enable)
+    enabled |= (uint8_t)(1U << bus);
+    CLOCK_register(I2C_reclock);
 
-    // 5. Enable I2C Peripheral
-    I2C1->CR1 |= (1 << 0); // PE (Peripheral Enable)
+    // 5. Every wait from here on has a budget
+    I2C_set_budget();
 }
 
-void I2C1_byteWrite(uint8_t saddr, uint8_t maddr, uint8_t data){
-    volatile int tmp;
+uint8_t I2C_recover(I2CBus bus){
+    const I2CWiring* w = &wiring[bus];
+    uint32_t sda = (1U << w->sda_pin);
+    uint32_t scl = (1U << w->scl_pin);
+
+    // 1. Peripheral off, then SCL/SDA as open-drain outputs, both released
+    w->regs->CR1 &= ~(1 << 0);
+    w->scl_port->BSRR = scl;
+    w->sda_port->BSRR = sda;
+    I2C_pin_mode(w->scl_port, w->scl_pin, 1U);
+    I2C_pin_mode(w->sda_port, w->sda_pin, 1U);
+    if (!(DWT->CTRL & (1 << 0))) {
+        CoreDebug->DEMCR |= (1 << 24);      // TRCENA
+        DWT->CTRL |= (1 << 0);              // CYCCNTENA
+    }
+
+    // 2. A slave cut off mid-byte still shifts out its bits: clock them
+    // out until it lets go of SDA (a byte and its ACK are 9 clocks)
+    for (uint8_t i = 0; (i < 9U) && !(w->sda_port->IDR & sda); i++) {
+        w->scl_port->BSRR = scl << 16;      // SCL low
+        I2C_half_bit();
+        w->scl_port->BSRR = scl;            // SCL high
+        I2C_half_bit();
+    }
+    uint8_t released = (w->sda_port->IDR & sda) ? 1 : 0;
+
+    // 3. STOP: SDA low while SCL is low, then SDA rises while SCL is high
+    w->scl_port->BSRR = scl << 16;
+    w->sda_port->BSRR = sda << 16;
+    I2C_half_bit();
+    w->scl_port->BSRR = scl;
+    I2C_half_bit();
+    w->sda_port->BSRR = sda;
+    I2C_half_bit();
+
+    // 4. Pins back to AF4 (AFR is untouched), peripheral from scratch
+    I2C_pin_mode(w->scl_port, w->scl_pin, 2U);
+    I2C_pin_mode(w->sda_port, w->sda_pin, 2U);
+    I2C_bus_init(bus);
+
+    stats[bus].recoveries++;
+    if (!released) {
+        stats[bus].recovery_failed++;
+    }
+    return released;
+}
+
+I2CStatus I2C_byteWrite(I2CBus bus, uint8_t saddr, uint8_t maddr, uint8_t data){
+    I2C_TypeDef* i2c = wiring[bus].regs;
     
     // 1. Wait until bus not busy
-    while(I2C1->SR2 & (1 << 1)); 
+    I2C_WAIT_IDLE(bus);
     
     // 2. Generate START
-    I2C1->CR1 |= (1 << 8); 
-    while(!(I2C1->SR1 & (1 << 0))); // Wait for SB bit
+    i2c->CR1 |= (1 << 8); 
+    I2C_WAIT(bus, SPIN_I2C_START, (1 << 0)); // Wait for SB bit
     
     // 3. Send Slave Address
-    I2C1->DR = saddr << 1; 
-    while(!(I2C1->SR1 & (1 << 1))); // Wait for ADDR bit
-    tmp = I2C1->SR2;                // Clear ADDR bit by reading SR2
+    i2c->DR = saddr << 1; 
+    I2C_WAIT(bus, SPIN_I2C_ADDR, (1 << 1)); // Wait for ADDR bit
+    (void)(uint32_t)i2c->SR2;      // Clear ADDR bit by reading SR2
     
     // 4. Send Memory Address
-    while(!(I2C1->SR1 & (1 << 7))); // Wait for TXE
-    I2C1->DR = maddr;
+    I2C_WAIT(bus, SPIN_I2C_TXE, (1 << 7)); // Wait for TXE
+    i2c->DR = maddr;
     
     // 5. Send Data
-    while(!(I2C1->SR1 & (1 << 7))); // Wait for TXE
-    I2C1->DR = data;
+    I2C_WAIT(bus, SPIN_I2C_TXE, (1 << 7)); // Wait for TXE
+    i2c->DR = data;
     
     // 6. Generate STOP
-    while(!(I2C1->SR1 & (1 << 2))); // Wait for BTF (Byte Transfer Finished)
-    I2C1->CR1 |= (1 << 9);          // Generate STOP
+    I2C_WAIT(bus, SPIN_I2C_BTF, (1 << 2)); // Wait for BTF (Byte Transfer Finished)
+    i2c->CR1 |= (1 << 9);          // Generate STOP
+    return I2C_OK;
 }
 
-void I2C1_byteRead(uint8_t saddr, uint8_t maddr, uint8_t* data) {
-    volatile int tmp;
+I2CStatus I2C_byteRead(I2CBus bus, uint8_t saddr, uint8_t maddr, uint8_t* data) {
+    I2C_TypeDef* i2c = wiring[bus].regs;
 
     // 1. Generate START
-    while(I2C1->SR2 & (1 << 1));    // Wait busy
-    I2C1->CR1 |= (1 << 8); 
-    while(!(I2C1->SR1 & (1 << 0))); // Wait SB
+    I2C_WAIT_IDLE(bus);               // Wait busy
+    i2c->CR1 |= (1 << 8); 
+    I2C_WAIT(bus, SPIN_I2C_START, (1 << 0)); // Wait SB
 
     // 2. Send Slave Address (Write Mode)
-    I2C1->DR = saddr << 1; 
-    while(!(I2C1->SR1 & (1 << 1))); // Wait ADDR
-    tmp = I2C1->SR2;                // Clear ADDR
+    i2c->DR = saddr << 1; 
+    I2C_WAIT(bus, SPIN_I2C_ADDR, (1 << 1)); // Wait ADDR
+    (void)(uint32_t)i2c->SR2;      // Clear ADDR
 
     // 3. Send Memory Address
-    while(!(I2C1->SR1 & (1 << 7))); // Wait TXE
-    I2C1->DR = maddr;
-    while(!(I2C1->SR1 & (1 << 2))); // Wait BTF (Address sent)
+    I2C_WAIT(bus, SPIN_I2C_TXE, (1 << 7)); // Wait TXE
+    i2c->DR = maddr;
+    I2C_WAIT(bus, SPIN_I2C_BTF, (1 << 2)); // Wait BTF (Address sent)
 
     // 4. Generate Repeated START
-    I2C1->CR1 |= (1 << 8);
-    while(!(I2C1->SR1 & (1 << 0))); // Wait SB
+    i2c->CR1 |= (1 << 8);
+    I2C_WAIT(bus, SPIN_I2C_START, (1 << 0)); // Wait SB
 
     // 5. Send Slave Address (Read Mode)
-    I2C1->DR = (saddr << 1) | 1; 
-    while(!(I2C1->SR1 & (1 << 1))); // Wait ADDR
+    i2c->DR = (saddr << 1) | 1; 
+    I2C_WAIT(bus, SPIN_I2C_ADDR, (1 << 1)); // Wait ADDR
 
     // 6. Disable ACK (Single Byte Read)
-    I2C1->CR1 &= ~(1 << 10);        // Clear ACK bit
+    i2c->CR1 &= ~(1 << 10);        // Clear ACK bit
     
     // 7. Clear ADDR Flag
-    tmp = I2C1->SR2; 
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();               // The STOP must be in before the byte ends
+    (void)(uint32_t)i2c->SR2;
 
     // 8. Generate STOP immediately after clearing ADDR (Sequence for 1 byte)
-    I2C1->CR1 |= (1 << 9);          // Generate STOP
+    i2c->CR1 |= (1 << 9);          // Generate STOP
+    __set_PRIMASK(primask);
 
     // 9. Wait for Data
-    while(!(I2C1->SR1 & (1 << 6))); // Wait RXNE
-    *data = I2C1->DR;
+    I2C_WAIT(bus, SPIN_I2C_RXNE, (1 << 6)); // Wait RXNE
+    *data = i2c->DR;
 
     // 10. Re-enable ACK for future transfers (default state)
-    I2C1->CR1 |= (1 << 10);
-}
\ No newline at end of file
+    i2c->CR1 |= (1 << 10);
+    return I2C_OK;
+}
+
+I2CStatus I2C_burstWrite(I2CBus bus, uint8_t saddr, uint8_t maddr, const uint8_t* data, uint16_t len){
+    I2C_TypeDef* i2c = wiring[bus].regs;
+
+    // 1. Wait until bus not busy, then START
+    I2C_WAIT_IDLE(bus);
+    i2c->CR1 |= (1 << 8);
+    I2C_WAIT(bus, SPIN_I2C_START, (1 << 0)); // Wait for SB bit
+
+    // 2. Send Slave Address
+    i2c->DR = saddr << 1;
+    I2C_WAIT(bus, SPIN_I2C_ADDR, (1 << 1)); // Wait for ADDR bit
+    (void)(uint32_t)i2c->SR2;      // Clear ADDR bit by reading SR2
+
+    // 3. Send Memory Address
+    I2C_WAIT(bus, SPIN_I2C_TXE, (1 << 7)); // Wait for TXE
+    i2c->DR = maddr;
+
+    // 4. Send the Data, one byte per TXE
+    for (uint16_t i = 0; i < len; i++) {
+        I2C_WAIT(bus, SPIN_I2C_TXE, (1 << 7));
+        i2c->DR = data[i];
+    }
+
+    // 5. Generate STOP once the last byte is out
+    I2C_WAIT(bus, SPIN_I2C_BTF, (1 << 2)); // Wait for BTF
+    i2c->CR1 |= (1 << 9);          // Generate STOP
+    return I2C_OK;
+}
+
+I2CStatus I2C_burstRead(I2CBus bus, uint8_t saddr, uint8_t maddr, uint8_t* data, uint16_t len){
+    I2C_TypeDef* i2c = wiring[bus].regs;
+
+    // 1. Generate START
+    I2C_WAIT_IDLE(bus);               // Wait busy
+    i2c->CR1 |= (1 << 8);
+    I2C_WAIT(bus, SPIN_I2C_START, (1 << 0)); // Wait SB
+
+    // 2. Send Slave Address (Write Mode) and the Memory Address
+    i2c->DR = saddr << 1;
+    I2C_WAIT(bus, SPIN_I2C_ADDR, (1 << 1)); // Wait ADDR
+    (void)(uint32_t)i2c->SR2;      // Clear ADDR
+    I2C_WAIT(bus, SPIN_I2C_TXE, (1 << 7)); // Wait TXE
+    i2c->DR = maddr;
+    I2C_WAIT(bus, SPIN_I2C_BTF, (1 << 2)); // Wait BTF (Address sent)
+
+    // 3. Repeated START, Slave Address (Read Mode)
+    i2c->CR1 |= (1 << 8);
+    I2C_WAIT(bus, SPIN_I2C_START, (1 << 0)); // Wait SB
+    i2c->DR = (saddr << 1) | 1;
+    I2C_WAIT(bus, SPIN_I2C_ADDR, (1 << 1)); // Wait ADDR
+
+    // 4. Receive as in RM0390 (master receiver): the NACK and STOP for the
+    // last byte are set while SCL is stretched (ADDR or BTF pending), so a
+    // late poll only slows the bus down
+    if (len == 1) {
+        // One byte: NACK before ADDR clears, STOP right after it (masked:
+        // the STOP must be in before that byte ends)
+        i2c->CR1 &= ~(1 << 10);    // Clear ACK bit
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        (void)(uint32_t)i2c->SR2;  // Clear ADDR
+        i2c->CR1 |= (1 << 9);      // Generate STOP
+        __set_PRIMASK(primask);
+        I2C_WAIT(bus, SPIN_I2C_RXNE, (1 << 6)); // Wait RXNE
+        data[0] = i2c->DR;
+    } else if (len == 2) {
+        // Two bytes: POS moves the NACK to the second one; both are held
+        // (DR and shift register, BTF) until STOP is set
+        i2c->CR1 = (i2c->CR1 & ~(1U << 10)) | (1 << 11);  // ACK off, POS
+        (void)(uint32_t)i2c->SR2;  // Clear ADDR
+        I2C_WAIT(bus, SPIN_I2C_BTF, (1 << 2));  // Wait BTF
+        i2c->CR1 |= (1 << 9);      // Generate STOP
+        data[0] = i2c->DR;
+        data[1] = i2c->DR;
+        i2c->CR1 &= ~(1U << 11);   // POS off
+    } else {
+        // Three or more: ACK all but the last; with N-2 in DR and N-1 in the
+        // shift register (BTF) the ACK goes off, so N is NACKed
+        i2c->CR1 |= (1 << 10);     // ACK every byte but the last
+        (void)(uint32_t)i2c->SR2;  // Clear ADDR
+        for (uint16_t i = 0; i < len - 3U; i++) {
+            I2C_WAIT(bus, SPIN_I2C_RXNE, (1 << 6)); // Wait RXNE
+            data[i] = i2c->DR;
+        }
+        I2C_WAIT(bus, SPIN_I2C_BTF, (1 << 2));  // N-2 in DR, N-1 in the shift register
+        i2c->CR1 &= ~(1 << 10);    // Clear ACK bit
+        data[len - 3U] = i2c->DR;
+        I2C_WAIT(bus, SPIN_I2C_BTF, (1 << 2));  // N-1 in DR, N in the shift register
+        i2c->CR1 |= (1 << 9);      // Generate STOP
+        data[len - 2U] = i2c->DR;
+        data[len - 1U] = i2c->DR;
+    }
+
+    // 5. Re-enable ACK for future transfers (default state)
+    i2c->CR1 |= (1 << 10);
+    return I2C_OK;
+}
+
+uint8_t I2C_is_busy(I2CBus bus){
+    return (wiring[bus].regs->SR2 & (1 << 1)) ? 1 : 0;
+}
+
+uint8_t I2C_any_busy(void){
+    for (uint32_t bus = 0; bus < I2C_NUM_BUSES; bus++) {
+        if ((enabled & (1U << bus)) && (wiring[bus].regs->SR2 & (1 << 1))) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void I2C_get_stats(I2CBus bus, I2CStats* out){
+    *out = stats[bus];
+}
+
+const char* I2C_status_name(I2CStatus status){
+    static const char* const names[] = { "OK", "NACK", "ARLO", "BUS", "TIMEOUT" };
+    return (status <= I2C_ERR_TIMEOUT) ? names[status] : "?";
+}
+
+const char* I2C_bus_name(I2CBus bus){
+    static const char* const names[] = { "I2C1", "I2C2" };
+    return (bus < I2C_NUM_BUSES) ? names[bus] : "?";
+}
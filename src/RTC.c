@@ -6,10 +6,18 @@
 */
 
 #include "RTC.h"
-#include "I2C.h"
+#include "board.h"
 #include "usart.h"
 #include <stdio.h> // For sprintf
 
+// INT/SQW falling edges (written by the ISR only) and how many the thread
+// has taken; a flag cleared by the thread could drop an edge that raced it
+static volatile uint32_t rtc_alarm_count = 0;
+static uint32_t rtc_alarm_taken = 0;
+
+// Bus the DS3231 is on
+static I2CBus rtc_bus = BOARD_RTC_BUS;
+
 // === HELPER FUNCTIONS ===
 
 // Convert Decimal to Binary Coded Decimal (e.g., 12 -> 0x12)
@@ -23,102 +31,209 @@ int bcdToDec(uint8_t val) {
 }
 
 
+// === BUS ===
+
+void RTC_set_bus(I2CBus bus) {
+    rtc_bus = bus;
+}
+
+I2CBus RTC_get_bus(void) {
+    return rtc_bus;
+}
+
+
 // === READ FUNCTIONS ===
 
-uint8_t RTC_read_second(void) {
+// One time register in decimal (mask drops the mode/century bits), RTC_READ_FAILED if the bus fails
+static I2CStatus RTC_read_register(uint8_t reg, uint8_t mask, uint8_t* value) {
     uint8_t data = 0;
-    I2C1_byteRead(RTC_ADDRESS, SECOND_ADDRESS, &data);
-    return (uint8_t)bcdToDec(data);
+    I2CStatus status = I2C_byteRead(rtc_bus, RTC_ADDRESS, reg, &data);
+    *value = (status == I2C_OK) ? (uint8_t)bcdToDec(data & mask) : RTC_READ_FAILED;
+    return status;
+}
+
+uint8_t RTC_read_second(void) {
+    uint8_t value;
+    RTC_read_register(SECOND_ADDRESS, 0xFF, &value);
+    return value;
 }
 
 uint8_t RTC_read_minute(void) {
-    uint8_t data = 0;
-    I2C1_byteRead(RTC_ADDRESS, MINUTE_ADDRESS, &data);
-    return (uint8_t)bcdToDec(data);
+    uint8_t value;
+    RTC_read_register(MINUTE_ADDRESS, 0xFF, &value);
+    return value;
 }
 
 uint8_t RTC_read_hour(void) {
-    uint8_t data = 0;
-    I2C1_byteRead(RTC_ADDRESS, HOUR_ADDRESS, &data);
+    uint8_t value;
     // Mask out 12/24 mode bit (Bit 6) just in case, assuming 24h mode usage
-    return (uint8_t)bcdToDec(data & 0x3F);
+    RTC_read_register(HOUR_ADDRESS, 0x3F, &value);
+    return value;
 }
 
 uint8_t RTC_read_day(void) {
-    uint8_t data = 0;
-    I2C1_byteRead(RTC_ADDRESS, DAY_ADDRESS, &data);
-    return (uint8_t)bcdToDec(data);
+    uint8_t value;
+    RTC_read_register(DAY_ADDRESS, 0xFF, &value);
+    return value;
 }
 
 uint8_t RTC_read_date(void) {
-    uint8_t data = 0;
-    I2C1_byteRead(RTC_ADDRESS, DATE_ADDRESS, &data);
-    return (uint8_t)bcdToDec(data);
+    uint8_t value;
+    RTC_read_register(DATE_ADDRESS, 0xFF, &value);
+    return value;
 }
 
 uint8_t RTC_read_month(void) {
-    uint8_t data = 0;
-    I2C1_byteRead(RTC_ADDRESS, MONTH_ADDRESS, &data);
+    uint8_t value;
     // Mask out Century bit (Bit 7)
-    return (uint8_t)bcdToDec(data & 0x1F);
+    RTC_read_register(MONTH_ADDRESS, 0x1F, &value);
+    return value;
 }
 
 uint8_t RTC_read_year(void) {
-    uint8_t data = 0;
-    I2C1_byteRead(RTC_ADDRESS, YEAR_ADDRESS, &data);
-    return (uint8_t)bcdToDec(data);
+    uint8_t value;
+    RTC_read_register(YEAR_ADDRESS, 0xFF, &value);
+    return value;
 }
 
-void RTC_read_clock(Clock* time) {
-    // Read all fields and store in the struct
-    time->seconds = RTC_read_second();
-    time->minutes = RTC_read_minute();
-    time->hours   = RTC_read_hour();
-    time->day     = RTC_read_day();
-    time->date    = RTC_read_date();
-    time->month   = RTC_read_month();
-    time->year    = RTC_read_year();
+I2CStatus RTC_read_clock(Clock* time) {
+    // Read all fields and store in the struct; the first failure is reported
+    I2CStatus status[7];
+    status[0] = RTC_read_register(SECOND_ADDRESS, 0xFF, &time->seconds);
+    status[1] = RTC_read_register(MINUTE_ADDRESS, 0xFF, &time->minutes);
+    status[2] = RTC_read_register(HOUR_ADDRESS, 0x3F, &time->hours);
+    status[3] = RTC_read_register(DAY_ADDRESS, 0xFF, &time->day);
+    status[4] = RTC_read_register(DATE_ADDRESS, 0xFF, &time->date);
+    status[5] = RTC_read_register(MONTH_ADDRESS, 0x1F, &time->month);
+    status[6] = RTC_read_register(YEAR_ADDRESS, 0xFF, &time->year);
+    for (uint32_t i = 0; i < 7U; i++) {
+        if (status[i] != I2C_OK) {
+            return status[i];
+        }
+    }
+    return I2C_OK;
 }
 
 // === WRITE FUNCTIONS ===
 
-void RTC_write_second(uint8_t sec) {
-    I2C1_byteWrite(RTC_ADDRESS, SECOND_ADDRESS, decToBcd(sec));
+I2CStatus RTC_write_second(uint8_t sec) {
+    return I2C_byteWrite(rtc_bus, RTC_ADDRESS, SECOND_ADDRESS, decToBcd(sec));
 }
 
-void RTC_write_minute(uint8_t min) {
-    I2C1_byteWrite(RTC_ADDRESS, MINUTE_ADDRESS, decToBcd(min));
+I2CStatus RTC_write_minute(uint8_t min) {
+    return I2C_byteWrite(rtc_bus, RTC_ADDRESS, MINUTE_ADDRESS, decToBcd(min));
 }
 
-void RTC_write_hour(uint8_t hour) {
+I2CStatus RTC_write_hour(uint8_t hour) {
     // Writes in 24-hour format
-    I2C1_byteWrite(RTC_ADDRESS, HOUR_ADDRESS, decToBcd(hour));
+    return I2C_byteWrite(rtc_bus, RTC_ADDRESS, HOUR_ADDRESS, decToBcd(hour));
+}
+
+I2CStatus RTC_write_day(uint8_t day) {
+    return I2C_byteWrite(rtc_bus, RTC_ADDRESS, DAY_ADDRESS, decToBcd(day));
 }
 
-void RTC_write_day(uint8_t day) {
-    I2C1_byteWrite(RTC_ADDRESS, DAY_ADDRESS, decToBcd(day));
+I2CStatus RTC_write_date(uint8_t date) {
+    return I2C_byteWrite(rtc_bus, RTC_ADDRESS, DATE_ADDRESS, decToBcd(date));
 }
 
-void RTC_write_date(uint8_t date) {
-    I2C1_byteWrite(RTC_ADDRESS, DATE_ADDRESS, decToBcd(date));
+I2CStatus RTC_write_month(uint8_t month) {
+    return I2C_byteWrite(rtc_bus, RTC_ADDRESS, MONTH_ADDRESS, decToBcd(month));
 }
 
-void RTC_write_month(uint8_t month) {
-    I2C1_byteWrite(RTC_ADDRESS, MONTH_ADDRESS, decToBcd(month));
+I2CStatus RTC_write_year(uint8_t year) {
+    return I2C_byteWrite(rtc_bus, RTC_ADDRESS, YEAR_ADDRESS, decToBcd(year));
 }
 
-void RTC_write_year(uint8_t year) {
-    I2C1_byteWrite(RTC_ADDRESS, YEAR_ADDRESS, decToBcd(year));
+I2CStatus RTC_write_clock(Clock* time) {
+    // Stops at the first failure: the fields after it keep their old values
+    I2CStatus status = RTC_write_second(time->seconds);
+    if (status == I2C_OK) {
+        status = RTC_write_minute(time->minutes);
+    }
+    if (status == I2C_OK) {
+        status = RTC_write_hour(time->hours);
+    }
+    if (status == I2C_OK) {
+        status = RTC_write_day(time->day);
+    }
+    if (status == I2C_OK) {
+        status = RTC_write_date(time->date);
+    }
+    if (status == I2C_OK) {
+        status = RTC_write_month(time->month);
+    }
+    if (status == I2C_OK) {
+        status = RTC_write_year(time->year);
+    }
+    return status;
+}
+
+// === ALARM FUNCTIONS ===
+
+I2CStatus RTC_set_alarm(uint8_t hour, uint8_t min, uint8_t sec) {
+    // 1. Alarm 1 matches seconds, minutes and hours (A1M4 set: any date)
+    I2CStatus status = I2C_byteWrite(rtc_bus, RTC_ADDRESS, ALARM1_ADDRESS, decToBcd(sec));
+    if (status == I2C_OK) {
+        status = I2C_byteWrite(rtc_bus, RTC_ADDRESS, ALARM1_ADDRESS + 1, decToBcd(min));
+    }
+    if (status == I2C_OK) {
+        status = I2C_byteWrite(rtc_bus, RTC_ADDRESS, ALARM1_ADDRESS + 2, decToBcd(hour));
+    }
+    if (status == I2C_OK) {
+        status = I2C_byteWrite(rtc_bus, RTC_ADDRESS, ALARM1_ADDRESS + 3, 0x80);
+    }
+
+    // 2. Drop an old match so INT/SQW starts high
+    if (status == I2C_OK) {
+        status = I2C_byteWrite(rtc_bus, RTC_ADDRESS, STATUS_ADDRESS, 0x08);     // Clear A1F/A2F, keep EN32kHz
+    }
+    if (status != I2C_OK) {
+        return status;                      // CONTROL (A1IE) left alone
+    }
+    rtc_alarm_taken = rtc_alarm_count;
+
+    // 3. EXTI0 on PA0, falling edge (PA0 input with pull-up from BOARD_INIT)
+    SYSCFG->EXTICR[0] &= ~(0xF << 0);                     // Port A
+    EXTI->FTSR |= (1 << 0);
+    EXTI->IMR  |= (1 << 0);
+    NVIC_EnableIRQ(EXTI0_IRQn);
+
+    // 4. INTCN (alarm on INT instead of the square wave) + A1IE
+    return I2C_byteWrite(rtc_bus, RTC_ADDRESS, CONTROL_ADDRESS, 0x05);
+}
+
+I2CStatus RTC_disable_alarm(void) {
+    I2CStatus status = I2C_byteWrite(rtc_bus, RTC_ADDRESS, CONTROL_ADDRESS, 0x04);     // INTCN only
+    if (status == I2C_OK) {
+        status = I2C_byteWrite(rtc_bus, RTC_ADDRESS, STATUS_ADDRESS, 0x08);
+    }
+    rtc_alarm_taken = rtc_alarm_count;
+    return status;
+}
+
+uint8_t RTC_alarm_fired(void) {
+    uint32_t count = rtc_alarm_count;
+    if (rtc_alarm_taken == count) {
+        return 0;
+    }
+
+    // Clearing A1F releases INT/SQW, ready for the next match. If that
+    // fails the pin stays low (no further edges), so the alarm stays
+    // pending and the next call tries again
+    if (I2C_byteWrite(rtc_bus, RTC_ADDRESS, STATUS_ADDRESS, 0x08) != I2C_OK) {
+        return 0;
+    }
+    rtc_alarm_taken = count;
+    return 1;
 }
 
-void RTC_write_clock(Clock* time) {
-    RTC_write_second(time->seconds);
-    RTC_write_minute(time->minutes);
-    RTC_write_hour(time->hours);
-    RTC_write_day(time->day);
-    RTC_write_date(time->date);
-    RTC_write_month(time->month);
-    RTC_write_year(time->year);
+// IRQ handler (EXTI0 has its own vector)
+void EXTI0_IRQHandler(void) {
+    if (EXTI->PR & (1 << 0)) {
+        EXTI->PR = (1 << 0);                // rc_w1
+        rtc_alarm_count++;
+    }
 }
 
 // === PRINT FUNCTION ===
@@ -128,7 +243,12 @@ void RTC_print_clock(void) {
     Clock t;
     
     // Get current time
-    RTC_read_clock(&t);
+    I2CStatus status = RTC_read_clock(&t);
+    if (status != I2C_OK) {
+        sprintf(buffer, "RTC: %s\r\n", I2C_status_name(status));
+        USART2_write(buffer);
+        return;
+    }
     
     // Format: HH:MM:SS DD/MM/YY
     sprintf(buffer, "%02d:%02d:%02d %02d/%02d/%02d\r\n", 
@@ -2,46 +2,216 @@
  *  Date: 8/14/2023
  *  Description: A source to contain function relating to
  *  system clock configuration settings for the F446RE
- *  Notes: Using 8MHz Crystal as HSE, sets STM to run at 45 MHz
+ *  Notes: Using 8MHz Crystal as HSE, boots at 45 MHz, profiles up to 180 MHz
  */
 
 #include "RccConfig.h"
+#include "spinwait.h"
+
+/*******************************************************************************/
+/*                          PROFILE TABLE */
+/*******************************************************************************/
+typedef struct {
+    uint32_t sysclk;    // Hz
+    uint16_t pll_n;     // PLL_N multiplier
+    uint8_t pll_p;      // PLL_P field (0: /2, 1: /4, 2: /6, 3: /8)
+    uint8_t apb1_psc;   // PPRE1 field (0: /1, 4: /2, 5: /4, 6: /8, 7: /16)
+    uint8_t apb2_psc;   // PPRE2 field
+    uint8_t flash_ws;   // Flash wait states at 2.7-3.6 V (30 MHz per WS)
+    uint8_t vos;        // PWR_CR VOS field (1: Scale 3, 2: Scale 2, 3: Scale 1)
+    uint8_t overdrive;  // Needed above 168 MHz
+} ClockProfileConfig;
+
+/* one row per CLOCK_PROFILE_LIST entry, solved by clocktree.h */
+#define CLOCK_PROFILE_ROW(sysclk) {                     \
+    (sysclk),                                           \
+    CLOCK_PLL_N(sysclk),                                \
+    CLOCK_PLL_P_FIELD(sysclk),                          \
+    CLOCK_PPRE_FIELD(CLOCK_APB1_DIV(sysclk)),           \
+    CLOCK_PPRE_FIELD(CLOCK_APB2_DIV(sysclk)),           \
+    CLOCK_FLASH_WS(sysclk),                             \
+    CLOCK_VOS(sysclk),                                  \
+    CLOCK_OVERDRIVE(sysclk) },
+
+static const ClockProfileConfig profiles[] = {
+    CLOCK_PROFILE_LIST(CLOCK_PROFILE_ROW)
+};
+
+/* refuse to build profiles the PLL can't make */
+#define CLOCK_PROFILE_CHECK(sysclk) CLOCK_ASSERT_SYSCLK(sysclk);
+CLOCK_PROFILE_LIST(CLOCK_PROFILE_CHECK)
+
+STATIC_ASSERT(sizeof(profiles) / sizeof(profiles[0]) == CLOCK_NUM_PROFILES,
+              "CLOCK_PROFILE_LIST must have one entry per ClockProfile");
+#define CLOCK_IS_BOOT_PROFILE(sysclk) || ((sysclk) == CLOCK_FREQUENCY)
+STATIC_ASSERT(0 CLOCK_PROFILE_LIST(CLOCK_IS_BOOT_PROFILE),
+              "CLOCK_FREQUENCY must be one of CLOCK_PROFILE_LIST");
+
+/* Clocks in effect (reset: HSI 16 MHz, no prescalers) */
+static uint32_t sysclk_hz = 16000000U;
+static uint32_t hclk_hz = 16000000U;
+static uint32_t pclk1_hz = 16000000U;
+static uint32_t pclk2_hz = 16000000U;
+static uint32_t apb1_timer_hz = 16000000U;
+static uint32_t apb2_timer_hz = 16000000U;
+static ClockProfile current_profile = CLOCK_NUM_PROFILES;
+
+static ClockCallback callbacks[CLOCK_MAX_CALLBACKS];
+static uint32_t callback_count = 0;
+
+/*******************************************************************************/
+/*                          HELPERS */
+/*******************************************************************************/
+static void CLOCK_notify(ClockEvent event){
+    for (uint32_t i = 0; i < callback_count; i++){
+        callbacks[i](event);
+    }
+}
+
+/* divider of a PPRE field (0b0xx = 1, 0b100 = 2 ... 0b111 = 16) */
+static uint32_t CLOCK_apb_divider(uint32_t ppre){
+    return (ppre < 4) ? 1U : (2U << (ppre - 4));
+}
+
+/* recompute the cached frequencies from SYSCLK and CFGR */
+static void CLOCK_update_frequencies(uint32_t sysclk){
+    uint32_t cfgr = RCC->CFGR;
+    uint32_t apb1_div = CLOCK_apb_divider((cfgr >> 10) & 7);
+    uint32_t apb2_div = CLOCK_apb_divider((cfgr >> 13) & 7);
+
+    sysclk_hz = sysclk;
+    hclk_hz = sysclk;   // AHB prescaler is always 1 here
+    pclk1_hz = hclk_hz / apb1_div;
+    pclk2_hz = hclk_hz / apb2_div;
+    apb1_timer_hz = (apb1_div == 1) ? pclk1_hz : (pclk1_hz * 2);
+    apb2_timer_hz = (apb2_div == 1) ? pclk2_hz : (pclk2_hz * 2);
+}
+
+/* switch SYSCLK (SW field) with the prescalers given, drivers notified around it */
+static void CLOCK_switch(uint32_t sw, uint32_t apb1_psc, uint32_t apb2_psc, uint32_t sysclk){
+    CLOCK_notify(CLOCK_PRE_CHANGE);
+
+    if (sw == 1){
+        /* slowing down: source first, then open up the prescalers */
+        RCC->CFGR = (RCC->CFGR & ~3U) | sw;
+        SPIN_WHILE(SPIN_RCC_SWS, ((RCC->CFGR >> 2) & 3) != sw);
+    }
+    RCC->CFGR = (RCC->CFGR & ~0xFCF0U) | (AHB_PSC << 4) | (apb1_psc << 10) | (apb2_psc << 13);
+    if (sw != 1){
+        /* speeding up: prescalers first so no bus ever runs too fast */
+        RCC->CFGR = (RCC->CFGR & ~3U) | sw;
+        SPIN_WHILE(SPIN_RCC_SWS, ((RCC->CFGR >> 2) & 3) != sw);
+    }
+
+    CLOCK_update_frequencies(sysclk);
+    CLOCK_notify(CLOCK_POST_CHANGE);
+}
 
 /*******************************************************************************/
 /*                          USER FUNCTION DEFINITIONS */
 /*******************************************************************************/
 void SysClockConfig(){
-    RCC->CR |= 1 << 16; // enable HSE
-    while (!(RCC->CR & (1 << 17)))
-    {
-    } // wait for HSE ready bit to set
+    /* boot into the profile running at CLOCK_FREQUENCY */
+    for (uint32_t i = 0; i < CLOCK_NUM_PROFILES; i++){
+        if (profiles[i].sysclk == CLOCK_FREQUENCY){
+            CLOCK_set_profile((ClockProfile)i);
+            return;
+        }
+    }
+}
+
+void CLOCK_start_hse(void){
+    RCC->CR |= 1 << 16; // enable HSE, ready is checked by CLOCK_set_profile
+}
 
-    RCC->APB1ENR |= 1 << 28; // power enable HSE
-    PWR->CR |= 3 << 14;      // set voltage regulator to scale by 1
+void CLOCK_set_profile(ClockProfile profile){
+    if (profile >= CLOCK_NUM_PROFILES){
+        return;
+    }
+    const ClockProfileConfig* next = &profiles[profile];
+
+    RCC->CR |= 1 << 16; // enable HSE
+    SPIN_WHILE(SPIN_RCC_HSE, !(RCC->CR & (1 << 17))); // wait for HSE ready bit to set
 
-    /* enable the Instruction Cache, Prefetch Buffer, and Data Cache */
+    RCC->APB1ENR |= 1 << 28; // power interface clock (PWR)
 
-    /* set Flash Latency to 5WS (6 CPU cycle) */
-    FLASH->ACR = (1 << 8) | (1 << 9) | (1 << 10) | (5 << 0);
+    /* 1. run from HSE (no prescalers) while the PLL is reprogrammed */
+    /*    flash latency stays at the old (higher or equal) setting */
+    CLOCK_switch(1, 0, 0, HSE_FREQUENCY);
 
-    /* clear and set AHB, APB1, APB2 prescalar config */
-    RCC->CFGR &= ~0xFCF0U; // bit 8 and 9 are reserved/unused
-    RCC->CFGR |= (AHB_PSC << 4) | (APB1_PSC << 10) | (APB2_PSC << 13);
+    /* 2. PLL off; over-drive only exists with the PLL, so drop it too */
+    RCC->CR &= ~(1U << 24);
+    SPIN_WHILE(SPIN_RCC_PLL_OFF, RCC->CR & (1 << 25));
+    PWR->CR &= ~((1U << 17) | (1U << 16)); // ODSWEN, ODEN
 
-    /* set PLL prescalar config */
-    RCC->PLLCFGR = (1 << 22) | (PLL_M) | (PLL_N << 6) | (PLL_P << 16);
+    /* 3. regulator scale (only writable with the PLL off) */
+    PWR->CR = (PWR->CR & ~(3U << 14)) | ((uint32_t)next->vos << 14);
 
+    /* 4. new PLL output, lock */
+    RCC->PLLCFGR = (1 << 22) | (CLOCK_PLL_M) | ((uint32_t)next->pll_n << 6) | ((uint32_t)next->pll_p << 16);
     RCC->CR |= 1 << 24; // enable PLL
-    while (!(RCC->CR & (1 << 25)))
-    {
-    } // wait for PLL ready bit to set
+    SPIN_WHILE(SPIN_RCC_PLL, !(RCC->CR & (1 << 25))); // wait for PLL ready bit to set
 
-    RCC->CFGR |= 2; // use PLLCLK as system clock
+    /* 5. over-drive for 180 MHz: enable, then switch the regulator over */
+    if (next->overdrive){
+        PWR->CR |= 1 << 16; // ODEN
+        SPIN_WHILE(SPIN_PWR_OD, !(PWR->CSR & (1 << 16)));
+        PWR->CR |= 1 << 17; // ODSWEN
+        SPIN_WHILE(SPIN_PWR_ODSW, !(PWR->CSR & (1 << 17)));
+    }
+
+    /* 6. enable the Instruction Cache, Prefetch Buffer, and Data Cache */
+    /*    and set the flash latency for the new HCLK before using it */
+    FLASH->ACR = (1 << 8) | (1 << 9) | (1 << 10) | next->flash_ws;
 
-    /* wait for system clock source status to state PLLCLK in use */
-    while (!(RCC->CFGR & (2 << 2)))
-    {
+    /* 7. back onto the PLL with the profile's bus prescalers */
+    CLOCK_switch(2, next->apb1_psc, next->apb2_psc, next->sysclk);
+    current_profile = profile;
+}
+
+void CLOCK_resume_from_stop(void){
+    /* the hardware already switched, only the drivers need to know */
+    CLOCK_update_frequencies(HSI_FREQUENCY);
+    CLOCK_notify(CLOCK_POST_CHANGE);
+}
+
+ClockProfile CLOCK_get_profile(void){
+    return current_profile;
+}
+
+uint8_t CLOCK_register(ClockCallback callback){
+    for (uint32_t i = 0; i < callback_count; i++){
+        if (callbacks[i] == callback){
+            return 1;
+        }
+    }
+    if (callback_count >= CLOCK_MAX_CALLBACKS){
+        return 0;
     }
+    callbacks[callback_count++] = callback;
+    return 1;
+}
+
+uint32_t CLOCK_get_sysclk(void){ return sysclk_hz; }
+uint32_t CLOCK_get_hclk(void){ return hclk_hz; }
+uint32_t CLOCK_get_pclk1(void){ return pclk1_hz; }
+uint32_t CLOCK_get_pclk2(void){ return pclk2_hz; }
+uint32_t CLOCK_get_apb1_timer_clock(void){ return apb1_timer_hz; }
+uint32_t CLOCK_get_apb2_timer_clock(void){ return apb2_timer_hz; }
+
+void CLOCK_timer_set_prescaler(TIM_TypeDef* tim, uint32_t psc){
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uint32_t cr1 = tim->CR1;
+    uint32_t cnt = tim->CNT;
+    tim->PSC = psc;
+    tim->CR1 = cr1 | (1 << 2); // URS: only over/underflow raises update events
+    tim->EGR = 1;              // UG: load PSC (and the other shadows) now
+    tim->CNT = cnt;            // UG cleared the count, put it back
+    tim->CR1 = cr1;
+
+    __set_PRIMASK(primask);
 }
 /*******************************************************************************/
 /*******************************************************************************/
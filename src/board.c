@@ -0,0 +1,65 @@
+/*
+* filename: board.c
+* purpose: implementation of the board-wide pin and clock setup
+* author: Connor Ockerse
+* date: 10/19/2026
+*/
+
+#include "board.h"
+
+// === BUILD-TIME CHECKS ===
+BOARD_ASSERT_PORT(BOARD_GPIOA_PINS);
+BOARD_ASSERT_PORT(BOARD_GPIOB_PINS);
+BOARD_ASSERT_PORT(BOARD_GPIOC_PINS);
+BOARD_ASSERT_CLOCKS(BOARD_AHB1_CLOCKS);
+BOARD_ASSERT_CLOCKS(BOARD_APB1_CLOCKS);
+BOARD_ASSERT_CLOCKS(BOARD_APB2_CLOCKS);
+
+STATIC_ASSERT(((0U BOARD_GPIOA_PINS(BOARD_PIN_BIT)) & BOARD_SWD_PINS) == 0U,
+              "PA13/PA14 are the SWD pins");
+
+// Every port with pins in the table needs its clock
+STATIC_ASSERT(((0U BOARD_GPIOA_PINS(BOARD_PIN_BIT)) == 0U) ||
+              ((0UL BOARD_AHB1_CLOCKS(BOARD_CLOCK_BIT)) & (1UL << 0)),
+              "GPIOA pins listed but its clock is not");
+STATIC_ASSERT(((0U BOARD_GPIOB_PINS(BOARD_PIN_BIT)) == 0U) ||
+              ((0UL BOARD_AHB1_CLOCKS(BOARD_CLOCK_BIT)) & (1UL << 1)),
+              "GPIOB pins listed but its clock is not");
+STATIC_ASSERT(((0U BOARD_GPIOC_PINS(BOARD_PIN_BIT)) == 0U) ||
+              ((0UL BOARD_AHB1_CLOCKS(BOARD_CLOCK_BIT)) & (1UL << 2)),
+              "GPIOC pins listed but its clock is not");
+
+// === PUBLIC FUNCTIONS ===
+
+void BOARD_INIT(void) {
+    // 1. Peripheral clocks (ports first in the same write)
+    RCC->AHB1ENR |= (uint32_t)(0UL BOARD_AHB1_CLOCKS(BOARD_CLOCK_BIT));
+    RCC->APB1ENR |= (uint32_t)(0UL BOARD_APB1_CLOCKS(BOARD_CLOCK_BIT));
+    RCC->APB2ENR |= (uint32_t)(0UL BOARD_APB2_CLOCKS(BOARD_CLOCK_BIT));
+
+    // 2. GPIOA: alternate functions before the mode so no pin glitches
+    GPIOA->AFR[0]  = BOARD_GPIO_AFRL(BOARD_GPIOA_PINS, 0U);
+    GPIOA->AFR[1]  = BOARD_GPIO_AFRH(BOARD_GPIOA_PINS, 0U);
+    GPIOA->OTYPER  = BOARD_GPIO_OTYPER(BOARD_GPIOA_PINS, 0U);
+    GPIOA->OSPEEDR = BOARD_GPIO_OSPEEDR(BOARD_GPIOA_PINS, BOARD_GPIOA_OSPEEDR_RESET);
+    GPIOA->PUPDR   = BOARD_GPIO_PUPDR(BOARD_GPIOA_PINS, BOARD_GPIOA_PUPDR_RESET);
+    GPIOA->MODER   = BOARD_GPIO_MODER(BOARD_GPIOA_PINS, BOARD_GPIOA_MODER_RESET);
+
+    // 3. GPIOB, same order
+    GPIOB->AFR[0]  = BOARD_GPIO_AFRL(BOARD_GPIOB_PINS, 0U);
+    GPIOB->AFR[1]  = BOARD_GPIO_AFRH(BOARD_GPIOB_PINS, 0U);
+    GPIOB->OTYPER  = BOARD_GPIO_OTYPER(BOARD_GPIOB_PINS, 0U);
+    GPIOB->OSPEEDR = BOARD_GPIO_OSPEEDR(BOARD_GPIOB_PINS, BOARD_GPIOB_OSPEEDR_RESET);
+    GPIOB->PUPDR   = BOARD_GPIO_PUPDR(BOARD_GPIOB_PINS, BOARD_GPIOB_PUPDR_RESET);
+    GPIOB->MODER   = BOARD_GPIO_MODER(BOARD_GPIOB_PINS, BOARD_GPIOB_MODER_RESET);
+
+    // 4. GPIOC only carries pins with the second I2C bus
+#if BOARD_I2C2
+    GPIOC->AFR[0]  = BOARD_GPIO_AFRL(BOARD_GPIOC_PINS, 0U);
+    GPIOC->AFR[1]  = BOARD_GPIO_AFRH(BOARD_GPIOC_PINS, 0U);
+    GPIOC->OTYPER  = BOARD_GPIO_OTYPER(BOARD_GPIOC_PINS, 0U);
+    GPIOC->OSPEEDR = BOARD_GPIO_OSPEEDR(BOARD_GPIOC_PINS, BOARD_GPIOC_OSPEEDR_RESET);
+    GPIOC->PUPDR   = BOARD_GPIO_PUPDR(BOARD_GPIOC_PINS, BOARD_GPIOC_PUPDR_RESET);
+    GPIOC->MODER   = BOARD_GPIO_MODER(BOARD_GPIOC_PINS, BOARD_GPIOC_MODER_RESET);
+#endif
+}
@@ -0,0 +1,146 @@
+/*
+* filename: boot.c
+* purpose: implementation of the timed, overlapped bring-up
+* author: Connor Ockerse
+* date: 10/19/2026
+*/
+
+#include "boot.h"
+#include <stdio.h>
+#include "RccConfig.h"
+#include "TIM6.h"
+#include "timebase.h"
+#include "watchdog.h"
+#include "I2C.h"
+#include "eeprom.h"
+#include "usart.h"
+
+// Phases in the order they finished, and when (us)
+static uint8_t mark_order[BOOT_NUM_PHASES];
+static uint32_t mark_count = 0;
+static uint32_t mark_us[BOOT_NUM_PHASES];
+
+// Device state read while the crystal started, and how each read went
+static Clock boot_clock;
+static uint8_t boot_eeprom[BOOT_EEPROM_PRELOAD_BYTES];
+static I2CStatus clock_status = I2C_ERR_BUS;     // Until BOOT_preload() ran
+static I2CStatus eeprom_status = I2C_ERR_BUS;
+
+static const char* const phase_names[BOOT_NUM_PHASES] = {
+    "timebase",
+    "kickoff",
+    "preload",
+    "clocks",
+    "watchdog",
+    "usart",
+    "ready",
+};
+
+// DS3231 time and the start of the EEPROM (their buses must be up)
+static void BOOT_preload(void) {
+    clock_status = RTC_read_clock(&boot_clock);
+
+    // Stops at the first failure (the rest would fail the same way)
+    eeprom_status = I2C_OK;
+    for (uint32_t i = 0; (i < BOOT_EEPROM_PRELOAD_BYTES) && (eeprom_status == I2C_OK); i++) {
+        eeprom_status = EEPROM_random_read(EEPROM_ADDRESS, (uint8_t)i, &boot_eeprom[i]);
+    }
+}
+
+// === PUBLIC FUNCTIONS ===
+
+void BOOT_INIT(void) {
+    mark_count = 0;
+
+    // 1. Timebase first so every phase gets a timestamp (reclocked later)
+    TIM6_INIT();
+    BOOT_mark(BOOT_PHASE_TIMEBASE);
+
+#if BOOT_OVERLAP
+    // 2. Start everything that only needs time
+    CLOCK_start_hse();
+    WDT_start();
+    BOOT_mark(BOOT_PHASE_KICKOFF);
+
+    // 3. Bus work at HSI while the crystal and the LSI domain catch up
+    I2C_INIT();
+    BOOT_preload();
+    BOOT_mark(BOOT_PHASE_PRELOAD);
+
+    // 4. Join: HSE is ready by now, only the PLL lock is left
+    SysClockConfig();
+    BOOT_mark(BOOT_PHASE_CLOCKS);
+
+    // 5. Join: PR/RLR applied long ago
+    WDT_wait_ready();
+    BOOT_mark(BOOT_PHASE_WATCHDOG);
+#else
+    // 2-5. One after another, each waiting where it starts
+    SysClockConfig();
+    BOOT_mark(BOOT_PHASE_CLOCKS);
+
+    WDT_INIT();
+    BOOT_mark(BOOT_PHASE_WATCHDOG);
+
+    I2C_INIT();
+    BOOT_preload();
+    BOOT_mark(BOOT_PHASE_PRELOAD);
+#endif
+
+    // 6. Serial port at the final baud rate divider
+    USART_INIT();
+    BOOT_mark(BOOT_PHASE_USART);
+}
+
+void BOOT_mark(BootPhase phase) {
+    if ((phase >= BOOT_NUM_PHASES) || (mark_count >= BOOT_NUM_PHASES)) {
+        return;
+    }
+    mark_us[phase] = (uint32_t)TIMEBASE_now_us();
+    mark_order[mark_count++] = (uint8_t)phase;
+}
+
+uint32_t BOOT_get_us(BootPhase phase) {
+    for (uint32_t i = 0; i < mark_count; i++) {
+        if (mark_order[i] == phase) {
+            return mark_us[phase];
+        }
+    }
+    return 0;
+}
+
+const Clock* BOOT_get_clock(void) {
+    return (clock_status == I2C_OK) ? &boot_clock : NULL;
+}
+
+const uint8_t* BOOT_get_eeprom(void) {
+    return (eeprom_status == I2C_OK) ? boot_eeprom : NULL;
+}
+
+I2CStatus BOOT_get_clock_status(void) {
+    return clock_status;
+}
+
+I2CStatus BOOT_get_eeprom_status(void) {
+    return eeprom_status;
+}
+
+void BOOT_report(void) {
+    char buffer[64];
+    uint32_t previous_us = 0;
+
+    sprintf(buffer, "--- boot (%s, us) ---\r\n", BOOT_OVERLAP ? "overlapped" : "serial");
+    USART2_write(buffer);
+
+    for (uint32_t i = 0; i < mark_count; i++) {
+        uint8_t phase = mark_order[i];
+        sprintf(buffer, "%-9s at %7lu  +%lu\r\n", phase_names[phase],
+                (unsigned long)mark_us[phase], (unsigned long)(mark_us[phase] - previous_us));
+        USART2_write(buffer);
+        previous_us = mark_us[phase];
+    }
+
+    sprintf(buffer, "preload: DS3231 %s, EEPROM %s\r\n",
+            I2C_status_name(clock_status), I2C_status_name(eeprom_status));
+    USART2_write(buffer);
+}
@@ -0,0 +1,226 @@
+/*
+* filename: brownout.c
+* purpose: implementation of the power-fail snapshot
+* author: Connor Ockerse
+* date: 10/19/2026
+*/
+
+#include "brownout.h"
+#include <stddef.h> // For offsetof
+#include <stdio.h>
+#include <string.h> // For memset
+#include "RccConfig.h"
+#include "crc.h"
+#include "eeprom.h"
+#include "encoder.h"
+#include "staticassert.h"
+#include "stepper.h"
+#include "stopwatch.h"
+#include "supervisor.h"
+#include "swtimer.h"
+#include "usart.h"
+
+// Backup SRAM copy: the snapshot plus what the save that wrote it cost
+typedef struct {
+    BrownoutSnapshot snapshot;
+    uint32_t backup_cycles;     // Handler entry to the snapshot stored
+    uint32_t eeprom_cycles;     // Handler entry to the EEPROM page sent, 0 = none
+    uint32_t sysclk_hz;         // To turn both into time
+}BrownoutBackup;
+
+#define BROWNOUT_BACKUP ((BrownoutBackup*)(uintptr_t)(BKPSRAM_BASE + BROWNOUT_BACKUP_OFFSET))
+#define BROWNOUT_EEPROM_LOCATION ((uint8_t)(BROWNOUT_EEPROM_PAGE * EEPROM_PAGE_BYTES))
+#define BROWNOUT_CRC_BYTES offsetof(BrownoutSnapshot, crc)
+
+STATIC_ASSERT(sizeof(BrownoutSnapshot) == EEPROM_PAGE_BYTES, "snapshot must fill one EEPROM page");
+STATIC_ASSERT(sizeof(SupervisorSnapshot) <= BROWNOUT_BACKUP_OFFSET, "overlaps the supervisor snapshot");
+
+static BrownoutStats stats;
+static uint8_t sequence = 0;
+static volatile uint8_t eeprom_valid = 0;  // The EEPROM page holds a snapshot
+static SWTimer invalidate_timer;
+
+static uint32_t BROWNOUT_cycles_to_ns(uint32_t cycles, uint32_t sysclk_hz) {
+    return (uint32_t)(((uint64_t)cycles * 1000000000U) / sysclk_hz);
+}
+
+static uint32_t BROWNOUT_cycles_to_us(uint32_t cycles, uint32_t sysclk_hz) {
+    return (uint32_t)(((uint64_t)cycles * 1000000U) / sysclk_hz);
+}
+
+static uint8_t BROWNOUT_is_valid(const BrownoutSnapshot* snapshot) {
+    return snapshot->crc == CRC_bytes_sw((const uint8_t*)snapshot, BROWNOUT_CRC_BYTES);
+}
+
+// Thread side of a recovery: the EEPROM page goes back to erased
+static void BROWNOUT_invalidate_eeprom(void* arg) {
+    (void)arg;
+    uint8_t erased[EEPROM_PAGE_BYTES];
+    memset(erased, 0xFF, sizeof(erased));
+    // Still valid if the bus failed: the next recovery tries again
+    eeprom_valid = !EEPROM_write_page(EEPROM_ADDRESS, BROWNOUT_EEPROM_LOCATION, erased, sizeof(erased));
+}
+
+// VDD fell below the level: everything here races the supply
+static void BROWNOUT_save(uint32_t start) {
+    BrownoutBackup* backup = BROWNOUT_BACKUP;
+    BrownoutSnapshot snapshot;
+    uint32_t sysclk_hz = CLOCK_get_sysclk();
+
+    // 1. Coils off (the biggest load, and the position stays put), then pack the state
+    STEPPER_stop();
+    snapshot.stepper_position = STEPPER_get_position();
+    snapshot.stopwatch_ms = STOPWATCH_read();
+    snapshot.encoder = ENCODER_read();
+    snapshot.stopwatch_running = STOPWATCH_is_running();
+    snapshot.sequence = ++sequence;
+    snapshot.crc = CRC_bytes_sw((const uint8_t*)&snapshot, BROWNOUT_CRC_BYTES);
+
+    // 2. Backup SRAM first: done in about a microsecond
+    backup->eeprom_cycles = 0;
+    backup->snapshot = snapshot;
+    __DSB();
+    uint32_t backup_cycles = DWT->CYCCNT - start;
+    backup->backup_cycles = backup_cycles;
+    backup->sysclk_hz = sysclk_hz;
+
+    uint32_t backup_ns = BROWNOUT_cycles_to_ns(backup_cycles, sysclk_hz);
+    stats.saves++;
+    if (backup_ns > stats.worst_backup_ns) {
+        stats.worst_backup_ns = backup_ns;
+    }
+    if (backup_ns > (BROWNOUT_HOLDUP_US * 1000U)) {
+        stats.over_holdup++;
+    }
+
+    // 3. One EEPROM page, unless the interrupted code is using its bus or the chip
+#if BROWNOUT_EEPROM
+    if (I2C_is_busy(EEPROM_get_bus()) || EEPROM_is_busy()) {
+        stats.eeprom_skipped++;
+        return;
+    }
+    if (!EEPROM_write_page(EEPROM_ADDRESS, BROWNOUT_EEPROM_LOCATION, (const uint8_t*)&snapshot, sizeof(snapshot))) {
+        stats.eeprom_failed++;              // Page not (all) sent: only backup SRAM has it
+        return;
+    }
+    uint32_t eeprom_cycles = DWT->CYCCNT - start;
+    backup->eeprom_cycles = eeprom_cycles;
+    eeprom_valid = 1;
+
+    uint32_t eeprom_us = BROWNOUT_cycles_to_us(eeprom_cycles, sysclk_hz);
+    stats.eeprom_writes++;
+    if (eeprom_us > stats.worst_eeprom_us) {
+        stats.worst_eeprom_us = eeprom_us;
+    }
+    if ((eeprom_us + BROWNOUT_EEPROM_CYCLE_US) > BROWNOUT_HOLDUP_US) {
+        stats.over_holdup++;
+    }
+#endif
+}
+
+// VDD came back without a reset: the copies are old news
+static void BROWNOUT_recover(void) {
+    memset(&BROWNOUT_BACKUP->snapshot, 0, sizeof(BrownoutSnapshot));
+    stats.recoveries++;
+    if (eeprom_valid) {
+        SWTIMER_start(&invalidate_timer, 0, 0, BROWNOUT_invalidate_eeprom, 0);
+    }
+}
+
+void PVD_IRQHandler(void) {
+    uint32_t start = DWT->CYCCNT;
+    EXTI->PR = (1U << 16);
+    if (PWR->CSR & (1 << 2)) {              // PVDO: VDD below the level
+        BROWNOUT_save(start);
+    } else {
+        BROWNOUT_recover();
+    }
+}
+
+BrownoutRestore BROWNOUT_INIT(void) {
+    BrownoutBackup* backup = BROWNOUT_BACKUP;
+    BrownoutSnapshot from_eeprom;
+    const BrownoutSnapshot* chosen = NULL;
+
+    // 1. Backup SRAM (clocked by BOARD_INIT) is behind DBP; BRE keeps it on VBAT
+    PWR->CR |= (1 << 8);                    // DBP
+    PWR->CSR |= (1 << 9);                   // BRE
+    if (!(DWT->CTRL & (1 << 0))) {
+        CoreDebug->DEMCR |= (1 << 24);      // TRCENA
+        DWT->CTRL |= (1 << 0);              // CYCCNTENA
+    }
+
+    // 2. Backup SRAM copy first, the EEPROM page without it
+    memset(&stats, 0, sizeof(stats));
+    stats.restored = BROWNOUT_RESTORED_NONE;
+#if BROWNOUT_EEPROM
+    eeprom_valid = (EEPROM_read_sequential(EEPROM_ADDRESS, BROWNOUT_EEPROM_LOCATION, (uint8_t*)&from_eeprom,
+                                           sizeof(from_eeprom)) == I2C_OK) && BROWNOUT_is_valid(&from_eeprom);
+#else
+    eeprom_valid = 0;
+#endif
+    if (BROWNOUT_is_valid(&backup->snapshot)) {
+        chosen = &backup->snapshot;
+        stats.restored = BROWNOUT_RESTORED_BACKUP;
+        if (backup->sysclk_hz) {
+            stats.last_backup_ns = BROWNOUT_cycles_to_ns(backup->backup_cycles, backup->sysclk_hz);
+            stats.last_eeprom_us = BROWNOUT_cycles_to_us(backup->eeprom_cycles, backup->sysclk_hz);
+        }
+    } else if (eeprom_valid) {
+        chosen = &from_eeprom;
+        stats.restored = BROWNOUT_RESTORED_EEPROM;
+    }
+
+    // 3. Put it back (the time without power isn't on the stopwatch)
+    if (chosen) {
+        STEPPER_set_position(chosen->stepper_position);
+        ENCODER_write(chosen->encoder);
+        STOPWATCH_set(chosen->stopwatch_ms);
+        if (chosen->stopwatch_running) {
+            STOPWATCH_resume();
+        }
+        sequence = chosen->sequence;
+    }
+
+    // 4. Used up: an ordinary reset later must not restore it again
+    memset(&backup->snapshot, 0, sizeof(BrownoutSnapshot));
+    if (eeprom_valid) {
+        BROWNOUT_invalidate_eeprom(0);      // One write cycle, finishes in the background
+    }
+
+    // 5. PVD on EXTI line 16: rising = VDD fell below the level, falling = back up
+    EXTI->IMR |= (1U << 16);
+    EXTI->RTSR |= (1U << 16);
+    EXTI->FTSR |= (1U << 16);
+    PWR->CR = (PWR->CR & ~(7U << 5)) | (BROWNOUT_PVD_LEVEL << 5) | (1 << 4);    // PLS, PVDE
+    NVIC_SetPriority(PVD_IRQn, 0);
+    NVIC_EnableIRQ(PVD_IRQn);
+    return stats.restored;
+}
+
+void BROWNOUT_get_stats(BrownoutStats* out) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *out = stats;
+    __set_PRIMASK(primask);
+}
+
+void BROWNOUT_report(void) {
+    static const char* const sources[] = { "nothing", "backup SRAM", "EEPROM" };
+    char buffer[128];
+    BrownoutStats now;
+    BROWNOUT_get_stats(&now);
+
+    sprintf(buffer, "BROWNOUT: restored %s, previous save %lu ns (EEPROM page %lu us)\r\n",
+            sources[now.restored], (unsigned long)now.last_backup_ns, (unsigned long)now.last_eeprom_us);
+    USART2_write(buffer);
+    sprintf(buffer, "BROWNOUT: %lu saves, %lu recoveries, %lu EEPROM pages, %lu skipped, %lu failed\r\n",
+            (unsigned long)now.saves, (unsigned long)now.recoveries, (unsigned long)now.eeprom_writes,
+            (unsigned long)now.eeprom_skipped, (unsigned long)now.eeprom_failed);
+    USART2_write(buffer);
+    sprintf(buffer, "BROWNOUT: worst %lu ns to backup SRAM, %lu + %lu us to EEPROM, hold-up %lu us, %lu over\r\n",
+            (unsigned long)now.worst_backup_ns, (unsigned long)now.worst_eeprom_us,
+            (unsigned long)BROWNOUT_EEPROM_CYCLE_US, (unsigned long)BROWNOUT_HOLDUP_US,
+            (unsigned long)now.over_holdup);
+    USART2_write(buffer);
+}
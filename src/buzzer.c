@@ -7,35 +7,47 @@
 
 #include "buzzer.h"
 #include "RccConfig.h"
+#include "dma.h"
+
+// PWM-DAC carrier stays above hearing at every SYSCLK
+#define BUZZER_CLOCK_CHECK(sysclk) \
+    STATIC_ASSERT(CLOCK_APB2_TIMER_HZ(sysclk) / PCM_CARRIER_STEPS >= 20000U, \
+                  "PCM carrier audible at a supported SYSCLK");
+CLOCK_SYSCLK_LIST(BUZZER_CLOCK_CHECK)
+
+// Tone set by update_buzzer_freq (0 = off), replayed after a clock change
+static uint32_t tone_frequency = 0;
+
+// DMA stream carrying TIM1_UP (DMA2 Stream5, taken at init)
+static uint8_t pcm_dma = DMA_NO_STREAM;
+
+static void BUZZER_reclock(ClockEvent event);
+static void PCM_dma_event(DmaEvent event, void* arg);
 
 // PWM initialization for TIM1_CH1 (PA8)
 void BUZZER_INIT(void){
-    // 1. Enable clocks
-    RCC->AHB1ENR |= (1 << 0);          // GPIOA clock
-    RCC->APB2ENR |= (1 << 0);          // TIM1 clock (TIM1 is on APB2)
-    
-    // 2. Configure PA8 as alternate function
-    GPIOA->MODER &= ~(3 << (8 * 2));   // Clear mode bits for PA8
-    GPIOA->MODER |= (2 << (8 * 2));    // Alternate function mode
-    GPIOA->AFR[1] &= ~(0xF << ((8-8) * 4)); // Clear AF bits for PA8
-    GPIOA->AFR[1] |= (1 << ((8-8) * 4)); // AF1 for TIM1
-    
-    // 3. Configure TIM1 for PWM
+    // 1. TIM1 clock and PA8 (AF1, TIM1_CH1) come from BOARD_INIT
+
+    // 2. Configure TIM1 for PWM
     TIM1->PSC = 0;                     // No prescaler
     TIM1->ARR = 0;                     // Auto-reload: 0 Hz initially (off)
     
-    // 4. Configure Channel 1 for PWM Mode 1
+    // 3. Configure Channel 1 for PWM Mode 1
     TIM1->CCMR1 &= ~(0x7 << 4);        // Clear OC1M bits
     TIM1->CCMR1 |= (6 << 4);           // PWM Mode 1 (OC1M = 110)
     TIM1->CCMR1 |= (1 << 3);           // Output compare preload enable (OC1PE)
     
-    // 5. Enable output (but don't start timer yet)
+    // 4. Enable output (but don't start timer yet)
     TIM1->CCER |= (1 << 0);            // Capture/Compare 1 output enable
     TIM1->BDTR |= (1 << 15);           // Main output enable (MOE) - required for TIM1
     TIM1->CR1 |= (1 << 7);             // Auto-reload preload enable (ARPE)
     
-    // 6. Set initial duty cycle to 0 (buzzer off)
+    // 5. Set initial duty cycle to 0 (buzzer off)
     TIM1->CCR1 = 0;
+    CLOCK_register(BUZZER_reclock);
+
+    // 6. Stream for PCM playback (TIM1_UP)
+    pcm_dma = DMA_alloc(DMA_REQ_TIM1_UP, "buzzer");
 }
 
 /**
@@ -43,15 +55,16 @@ void BUZZER_INIT(void){
  * @param frequency: frequency in Hz
  */
 void update_buzzer_freq(uint32_t frequency) {
+    tone_frequency = frequency;
     if (frequency == 0) {
         TIM1->CR1 &= ~(1 << 0);        // Counter disable
         TIM1->CCR1 = 0;                // 0% duty cycle
         return;
     }
     
-    // Use the GLOBAL clock variable from RccConfig.h
-    // TIM1 is on APB2, so we use APB2_CLOCK_FREQ
-    uint32_t total_ticks = CLOCK_FREQUENCY / frequency;
+    // TIM1 is on APB2, so we use the APB2 timer clock from RccConfig.h
+    uint32_t timer_clock = CLOCK_get_apb2_timer_clock();
+    uint32_t total_ticks = timer_clock / frequency;
     uint32_t prescaler = 1;            
     uint32_t period;
     
@@ -61,7 +74,7 @@ void update_buzzer_freq(uint32_t frequency) {
     }
     
     // Calculate final period (ARR)
-    period = (CLOCK_FREQUENCY / (prescaler * frequency)) - 1;
+    period = (timer_clock / (prescaler * frequency)) - 1;
     
     // Stop timer before reconfiguration
     TIM1->CR1 &= ~(1 << 0);            
@@ -74,4 +87,152 @@ void update_buzzer_freq(uint32_t frequency) {
     TIM1->BDTR |= (1 << 15);           // MOE bit
     TIM1->EGR |= (1 << 0);             // Force update of shadow registers
     TIM1->CR1 |= (1 << 0);             // Counter enable
-}
\ No newline at end of file
+}
+// === PCM PLAYBACK (PWM-DAC) ===
+
+// Playback state shared with the DMA interrupt
+static const uint8_t* pcm_clip = 0;       // Start of the clip being played
+static volatile uint32_t pcm_next = 0;    // Offset of the next chunk to queue
+static uint32_t pcm_length = 0;           // Clip length in samples
+static uint32_t pcm_sample_rate = 0;      // Samples per second of the clip
+static volatile uint32_t pcm_chunks_left = 0; // Chunks still to be played out
+static volatile uint8_t pcm_playing = 0;
+
+// What the stream writes to CCR1, one half-word per sample: a timer register
+// takes no byte writes, and equal PSIZE/MSIZE keeps the stream in direct mode
+// (no FIFO packing). One buffer plays while the other is refilled.
+static uint16_t pcm_buffer[2][PCM_CHUNK_SAMPLES];
+
+// Widens the next chunk of the clip into a buffer, silence past the end, and advances pcm_next
+static const uint16_t* PCM_fill(uint8_t which) {
+    uint16_t* buffer = pcm_buffer[which];
+    uint32_t remaining = pcm_length - pcm_next;
+    uint32_t take = (remaining < PCM_CHUNK_SAMPLES) ? remaining : PCM_CHUNK_SAMPLES;
+
+    for (uint32_t i = 0; i < PCM_CHUNK_SAMPLES; i++) {
+        buffer[i] = (i < take) ? pcm_clip[pcm_next + i] : PCM_SILENCE;
+    }
+    pcm_next += take;
+    return buffer;
+}
+
+// Update events per sample = carrier / sample rate (rounded), 0 if out of range
+// TIM1 repetition counter is 8 bits, so 1..256 carrier periods per sample
+static uint32_t PCM_repeats(uint32_t sample_rate) {
+    uint32_t carrier = CLOCK_get_apb2_timer_clock() / PCM_CARRIER_STEPS;
+    uint32_t repeats = (carrier + (sample_rate / 2)) / sample_rate;
+    return (repeats > 256) ? 0 : repeats;
+}
+
+uint8_t BUZZER_pcm_play(const uint8_t* samples, uint32_t length, uint32_t sample_rate) {
+    if (samples == 0 || length == 0 || sample_rate == 0 || pcm_dma == DMA_NO_STREAM) {
+        return 0;
+    }
+
+    uint32_t repeats = PCM_repeats(sample_rate);
+    if (repeats == 0) {
+        return 0;
+    }
+
+    BUZZER_pcm_stop();
+
+    // 1. Reset playback state (DMA2 is clocked by BOARD_INIT)
+    pcm_sample_rate = sample_rate;
+    pcm_clip = samples;
+    pcm_length = length;
+    pcm_next = 0;
+    pcm_chunks_left = (length + PCM_CHUNK_SAMPLES - 1) / PCM_CHUNK_SAMPLES;
+
+    // 2. Configure TIM1 as a PWM-DAC
+    TIM1->CR1 &= ~(1 << 0);            // Counter disable
+    TIM1->PSC = 0;                     // Carrier runs at the full timer clock
+    TIM1->ARR = PCM_CARRIER_STEPS - 1; // 8-bit resolution
+    TIM1->RCR = repeats - 1;           // One update (DMA request) per sample
+    TIM1->CCR1 = PCM_SILENCE;
+
+    // 3. Double-buffered stream: one chunk plays while the other is queued
+    DmaConfig dma;
+    DMA_config_init(&dma, DMA_DIR_MEM_TO_PERIPH);
+    dma.peripheral = (uint32_t)(uintptr_t)&TIM1->CCR1;
+    dma.memory0 = PCM_fill(0);
+    dma.memory1 = PCM_fill(1);
+    dma.count = PCM_CHUNK_SAMPLES;     // Half-words
+    dma.periph_size = 2;               // Half-word buffer to half-word CCR1 (direct mode)
+    dma.memory_size = 2;
+    dma.priority = 2;                  // High
+    dma.mode = DMA_MODE_DOUBLE;
+    dma.callback = PCM_dma_event;
+
+    // 4. Start stream, load PSC/ARR/RCR, then let TIM1 update events pull
+    // samples. UDE goes on after the UG, or the forced update would take
+    // the first sample a carrier period early.
+    pcm_playing = 1;
+    DMA_start(pcm_dma, &dma);
+    TIM1->BDTR |= (1 << 15);           // MOE bit
+    TIM1->EGR |= (1 << 0);             // Load PSC/ARR/RCR
+    TIM1->SR &= ~(1 << 0);
+    TIM1->DIER |= (1 << 8);            // UDE (Update DMA request)
+    TIM1->CR1 |= (1 << 0);             // Counter enable
+
+    return 1;
+}
+
+uint8_t BUZZER_pcm_is_playing(void) {
+    return pcm_playing;
+}
+
+void BUZZER_pcm_stop(void) {
+    // Stop requesting samples and halt the stream
+    TIM1->DIER &= ~(1 << 8);           // UDE off
+    if (pcm_dma != DMA_NO_STREAM) {
+        DMA_stop(pcm_dma);
+    }
+
+    // Silence the output and restore tone mode defaults
+    TIM1->CR1 &= ~(1 << 0);
+    TIM1->CCR1 = 0;
+    TIM1->RCR = 0;
+    pcm_playing = 0;
+}
+
+// Follows clock changes: the tone is recomputed, a clip keeps its sample rate
+static void BUZZER_reclock(ClockEvent event) {
+    if (event != CLOCK_POST_CHANGE) {
+        return;
+    }
+    if (pcm_playing) {
+        uint32_t repeats = PCM_repeats(pcm_sample_rate);
+        if (repeats == 0) {
+            BUZZER_pcm_stop();          // Sample rate out of reach at this clock
+        } else {
+            TIM1->RCR = repeats - 1;    // Preloaded: takes over at the next update
+        }
+    } else if (tone_frequency != 0) {
+        update_buzzer_freq(tone_frequency);
+    }
+}
+
+// DMA interrupt: one chunk has finished playing
+static void PCM_dma_event(DmaEvent event, void* arg) {
+    (void)arg;
+    if (event == DMA_EVENT_ERROR) {
+        // Transfer error (bad address): give up on the clip
+        BUZZER_pcm_stop();
+        return;
+    }
+    if (event != DMA_EVENT_DONE) {
+        return;                         // HTIF is set even with HTIE off; chunks end at TCIF
+    }
+
+    if (pcm_chunks_left > 0) {
+        pcm_chunks_left--;
+    }
+
+    if (pcm_chunks_left == 0) {
+        BUZZER_pcm_stop();
+    } else {
+        // The current buffer is now playing; refill the other one in place
+        uint8_t idle = DMA_current_buffer(pcm_dma) ? 0U : 1U;
+        DMA_set_buffer(pcm_dma, idle, PCM_fill(idle));
+    }
+}
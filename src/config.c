@@ -0,0 +1,494 @@
+/*
+* filename: config.c
+* purpose: implementation of the internal-flash settings store
+* author: Connor Ockerse
+* date: 10/19/2026
+*/
+
+#include "config.h"
+#include <stdio.h>
+#include <string.h> // For memcmp, memcpy
+#include "crc.h"
+#include "eeprom.h"
+#include "spinwait.h"
+#include "timebase.h"
+#include "usart.h"
+#include "watchdog.h"
+
+// Sector header
+#define CONFIG_MAGIC 0x43464731U            // "CFG1"
+#define CONFIG_HEADER_WORDS 2U
+#define CONFIG_ERASED 0xFFFFFFFFU
+
+// Record header word
+#define CONFIG_KEY_MASK 0xFFFFU
+#define CONFIG_LEN_SHIFT 16
+#define CONFIG_CHECK_SHIFT 24
+#define CONFIG_VALUE_WORDS(len) (((uint32_t)(len) + 3U) / 4U)
+#define CONFIG_RECORD_WORDS(len) (2U + CONFIG_VALUE_WORDS(len))
+
+// FLASH_SR error flags (OPERR excluded): PGSERR, PGPERR, PGAERR, WRPERR
+#define CONFIG_SR_ERRORS (0xFU << 4)
+
+// Sector geometry (offset from FLASH_BASE, size), F446 single bank
+static const uint32_t sector_offsets[8] = {
+    0x00000U, 0x04000U, 0x08000U, 0x0C000U, 0x10000U, 0x20000U, 0x40000U, 0x60000U
+};
+static const uint32_t sector_sizes[8] = {
+    0x4000U, 0x4000U, 0x4000U, 0x4000U, 0x10000U, 0x20000U, 0x20000U, 0x20000U
+};
+
+// One cached setting
+typedef struct {
+    uint16_t key;
+    uint8_t len;
+    uint8_t used;
+    uint8_t data[CONFIG_MAX_VALUE];
+}ConfigEntry;
+
+// A key also kept in the EEPROM
+typedef struct {
+    uint16_t key;
+    uint8_t location;
+    uint8_t len;
+    uint8_t used;
+}ConfigMirror;
+
+static ConfigEntry entries[CONFIG_MAX_KEYS];
+static ConfigMirror mirrors[CONFIG_MIRROR_SLOTS];
+static uint8_t active = CONFIG_SECTOR_A;    // Sector holding the newest values
+static uint8_t spare = CONFIG_SECTOR_B;
+static uint8_t spare_dirty = 0;             // Spare must be erased before the next compaction
+static uint8_t closed = 0;                  // Bad record seen: no more appends to active
+static uint32_t generation = 0;
+static uint32_t write_pos = 0;              // Next free word of active
+static ConfigStats stats;
+
+// === FLASH ACCESS ===
+
+static volatile uint32_t* CONFIG_sector(uint8_t sector) {
+    return (volatile uint32_t*)(uintptr_t)(FLASH_BASE + sector_offsets[sector]);
+}
+
+static uint32_t CONFIG_sector_words(uint8_t sector) {
+    return sector_sizes[sector] / 4U;
+}
+
+static uint32_t CONFIG_erase_max_us(uint8_t sector) {
+    if (sector_sizes[sector] == 0x4000U) {
+        return CONFIG_ERASE_16K_MAX_US;
+    }
+    return (sector_sizes[sector] == 0x10000U) ? CONFIG_ERASE_64K_MAX_US : CONFIG_ERASE_128K_MAX_US;
+}
+
+static uint8_t CONFIG_is_erased(uint8_t sector) {
+    volatile uint32_t* words = CONFIG_sector(sector);
+    for (uint32_t i = 0; i < CONFIG_sector_words(sector); i++) {
+        if (words[i] != CONFIG_ERASED) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void CONFIG_unlock(void) {
+    if (FLASH->CR & (1U << 31)) {
+        FLASH->KEYR = 0x45670123U;
+        FLASH->KEYR = 0xCDEF89ABU;
+    }
+    FLASH->SR = CONFIG_SR_ERRORS;               // Left over from someone else
+    FLASH->CR = (2U << 8) | (1U << 0);          // PSIZE x32, PG
+}
+
+static void CONFIG_lock(void) {
+    FLASH->CR = (1U << 31);                     // LOCK (PG off)
+}
+
+/**
+ * @brief Programs one word and waits for it
+ * @details Interrupts are masked for the word only: fetches stall while it
+ * programs anyway, and the stall measured is then the flash's alone.
+ * @return 1 if the word reads back, 0 on a flash error
+ */
+static uint8_t CONFIG_program(volatile uint32_t* address, uint32_t value) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    // 1. Store and wait for BSY to drop
+    uint64_t start = TIMEBASE_now_us();
+    *address = value;
+    SPIN_WHILE(SPIN_FLASH_BSY, FLASH->SR & (1U << 16));
+    uint32_t stall = (uint32_t)(TIMEBASE_now_us() - start);
+    uint32_t errors = FLASH->SR & CONFIG_SR_ERRORS;
+
+    __set_PRIMASK(primask);
+
+    // 2. Account for it
+    stats.words++;
+    if (stall > stats.worst_stall_us) {
+        stats.worst_stall_us = stall;
+    }
+    if (stall > CONFIG_FLASH_BUDGET_US) {
+        stats.over_budget++;
+    }
+
+    // 3. Check it took
+    if (errors) {
+        FLASH->SR = errors;
+        return 0;
+    }
+    return *address == value;
+}
+
+static uint8_t CONFIG_erase(uint8_t sector) {
+    // 1. Sector erase: SER + SNB, then STRT
+    CONFIG_unlock();
+    FLASH->CR = (2U << 8) | ((uint32_t)sector << 3) | (1U << 1);
+    FLASH->CR = (2U << 8) | ((uint32_t)sector << 3) | (1U << 1) | (1U << 16);
+    SPIN_WHILE(SPIN_FLASH_BSY, FLASH->SR & (1U << 16));
+    uint32_t errors = FLASH->SR & CONFIG_SR_ERRORS;
+    FLASH->SR = errors;
+    CONFIG_lock();
+
+    // 2. Check it
+    stats.erases++;
+    return !errors && CONFIG_is_erased(sector);
+}
+
+// === RECORDS ===
+
+static uint32_t CONFIG_header(uint16_t key, uint8_t len) {
+    uint8_t check = (uint8_t)~((key & 0xFFU) ^ (key >> 8) ^ len);
+    return key | ((uint32_t)len << CONFIG_LEN_SHIFT) | ((uint32_t)check << CONFIG_CHECK_SHIFT);
+}
+
+// Header and value words of a record (the CRC covers exactly these)
+static uint32_t CONFIG_pack(uint32_t* words, uint16_t key, const uint8_t* data, uint8_t len) {
+    uint32_t count = 1U + CONFIG_VALUE_WORDS(len);
+    words[count - 1U] = CONFIG_ERASED;          // Padding of the last value word stays 0xFF
+    words[0] = CONFIG_header(key, len);
+    if (len) {
+        memcpy(&words[1], data, len);
+    }
+    return count;
+}
+
+// Appends a record at write_pos (the CRC word last: the record's commit point)
+static uint8_t CONFIG_write_record(uint8_t sector, uint16_t key, const uint8_t* data, uint8_t len) {
+    uint32_t words[1U + CONFIG_VALUE_WORDS(CONFIG_MAX_VALUE)];
+    uint32_t count = CONFIG_pack(words, key, data, len);
+    uint32_t crc = CRC_words(words, count);
+    volatile uint32_t* base = CONFIG_sector(sector);
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (!CONFIG_program(&base[write_pos + i], words[i])) {
+            return 0;
+        }
+    }
+    if (!CONFIG_program(&base[write_pos + count], crc)) {
+        return 0;
+    }
+    write_pos += count + 1U;
+    stats.commits++;
+    return 1;
+}
+
+static ConfigEntry* CONFIG_find(uint16_t key) {
+    for (uint32_t i = 0; i < CONFIG_MAX_KEYS; i++) {
+        if (entries[i].used && (entries[i].key == key)) {
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+static ConfigEntry* CONFIG_free_entry(void) {
+    for (uint32_t i = 0; i < CONFIG_MAX_KEYS; i++) {
+        if (!entries[i].used) {
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+static void CONFIG_cache(uint16_t key, const uint8_t* data, uint8_t len) {
+    ConfigEntry* entry = CONFIG_find(key);
+    if (len == 0) {
+        if (entry) {
+            entry->used = 0;
+        }
+        return;
+    }
+    if (!entry) {
+        entry = CONFIG_free_entry();
+        if (!entry) {
+            return;                             // More keys than a build with fewer slots wrote
+        }
+    }
+    entry->key = key;
+    entry->len = len;
+    entry->used = 1;
+    memcpy(entry->data, data, len);
+}
+
+// Replays the records of active into the cache; stops at the end or a bad record
+static void CONFIG_load(void) {
+    volatile uint32_t* base = CONFIG_sector(active);
+    uint32_t total = CONFIG_sector_words(active);
+    uint32_t pos = CONFIG_HEADER_WORDS;
+
+    memset(entries, 0, sizeof(entries));
+    closed = 0;
+    while (pos < total) {
+        // 1. End of the log?
+        uint32_t header = base[pos];
+        if (header == CONFIG_ERASED) {
+            break;
+        }
+
+        // 2. Header sane, record inside the sector and its CRC right?
+        uint16_t key = (uint16_t)(header & CONFIG_KEY_MASK);
+        uint8_t len = (uint8_t)(header >> CONFIG_LEN_SHIFT);
+        uint32_t words[1U + CONFIG_VALUE_WORDS(CONFIG_MAX_VALUE)];
+        if ((header != CONFIG_header(key, len)) || (len > CONFIG_MAX_VALUE)
+            || ((pos + CONFIG_RECORD_WORDS(len)) > total)) {
+            closed = 1;
+            break;
+        }
+        uint32_t count = 1U + CONFIG_VALUE_WORDS(len);
+        for (uint32_t i = 0; i < count; i++) {
+            words[i] = base[pos + i];
+        }
+        if (base[pos + count] != CRC_words(words, count)) {
+            closed = 1;                         // Cut off mid-write: the next set compacts
+            break;
+        }
+
+        // 3. Newest record wins
+        CONFIG_cache(key, (const uint8_t*)&words[1], len);
+        pos += count + 1U;
+    }
+    write_pos = pos;
+}
+
+/**
+ * @brief Copies every cached value into the (erased) spare sector
+ * @details Generation first, records, magic last: until the magic is in,
+ * the old sector is still the valid one.
+ */
+static ConfigStatus CONFIG_compact(void) {
+    if (spare_dirty) {
+        return CONFIG_ERR_FULL;
+    }
+
+    // 1. Fill the spare
+    uint8_t target = spare;
+    uint32_t old_pos = write_pos;
+    volatile uint32_t* base = CONFIG_sector(target);
+    CONFIG_unlock();
+    uint8_t ok = CONFIG_program(&base[1], generation + 1U);
+    write_pos = CONFIG_HEADER_WORDS;
+    for (uint32_t i = 0; ok && (i < CONFIG_MAX_KEYS); i++) {
+        if (entries[i].used) {
+            ok = CONFIG_write_record(target, entries[i].key, entries[i].data, entries[i].len);
+        }
+    }
+    ok = ok && CONFIG_program(&base[0], CONFIG_MAGIC);
+    CONFIG_lock();
+
+    // 2. Swap (a failed copy is erased by CONFIG_maintain() and the old sector stays)
+    spare_dirty = 1;
+    if (!ok) {
+        write_pos = old_pos;
+        closed = 1;
+        return CONFIG_ERR_FLASH;
+    }
+    spare = active;
+    active = target;
+    generation++;
+    closed = 0;
+    stats.compactions++;
+    return CONFIG_OK;
+}
+
+// Appends one record, compacting first if it doesn't fit
+static ConfigStatus CONFIG_append(uint16_t key, const uint8_t* data, uint8_t len) {
+    if (closed || ((write_pos + CONFIG_RECORD_WORDS(len)) > CONFIG_sector_words(active))) {
+        ConfigStatus status = CONFIG_compact();
+        if (status != CONFIG_OK) {
+            return status;
+        }
+    }
+    CONFIG_unlock();
+    uint8_t ok = CONFIG_write_record(active, key, data, len);
+    CONFIG_lock();
+    if (!ok) {
+        closed = 1;                             // Half a record: the rest of the sector is unusable
+        return CONFIG_ERR_FLASH;
+    }
+    return CONFIG_OK;
+}
+
+// === API ===
+
+void CONFIG_INIT(void) {
+    uint8_t sectors[2] = {CONFIG_SECTOR_A, CONFIG_SECTOR_B};
+    uint8_t found = 0;
+
+    // 1. The valid sector with the highest generation wins
+    memset(&stats, 0, sizeof(stats));
+    generation = 0;
+    for (uint32_t i = 0; i < 2U; i++) {
+        volatile uint32_t* base = CONFIG_sector(sectors[i]);
+        uint32_t gen = base[1];
+        if ((base[0] == CONFIG_MAGIC) && (gen != CONFIG_ERASED) && (!found || (gen > generation))) {
+            active = sectors[i];
+            spare = sectors[i ^ 1U];
+            generation = gen;
+            found = 1;
+        }
+    }
+
+    // 2. First boot: format A (erasing it if it holds anything)
+    if (!found) {
+        active = CONFIG_SECTOR_A;
+        spare = CONFIG_SECTOR_B;
+        if (!CONFIG_is_erased(active)) {
+            CONFIG_erase(active);
+        }
+        volatile uint32_t* base = CONFIG_sector(active);
+        CONFIG_unlock();
+        CONFIG_program(&base[1], 1U);
+        CONFIG_program(&base[0], CONFIG_MAGIC);
+        CONFIG_lock();
+        generation = 1;
+    }
+
+    // 3. Load it; the other one is spare once erased (now, unless the WWDG can't take it)
+    CONFIG_load();
+    spare_dirty = !CONFIG_is_erased(spare);
+    CONFIG_maintain(CONFIG_erase_max_us(spare));
+}
+
+uint8_t CONFIG_get(uint16_t key, void* data, uint8_t max) {
+    ConfigEntry* entry = CONFIG_find(key);
+    if (!entry) {
+        return 0;
+    }
+    memcpy(data, entry->data, (entry->len < max) ? entry->len : max);
+    return entry->len;
+}
+
+ConfigStatus CONFIG_set(uint16_t key, const void* data, uint8_t len) {
+    const uint8_t* bytes = (const uint8_t*)data;
+
+    // 1. Check it, and skip the write if nothing changed
+    if ((len == 0) || (len > CONFIG_MAX_VALUE)) {
+        return CONFIG_ERR_LENGTH;
+    }
+    ConfigEntry* entry = CONFIG_find(key);
+    if (entry && (entry->len == len) && !memcmp(entry->data, bytes, len)) {
+        return CONFIG_OK;
+    }
+    if (!entry && !CONFIG_free_entry()) {
+        return CONFIG_ERR_NO_KEY;
+    }
+
+    // 2. Flash, then the cache
+    ConfigStatus status = CONFIG_append(key, bytes, len);
+    if (status != CONFIG_OK) {
+        return status;
+    }
+    CONFIG_cache(key, bytes, len);
+
+    // 3. EEPROM copy for the keys that have one
+#if CONFIG_EEPROM_MIRROR
+    for (uint32_t i = 0; i < CONFIG_MIRROR_SLOTS; i++) {
+        if (mirrors[i].used && (mirrors[i].key == key) && (mirrors[i].len == len)) {
+            EEPROM_write_record(EEPROM_ADDRESS, mirrors[i].location, bytes, len);
+        }
+    }
+#endif
+    return CONFIG_OK;
+}
+
+ConfigStatus CONFIG_remove(uint16_t key) {
+    if (!CONFIG_find(key)) {
+        return CONFIG_OK;
+    }
+    ConfigStatus status = CONFIG_append(key, NULL, 0);
+    if (status == CONFIG_OK) {
+        CONFIG_cache(key, NULL, 0);
+    }
+    return status;
+}
+
+uint8_t CONFIG_maintain(uint32_t allowed_stall_us) {
+    // WWDG_IRQHandler can't refresh during the stall: it must fit one timeout
+    uint32_t wwdg_us = WWDG_get_timeout_us();
+    if (wwdg_us && (allowed_stall_us > wwdg_us)) {
+        allowed_stall_us = wwdg_us;
+    }
+    if (!spare_dirty || (CONFIG_erase_max_us(spare) > allowed_stall_us)) {
+        return 0;
+    }
+    WWDG_refresh();                             // The whole timeout for the erase
+    spare_dirty = !CONFIG_erase(spare);
+    return 1;
+}
+
+uint8_t CONFIG_mirror(uint16_t key, uint8_t eeprom_location, uint8_t len) {
+#if CONFIG_EEPROM_MIRROR
+    for (uint32_t i = 0; i < CONFIG_MIRROR_SLOTS; i++) {
+        if (mirrors[i].used && (mirrors[i].key != key)) {
+            continue;
+        }
+
+        // 1. Import the EEPROM copy if flash doesn't have the key yet
+        uint8_t value[CONFIG_MAX_VALUE];
+        if (!CONFIG_find(key) && (len > 0) && (len <= CONFIG_MAX_VALUE)
+            && EEPROM_read_record(EEPROM_ADDRESS, eeprom_location, value, len)) {
+            CONFIG_set(key, value, len);
+        }
+
+        // 2. Keep it in step from now on
+        mirrors[i].key = key;
+        mirrors[i].location = eeprom_location;
+        mirrors[i].len = len;
+        mirrors[i].used = 1;
+        return 1;
+    }
+#else
+    (void)key;
+    (void)eeprom_location;
+    (void)len;
+#endif
+    return 0;
+}
+
+void CONFIG_get_stats(ConfigStats* out) {
+    *out = stats;
+    out->used_bytes = write_pos * 4U;
+    out->sector_bytes = sector_sizes[active];
+}
+
+void CONFIG_report(void) {
+    char buffer[128];
+    uint32_t keys = 0;
+    for (uint32_t i = 0; i < CONFIG_MAX_KEYS; i++) {
+        keys += entries[i].used;
+    }
+
+    sprintf(buffer, "CONFIG: %lu keys, sector %u gen %lu, %lu/%lu bytes%s\r\n", (unsigned long)keys,
+            (unsigned)active, (unsigned long)generation, (unsigned long)(write_pos * 4U),
+            (unsigned long)sector_sizes[active], spare_dirty ? ", spare needs erase" : "");
+    USART2_write(buffer);
+    sprintf(buffer, "CONFIG: %lu commits, %lu words, %lu compactions, %lu erases\r\n",
+            (unsigned long)stats.commits, (unsigned long)stats.words, (unsigned long)stats.compactions,
+            (unsigned long)stats.erases);
+    USART2_write(buffer);
+    sprintf(buffer, "CONFIG: worst stall %lu us (budget %lu us), %lu over\r\n",
+            (unsigned long)stats.worst_stall_us, (unsigned long)CONFIG_FLASH_BUDGET_US,
+            (unsigned long)stats.over_budget);
+    USART2_write(buffer);
+}
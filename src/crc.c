@@ -0,0 +1,233 @@
+/*
+* filename: crc.c
+* purpose: implementation of the CRC unit driver and its software fallback
+* author: Connor Ockerse
+* date: 10/19/2026
+*/
+
+#include "crc.h"
+#include "RccConfig.h" // Needed for CLOCK_get_sysclk
+#include "dma.h"
+#include "spinwait.h"
+
+// CRC_wait() budget: a memory-to-memory word is two AHB transfers, well
+// under this, and the fixed part covers the ISRs that run meanwhile
+#define CRC_DMA_CYCLES_PER_WORD 16U
+#define CRC_DMA_SLACK_DIVIDER 1000U     // SYSCLK / 1000 = 1 ms
+
+// CRC of (n << 28) after 4 shifts: one table step handles a nibble
+static const uint32_t crc_nibble[16] = {
+    0x00000000U, 0x04C11DB7U, 0x09823B6EU, 0x0D4326D9U,
+    0x130476DCU, 0x17C56B6BU, 0x1A864DB2U, 0x1E475005U,
+    0x2608EDB8U, 0x22C9F00FU, 0x2F8AD6D6U, 0x2B4BCB61U,
+    0x350C9B64U, 0x31CD86D3U, 0x3C8EA00AU, 0x384FBDBDU,
+};
+
+// The unit holds one running CRC: whoever claimed it (CPU or DMA) owns DR
+static volatile uint8_t crc_claimed = 0;
+
+// DMA feed in flight (on the memory-to-memory stream taken at init)
+static uint8_t crc_dma = DMA_NO_STREAM;
+static volatile uint8_t crc_dma_busy = 0;
+static volatile uint32_t crc_dma_result = CRC_INITIAL;
+static const uint32_t* crc_dma_words;
+static uint32_t crc_dma_count;
+static CrcCallback crc_dma_callback;
+static void* crc_dma_arg;
+
+// Continues crc over one word, MSB first (what a DR write does)
+static uint32_t CRC_step_word(uint32_t crc, uint32_t word) {
+    crc ^= word;
+    for (uint32_t i = 0; i < 8; i++) {
+        crc = (crc << 4) ^ crc_nibble[crc >> 28];
+    }
+    return crc;
+}
+
+// Continues crc over one byte, MSB first (the tail of a byte buffer)
+static uint32_t CRC_step_byte(uint32_t crc, uint8_t byte) {
+    crc ^= (uint32_t)byte << 24;
+    crc = (crc << 4) ^ crc_nibble[crc >> 28];
+    return (crc << 4) ^ crc_nibble[crc >> 28];
+}
+
+// Little-endian word from any address (what LDR gives on an aligned one)
+static uint32_t CRC_load_word(const uint8_t* data) {
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8) |
+           ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+// Takes the unit; 0 if the DMA or an interrupted caller already has it
+static uint8_t CRC_claim(void) {
+#if CRC_HARDWARE
+    uint8_t taken = 0;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (!crc_claimed) {
+        crc_claimed = 1;
+        taken = 1;
+    }
+    __set_PRIMASK(primask);
+    return taken;
+#else
+    return 0;
+#endif
+}
+
+static void CRC_release(void) {
+    crc_claimed = 0;
+}
+
+// DMA interrupt: the feed is done (or failed)
+static void CRC_dma_event(DmaEvent event, void* arg) {
+    (void)arg;
+    if (event == DMA_EVENT_ERROR) {
+        // The stream stopped early, DR is partial
+        crc_dma_result = CRC_words_sw(crc_dma_words, crc_dma_count);
+    } else {
+        crc_dma_result = CRC->DR;
+    }
+
+    crc_dma_busy = 0;
+    CRC_release();
+    if (crc_dma_callback) {
+        crc_dma_callback(crc_dma_result, crc_dma_arg);
+    }
+}
+
+// CRC_wait() timed out: take the feed back and finish it in software
+static void CRC_abort_dma(void) {
+    uint8_t aborted = 0;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (crc_dma_busy) {
+        // 1. Stop the stream and drop its flags, so its interrupt can't follow
+        DMA_stop(crc_dma);
+        crc_dma_result = CRC_words_sw(crc_dma_words, crc_dma_count);
+        crc_dma_busy = 0;
+        CRC_release();
+        aborted = 1;
+    }
+    __set_PRIMASK(primask);
+
+    // 2. The callback still gets its one result (thread context this time)
+    if (aborted && crc_dma_callback) {
+        crc_dma_callback(crc_dma_result, crc_dma_arg);
+    }
+}
+
+// === PUBLIC FUNCTIONS ===
+
+void CRC_INIT(void) {
+    // 1. CRC clock comes from BOARD_INIT
+    CRC->CR = (1 << 0);                 // RESET: DR = 0xFFFFFFFF
+
+    // 2. A DMA2 stream for the feed (without one, CRC_start_dma() computes in software)
+    if (crc_dma == DMA_NO_STREAM) {
+        crc_dma = DMA_alloc(DMA_REQ_MEM_TO_MEM, "crc");
+    }
+}
+
+uint32_t CRC_words_sw(const uint32_t* words, uint32_t count) {
+    uint32_t crc = CRC_INITIAL;
+    for (uint32_t i = 0; i < count; i++) {
+        crc = CRC_step_word(crc, words[i]);
+    }
+    return crc;
+}
+
+uint32_t CRC_bytes_sw(const uint8_t* data, uint32_t len) {
+    uint32_t crc = CRC_INITIAL;
+    uint32_t i = 0;
+    for (; i + 4U <= len; i += 4U) {
+        crc = CRC_step_word(crc, CRC_load_word(&data[i]));
+    }
+    for (; i < len; i++) {
+        crc = CRC_step_byte(crc, data[i]);
+    }
+    return crc;
+}
+
+uint32_t CRC_words(const uint32_t* words, uint32_t count) {
+    if (!CRC_claim()) {
+        return CRC_words_sw(words, count);
+    }
+    CRC->CR = (1 << 0);                 // RESET
+    for (uint32_t i = 0; i < count; i++) {
+        CRC->DR = words[i];
+    }
+    uint32_t crc = CRC->DR;
+    CRC_release();
+    return crc;
+}
+
+uint32_t CRC_bytes(const uint8_t* data, uint32_t len) {
+    if (!CRC_claim()) {
+        return CRC_bytes_sw(data, len);
+    }
+
+    // 1. Whole words through the unit (straight loads when aligned)
+    uint32_t words = len / 4U;
+    CRC->CR = (1 << 0);                 // RESET
+    if (((uintptr_t)data & 3U) == 0) {
+        const uint32_t* aligned = (const uint32_t*)(const void*)data;
+        for (uint32_t i = 0; i < words; i++) {
+            CRC->DR = aligned[i];
+        }
+    } else {
+        for (uint32_t i = 0; i < words; i++) {
+            CRC->DR = CRC_load_word(&data[i * 4U]);
+        }
+    }
+    uint32_t crc = CRC->DR;
+    CRC_release();
+
+    // 2. The unit only takes words: 1-3 leftover bytes in software
+    for (uint32_t i = words * 4U; i < len; i++) {
+        crc = CRC_step_byte(crc, data[i]);
+    }
+    return crc;
+}
+
+uint8_t CRC_start_dma(const uint32_t* words, uint32_t count, CrcCallback callback, void* arg) {
+    if ((count == 0) || (count > CRC_DMA_MAX_WORDS) || (crc_dma == DMA_NO_STREAM) || !CRC_claim()) {
+        crc_dma_result = CRC_words_sw(words, count);
+        if (callback) {
+            callback(crc_dma_result, arg);
+        }
+        return 0;
+    }
+
+    // 1. Remember the job (the software fallback on a transfer error needs it)
+    crc_dma_words = words;
+    crc_dma_count = count;
+    crc_dma_callback = callback;
+    crc_dma_arg = arg;
+    crc_dma_busy = 1;
+    SPIN_set_timeout(SPIN_CRC_DMA, (count * CRC_DMA_CYCLES_PER_WORD) +
+                                   (CLOCK_get_sysclk() / CRC_DMA_SLACK_DIVIDER));
+    CRC->CR = (1 << 0);                 // RESET
+
+    // 2. Words from memory (PAR side) into the fixed DR address (M0AR side)
+    DmaConfig dma;
+    DMA_config_init(&dma, DMA_DIR_MEM_TO_MEM);
+    dma.peripheral = (uint32_t)(uintptr_t)words;
+    dma.memory0 = (const void*)&CRC->DR;
+    dma.count = (uint16_t)count;
+    dma.periph_size = 4;
+    dma.memory_size = 4;
+    dma.memory_increment = 0;
+    dma.callback = CRC_dma_event;
+    DMA_start(crc_dma, &dma);
+    return 1;
+}
+
+uint8_t CRC_is_busy(void) {
+    return crc_dma_busy;
+}
+
+uint32_t CRC_wait(void) {
+    // Polled, not WFI: a stream that never finishes raises no interrupt
+    SPIN_WHILE_OR(SPIN_CRC_DMA, crc_dma_busy, CRC_abort_dma());
+    return crc_dma_result;
+}
@@ -0,0 +1,415 @@
+/*
+* filename: datalog.c
+* purpose: implementation of the compressed EEPROM sensor log
+* author: Connor Ockerse
+* date: 10/19/2026
+*/
+
+#include "datalog.h"
+#include <stdio.h>
+#include <string.h> // For memset, memcpy
+#include "usart.h"
+
+// Page layout
+#define DATALOG_HEADER_BYTES 2U
+#define DATALOG_PAYLOAD_BYTES (EEPROM_PAGE_BYTES - DATALOG_HEADER_BYTES)
+#define DATALOG_KEYFRAME_FLAG 0x80U
+#define DATALOG_LENGTH_MASK 0x1FU
+
+// Sample header bits
+#define DATALOG_TIME_FLAG 0x80U
+#define DATALOG_SONAR_FLAG 0x40U
+#define DATALOG_ENCODER_FLAG 0x20U
+#define DATALOG_LIGHT_MASK 0x1FU
+#define DATALOG_LIGHT_ESCAPE 0x10U          // -16: varint follows
+
+// Largest time step a delta sample carries (3-byte varint)
+#define DATALOG_MAX_STEP ((1UL << 21) - 1U)
+
+// Pages read per sequential read while scanning
+#define DATALOG_READ_PAGES 4U
+
+// Encoder and decoder state: the last sample and its time step
+typedef struct {
+    DatalogSample last;
+    uint32_t step;
+}DatalogState;
+
+// Page being filled (written out when full or flushed)
+static uint8_t page[EEPROM_PAGE_BYTES];
+static uint8_t page_slot = 0;           // Slot it goes to (the next one while closed)
+static uint8_t page_open = 0;
+static uint8_t page_dirty = 0;
+static uint8_t next_seq = 0;
+static uint8_t pages_since_key = 0;
+static uint8_t need_key = 1;
+static DatalogState writer;
+static DatalogStats stats;
+
+// === VARINTS ===
+
+// 7 bits per byte, low first, bit 7 = more follows
+static uint32_t DATALOG_put_varint(uint8_t* out, uint32_t value) {
+    uint32_t n = 0;
+    while (value >= 0x80U) {
+        out[n++] = (uint8_t)(value | 0x80U);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+// 0 if the varint runs past end
+static uint32_t DATALOG_get_varint(const uint8_t* in, uint32_t end, uint32_t* pos, uint32_t* value) {
+    uint32_t result = 0;
+    for (uint32_t shift = 0; (*pos < end) && (shift < 35U); shift += 7U) {
+        uint8_t byte = in[(*pos)++];
+        result |= (uint32_t)(byte & 0x7FU) << shift;
+        if (!(byte & 0x80U)) {
+            *value = result;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Signed 16-bit change (mod 2^16) as an unsigned: 0, -1, 1, -2, ...
+static uint32_t DATALOG_zigzag(uint16_t from, uint16_t to) {
+    int16_t delta = (int16_t)(uint16_t)(to - from);
+    return (uint16_t)(((uint16_t)delta << 1) ^ (uint16_t)(delta >> 15));
+}
+
+static uint16_t DATALOG_unzigzag(uint16_t from, uint32_t zz) {
+    uint16_t delta = (uint16_t)((zz >> 1) ^ (0U - (zz & 1U)));
+    return (uint16_t)(from + delta);
+}
+
+// === ENCODING ===
+
+static uint32_t DATALOG_encode_key(uint8_t* out, const DatalogSample* s) {
+    uint32_t n = DATALOG_put_varint(out, s->time_s);
+    n += DATALOG_put_varint(&out[n], s->sonar_cm);
+    n += DATALOG_put_varint(&out[n], s->light);
+    n += DATALOG_put_varint(&out[n], s->encoder);
+    return n;
+}
+
+// At most 1 + 3 * 4 bytes (the time step is limited to 21 bits)
+static uint32_t DATALOG_encode_delta(uint8_t* out, const DatalogState* state, const DatalogSample* s) {
+    uint32_t step = s->time_s - state->last.time_s;
+    int16_t light = (int16_t)(uint16_t)(s->light - state->last.light);
+    uint8_t header = 0;
+    uint32_t n = 1;
+
+    if (step != state->step) {
+        header |= DATALOG_TIME_FLAG;
+        n += DATALOG_put_varint(&out[n], step);
+    }
+    if (s->sonar_cm != state->last.sonar_cm) {
+        header |= DATALOG_SONAR_FLAG;
+        n += DATALOG_put_varint(&out[n], DATALOG_zigzag(state->last.sonar_cm, s->sonar_cm));
+    }
+    if (s->encoder != state->last.encoder) {
+        header |= DATALOG_ENCODER_FLAG;
+        n += DATALOG_put_varint(&out[n], DATALOG_zigzag(state->last.encoder, s->encoder));
+    }
+    if ((light >= -15) && (light <= 15)) {
+        header |= (uint8_t)light & DATALOG_LIGHT_MASK;
+    } else {
+        header |= DATALOG_LIGHT_ESCAPE;
+        n += DATALOG_put_varint(&out[n], DATALOG_zigzag(state->last.light, s->light));
+    }
+    out[0] = header;
+    return n;
+}
+
+// === DECODING ===
+
+// Decodes one page into state, calling visitor per sample; returns samples
+static uint32_t DATALOG_decode_page(const uint8_t* p, DatalogState* state, DatalogVisitor visitor, void* arg) {
+    uint32_t end = DATALOG_HEADER_BYTES + (p[1] & DATALOG_LENGTH_MASK);
+    uint32_t pos = DATALOG_HEADER_BYTES;
+    uint32_t count = 0;
+    uint32_t value;
+
+    // 1. Keyframe: absolute sample, no step yet
+    if (p[1] & DATALOG_KEYFRAME_FLAG) {
+        DatalogSample key;
+        if (!DATALOG_get_varint(p, end, &pos, &value)) return 0;
+        key.time_s = value;
+        if (!DATALOG_get_varint(p, end, &pos, &value)) return 0;
+        key.sonar_cm = (uint16_t)value;
+        if (!DATALOG_get_varint(p, end, &pos, &value)) return 0;
+        key.light = (uint16_t)value;
+        if (!DATALOG_get_varint(p, end, &pos, &value)) return 0;
+        key.encoder = (uint16_t)value;
+        state->last = key;
+        state->step = 0;
+        visitor(&key, arg);
+        count++;
+    }
+
+    // 2. Delta samples
+    while (pos < end) {
+        uint8_t header = p[pos++];
+        DatalogSample s = state->last;
+
+        if (header & DATALOG_TIME_FLAG) {
+            if (!DATALOG_get_varint(p, end, &pos, &state->step)) break;
+        }
+        s.time_s += state->step;
+        if (header & DATALOG_SONAR_FLAG) {
+            if (!DATALOG_get_varint(p, end, &pos, &value)) break;
+            s.sonar_cm = DATALOG_unzigzag(s.sonar_cm, value);
+        }
+        if (header & DATALOG_ENCODER_FLAG) {
+            if (!DATALOG_get_varint(p, end, &pos, &value)) break;
+            s.encoder = DATALOG_unzigzag(s.encoder, value);
+        }
+        uint8_t light = header & DATALOG_LIGHT_MASK;
+        if (light == DATALOG_LIGHT_ESCAPE) {
+            if (!DATALOG_get_varint(p, end, &pos, &value)) break;
+            s.light = DATALOG_unzigzag(s.light, value);
+        } else {
+            s.light = (uint16_t)(s.light + ((light & 0x10U) ? (int32_t)light - 32 : (int32_t)light));
+        }
+        state->last = s;
+        visitor(&s, arg);
+        count++;
+    }
+    return count;
+}
+
+// === EEPROM PAGES ===
+
+static uint8_t DATALOG_page_valid(const uint8_t* p) {
+    uint8_t len = p[1] & DATALOG_LENGTH_MASK;
+    return ((len != 0) && (len <= DATALOG_PAYLOAD_BYTES) && !(p[1] & 0x60U)) ? 1 : 0;
+}
+
+static uint8_t DATALOG_address(uint32_t slot) {
+    return (uint8_t)((DATALOG_FIRST_PAGE + slot) * EEPROM_PAGE_BYTES);
+}
+
+// Calls fn for count pages from slot on (ring order), DATALOG_READ_PAGES per read
+static void DATALOG_walk(uint32_t slot, uint32_t count, void (*fn)(const uint8_t* p, uint32_t slot, void* arg), void* arg) {
+    uint8_t buffer[DATALOG_READ_PAGES * EEPROM_PAGE_BYTES];
+
+    while (count) {
+        // 1. As many pages as fit, without running past the end of the region
+        uint32_t run = DATALOG_NUM_PAGES - slot;
+        run = (run < count) ? run : count;
+        run = (run < DATALOG_READ_PAGES) ? run : DATALOG_READ_PAGES;
+        EEPROM_read_sequential(EEPROM_ADDRESS, DATALOG_address(slot), buffer, (uint16_t)(run * EEPROM_PAGE_BYTES));
+
+        // 2. Hand them out
+        for (uint32_t i = 0; i < run; i++) {
+            fn(&buffer[i * EEPROM_PAGE_BYTES], slot + i, arg);
+        }
+        slot = (slot + run) % DATALOG_NUM_PAGES;
+        count -= run;
+    }
+}
+
+static void DATALOG_write_page(void) {
+    page[0] = next_seq;
+    if (!EEPROM_write_page(EEPROM_ADDRESS, DATALOG_address(page_slot), page, EEPROM_PAGE_BYTES)) {
+        stats.write_errors++;           // Still dirty: a flush of the open page tries again
+        return;
+    }
+    stats.page_writes++;
+    page_dirty = 0;
+}
+
+// Writes the open page and moves to the next slot
+static void DATALOG_close_page(void) {
+    if (page_dirty) {
+        DATALOG_write_page();
+    }
+    page_open = 0;
+    page_slot = (uint8_t)((page_slot + 1U) % DATALOG_NUM_PAGES);
+    next_seq++;
+    pages_since_key++;
+}
+
+static void DATALOG_open_page(uint8_t keyframe) {
+    memset(page, 0xFF, sizeof(page));
+    page[1] = keyframe ? DATALOG_KEYFRAME_FLAG : 0U;
+    page_open = 1;
+    if (keyframe) {
+        pages_since_key = 0;
+        need_key = 0;
+    }
+}
+
+// Newest valid page: the one the next slot doesn't continue
+typedef struct {
+    uint8_t seq[DATALOG_NUM_PAGES];
+    uint8_t valid[DATALOG_NUM_PAGES];
+}DatalogScan;
+
+static void DATALOG_scan_page(const uint8_t* p, uint32_t slot, void* arg) {
+    DatalogScan* scan = (DatalogScan*)arg;
+    scan->seq[slot] = p[0];
+    scan->valid[slot] = DATALOG_page_valid(p);
+}
+
+// Dump walk: decodes pages that follow a keyframe without a gap
+typedef struct {
+    DatalogState state;
+    uint8_t have_state;
+    uint8_t last_seq;
+    DatalogVisitor visitor;
+    void* arg;
+    uint32_t count;
+}DatalogReader;
+
+static void DATALOG_read_page(const uint8_t* p, uint32_t slot, void* arg) {
+    DatalogReader* reader = (DatalogReader*)arg;
+    (void)slot;
+
+    if (!DATALOG_page_valid(p)) {
+        reader->have_state = 0;
+        return;
+    }
+    if (!(p[1] & DATALOG_KEYFRAME_FLAG) &&
+        (!reader->have_state || (p[0] != (uint8_t)(reader->last_seq + 1U)))) {
+        reader->have_state = 0;         // Its keyframe is gone
+        return;
+    }
+    reader->count += DATALOG_decode_page(p, &reader->state, reader->visitor, reader->arg);
+    reader->have_state = 1;
+    reader->last_seq = p[0];
+}
+
+// === PUBLIC FUNCTIONS ===
+
+void DATALOG_INIT(void) {
+    DatalogScan scan;
+
+    // 1. Sequence numbers of every page
+    DATALOG_walk(0, DATALOG_NUM_PAGES, DATALOG_scan_page, &scan);
+
+    // 2. Append after the newest page (slot 0 if the region is empty)
+    page_slot = 0;
+    next_seq = 0;
+    for (uint32_t s = 0; s < DATALOG_NUM_PAGES; s++) {
+        uint32_t next = (s + 1U) % DATALOG_NUM_PAGES;
+        if (scan.valid[s] && !(scan.valid[next] && (scan.seq[next] == (uint8_t)(scan.seq[s] + 1U)))) {
+            page_slot = (uint8_t)next;
+            next_seq = (uint8_t)(scan.seq[s] + 1U);
+            break;
+        }
+    }
+
+    // 3. Nothing to continue from: start with a keyframe
+    page_open = 0;
+    page_dirty = 0;
+    need_key = 1;
+    memset(&stats, 0, sizeof(stats));
+}
+
+void DATALOG_append(const DatalogSample* sample) {
+    uint8_t encoded[DATALOG_PAYLOAD_BYTES];
+    uint32_t n = 0;
+    uint32_t step = sample->time_s - writer.last.time_s;
+
+    // 1. Time went backwards or jumped: delta samples can't carry it
+    if (step > DATALOG_MAX_STEP) {
+        need_key = 1;
+    }
+
+    // 2. Into the open page if it fits
+    uint8_t as_key = 0;
+    if (page_open && !need_key) {
+        n = DATALOG_encode_delta(encoded, &writer, sample);
+        if ((page[1] & DATALOG_LENGTH_MASK) + n > DATALOG_PAYLOAD_BYTES) {
+            n = 0;
+        }
+    }
+
+    // 3. Otherwise the page is done: write it, start the next
+    if (n == 0) {
+        if (page_open) {
+            DATALOG_close_page();
+        }
+        as_key = (need_key || (pages_since_key >= DATALOG_KEYFRAME_PAGES)) ? 1 : 0;
+        DATALOG_open_page(as_key);
+        n = as_key ? DATALOG_encode_key(encoded, sample) : DATALOG_encode_delta(encoded, &writer, sample);
+    }
+
+    // 4. Append and remember what the next delta is against
+    uint8_t len = page[1] & DATALOG_LENGTH_MASK;
+    memcpy(&page[DATALOG_HEADER_BYTES + len], encoded, n);
+    page[1] = (uint8_t)((page[1] & DATALOG_KEYFRAME_FLAG) | (len + n));
+    page_dirty = 1;
+    writer.step = as_key ? 0U : step;
+    writer.last = *sample;
+    stats.samples++;
+    stats.bytes += n;
+}
+
+void DATALOG_flush(void) {
+    if (page_open && page_dirty) {
+        DATALOG_write_page();
+    }
+}
+
+uint32_t DATALOG_dump(DatalogVisitor visitor, void* arg) {
+    DatalogReader reader;
+    reader.have_state = 0;
+    reader.last_seq = 0;
+    reader.visitor = visitor;
+    reader.arg = arg;
+    reader.count = 0;
+
+    // 1. Oldest first: the slot after the open page (its EEPROM copy is stale)
+    if (page_open) {
+        DATALOG_walk((page_slot + 1U) % DATALOG_NUM_PAGES, DATALOG_NUM_PAGES - 1U, DATALOG_read_page, &reader);
+
+        // 2. Then the open page from RAM
+        page[0] = next_seq;
+        DATALOG_read_page(page, page_slot, &reader);
+    } else {
+        DATALOG_walk(page_slot, DATALOG_NUM_PAGES, DATALOG_read_page, &reader);
+    }
+    return reader.count;
+}
+
+void DATALOG_clear(void) {
+    uint8_t empty[EEPROM_PAGE_BYTES];
+    memset(empty, 0, sizeof(empty));
+    for (uint32_t s = 0; s < DATALOG_NUM_PAGES; s++) {
+        EEPROM_write_page(EEPROM_ADDRESS, DATALOG_address(s), empty, EEPROM_PAGE_BYTES);
+    }
+    page_slot = 0;
+    next_seq = 0;
+    page_open = 0;
+    page_dirty = 0;
+    need_key = 1;
+}
+
+void DATALOG_get_stats(DatalogStats* out) {
+    *out = stats;
+}
+
+static void DATALOG_count(const DatalogSample* sample, void* arg) {
+    (void)sample;
+    (*(uint32_t*)arg)++;
+}
+
+void DATALOG_report(void) {
+    char buffer[128];
+    uint32_t held = 0;
+    DATALOG_dump(DATALOG_count, &held);
+
+    // Bytes per sample over the whole region, in hundredths
+    uint32_t region = DATALOG_NUM_PAGES * EEPROM_PAGE_BYTES;
+    uint32_t per_100 = held ? (region * 100U) / held : 0;
+    uint32_t gain_10 = per_100 ? (DATALOG_RAW_BYTES * 1000U) / per_100 : 0;
+    sprintf(buffer, "datalog: %lu samples in %lu bytes (%lu.%02lu B each, %lu.%lux plain), %lu page writes, %lu failed\r\n",
+            (unsigned long)held, (unsigned long)region, (unsigned long)(per_100 / 100U),
+            (unsigned long)(per_100 % 100U), (unsigned long)(gain_10 / 10U), (unsigned long)(gain_10 % 10U),
+            (unsigned long)stats.page_writes, (unsigned long)stats.write_errors);
+    USART2_write(buffer);
+}
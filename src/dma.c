@@ -0,0 +1,353 @@
+/*
+* filename: dma.c
+* purpose: implementation of the DMA stream allocator and its interrupts
+* author: Connor Ockerse
+* date: 10/19/2026
+*/
+
+#include "dma.h"
+#include <stdio.h>
+#include "spinwait.h"
+#include "profile.h"
+#include "usart.h"
+
+#define DMA1_S(n) (n)
+#define DMA2_S(n) (8U + (n))
+
+// One stream/channel a request is wired to
+typedef struct {
+    uint8_t request;
+    uint8_t stream;         // Handle (DMA1_S / DMA2_S)
+    uint8_t channel;        // CHSEL
+}DmaRoute;
+
+// RM0390 tables 28/29, tried in this order
+static const DmaRoute dma_routes[] = {
+    // Memory-to-memory: streams no request below needs come first
+    { DMA_REQ_MEM_TO_MEM, DMA2_S(7), 0 },
+    { DMA_REQ_MEM_TO_MEM, DMA2_S(6), 0 },
+    { DMA_REQ_MEM_TO_MEM, DMA2_S(2), 0 },
+    { DMA_REQ_MEM_TO_MEM, DMA2_S(3), 0 },
+    { DMA_REQ_MEM_TO_MEM, DMA2_S(1), 0 },
+    { DMA_REQ_MEM_TO_MEM, DMA2_S(0), 0 },
+    { DMA_REQ_MEM_TO_MEM, DMA2_S(4), 0 },
+    { DMA_REQ_MEM_TO_MEM, DMA2_S(5), 0 },
+    { DMA_REQ_ADC1,       DMA2_S(0), 0 },
+    { DMA_REQ_ADC1,       DMA2_S(4), 0 },
+    { DMA_REQ_I2C1_RX,    DMA1_S(0), 1 },
+    { DMA_REQ_I2C1_RX,    DMA1_S(5), 1 },
+    { DMA_REQ_I2C1_TX,    DMA1_S(6), 1 },
+    { DMA_REQ_I2C1_TX,    DMA1_S(7), 1 },
+    { DMA_REQ_USART2_RX,  DMA1_S(5), 4 },
+    { DMA_REQ_USART2_TX,  DMA1_S(6), 4 },
+    { DMA_REQ_TIM1_UP,    DMA2_S(5), 6 },
+    { DMA_REQ_TIM1_CH1,   DMA2_S(1), 6 },
+    { DMA_REQ_TIM1_CH1,   DMA2_S(3), 6 },
+    { DMA_REQ_TIM3_UP,    DMA1_S(2), 5 },
+    { DMA_REQ_TIM3_CH1,   DMA1_S(4), 5 },
+    { DMA_REQ_TIM3_CH2,   DMA1_S(5), 5 },
+    { DMA_REQ_TIM4_CH1,   DMA1_S(0), 2 },
+};
+
+#define DMA_NUM_ROUTES (sizeof(dma_routes) / sizeof(dma_routes[0]))
+
+static const char* const dma_request_names[DMA_NUM_REQUESTS] = {
+    "mem2mem", "ADC1", "I2C1_RX", "I2C1_TX", "USART2_RX", "USART2_TX",
+    "TIM1_UP", "TIM1_CH1", "TIM3_UP", "TIM3_CH1", "TIM3_CH2", "TIM4_CH1"
+};
+
+static DMA_Stream_TypeDef* const dma_streams[DMA_NUM_STREAMS] = {
+    DMA1_Stream0, DMA1_Stream1, DMA1_Stream2, DMA1_Stream3,
+    DMA1_Stream4, DMA1_Stream5, DMA1_Stream6, DMA1_Stream7,
+    DMA2_Stream0, DMA2_Stream1, DMA2_Stream2, DMA2_Stream3,
+    DMA2_Stream4, DMA2_Stream5, DMA2_Stream6, DMA2_Stream7
+};
+
+static const IRQn_Type dma_irqs[DMA_NUM_STREAMS] = {
+    DMA1_Stream0_IRQn, DMA1_Stream1_IRQn, DMA1_Stream2_IRQn, DMA1_Stream3_IRQn,
+    DMA1_Stream4_IRQn, DMA1_Stream5_IRQn, DMA1_Stream6_IRQn, DMA1_Stream7_IRQn,
+    DMA2_Stream0_IRQn, DMA2_Stream1_IRQn, DMA2_Stream2_IRQn, DMA2_Stream3_IRQn,
+    DMA2_Stream4_IRQn, DMA2_Stream5_IRQn, DMA2_Stream6_IRQn, DMA2_Stream7_IRQn
+};
+
+// Flag position of a stream inside LISR/HISR (same for every controller)
+static const uint8_t dma_flag_shift[4] = { 0, 6, 16, 22 };
+
+// Owner and transfer in progress of each stream
+typedef struct {
+    const char* owner;          // 0 = free
+    uint8_t request;
+    uint8_t channel;
+    DmaMode mode;
+    uint16_t count;
+    uint8_t periph_size;
+    DmaCallback callback;
+    void* arg;
+    DmaStats stats;
+}DmaSlot;
+
+static DmaSlot dma_slots[DMA_NUM_STREAMS];
+static uint32_t dma_conflicts[DMA_NUM_REQUESTS];
+
+// Controller of a handle
+static DMA_TypeDef* DMA_controller(uint8_t handle) {
+    return (handle < 8U) ? DMA1 : DMA2;
+}
+
+// TCIF/HTIF/TEIF/DMEIF/FEIF of a stream, shifted down to stream 0's position
+static uint32_t DMA_read_flags(uint8_t handle) {
+    DMA_TypeDef* dma = DMA_controller(handle);
+    uint32_t stream = handle & 7U;
+    uint32_t isr = (stream < 4U) ? dma->LISR : dma->HISR;
+    return (isr >> dma_flag_shift[stream & 3U]) & 0x3DU;
+}
+
+static void DMA_clear_flags(uint8_t handle, uint32_t flags) {
+    DMA_TypeDef* dma = DMA_controller(handle);
+    uint32_t stream = handle & 7U;
+    if (stream < 4U) {
+        dma->LIFCR = flags << dma_flag_shift[stream & 3U];
+    } else {
+        dma->HIFCR = flags << dma_flag_shift[stream & 3U];
+    }
+}
+
+// PSIZE/MSIZE field for 1, 2 or 4 bytes (0xFF otherwise)
+static uint32_t DMA_size_code(uint8_t bytes) {
+    return (bytes == 1U) ? 0U : (bytes == 2U) ? 1U : (bytes == 4U) ? 2U : 0xFFU;
+}
+
+// Stream interrupt: counters first, then the owner's callback
+static void DMA_irq(uint8_t handle) {
+    DmaSlot* slot = &dma_slots[handle];
+    uint32_t flags = DMA_read_flags(handle);
+    DMA_clear_flags(handle, flags);
+
+    if (flags & (1 << 0)) {
+        slot->stats.fifo_errors++;
+    }
+    if (flags & ((1 << 3) | (1 << 2))) {
+        // TEIF / DMEIF: the hardware has cleared EN
+        if (flags & (1 << 3)) {
+            slot->stats.errors++;
+        } else {
+            slot->stats.direct_errors++;
+        }
+        uint32_t moved = (uint32_t)slot->count - DMA_remaining(handle);
+        slot->stats.bytes += (uint64_t)moved * slot->periph_size;
+        if (slot->callback) {
+            slot->callback(DMA_EVENT_ERROR, slot->arg);
+        }
+        return;
+    }
+    // HTIF is set whether or not HTIE is: only report it when asked for
+    if ((flags & (1 << 4)) && (dma_streams[handle]->CR & (1 << 3)) && slot->callback) {
+        slot->callback(DMA_EVENT_HALF, slot->arg);
+    }
+    if (flags & (1 << 5)) {
+        slot->stats.buffers++;
+        slot->stats.bytes += (uint64_t)slot->count * slot->periph_size;
+        if (slot->callback) {
+            slot->callback(DMA_EVENT_DONE, slot->arg);
+        }
+    }
+}
+
+// === PUBLIC FUNCTIONS ===
+
+void DMA_config_init(DmaConfig* cfg, DmaDirection direction) {
+    cfg->peripheral = 0;
+    cfg->memory0 = 0;
+    cfg->memory1 = 0;
+    cfg->count = 0;
+    cfg->periph_size = 1;
+    cfg->memory_size = 1;
+    cfg->periph_increment = (direction == DMA_DIR_MEM_TO_MEM) ? 1U : 0U;
+    cfg->memory_increment = 1;
+    cfg->priority = 0;
+    cfg->direction = direction;
+    cfg->mode = DMA_MODE_SINGLE;
+    cfg->callback = 0;
+    cfg->arg = 0;
+    cfg->half_event = 0;
+}
+
+uint8_t DMA_alloc(DmaRequest request, const char* owner) {
+    uint8_t handle = DMA_NO_STREAM;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    for (uint32_t i = 0; i < DMA_NUM_ROUTES; i++) {
+        const DmaRoute* route = &dma_routes[i];
+        if ((route->request == request) && (dma_slots[route->stream].owner == 0)) {
+            DmaSlot* slot = &dma_slots[route->stream];
+            slot->owner = owner ? owner : "?";
+            slot->request = (uint8_t)request;
+            slot->channel = route->channel;
+            slot->callback = 0;
+            slot->stats.bytes = 0;
+            slot->stats.buffers = 0;
+            slot->stats.errors = 0;
+            slot->stats.direct_errors = 0;
+            slot->stats.fifo_errors = 0;
+            handle = route->stream;
+            break;
+        }
+    }
+    if ((handle == DMA_NO_STREAM) && (request < DMA_NUM_REQUESTS)) {
+        dma_conflicts[request]++;
+    }
+
+    __set_PRIMASK(primask);
+    return handle;
+}
+
+void DMA_free(uint8_t handle) {
+    if (handle >= DMA_NUM_STREAMS) {
+        return;
+    }
+    DMA_stop(handle);
+    NVIC_DisableIRQ(dma_irqs[handle]);
+    dma_slots[handle].callback = 0;
+    dma_slots[handle].owner = 0;
+}
+
+uint8_t DMA_start(uint8_t handle, const DmaConfig* cfg) {
+    if ((handle >= DMA_NUM_STREAMS) || (dma_slots[handle].owner == 0) || (cfg->count == 0)) {
+        return 0;
+    }
+    uint32_t psize = DMA_size_code(cfg->periph_size);
+    uint32_t msize = DMA_size_code(cfg->memory_size);
+    if ((psize == 0xFFU) || (msize == 0xFFU) ||
+        ((cfg->mode == DMA_MODE_DOUBLE) && (cfg->memory1 == 0)) ||
+        ((cfg->direction == DMA_DIR_MEM_TO_MEM) && ((cfg->mode != DMA_MODE_SINGLE) || (handle < 8U)))) {
+        return 0;   // Bad size, no second buffer, or M2M circular / on DMA1
+    }
+    DmaSlot* slot = &dma_slots[handle];
+    DMA_Stream_TypeDef* stream = dma_streams[handle];
+
+    // 1. Stop whatever ran before and drop its flags
+    DMA_stop(handle);
+    slot->mode = cfg->mode;
+    slot->count = cfg->count;
+    slot->periph_size = cfg->periph_size;
+    slot->callback = cfg->callback;
+    slot->arg = cfg->arg;
+
+    // 2. Addresses and count
+    stream->PAR  = cfg->peripheral;
+    stream->M0AR = (uint32_t)(uintptr_t)cfg->memory0;
+    stream->M1AR = (uint32_t)(uintptr_t)cfg->memory1;
+    stream->NDTR = cfg->count;
+
+    // 3. Direct mode needs equal sizes and a peripheral; else FIFO at 1/2
+    uint8_t fifo = (cfg->direction == DMA_DIR_MEM_TO_MEM) || (psize != msize);
+    stream->FCR = fifo ? ((1 << 2) | (1 << 0)) : 0;    // DMDIS, FTH = 1/2
+
+    // 4. Control: channel, mode, sizes, direction, interrupts
+    uint32_t cr = ((uint32_t)slot->channel << 25)
+                | ((uint32_t)(cfg->priority & 3U) << 16)
+                | (msize << 13)
+                | (psize << 11)
+                | ((cfg->memory_increment ? 1U : 0U) << 10)
+                | ((cfg->periph_increment ? 1U : 0U) << 9)
+                | ((uint32_t)cfg->direction << 6);
+    if (cfg->mode == DMA_MODE_DOUBLE) {
+        cr |= (1 << 18) | (1 << 8);     // DBM (needs CIRC)
+    } else if (cfg->mode == DMA_MODE_CIRCULAR) {
+        cr |= (1 << 8);                 // CIRC
+    }
+    if (cfg->callback) {
+        cr |= (1 << 4) | (1 << 2);      // TCIE, TEIE
+        cr |= fifo ? 0U : (1U << 1);    // DMEIE (direct mode only)
+        cr |= cfg->half_event ? (1U << 3) : 0U;  // HTIE
+        NVIC_EnableIRQ(dma_irqs[handle]);
+    }
+    stream->CR = cr;
+
+    // 5. Go: the peripheral's DMA requests (or M2M right away) move data
+    stream->CR |= (1 << 0);             // EN
+    return 1;
+}
+
+void DMA_stop(uint8_t handle) {
+    if (handle >= DMA_NUM_STREAMS) {
+        return;
+    }
+    DMA_Stream_TypeDef* stream = dma_streams[handle];
+    stream->CR &= ~(1U << 0);           // EN off (finishes the current beat)
+    SPIN_WHILE(SPIN_DMA_DISABLE, stream->CR & (1 << 0));
+    DMA_clear_flags(handle, 0x3D);
+}
+
+uint8_t DMA_is_busy(uint8_t handle) {
+    return (handle < DMA_NUM_STREAMS) && (dma_streams[handle]->CR & (1 << 0)) ? 1 : 0;
+}
+
+uint16_t DMA_remaining(uint8_t handle) {
+    return (handle < DMA_NUM_STREAMS) ? (uint16_t)dma_streams[handle]->NDTR : 0;
+}
+
+uint8_t DMA_current_buffer(uint8_t handle) {
+    return (handle < DMA_NUM_STREAMS) && (dma_streams[handle]->CR & (1 << 19)) ? 1 : 0;
+}
+
+void DMA_set_buffer(uint8_t handle, uint8_t which, const void* memory) {
+    if (handle >= DMA_NUM_STREAMS) {
+        return;
+    }
+    if (which) {
+        dma_streams[handle]->M1AR = (uint32_t)(uintptr_t)memory;
+    } else {
+        dma_streams[handle]->M0AR = (uint32_t)(uintptr_t)memory;
+    }
+}
+
+void DMA_get_stats(uint8_t handle, DmaStats* stats) {
+    if (handle < DMA_NUM_STREAMS) {
+        *stats = dma_slots[handle].stats;
+    }
+}
+
+void DMA_report(void) {
+    char buffer[96];
+
+    USART2_write((char*)"--- dma ---\r\n");
+    for (uint32_t i = 0; i < DMA_NUM_STREAMS; i++) {
+        const DmaSlot* slot = &dma_slots[i];
+        if (slot->owner == 0) {
+            continue;
+        }
+        sprintf(buffer, "DMA%lu S%lu ch%u %-9s %-8.8s %llu B, %lu buffers, %lu errors\r\n",
+                (unsigned long)(i / 8U + 1U), (unsigned long)(i % 8U), slot->channel,
+                dma_request_names[slot->request], slot->owner,
+                (unsigned long long)slot->stats.bytes, (unsigned long)slot->stats.buffers,
+                (unsigned long)(slot->stats.errors + slot->stats.direct_errors));
+        USART2_write(buffer);
+    }
+    for (uint32_t r = 0; r < DMA_NUM_REQUESTS; r++) {
+        if (dma_conflicts[r]) {
+            sprintf(buffer, "%s: %lu requests found no free stream\r\n",
+                    dma_request_names[r], (unsigned long)dma_conflicts[r]);
+            USART2_write(buffer);
+        }
+    }
+}
+
+// Stream interrupts
+void DMA1_Stream0_IRQHandler(void) { PROFILE_BEGIN(PROFILE_ISR_DMA); DMA_irq(0);  PROFILE_END(PROFILE_ISR_DMA); }
+void DMA1_Stream1_IRQHandler(void) { PROFILE_BEGIN(PROFILE_ISR_DMA); DMA_irq(1);  PROFILE_END(PROFILE_ISR_DMA); }
+void DMA1_Stream2_IRQHandler(void) { PROFILE_BEGIN(PROFILE_ISR_DMA); DMA_irq(2);  PROFILE_END(PROFILE_ISR_DMA); }
+void DMA1_Stream3_IRQHandler(void) { PROFILE_BEGIN(PROFILE_ISR_DMA); DMA_irq(3);  PROFILE_END(PROFILE_ISR_DMA); }
+void DMA1_Stream4_IRQHandler(void) { PROFILE_BEGIN(PROFILE_ISR_DMA); DMA_irq(4);  PROFILE_END(PROFILE_ISR_DMA); }
+void DMA1_Stream5_IRQHandler(void) { PROFILE_BEGIN(PROFILE_ISR_DMA); DMA_irq(5);  PROFILE_END(PROFILE_ISR_DMA); }
+void DMA1_Stream6_IRQHandler(void) { PROFILE_BEGIN(PROFILE_ISR_DMA); DMA_irq(6);  PROFILE_END(PROFILE_ISR_DMA); }
+void DMA1_Stream7_IRQHandler(void) { PROFILE_BEGIN(PROFILE_ISR_DMA); DMA_irq(7);  PROFILE_END(PROFILE_ISR_DMA); }
+void DMA2_Stream0_IRQHandler(void) { PROFILE_BEGIN(PROFILE_ISR_DMA); DMA_irq(8);  PROFILE_END(PROFILE_ISR_DMA); }
+void DMA2_Stream1_IRQHandler(void) { PROFILE_BEGIN(PROFILE_ISR_DMA); DMA_irq(9);  PROFILE_END(PROFILE_ISR_DMA); }
+void DMA2_Stream2_IRQHandler(void) { PROFILE_BEGIN(PROFILE_ISR_DMA); DMA_irq(10); PROFILE_END(PROFILE_ISR_DMA); }
+void DMA2_Stream3_IRQHandler(void) { PROFILE_BEGIN(PROFILE_ISR_DMA); DMA_irq(11); PROFILE_END(PROFILE_ISR_DMA); }
+void DMA2_Stream4_IRQHandler(void) { PROFILE_BEGIN(PROFILE_ISR_DMA); DMA_irq(12); PROFILE_END(PROFILE_ISR_DMA); }
+void DMA2_Stream5_IRQHandler(void) { PROFILE_BEGIN(PROFILE_ISR_DMA); DMA_irq(13); PROFILE_END(PROFILE_ISR_DMA); }
+void DMA2_Stream6_IRQHandler(void) { PROFILE_BEGIN(PROFILE_ISR_DMA); DMA_irq(14); PROFILE_END(PROFILE_ISR_DMA); }
+void DMA2_Stream7_IRQHandler(void) { PROFILE_BEGIN(PROFILE_ISR_DMA); DMA_irq(15); PROFILE_END(PROFILE_ISR_DMA); }
@@ -0,0 +1,311 @@
+/*
+* filename: dsp.c
+* purpose: implementation of the SIMD block filters and their scalar references
+* author: Connor Ockerse
+* date: 10/19/2026
+*/
+
+#include "dsp.h"
+#include <stdio.h>
+#include <string.h> // For memcpy
+#include "usart.h"
+
+// Q15 rounding: half an LSB of the result
+#define DSP_Q15_ROUND (1 << 14)
+
+// Two samples in one word, p[0] in the low half (LDR, unaligned is fine on the M4)
+static inline uint32_t DSP_load_pair(const int16_t* p) {
+    uint32_t pair;
+    memcpy(&pair, p, sizeof(pair));
+    return pair;
+}
+
+static inline void DSP_store_pair(int16_t* p, uint32_t pair) {
+    memcpy(p, &pair, sizeof(pair));
+}
+
+static inline int16_t DSP_saturate16(int32_t value) {
+    return (int16_t)((value > 32767) ? 32767 : (value < -32768) ? -32768 : value);
+}
+
+// Q15 accumulator back to a sample
+static inline int16_t DSP_q15_result(uint32_t acc) {
+    return DSP_saturate16((int32_t)(acc + DSP_Q15_ROUND) >> 15);
+}
+
+// Sum of n samples (wraps at 32 bits like __SMLAD)
+static uint32_t DSP_sum_scalar(const int16_t* x, uint32_t n) {
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        sum += (uint32_t)x[i];
+    }
+    return sum;
+}
+
+// Sum of n samples, two per __SMLAD (each half times 1)
+static uint32_t DSP_sum_simd(const int16_t* x, uint32_t n) {
+    uint32_t sum = 0;
+    uint32_t i = 0;
+    for (; i + 1U < n; i += 2U) {
+        sum = __SMLAD(DSP_load_pair(&x[i]), 0x00010001U, sum);
+    }
+    if (i < n) {
+        sum += (uint32_t)x[i];
+    }
+    return sum;
+}
+
+static inline int16_t DSP_median_of(int16_t a, int16_t b, int16_t c) {
+    int16_t lo = (a < b) ? a : b;
+    int16_t hi = (a < b) ? b : a;
+    return (c < lo) ? lo : (c > hi) ? hi : c;
+}
+
+// === FIR ===
+
+uint32_t DSP_fir_q15_scalar(const int16_t* in, int16_t* out, uint32_t len, const int16_t* coeffs, uint32_t taps) {
+    if ((taps == 0) || (len < taps)) {
+        return 0;
+    }
+    uint32_t outputs = len - taps + 1U;
+    for (uint32_t n = 0; n < outputs; n++) {
+        uint32_t acc = 0;
+        for (uint32_t k = 0; k < taps; k++) {
+            acc += (uint32_t)((int32_t)coeffs[k] * in[n + k]);
+        }
+        out[n] = DSP_q15_result(acc);
+    }
+    return outputs;
+}
+
+uint32_t DSP_fir_q15_simd(const int16_t* in, int16_t* out, uint32_t len, const int16_t* coeffs, uint32_t taps) {
+    if ((taps == 0) || (len < taps)) {
+        return 0;
+    }
+    uint32_t outputs = len - taps + 1U;
+    for (uint32_t n = 0; n < outputs; n++) {
+        const int16_t* x = &in[n];
+        uint32_t acc = 0;
+        uint32_t k = 0;
+
+        // 1. Two taps per __SMLAD
+        for (; k + 1U < taps; k += 2U) {
+            acc = __SMLAD(DSP_load_pair(&x[k]), DSP_load_pair(&coeffs[k]), acc);
+        }
+
+        // 2. Odd tap count: the last one alone
+        if (k < taps) {
+            acc += (uint32_t)((int32_t)coeffs[k] * x[k]);
+        }
+        out[n] = (int16_t)__SSAT((int32_t)(acc + DSP_Q15_ROUND) >> 15, 16);
+    }
+    return outputs;
+}
+
+uint32_t DSP_fir_q15(const int16_t* in, int16_t* out, uint32_t len, const int16_t* coeffs, uint32_t taps) {
+#if DSP_SIMD
+    return DSP_fir_q15_simd(in, out, len, coeffs, taps);
+#else
+    return DSP_fir_q15_scalar(in, out, len, coeffs, taps);
+#endif
+}
+
+// === MOVING AVERAGE ===
+
+uint32_t DSP_moving_average_scalar(const int16_t* in, int16_t* out, uint32_t len, uint32_t window) {
+    if ((window == 0) || (len < window)) {
+        return 0;
+    }
+    uint32_t outputs = len - window + 1U;
+    for (uint32_t n = 0; n < outputs; n++) {
+        out[n] = (int16_t)((int32_t)DSP_sum_scalar(&in[n], window) / (int32_t)window);
+    }
+    return outputs;
+}
+
+uint32_t DSP_moving_average_simd(const int16_t* in, int16_t* out, uint32_t len, uint32_t window) {
+    if ((window == 0) || (len < window)) {
+        return 0;
+    }
+    uint32_t outputs = len - window + 1U;
+    for (uint32_t n = 0; n < outputs; n++) {
+        out[n] = (int16_t)((int32_t)DSP_sum_simd(&in[n], window) / (int32_t)window);
+    }
+    return outputs;
+}
+
+uint32_t DSP_moving_average(const int16_t* in, int16_t* out, uint32_t len, uint32_t window) {
+#if DSP_SIMD
+    return DSP_moving_average_simd(in, out, len, window);
+#else
+    return DSP_moving_average_scalar(in, out, len, window);
+#endif
+}
+
+// === DECIMATION ===
+
+uint32_t DSP_decimate_scalar(const int16_t* in, int16_t* out, uint32_t len, uint32_t factor) {
+    if (factor == 0) {
+        return 0;
+    }
+    uint32_t outputs = len / factor;
+    for (uint32_t m = 0; m < outputs; m++) {
+        out[m] = (int16_t)((int32_t)DSP_sum_scalar(&in[m * factor], factor) / (int32_t)factor);
+    }
+    return outputs;
+}
+
+uint32_t DSP_decimate_simd(const int16_t* in, int16_t* out, uint32_t len, uint32_t factor) {
+    if (factor == 0) {
+        return 0;
+    }
+    uint32_t outputs = len / factor;
+    for (uint32_t m = 0; m < outputs; m++) {
+        out[m] = (int16_t)((int32_t)DSP_sum_simd(&in[m * factor], factor) / (int32_t)factor);
+    }
+    return outputs;
+}
+
+uint32_t DSP_decimate(const int16_t* in, int16_t* out, uint32_t len, uint32_t factor) {
+#if DSP_SIMD
+    return DSP_decimate_simd(in, out, len, factor);
+#else
+    return DSP_decimate_scalar(in, out, len, factor);
+#endif
+}
+
+// === MEDIAN OF 3 ===
+
+uint32_t DSP_median3_scalar(const int16_t* in, int16_t* out, uint32_t len) {
+    if (len < 3U) {
+        return 0;
+    }
+    uint32_t outputs = len - 2U;
+    for (uint32_t n = 0; n < outputs; n++) {
+        out[n] = DSP_median_of(in[n], in[n + 1U], in[n + 2U]);
+    }
+    return outputs;
+}
+
+uint32_t DSP_median3_simd(const int16_t* in, int16_t* out, uint32_t len) {
+    if (len < 3U) {
+        return 0;
+    }
+    uint32_t outputs = len - 2U;
+    uint32_t n = 0;
+
+    // Two outputs at once: lanes (n, n + 1) of a, b and c
+    for (; n + 1U < outputs; n += 2U) {
+        uint32_t a = DSP_load_pair(&in[n]);
+        uint32_t b = DSP_load_pair(&in[n + 1U]);
+        uint32_t c = DSP_load_pair(&in[n + 2U]);
+
+        // 1. lo = min(a, b), hi = max(a, b) (GE set per lane where a >= b)
+        __SSUB16(a, b);
+        uint32_t hi = __SEL(a, b);
+        uint32_t lo = __SEL(b, a);
+
+        // 2. median = max(lo, min(hi, c))
+        __SSUB16(hi, c);
+        uint32_t mid = __SEL(c, hi);
+        __SSUB16(lo, mid);
+        DSP_store_pair(&out[n], __SEL(lo, mid));
+    }
+
+    // 3. Odd output count: the last one alone
+    if (n < outputs) {
+        out[n] = DSP_median_of(in[n], in[n + 1U], in[n + 2U]);
+    }
+    return outputs;
+}
+
+uint32_t DSP_median3(const int16_t* in, int16_t* out, uint32_t len) {
+#if DSP_SIMD
+    return DSP_median3_simd(in, out, len);
+#else
+    return DSP_median3_scalar(in, out, len);
+#endif
+}
+
+// === BENCHMARK ===
+
+// 8-tap low-pass, gain 1.0 in Q15
+static const int16_t bench_taps[8] = { 1024, 2560, 4608, 8192, 8192, 4608, 2560, 1024 };
+#define DSP_BENCH_WINDOW 8U
+#define DSP_BENCH_FACTOR 4U
+
+static int16_t bench_in[DSP_BENCH_BLOCK];
+static int16_t bench_scalar[DSP_BENCH_BLOCK];
+static int16_t bench_simd[DSP_BENCH_BLOCK];
+
+// A noisy ramp with a spike every 16 samples (same block every call)
+static void DSP_bench_fill(void) {
+    uint32_t seed = 12345U;
+    for (uint32_t i = 0; i < DSP_BENCH_BLOCK; i++) {
+        seed = seed * 1664525U + 1013904223U;
+        int32_t noise = (int32_t)(seed >> 24) - 128;
+        bench_in[i] = (int16_t)(1000 + 20 * (int32_t)i + noise + (((i % 16U) == 5U) ? 12000 : 0));
+    }
+}
+
+static uint32_t DSP_bench_run(DspKernel kernel, uint8_t simd, int16_t* out) {
+    switch (kernel) {
+        case DSP_KERNEL_FIR:
+            return simd ? DSP_fir_q15_simd(bench_in, out, DSP_BENCH_BLOCK, bench_taps, 8U)
+                        : DSP_fir_q15_scalar(bench_in, out, DSP_BENCH_BLOCK, bench_taps, 8U);
+        case DSP_KERNEL_MOVING_AVERAGE:
+            return simd ? DSP_moving_average_simd(bench_in, out, DSP_BENCH_BLOCK, DSP_BENCH_WINDOW)
+                        : DSP_moving_average_scalar(bench_in, out, DSP_BENCH_BLOCK, DSP_BENCH_WINDOW);
+        case DSP_KERNEL_DECIMATE:
+            return simd ? DSP_decimate_simd(bench_in, out, DSP_BENCH_BLOCK, DSP_BENCH_FACTOR)
+                        : DSP_decimate_scalar(bench_in, out, DSP_BENCH_BLOCK, DSP_BENCH_FACTOR);
+        case DSP_KERNEL_MEDIAN3:
+            return simd ? DSP_median3_simd(bench_in, out, DSP_BENCH_BLOCK)
+                        : DSP_median3_scalar(bench_in, out, DSP_BENCH_BLOCK);
+        default:
+            return 0;
+    }
+}
+
+void DSP_bench(DspKernel kernel, DspBench* result) {
+    // 1. Cycle counter on (as for the spin waits)
+    if (!(DWT->CTRL & (1 << 0))) {
+        CoreDebug->DEMCR |= (1 << 24);  // TRCENA
+        DWT->CTRL |= (1 << 0);          // CYCCNTENA
+    }
+    DSP_bench_fill();
+
+    // 2. Each version with interrupts held off, so only the kernel is counted
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t start = DWT->CYCCNT;
+    uint32_t outputs = DSP_bench_run(kernel, 0, bench_scalar);
+    result->scalar_cycles = DWT->CYCCNT - start;
+    start = DWT->CYCCNT;
+    DSP_bench_run(kernel, 1, bench_simd);
+    result->simd_cycles = DWT->CYCCNT - start;
+    __set_PRIMASK(primask);
+
+    // 3. Same outputs both ways
+    result->outputs = outputs;
+    result->match = (memcmp(bench_scalar, bench_simd, outputs * sizeof(int16_t)) == 0) ? 1 : 0;
+}
+
+void DSP_report(void) {
+    static const char* const kernel_names[DSP_NUM_KERNELS] = { "fir8", "movavg8", "decim4", "median3" };
+    char buffer[96];
+    DspBench bench;
+
+    sprintf(buffer, "--- dsp (%u-sample block) ---\r\n", (unsigned)DSP_BENCH_BLOCK);
+    USART2_write(buffer);
+    for (uint32_t k = 0; k < DSP_NUM_KERNELS; k++) {
+        DSP_bench((DspKernel)k, &bench);
+        uint32_t simd = bench.simd_cycles ? bench.simd_cycles : 1U;
+        sprintf(buffer, "%-8s scalar %6lu  simd %6lu  x%lu.%02lu  %s\r\n", kernel_names[k],
+                (unsigned long)bench.scalar_cycles, (unsigned long)bench.simd_cycles,
+                (unsigned long)(bench.scalar_cycles / simd),
+                (unsigned long)((bench.scalar_cycles % simd) * 100U / simd),
+                bench.match ? "match" : "MISMATCH");
+        USART2_write(buffer);
+    }
+}
@@ -1,58 +1,72 @@
 
 
 #include "eeprom.h"
-#include "I2C.h"
-#include "TIM6.h"
+#include "board.h"
+#include "timebase.h"
+#include "crc.h"
 
+// Time at which the last internal write cycle is over (monotonic us)
+static uint64_t write_ready_time = 0;
 
-void EEPROM_write(uint8_t saddr, uint8_t memory_location, uint8_t data){
-    I2C1_byteWrite(saddr, memory_location, data);
-    TIM6_delay(2);
+// Bus the 24C02C is on
+static I2CBus eeprom_bus = BOARD_EEPROM_BUS;
+
+// Sleeps until the previous write cycle is over (returns at once if idle)
+static void EEPROM_wait_ready(void){
+    TIMEBASE_sleep_until(write_ready_time);
+}
+
+void EEPROM_set_bus(I2CBus bus){
+    eeprom_bus = bus;
+}
+
+I2CBus EEPROM_get_bus(void){
+    return eeprom_bus;
+}
+
+uint8_t EEPROM_is_busy(void){
+    return (TIMEBASE_now_us() < write_ready_time) ? 1 : 0;
+}
+
+I2CStatus EEPROM_write(uint8_t saddr, uint8_t memory_location, uint8_t data){
+    EEPROM_wait_ready();
+    I2CStatus status = I2C_byteWrite(eeprom_bus, saddr, memory_location, data);
+
+    // Don't block here: the next EEPROM access waits for whatever is left
+    // (also after a failure, which may have started a cycle after the data byte)
+    write_ready_time = TIMEBASE_now_us() + (EEPROM_WRITE_CYCLE_MS * 1000U);
+    return status;
+}
+
+uint8_t EEPROM_write_page(uint8_t saddr, uint8_t memory_location, const uint8_t* data, uint16_t len){
+    if ((len == 0) || ((memory_location % EEPROM_PAGE_BYTES) + len > EEPROM_PAGE_BYTES)){
+        return 0;
+    }
+    EEPROM_wait_ready();
+    I2CStatus status = I2C_burstWrite(eeprom_bus, saddr, memory_location, data, len);
+
+    // One write cycle for the whole page
+    write_ready_time = TIMEBASE_now_us() + (EEPROM_WRITE_CYCLE_MS * 1000U);
+    return (status == I2C_OK) ? 1 : 0;
+}
+
+I2CStatus EEPROM_read_sequential(uint8_t saddr, uint8_t memory_location, uint8_t* data, uint16_t len){
+    // The chip ignores its address while a write cycle is running
+    EEPROM_wait_ready();
+    return I2C_burstRead(eeprom_bus, saddr, memory_location, data, len);
 }
 
-void EEPROM_random_read(uint8_t saddr, uint8_t maddr, uint8_t* data){
-    // random read for EEPROM involves first writing to the word address
-    // then reading the data that is sent
-
-    volatile int tmp;
-    
-    // Phase 1: Write memory address to set pointer
-    while(I2C1->SR2 & 2);  // Wait until bus not busy
-    I2C1->CR1 |= 0x100;    // Generate start 
-    while(!(I2C1->SR1 & 1));
-    
-    I2C1->DR = saddr << 1; // Slave address + write
-    while(!(I2C1->SR1 & 2));
-    tmp = I2C1->SR2;
-    
-    while(!(I2C1->SR1 & 0x80));
-    I2C1->DR = maddr;      // Memory address
-    
-    // Phase 2: Repeated start and read
-    while(!(I2C1->SR1 & 0x80));
-    I2C1->CR1 |= 0x100;    // Repeated start
-    while(!(I2C1->SR1 & 1));
-    
-    I2C1->DR = (saddr << 1) | 1; // Slave address + read
-    while(!(I2C1->SR1 & 2));
-    tmp = I2C1->SR2;
-    
-    // Disable ACK for single byte read
-    I2C1->CR1 &= ~(1 << 10);
-    
-    // Wait for data and read it
-    while(!(I2C1->SR1 & 0x40));
-    *data = I2C1->DR;
-    
-    // Generate STOP after reading
-    I2C1->CR1 |= 0x200;
-    
-    // Re-enable ACK
-    I2C1->CR1 |= (1 << 10);
+I2CStatus EEPROM_random_read(uint8_t saddr, uint8_t maddr, uint8_t* data){
+    // Random read: set the address pointer with a write, then read one byte
+    // after a repeated START (a single-byte register read to the I2C driver)
+
+    // The chip ignores its address while a write cycle is running
+    EEPROM_wait_ready();
+    return I2C_byteRead(eeprom_bus, saddr, maddr, data);
 }
 
 uint8_t EEPROM_read_address(uint8_t saddr, uint8_t memory_location){
-    uint8_t data;
+    uint8_t data = 0xFF;                    // What an erased cell reads if the bus fails
     EEPROM_random_read(saddr, memory_location, &data);
     return data;
 }
@@ -62,4 +76,40 @@ void EEPROM_clear(uint8_t saddr){
     for (uint16_t i = 0;  i < EEPROM_NUM_BYTES; i++){
         EEPROM_write(saddr, i, 0);
     }
-}
\ No newline at end of file
+}
+
+uint8_t EEPROM_write_record(uint8_t saddr, uint8_t memory_location, const uint8_t* data, uint16_t len){
+    if ((uint32_t)memory_location + len + EEPROM_RECORD_CRC_BYTES > EEPROM_NUM_BYTES){
+        return 0;
+    }
+    uint32_t crc = CRC_bytes(data, len);
+    uint8_t ok = 1;
+
+    // A failed byte leaves the CRC wrong, so the rest still goes out
+    for (uint16_t i = 0; i < len; i++){
+        ok &= (EEPROM_write(saddr, (uint8_t)(memory_location + i), data[i]) == I2C_OK);
+    }
+    for (uint16_t i = 0; i < EEPROM_RECORD_CRC_BYTES; i++){
+        ok &= (EEPROM_write(saddr, (uint8_t)(memory_location + len + i), (uint8_t)(crc >> (8U * i))) == I2C_OK);
+    }
+    return ok;
+}
+
+uint8_t EEPROM_read_record(uint8_t saddr, uint8_t memory_location, uint8_t* data, uint16_t len){
+    if ((uint32_t)memory_location + len + EEPROM_RECORD_CRC_BYTES > EEPROM_NUM_BYTES){
+        return 0;
+    }
+    uint32_t stored = 0;
+    uint8_t ok = 1;
+
+    for (uint16_t i = 0; i < len; i++){
+        data[i] = 0xFF;
+        ok &= (EEPROM_random_read(saddr, (uint8_t)(memory_location + i), &data[i]) == I2C_OK);
+    }
+    for (uint16_t i = 0; i < EEPROM_RECORD_CRC_BYTES; i++){
+        uint8_t byte = 0xFF;
+        ok &= (EEPROM_random_read(saddr, (uint8_t)(memory_location + len + i), &byte) == I2C_OK);
+        stored |= (uint32_t)byte << (8U * i);
+    }
+    return (ok && (CRC_bytes(data, len) == stored)) ? 1 : 0;
+}
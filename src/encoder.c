@@ -6,23 +6,45 @@
 */
 
 #include "encoder.h"
-#include "TIM6.h"
+#include "board.h"
+#include "timebase.h"
+#include "swtimer.h"
+#include "profile.h"
+#include "trace.h"
+#include "ring.h"
 
-// volatile variables
-volatile uint8_t encoder_button_flag = 0;
-volatile uint32_t encoder_button_press_time = 0;
+// Debounce time before the button level is checked again
+#define ENCODER_DEBOUNCE_MS 16
+
+// Button pin and its EXTI line (PB10, or PC13 with BOARD_I2C2)
+#define ENCODER_BUTTON (1U << BOARD_BUTTON_PIN)
+
+// First falling edge of each press: EXTI ISR -> debounce callback
+RING_DEFINE(edge_ring, uint64_t, ENCODER_EDGE_RING_SIZE);
+
+// Confirmed presses: debounce callback -> ENCODER_debounce()/ENCODER_read_press()
+RING_DEFINE(press_ring, uint64_t, ENCODER_PRESS_RING_SIZE);
+
+static SWTimer debounce_timer;
+
+#if TRACE_ENABLE
+static uint16_t traced_count = 0;   // Count in the last TRACE_ENCODER record
+#endif
+
+// One-shot timer callback: confirm the press if the button is still held
+static void ENCODER_debounce_expired(void* arg) {
+    (void)arg;
+    uint64_t press_time;
+    if (!RING_pop(&edge_ring, press_time)) {
+        return;
+    }
+    if ((BOARD_BUTTON_PORT->IDR & ENCODER_BUTTON) == 0) {
+        RING_push(&press_ring, press_time);    // valid button press
+    }
+}
 
 void ENCODER_INIT(void){
-    // --- 1. ENCODER PINS (PB6, PB7) ---
-    RCC->AHB1ENR |= (1 << 1);          // GPIOB Clock
-    RCC->APB1ENR |= (1 << 2);          // TIM4 Clock
-    
-    // Configure PB6 & PB7 as AF2 (TIM4)
-    GPIOB->MODER &= ~((3 << 12) | (3 << 14)); 
-    GPIOB->MODER |=  ((2 << 12) | (2 << 14)); 
-    GPIOB->AFR[0] &= ~((0xF << 24) | (0xF << 28)); 
-    GPIOB->AFR[0] |=  ((0x2 << 24) | (0x2 << 28)); 
-    
+    // --- 1. ENCODER (TIM4 on PB6/PB7 AF2, set up by BOARD_INIT) ---
     // TIM4 Config
     TIM4->CR1 = 0;
     TIM4->SMCR |= (1 << 0); // Encoder Mode 1
@@ -30,24 +52,20 @@ void ENCODER_INIT(void){
     TIM4->ARR = 0xFFFF;
     TIM4->CR1 |= (1 << 0); // Enable Timer
     
-    // --- 2. BUTTON PIN (PB10) ---
-    // Configure PB10 as Input with Pull-Up
-    GPIOB->MODER &= ~(3 << 20); // Input Mode (00)
-    GPIOB->PUPDR &= ~(3 << 20); // Clear
-    GPIOB->PUPDR |=  (1 << 20); // Pull-Up (01) - Button usually connects to GND
-    
-    // --- 3. EXTI INTERRUPT FOR BUTTON ---
-    RCC->APB2ENR |= (1 << 14); // SYSCFG Clock
-    
-    // Map EXTI10 to Port B (0001)
-    // EXTICR[2] controls EXTI 8-11. 
-    // EXTI10 is bits 8-11 in that register.
-    SYSCFG->EXTICR[2] &= ~(0xF << 8);
-    SYSCFG->EXTICR[2] |=  (1 << 8);   // Set to Port B
+    // --- 2. EXTI INTERRUPT FOR BUTTON ---
+    // The button pin is an input with pull-up (button to GND), SYSCFG clocked by BOARD_INIT
+
+    // Map its EXTI line to its port (0001 = B, 0010 = C)
+    // EXTICR[pin / 4] controls 4 lines, 4 bits each
+    SYSCFG->EXTICR[BOARD_BUTTON_PIN / 4U] &= ~(0xFU << (4U * (BOARD_BUTTON_PIN % 4U)));
+    SYSCFG->EXTICR[BOARD_BUTTON_PIN / 4U] |=  (BOARD_BUTTON_EXTI_PORT << (4U * (BOARD_BUTTON_PIN % 4U)));
     
-    // Unmask EXTI10 and Set Falling Edge (Press)
-    EXTI->IMR  |= (1 << 10);
-    EXTI->FTSR |= (1 << 10); // Falling Edge Trigger
+    // Unmask the line and Set Falling Edge (Press)
+    EXTI->IMR  |= ENCODER_BUTTON;
+    EXTI->FTSR |= ENCODER_BUTTON; // Falling Edge Trigger
+#if TRACE_ENABLE
+    EXTI->RTSR |= ENCODER_BUTTON; // Releases too, so the trace has both edges
+#endif
     
     // Enable NVIC (EXTI15_10 handles lines 10-15)
     NVIC_EnableIRQ(EXTI15_10_IRQn);
@@ -55,20 +73,48 @@ void ENCODER_INIT(void){
 
 // IRQ handler
 void EXTI15_10_IRQHandler(void) {
-    // Check if interrupt came from Line 10 (PB10)
-    if (EXTI->PR & (1 << 10)) {
+    // No hardware timestamp for EXTI edges, so only the duration is measured
+    PROFILE_BEGIN(PROFILE_ISR_EXTI15_10);
+
+    // Check if interrupt came from the button line
+    if (EXTI->PR & ENCODER_BUTTON) {
         // Clear flag immediately
-        EXTI->PR |= (1 << 10);
-        
-        // Set flag and record time
-        encoder_button_flag = 1;
-        encoder_button_press_time = TIM6_get_count();
+        EXTI->PR |= ENCODER_BUTTON;
+
+#if TRACE_ENABLE
+        // Log the edge; releases (rising) only interrupt in trace builds
+        uint8_t level = (BOARD_BUTTON_PORT->IDR & ENCODER_BUTTON) ? 1 : 0;
+        TRACE_record(TRACE_BUTTON, level);
+        if (level == 0)
+#endif
+        {
+            // Record time and check the level again once the contacts settle
+            // Bounces while the timer is armed are ignored
+            if (!SWTIMER_is_active(&debounce_timer)) {
+                RING_push(&edge_ring, TIMEBASE_now_ms());
+                SWTIMER_start(&debounce_timer, ENCODER_DEBOUNCE_MS, 0, ENCODER_debounce_expired, 0);
+            }
+        }
     }
+
+    PROFILE_END(PROFILE_ISR_EXTI15_10);
 }
 
 uint16_t ENCODER_read(void){
     // Return the raw counter value
-    return (uint16_t)TIM4->CNT;
+    uint16_t count = (uint16_t)TIM4->CNT;
+#if TRACE_ENABLE
+    if (count != traced_count) {
+        traced_count = count;
+        TRACE_record(TRACE_ENCODER, count);
+    }
+#endif
+    return count;
+}
+
+void ENCODER_write(uint16_t count){
+    // The timer carries on counting from here
+    TIM4->CNT = count;
 }
 
 uint8_t ENCODER_raw_direction(void) {
@@ -77,19 +123,16 @@ uint8_t ENCODER_raw_direction(void) {
 
 
 uint8_t ENCODER_debounce(void){
-    if (encoder_button_flag){
-        uint32_t current_time = TIM6_get_count();
-
-        // 15 ms debounce
-        if ((current_time - encoder_button_press_time) > 15){
-            // check if button is still pressed
-            if ((GPIOB->IDR & (1 << 10)) == 0){
-                encoder_button_flag = 0;
-                TIM6_reset_count();         // reset counter to 0
-                return 1;   // valid button press
-            }
-            encoder_button_flag = 0;
-        }
-    }
-    return 0;   // invalid button press
+    // Same as ENCODER_read_press() without the timestamp
+    uint64_t press_time_ms;
+    return ENCODER_read_press(&press_time_ms);
+}
+
+uint8_t ENCODER_read_press(uint64_t* press_time_ms){
+    SWTIMER_process();
+    return (uint8_t)RING_pop(&press_ring, *press_time_ms);
+}
+
+uint32_t ENCODER_get_overflows(void){
+    return edge_ring.overflows + press_ring.overflows;
 }
\ No newline at end of file
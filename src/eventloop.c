@@ -0,0 +1,73 @@
+/*
+* filename: eventloop.c
+* purpose: implementation of the WFI event loop and CPU load accounting
+* author: Connor Ockerse
+* date: 10/19/2026
+*/
+
+#include "eventloop.h"
+#include "swtimer.h"
+#include "timebase.h"
+#include "power.h"
+#include "supervisor.h"
+
+// === LOAD ACCOUNTING ===
+static uint64_t idle_total_us = 0;      // Time asleep since boot
+static uint64_t window_start_us = 0;    // Start of the current load window
+static uint64_t window_idle_us = 0;     // Time asleep in the current window
+static uint16_t load_permille = 0;      // Result of the last full window
+
+// Closes the load window once it is long enough
+static void EVENTLOOP_update_load(uint64_t now) {
+    uint64_t elapsed = now - window_start_us;
+
+    if (elapsed >= (uint64_t)EVENTLOOP_LOAD_WINDOW_MS * 1000U) {
+        uint64_t busy = (elapsed > window_idle_us) ? (elapsed - window_idle_us) : 0;
+        load_permille = (uint16_t)((busy * 1000U) / elapsed);
+        window_start_us = now;
+        window_idle_us = 0;
+    }
+}
+
+uint32_t EVENTLOOP_poll(void) {
+    // One timed pass: the callbacks that are due
+    SUPERVISOR_pass_begin();
+    uint32_t fired = SWTIMER_process();
+    SUPERVISOR_pass_end();
+
+    if (fired == 0) {
+        // Mask interrupts so one arriving between the check and the WFI is
+        // not lost: WFI still wakes on a pending interrupt with PRIMASK set,
+        // and the handler runs as soon as the mask is lifted.
+        __disable_irq();
+        uint64_t sleep_start = TIMEBASE_now_us();
+
+        // Sleep or Stop until the next timer or interrupt
+        uint64_t deadline_ms = 0;
+        uint8_t has_deadline = SWTIMER_next_deadline(&deadline_ms);
+        uint64_t sleep_end = POWER_idle(sleep_start, has_deadline, deadline_ms * 1000U);
+        __enable_irq();
+
+        idle_total_us += sleep_end - sleep_start;
+        window_idle_us += sleep_end - sleep_start;
+        EVENTLOOP_update_load(sleep_end);
+    } else {
+        EVENTLOOP_update_load(TIMEBASE_now_us());
+    }
+
+    return fired;
+}
+
+void EVENTLOOP_run(void) {
+    while (1) {
+        EVENTLOOP_poll();
+    }
+}
+
+uint16_t EVENTLOOP_get_load(void) {
+    return load_permille;
+}
+
+uint64_t EVENTLOOP_get_idle_us(void) {
+    return idle_total_us;
+}
@@ -1,9 +1,51 @@
+#include "board.h"
+#include "boot.h"
+#include "power.h"
+#include "supervisor.h"
 #include "buzzer.h"
+#include "photoresistor.h"
+#include "swtimer.h"
+#include "eventloop.h"
+#include "profile.h"
+#include "trace.h"
+#include "stats.h"
+
+// Light level sampled by the event loop, checked by the supervisor
+#define LIGHT_PERIOD_MS 250U
+
+static SWTimer light_timer;
+static uint8_t light_task;
+static StatsStream light_stats;
+
+static void sample_light(void* arg){
+	(void)arg;
+	STATS_add(&light_stats, PHOTO_read_filtered());
+	SUPERVISOR_checkin(light_task);
+}
 
 int main(void){
+	BOARD_INIT();
+	BOOT_INIT();
+	POWER_INIT();
+	PROFILE_INIT();
+	TRACE_INIT();
 	BUZZER_INIT();
 	update_buzzer_freq(100);
-	while(1){
-	}
+
+	// First valid sensor reading ends the boot
+	PHOTO_INIT();
+	PHOTO_read();
+	BOOT_mark(BOOT_PHASE_READY);
+	BOOT_report();
+
+	// IWDG kicks only while the light task keeps up; WWDG times every pass
+	SUPERVISOR_INIT();
+	light_task = SUPERVISOR_register("light", 2U * LIGHT_PERIOD_MS);
+	STATS_INIT();
+	STATS_register(&light_stats, "light");
+	SWTIMER_start(&light_timer, LIGHT_PERIOD_MS, LIGHT_PERIOD_MS, sample_light, 0);
+
+	// Run timer callbacks, Sleep or Stop in between
+	EVENTLOOP_run();
 	return 0;
-}
\ No newline at end of file
+}
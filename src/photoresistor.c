@@ -6,56 +6,63 @@
 */
 
 #include "photoresistor.h"
-#include "RccConfig.h" // Needed for CLOCK_FREQUENCY
+#include "RccConfig.h" // Needed for CLOCK_get_pclk2
+#include "spinwait.h"
+#include "trace.h"
+#include "dsp.h"
 
-void PHOTO_INIT(void){
-    // 1. Enable Clocks
-    RCC->AHB1ENR |= (1 << 0);          // GPIOA Clock
-    RCC->APB2ENR |= (1 << 8);          // ADC1 Clock
-    
-    // 2. Configure PA1 as Analog Input
-    GPIOA->MODER |= (3 << (1 * 2));    // Mode 11 (Analog)
-    GPIOA->PUPDR &= ~(3 << (1 * 2));   // No pull-up/pull-down
-    
-    // 3. Configure ADC Clock Prescaler
-    // The ADC runs off PCLK2. We need to ensure ADC clock is <= 30-36 MHz.
-    // We use CLOCK_FREQUENCY to decide the prescaler.
-    
+// ADCCLK between 0.6 and 36 MHz at every SYSCLK
+#define PHOTO_CLOCK_CHECK(sysclk) \
+    STATIC_ASSERT((CLOCK_ADC_HZ(CLOCK_PCLK2_HZ(sysclk)) >= 600000U) && \
+                  (CLOCK_ADC_HZ(CLOCK_PCLK2_HZ(sysclk)) <= CLOCK_ADC_MAX), \
+                  "ADC clock out of range at a supported SYSCLK");
+CLOCK_SYSCLK_LIST(PHOTO_CLOCK_CHECK)
+
+// ADC clock prescaler for the current PCLK2
+static void PHOTO_set_prescaler(void){
+    // The ADC runs off PCLK2. We need to ensure ADC clock is <= 36 MHz.
+    // Example: 180MHz System -> 90MHz APB2 -> /4 = 22.5MHz
+    // Example: 45MHz System -> 45MHz APB2 -> /2 = 22.5MHz
     ADC123_COMMON->CCR &= ~(3 << 16);  // Clear ADCPRE bits
-    
-    // If System is fast (>60MHz), we generally need to divide by 4.
-    // If System is slow (<=60MHz), divide by 2 is safe.
-    if (CLOCK_FREQUENCY > 60000000) {
-        // Example: 180MHz System -> 90MHz APB2. 
-        // 90MHz / 4 = 22.5MHz (Safe)
-        ADC123_COMMON->CCR |= (1 << 16); 
-    } else {
-        // Example: 45MHz System -> 45MHz APB2.
-        // 45MHz / 2 = 22.5MHz (Safe)
-        ADC123_COMMON->CCR |= (0 << 16);
+    ADC123_COMMON->CCR |= (CLOCK_ADC_PRE(CLOCK_get_pclk2()) << 16);
+}
+
+// Conversions never span a call, so only the new prescaler matters
+static void PHOTO_reclock(ClockEvent event){
+    if (event == CLOCK_POST_CHANGE) {
+        PHOTO_set_prescaler();
     }
+}
+
+void PHOTO_INIT(void){
+    // 1. ADC1 clock and PA1 (analog, no pull) come from BOARD_INIT
+
+    // 2. Configure ADC Clock Prescaler
+    // We use PCLK2 to decide the prescaler.
+    PHOTO_set_prescaler();
     
-    // 4. Configure ADC1 CR1 (Control Register 1)
+    // 3. Configure ADC1 CR1 (Control Register 1)
     ADC1->CR1 = 0;                     // Reset defaults
     ADC1->CR1 &= ~(1 << 8);            // SCAN mode disabled
     ADC1->CR1 &= ~(1 << 5);            // EOCIE (Interrupts) disabled
     
-    // 5. Configure ADC1 CR2 (Control Register 2)
+    // 4. Configure ADC1 CR2 (Control Register 2)
     ADC1->CR2 = 0;                     // Reset defaults
     ADC1->CR2 &= ~(1 << 1);            // CONT = 0 (Single Conversion)
     ADC1->CR2 &= ~(3 << 28);           // EXTEN = 00 (Software Trigger Only)
     ADC1->CR2 |= (1 << 10);            // EOCS = 1 (EOC bit set at end of conversion)
     
-    // 6. Configure Sample Time for Channel 1
+    // 5. Configure Sample Time for Channel 1
     // 84 Cycles provides stable reading
     ADC1->SMPR2 |= (1 << (1 * 3 + 2)); // Channel 1 -> 84 cycles
     
-    // 7. Configure Sequence
+    // 6. Configure Sequence
     ADC1->SQR1 = 0;                    // Sequence length = 1 conversion
     ADC1->SQR3 = (1 << 0);             // 1st conversion = Channel 1
     
-    // 8. Turn On ADC
+    // 7. Turn On ADC
     ADC1->CR2 |= (1 << 0);             // ADON = 1
+    CLOCK_register(PHOTO_reclock);
 }
 
 uint16_t PHOTO_read(void){
@@ -63,8 +70,26 @@ uint16_t PHOTO_read(void){
     ADC1->CR2 |= (1 << 30);            // SWSTART = 1
     
     // 2. Wait for conversion to complete
-    while(!(ADC1->SR & (1 << 1))){}
+    SPIN_WHILE(SPIN_ADC_EOC, !(ADC1->SR & (1 << 1)));
     
     // 3. Read and Return Data
-    return (uint16_t)ADC1->DR;
-}
\ No newline at end of file
+    uint16_t sample = (uint16_t)ADC1->DR;
+    TRACE_record(TRACE_ADC, sample);
+    return sample;
+}
+
+uint16_t PHOTO_read_filtered(void){
+    int16_t block[PHOTO_FILTER_SAMPLES];
+    int16_t medians[PHOTO_FILTER_SAMPLES];
+    int16_t mean;
+
+    // 1. Back-to-back conversions
+    for (uint32_t i = 0; i < PHOTO_FILTER_SAMPLES; i++) {
+        block[i] = (int16_t)PHOTO_read();
+    }
+
+    // 2. Spikes out, then the mean of what is left
+    uint32_t count = DSP_median3(block, medians, PHOTO_FILTER_SAMPLES);
+    DSP_decimate(medians, &mean, count, count);
+    return (uint16_t)mean;
+}
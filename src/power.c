@@ -0,0 +1,384 @@
+/*
+* filename: power.c
+* purpose: implementation of the Sleep/Stop idle and its accounting
+* author: Connor Ockerse
+* date: 10/19/2026
+*/
+
+#include "power.h"
+#include <stdio.h>
+#include "RccConfig.h"
+#include "I2C.h"
+#include "board.h"
+#include "timebase.h"
+#include "spinwait.h"
+#include "usart.h"
+#include "watchdog.h"
+
+// RTC on the LSI: subseconds count at the full LSI rate, an RTC "second"
+// after PREDIV_S + 1 of them (1 s only if the LSI is at its nominal 32 kHz)
+#define POWER_LSI_NOMINAL_HZ 32000U
+#define POWER_RTC_PREDIV_S  (POWER_LSI_NOMINAL_HZ - 1U)
+#define POWER_TICKS_PER_DAY (86400UL * (POWER_RTC_PREDIV_S + 1U))
+
+// Wakeup timer on RTC/2: ~62.5 us per count, up to ~4 s per Stop
+#define POWER_WUT_MAX       0x10000UL
+
+// LSI calibration: TIM5_CH4 captures every 8th LSI edge, 16 captures (~4 ms)
+#define POWER_LSI_IC_PSC    8U
+#define POWER_LSI_CAPTURES  16U
+
+// Regulator start-up before the first instruction runs (datasheet tWUSTOP)
+#if POWER_STOP_LOW_POWER
+#define POWER_STOP_EXIT_US  105U
+#else
+#define POWER_STOP_EXIT_US  13U
+#endif
+
+static uint8_t initialized = 0;
+static uint32_t stop_locks = 0;
+static uint64_t start_us = 0;
+
+static PowerStats stats;
+static uint64_t latency_total_us = 0;
+
+// === HELPERS ===
+
+static void POWER_rtc_unlock(void) {
+    RTC->WPR = 0xCA;
+    RTC->WPR = 0x53;
+}
+
+static void POWER_rtc_lock(void) {
+    RTC->WPR = 0xFF;
+}
+
+// LSI rate from its edges on the 1 MHz TIM5 timebase (TI4_RMP routes the LSI
+// to TIM5_CH4; channel 1 keeps serving the timebase wakeups)
+static uint32_t POWER_measure_lsi(void) {
+    uint32_t first = 0;
+    uint32_t last = 0;
+    uint8_t captured = 1;
+
+    // 1. CH4 input capture on every 8th rising LSI edge
+    TIM5->CCER &= ~(0xBU << 12);                    // CC4E off, rising edge
+    TIM5->OR = (1U << 6);                           // TI4_RMP = LSI
+    TIM5->CCMR2 = (TIM5->CCMR2 & ~(0xFFU << 8)) | (3U << 10) | (1U << 8);   // IC4PSC = /8, CC4S = TI4
+    (void)(uint32_t)TIM5->CCR4;                     // Drops a stale CC4IF
+    TIM5->SR = ~(1U << 12);                         // CC4OF (rc_w0)
+    TIM5->CCER |= (1U << 12);                       // CC4E
+
+    // 2. The first capture only fixes the phase; time the ones after it
+    //    (8 LSI periods are under 0.5 ms even at the 17 kHz minimum)
+    SPIN_set_timeout(SPIN_LSI_CAPTURE, CLOCK_get_sysclk() / 1000U);
+    for (uint32_t i = 0; (i <= POWER_LSI_CAPTURES) && captured; i++) {
+        SPIN_WHILE_OR(SPIN_LSI_CAPTURE, !(TIM5->SR & (1 << 4)), captured = 0);
+        last = TIM5->CCR4;                          // Clears CC4IF
+        if (i == 0) {
+            first = last;
+        }
+    }
+
+    // 3. Channel and remap back to reset state
+    TIM5->CCER &= ~(0xBU << 12);
+    TIM5->CCMR2 &= ~(0xFFU << 8);
+    TIM5->OR = 0;
+    TIM5->SR = ~((1U << 12) | (1U << 4));
+
+    uint32_t span_us = last - first;
+    if (!captured || (span_us == 0)) {
+        return POWER_LSI_NOMINAL_HZ;                // No LSI edges: keep the datasheet value
+    }
+    return (uint32_t)((((uint64_t)POWER_LSI_CAPTURES * POWER_LSI_IC_PSC * 1000000U) +
+                       (span_us / 2U)) / span_us);
+}
+
+static uint32_t POWER_from_bcd(uint32_t value) {
+    return ((value >> 4) * 10U) + (value & 0xF);
+}
+
+// RTC position in LSI ticks since midnight
+static uint32_t POWER_rtc_ticks(void) {
+    uint32_t tr, ssr;
+
+    // Shadow registers are bypassed: read again if a second passed meanwhile
+    do {
+        tr = RTC->TR;
+        ssr = RTC->SSR;
+    } while (tr != RTC->TR);
+
+    uint32_t seconds = POWER_from_bcd((tr >> 16) & 0x3F) * 3600U +
+                       POWER_from_bcd((tr >> 8) & 0x7F) * 60U +
+                       POWER_from_bcd(tr & 0x7F);
+    return (seconds * (POWER_RTC_PREDIV_S + 1U)) + (POWER_RTC_PREDIV_S - (ssr & 0xFFFF));
+}
+
+// Nothing clocked may be running: it would stall or lose its work in Stop
+static uint8_t POWER_stop_allowed(void) {
+    uint8_t drained = 1;
+
+    if (stop_locks) {
+        return 0;
+    }
+    if ((TIM1->CR1 | TIM2->CR1 | TIM3->CR1) & (1 << 0)) {
+        return 0;                       // Buzzer, stopwatch or sonar running
+    }
+
+    // The last USART2 frame (TC) or I2C STOP (BUSY) finishes on its own
+    // within a frame time, but no interrupt would end a Sleep: wait it out
+    SPIN_WHILE_OR(SPIN_POWER_DRAIN, !(USART2->SR & (1 << 6)) || I2C_any_busy(),
+                  drained = 0);
+    return drained;
+}
+
+// RTC wakeup interrupt after sleep_us (rounded down, at least one count)
+static void POWER_arm_wakeup(uint64_t sleep_us) {
+    uint64_t counts = (sleep_us * (stats.lsi_hz / 2U)) / 1000000U;
+    if (counts == 0) {
+        counts = 1;
+    } else if (counts > POWER_WUT_MAX) {
+        counts = POWER_WUT_MAX;         // Longer waits take several Stops
+    }
+
+    POWER_rtc_unlock();
+    RTC->CR &= ~((1U << 14) | (1U << 10));                 // WUTIE, WUTE off
+    SPIN_WHILE(SPIN_RTC_WUTWF, !(RTC->ISR & (1 << 2)));    // WUTWF: WUTR writable
+    RTC->WUTR = (uint32_t)(counts - 1U);
+    RTC->CR |= (1 << 14) | (1 << 10);                      // WUTIE, WUTE
+    POWER_rtc_lock();
+}
+
+static void POWER_disarm_wakeup(void) {
+    POWER_rtc_unlock();
+    RTC->CR &= ~((1U << 14) | (1U << 10));
+    POWER_rtc_lock();
+}
+
+static void POWER_count_wakeups(uint32_t pending) {
+    uint8_t counted = 0;
+
+    if (pending & (1UL << 22)) {
+        stats.wakeups[POWER_WAKE_TIMER]++;
+        counted = 1;
+    }
+    if (pending & (1UL << 0)) {
+        stats.wakeups[POWER_WAKE_ALARM]++;
+        counted = 1;
+    }
+    if (pending & (1UL << BOARD_BUTTON_PIN)) {
+        stats.wakeups[POWER_WAKE_BUTTON]++;
+        counted = 1;
+    }
+    if (!counted) {
+        stats.wakeups[POWER_WAKE_OTHER]++;
+    }
+}
+
+static uint64_t POWER_stop(uint64_t now_us, uint8_t has_deadline, uint64_t deadline_us) {
+    ClockProfile profile = CLOCK_get_profile();
+
+    // 1. Wake early enough for the clocks to be back at the deadline
+    if (has_deadline) {
+        uint64_t restore_us = stats.latency_max_us ? stats.latency_max_us : POWER_RESTORE_US;
+        uint64_t idle_us = deadline_us - now_us;
+        POWER_arm_wakeup((idle_us > restore_us) ? (idle_us - restore_us) : 0);
+    }
+
+    // 2. Both clocks just before the timebase freezes
+    uint32_t rtc_start = POWER_rtc_ticks();
+    uint64_t awake_start_us = TIMEBASE_now_us();
+
+    // 3. Stop: WFI with SLEEPDEEP (PDDS stays 0)
+    SCB->SCR |= (1 << 2);
+    __DSB();
+    __WFI();
+    SCB->SCR &= ~(1U << 2);
+
+    // 4. Which lines woke us (their handlers run once the caller unmasks)
+    POWER_count_wakeups(EXTI->PR);
+    POWER_disarm_wakeup();
+
+    // 5. On HSI now: drivers retune to it, then the timebase gets back what
+    //    the RTC saw pass and TIM5 didn't
+    CLOCK_resume_from_stop();
+    uint32_t rtc_ticks = (POWER_rtc_ticks() + POWER_TICKS_PER_DAY - rtc_start) % POWER_TICKS_PER_DAY;
+    uint64_t rtc_us = ((uint64_t)rtc_ticks * 1000000U) / stats.lsi_hz;
+    uint64_t awake_us = TIMEBASE_now_us() - awake_start_us;
+    uint64_t stopped_us = (rtc_us > awake_us) ? (rtc_us - awake_us) : 0;
+    TIMEBASE_advance_us(stopped_us);
+    uint64_t wake_us = awake_start_us + stopped_us;
+
+    // 6. Profile clocks back (HSE start-up and PLL lock)
+    if (profile < CLOCK_NUM_PROFILES) {
+        CLOCK_set_profile(profile);
+    }
+    uint64_t end_us = TIMEBASE_now_us();
+
+    // 7. Accounting: latency from the wakeup event, regulator start-up included
+    uint32_t latency = (uint32_t)(end_us - wake_us) + POWER_STOP_EXIT_US;
+    stats.mode_us[POWER_MODE_STOP] += stopped_us;
+    stats.entries[POWER_MODE_STOP]++;
+    latency_total_us += latency;
+    if ((stats.latency_min_us == 0) || (latency < stats.latency_min_us)) {
+        stats.latency_min_us = latency;
+    }
+    if (latency > stats.latency_max_us) {
+        stats.latency_max_us = latency;
+    }
+    return end_us;
+}
+
+// === PUBLIC FUNCTIONS ===
+
+void POWER_INIT(void) {
+    // 1. Backup domain (RCC_BDCR, RTC) write access; PWR clock from BOARD_INIT
+    PWR->CR |= (1 << 8);                // DBP
+
+    // 2. LSI (the IWDG starts it too, but may not be running yet)
+    RCC->CSR |= (1 << 0);               // LSION
+    SPIN_WHILE(SPIN_RCC_LSI, !(RCC->CSR & (1 << 1)));
+
+    // 3. RTC clocked from the LSI
+    RCC->BDCR = (RCC->BDCR & ~(3U << 8)) | (2U << 8) | (1U << 15);  // RTCSEL = LSI, RTCEN
+
+    // 4. Prescalers in init mode: PREDIV_A = 0 (full-rate subseconds), ~1 Hz seconds
+    POWER_rtc_unlock();
+    RTC->ISR |= (1 << 7);               // INIT
+    SPIN_WHILE(SPIN_RTC_INIT, !(RTC->ISR & (1 << 6)));
+    RTC->PRER = POWER_RTC_PREDIV_S;     // Synchronous first, then asynchronous
+    RTC->PRER = (0U << 16) | POWER_RTC_PREDIV_S;
+    RTC->TR = 0;
+    RTC->CR = (1 << 5) | (3 << 0);      // BYPSHAD (read TR/SSR live), WUCKSEL = RTC/2
+    RTC->ISR &= ~(1U << 7);             // Leave init mode: the count starts
+    POWER_rtc_lock();
+
+    // 5. Wakeup timer interrupt through EXTI line 22 (rising)
+    EXTI->RTSR |= (1UL << 22);
+    EXTI->IMR |= (1UL << 22);
+    NVIC_EnableIRQ(RTC_WKUP_IRQn);
+
+    // 6. Stop flavour: low-power regulator + flash power-down, or main regulator
+#if POWER_STOP_LOW_POWER
+    PWR->CR |= (1 << 9) | (1 << 0);     // FPDS, LPDS
+#else
+    PWR->CR &= ~((1U << 9) | (1U << 0));
+#endif
+    PWR->CR &= ~(1U << 1);              // PDDS = 0: deepsleep is Stop, not Standby
+
+    // 7. Statistics
+    for (uint32_t i = 0; i < POWER_NUM_MODES; i++) {
+        stats.mode_us[i] = 0;
+        stats.entries[i] = 0;
+    }
+    for (uint32_t i = 0; i < POWER_NUM_WAKE_SOURCES; i++) {
+        stats.wakeups[i] = 0;
+    }
+    stats.wwdg_wakeups = 0;
+    stats.latency_min_us = 0;
+    stats.latency_max_us = 0;
+    latency_total_us = 0;
+
+    // 8. What the LSI really runs at (17-47 kHz over parts and temperature):
+    //    every Stop is converted back to microseconds with it
+    stats.lsi_hz = POWER_measure_lsi();
+    start_us = TIMEBASE_now_us();
+    initialized = 1;
+}
+
+uint64_t POWER_idle(uint64_t now_us, uint8_t has_deadline, uint64_t deadline_us) {
+    if (initialized && POWER_stop_allowed() &&
+        (!has_deadline || (deadline_us >= now_us + POWER_STOP_MIN_US))) {
+        return POWER_stop(now_us, has_deadline, deadline_us);
+    }
+
+    // The WWDG keeps counting in Sleep and only the loop refreshes it: wake
+    // for the next pass before its early warning
+    uint8_t wwdg_wake = 0;
+    if (WWDG_get_timeout_us()) {
+        uint32_t left_us = WWDG_get_remaining_us();
+        uint64_t limit_us = now_us + ((left_us > POWER_WWDG_MARGIN_US) ? (left_us - POWER_WWDG_MARGIN_US) : 0U);
+        if (!has_deadline || (deadline_us > limit_us)) {
+            has_deadline = 1;
+            deadline_us = limit_us;
+            wwdg_wake = 1;
+        }
+    }
+
+    // Tickless: nothing else wakes us for the next timer, so ask for it
+    if (has_deadline) {
+        TIMEBASE_set_wakeup(deadline_us);
+    }
+    __DSB();
+    __WFI();
+    uint64_t end_us = TIMEBASE_now_us();
+
+    if (initialized) {
+        stats.mode_us[POWER_MODE_SLEEP] += end_us - now_us;
+        stats.entries[POWER_MODE_SLEEP]++;
+        if (wwdg_wake && (end_us >= deadline_us)) {
+            stats.wwdg_wakeups++;
+        }
+    }
+    return end_us;
+}
+
+void POWER_stop_lock(void) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    stop_locks++;
+    __set_PRIMASK(primask);
+}
+
+void POWER_stop_unlock(void) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (stop_locks) {
+        stop_locks--;
+    }
+    __set_PRIMASK(primask);
+}
+
+void POWER_get_stats(PowerStats* out) {
+    uint64_t total = initialized ? (TIMEBASE_now_us() - start_us) : 0;
+    uint64_t idle = stats.mode_us[POWER_MODE_SLEEP] + stats.mode_us[POWER_MODE_STOP];
+
+    *out = stats;
+    out->mode_us[POWER_MODE_RUN] = (total > idle) ? (total - idle) : 0;
+    out->latency_avg_us = stats.entries[POWER_MODE_STOP] ?
+        (uint32_t)(latency_total_us / stats.entries[POWER_MODE_STOP]) : 0;
+}
+
+void POWER_report(void) {
+    static const char* const mode_names[POWER_NUM_MODES] = { "run", "sleep", "stop" };
+    char buffer[96];
+    PowerStats s;
+
+    POWER_get_stats(&s);
+    uint64_t total = s.mode_us[POWER_MODE_RUN] + s.mode_us[POWER_MODE_SLEEP] + s.mode_us[POWER_MODE_STOP];
+
+    USART2_write((char*)"--- power (us, since POWER_INIT) ---\r\n");
+    for (uint32_t i = 0; i < POWER_NUM_MODES; i++) {
+        uint32_t permille = total ? (uint32_t)((s.mode_us[i] * 1000U) / total) : 0;
+        sprintf(buffer, "%-5s %10lu  %3lu.%lu%%  %lu entries\r\n", mode_names[i],
+                (unsigned long)s.mode_us[i], (unsigned long)(permille / 10),
+                (unsigned long)(permille % 10), (unsigned long)s.entries[i]);
+        USART2_write(buffer);
+    }
+    sprintf(buffer, "stop wakeups: timer %lu, alarm %lu, button %lu, other %lu\r\n",
+            (unsigned long)s.wakeups[POWER_WAKE_TIMER], (unsigned long)s.wakeups[POWER_WAKE_ALARM],
+            (unsigned long)s.wakeups[POWER_WAKE_BUTTON], (unsigned long)s.wakeups[POWER_WAKE_OTHER]);
+    USART2_write(buffer);
+    sprintf(buffer, "sleeps ended for the WWDG: %lu\r\n", (unsigned long)s.wwdg_wakeups);
+    USART2_write(buffer);
+    sprintf(buffer, "stop exit latency: min %lu, avg %lu, max %lu; LSI %lu Hz\r\n",
+            (unsigned long)s.latency_min_us, (unsigned long)s.latency_avg_us,
+            (unsigned long)s.latency_max_us, (unsigned long)s.lsi_hz);
+    USART2_write(buffer);
+}
+
+// IRQ handler
+void RTC_WKUP_IRQHandler(void) {
+    // The wakeup itself was the point; just clear the flags
+    RTC->ISR &= ~(1U << 10);            // WUTF (rc_w0)
+    EXTI->PR = (1UL << 22);             // rc_w1
+}
@@ -0,0 +1,155 @@
+/*
+* filename: profile.c
+* purpose: implementation of DWT cycle-counter histograms
+* author: Connor Ockerse
+* date: 10/19/2026
+*/
+
+#include "profile.h"
+
+#if PROFILE_ENABLE
+
+#include "usart.h"
+#include <stdio.h>  // For sprintf
+#include <string.h> // For memset
+
+// One fixed-bucket histogram
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t buckets[PROFILE_NUM_BUCKETS];
+}ProfileHistogram;
+
+static ProfileHistogram durations[PROFILE_NUM_IDS];
+static ProfileHistogram latencies[PROFILE_NUM_IDS];
+
+static const char* const profile_names[PROFILE_NUM_IDS] = {
+    "TIM3_IRQ", "TIM5_IRQ", "EXTI15_10_IRQ", "DMA_IRQ",
+    "timers", "user0", "user1", "user2", "user3"
+};
+
+// === BUCKET MATH ===
+// Values 0-3 get their own bucket, then every power of two is split in 4:
+// [4,5) [5,6) [6,7) [7,8) [8,10) [10,12) ... so the width is ~19% of the value
+
+static uint32_t PROFILE_bucket(uint32_t cycles) {
+    if (cycles < 4) {
+        return cycles;
+    }
+    uint32_t msb = 31U - __CLZ(cycles);         // >= 2
+    uint32_t sub = (cycles >> (msb - 2)) & 3U;  // 2 bits below the MSB
+    uint32_t index = ((msb - 1) * 4U) + sub;
+    return (index < PROFILE_NUM_BUCKETS) ? index : (PROFILE_NUM_BUCKETS - 1);
+}
+
+// Largest value that falls in a bucket
+static uint32_t PROFILE_bucket_top(uint32_t index) {
+    if (index < 4) {
+        return index;
+    }
+    uint32_t msb = (index / 4U) + 1;
+    uint32_t sub = index % 4U;
+    uint64_t low = ((uint64_t)(4U + sub)) << (msb - 2);
+    uint64_t top = low + (1ULL << (msb - 2)) - 1;
+    return (top > 0xFFFFFFFFULL) ? 0xFFFFFFFFU : (uint32_t)top;
+}
+
+static void PROFILE_add(ProfileHistogram* h, uint32_t cycles) {
+    // ISRs of different priority may record into different histograms
+    // concurrently, but each histogram only has one writer at a time
+    if (h->count == 0 || cycles < h->min) h->min = cycles;
+    if (cycles > h->max) h->max = cycles;
+    h->count++;
+    h->sum += cycles;
+    h->buckets[PROFILE_bucket(cycles)]++;
+}
+
+static uint32_t PROFILE_percentile(const ProfileHistogram* h, uint32_t permille) {
+    uint64_t target = (((uint64_t)h->count * permille) + 999U) / 1000U;
+    uint64_t seen = 0;
+
+    for (uint32_t i = 0; i < PROFILE_NUM_BUCKETS; i++) {
+        seen += h->buckets[i];
+        if (seen >= target && seen > 0) {
+            uint32_t top = PROFILE_bucket_top(i);
+            return (top > h->max) ? h->max : top;
+        }
+    }
+    return h->max;
+}
+
+// === PUBLIC FUNCTIONS ===
+
+void PROFILE_INIT(void) {
+    // 1. Enable trace (DEMCR.TRCENA) so the DWT is powered
+    CoreDebug->DEMCR |= (1 << 24);
+
+    // 2. Reset and start the cycle counter (DWT_CTRL.CYCCNTENA)
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= (1 << 0);
+
+    PROFILE_reset();
+}
+
+void PROFILE_record(ProfileId id, uint32_t cycles) {
+    if (id < PROFILE_NUM_IDS) {
+        PROFILE_add(&durations[id], cycles);
+    }
+}
+
+void PROFILE_record_latency(ProfileId id, uint32_t cycles) {
+    if (id < PROFILE_NUM_IDS) {
+        PROFILE_add(&latencies[id], cycles);
+    }
+}
+
+void PROFILE_get_summary(ProfileId id, uint8_t latency, ProfileSummary* summary) {
+    const ProfileHistogram* h = latency ? &latencies[id] : &durations[id];
+
+    summary->count = h->count;
+    summary->min = h->min;
+    summary->max = h->max;
+    summary->mean = h->count ? (uint32_t)(h->sum / h->count) : 0;
+    summary->p50 = h->count ? PROFILE_percentile(h, 500) : 0;
+    summary->p90 = h->count ? PROFILE_percentile(h, 900) : 0;
+    summary->p99 = h->count ? PROFILE_percentile(h, 990) : 0;
+}
+
+void PROFILE_reset(void) {
+    memset(durations, 0, sizeof(durations));
+    memset(latencies, 0, sizeof(latencies));
+}
+
+static void PROFILE_print(const char* name, const char* kind, ProfileSummary* s) {
+    char buffer[128];
+
+    sprintf(buffer, "%-14s %-4s n=%lu min=%lu mean=%lu p50=%lu p90=%lu p99=%lu max=%lu\r\n",
+            name, kind,
+            (unsigned long)s->count, (unsigned long)s->min, (unsigned long)s->mean,
+            (unsigned long)s->p50, (unsigned long)s->p90, (unsigned long)s->p99,
+            (unsigned long)s->max);
+    USART2_write(buffer);
+}
+
+void PROFILE_dump(void) {
+    ProfileSummary s;
+    char buffer[64];
+
+    sprintf(buffer, "--- profile (cycles @ %lu Hz) ---\r\n", (unsigned long)CLOCK_get_hclk());
+    USART2_write(buffer);
+
+    for (uint32_t id = 0; id < PROFILE_NUM_IDS; id++) {
+        PROFILE_get_summary((ProfileId)id, 0, &s);
+        if (s.count) {
+            PROFILE_print(profile_names[id], "run", &s);
+        }
+        PROFILE_get_summary((ProfileId)id, 1, &s);
+        if (s.count) {
+            PROFILE_print(profile_names[id], "lat", &s);
+        }
+    }
+}
+
+#endif
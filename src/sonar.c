@@ -6,44 +6,53 @@
 */
 
 #include "sonar.h"
-#include "RccConfig.h" // Needed for CLOCK_FREQUENCY
+#include "RccConfig.h" // Needed for CLOCK_get_apb1_timer_clock
+#include "profile.h"
+#include "trace.h"
+#include "timebase.h"
+#include "ring.h"
+#include "seqlock.h"
+#include "dsp.h"
 
-// Global variables for ISR to communicate with main
-volatile uint16_t rise_time = 0;
-volatile uint16_t fall_time = 0;
-volatile uint16_t pulse_width = 0;
-volatile uint8_t capture_edge = 0; // 0 = Looking for Rising, 1 = Looking for Falling
+// 1 us tick: pulse widths in TIM3 counts are microseconds
+#define SONAR_TICK_HZ 1000000U
+#define SONAR_CLOCK_CHECK(sysclk) CLOCK_ASSERT_TIMER(CLOCK_APB1_TIMER_HZ(sysclk), SONAR_TICK_HZ, 0);
+CLOCK_SYSCLK_LIST(SONAR_CLOCK_CHECK)
+
+// ISR-only capture state
+static uint16_t rise_time = 0;
+static uint8_t capture_edge = 0; // 0 = Looking for Rising, 1 = Looking for Falling
+
+// Published by the ISR: every echo in order, and the latest one
+RING_DEFINE(echo_ring, SonarEcho, SONAR_RING_SIZE);
+SEQLOCK_DEFINE(latest_echo, SonarEcho);
+
+// Last two distances of SONAR_read_filtered() (the median's look-back)
+static int16_t filter_history[2];
+static uint8_t filter_primed = 0;
+
+// Keeps the 1 us tick across clock changes (a ping in flight may read wrong once)
+static void SONAR_reclock(ClockEvent event){
+    if (event == CLOCK_POST_CHANGE) {
+        CLOCK_timer_set_prescaler(TIM3, CLOCK_TIMER_PSC(CLOCK_get_apb1_timer_clock(), SONAR_TICK_HZ));
+    }
+}
 
 void SONAR_INIT(void){
-    // 1. Enable Clocks
-    RCC->AHB1ENR |= (1 << 1);          // GPIOB Clock (Bit 1)
-    RCC->APB1ENR |= (1 << 1);          // TIM3 Clock (Bit 1)
-    
-    // 2. Configure Pins (PB4=Trig, PB5=Echo)
-    // Set PB4 and PB5 to Alternate Function Mode (10)
-    GPIOB->MODER &= ~((3 << 8) | (3 << 10)); // Clear bits
-    GPIOB->MODER |=  ((2 << 8) | (2 << 10)); // Set AF mode
-    
-    // Set AF2 (TIM3) for both PB4 and PB5
-    // AFR[0] handles pins 0-7. 
-    // PB4: Bits 19:16 -> 0010 (2)
-    // PB5: Bits 23:20 -> 0010 (2)
-    GPIOB->AFR[0] &= ~((0xF << 16) | (0xF << 20)); // Clear
-    GPIOB->AFR[0] |=  ((2 << 16) | (2 << 20));     // Set AF2
-    
-    // 3. Configure TIM3 Timebase
+    // 1. TIM3 clock and PB4 (Trig) / PB5 (Echo) as AF2 come from BOARD_INIT
+
+    // 2. Configure TIM3 Timebase
     // Goal: 1MHz Timer Clock (1 tick = 1 microsecond)
     // PSC = (Clock / Target) - 1
-    // Note: If APB1 prescaler != 1, Timer Clock is 2x PCLK1. 
-    // However, with your 45MHz config (prescalers=0), everything is 1:1.
-    // We use CLOCK_FREQUENCY generic calculation.
-    uint32_t psc_val = (CLOCK_FREQUENCY / 1000000) - 1;
+    // Note: If APB1 prescaler != 1, Timer Clock is 2x PCLK1,
+    // which CLOCK_get_apb1_timer_clock() accounts for.
+    uint32_t psc_val = CLOCK_TIMER_PSC(CLOCK_get_apb1_timer_clock(), SONAR_TICK_HZ);
     TIM3->PSC = psc_val;
     
     // 50 ms period
     TIM3->ARR = 50000 - 1;
     
-    // 4. Configure Trigger (CH1 - PB4) - PWM Mode
+    // 3. Configure Trigger (CH1 - PB4) - PWM Mode
     // We want a 10us pulse.
     TIM3->CCMR1 &= ~(3 << 0);          // CC1S = 00 (Output)
     TIM3->CCMR1 |= (6 << 4);           // OC1M = 110 (PWM Mode 1)
@@ -51,24 +60,31 @@ void SONAR_INIT(void){
     TIM3->CCR1 = 10;                   // High for 10us (10 ticks)
     TIM3->CCER |= (1 << 0);            // CC1E = 1 (Enable Output)
     
-    // 5. Configure Echo (CH2 - PB5) - Input Capture Mode
+    // 4. Configure Echo (CH2 - PB5) - Input Capture Mode
     TIM3->CCMR1 &= ~(3 << 8);          // Clear CC2S bits
     TIM3->CCMR1 |= (1 << 8);           // CC2S = 01 (Input is TI2)
     TIM3->CCER &= ~(1 << 5 | 1 << 7);  // CC2P/CC2NP = 00 (Rising Edge initially)
     TIM3->CCER |= (1 << 4);            // CC2E = 1 (Enable Capture)
     
-    // 6. Enable Interrupts
+    // 5. Enable Interrupts
     TIM3->DIER |= (1 << 2);            // CC2IE (Enable Interrupt for Channel 2)
     NVIC_EnableIRQ(TIM3_IRQn);         // Enable NVIC
     
-    // 7. Start Timer
+    // 6. Start Timer
     TIM3->CR1 |= (1 << 0);             // CEN = 1
+    CLOCK_register(SONAR_reclock);
 }
 
 // Interrupt Handler
 void TIM3_IRQHandler(void){
+    PROFILE_BEGIN(PROFILE_ISR_TIM3);
+
     // Check if interrupt came from Channel 2 (Echo)
     if (TIM3->SR & (1 << 2)) {
+        // Latency: 1 us ticks between the captured edge and now (mod ARR + 1)
+        PROFILE_LATENCY_US_TICKS(PROFILE_ISR_TIM3,
+            (TIM3->CNT + TIM3->ARR + 1 - TIM3->CCR2) % (TIM3->ARR + 1));
+
         if (capture_edge == 0) {
             // We just caught the RISING edge
             rise_time = TIM3->CCR2;
@@ -79,7 +95,8 @@ void TIM3_IRQHandler(void){
         } 
         else {
             // We just caught the FALLING edge
-            fall_time = TIM3->CCR2;
+            uint16_t fall_time = TIM3->CCR2;
+            uint16_t pulse_width;
             
             // Calculate Pulse Width
             if (fall_time >= rise_time) {
@@ -88,6 +105,15 @@ void TIM3_IRQHandler(void){
                 // Handle timer overflow (Counter wrapped around)
                 pulse_width = (TIM3->ARR - rise_time) + fall_time;
             }
+            TRACE_record(TRACE_SONAR, pulse_width);
+
+            // Publish, stamped with the edge time (1 us ticks since the capture)
+            SonarEcho echo;
+            echo.time_us = TIMEBASE_now_us() -
+                ((TIM3->CNT + TIM3->ARR + 1 - fall_time) % (TIM3->ARR + 1));
+            echo.width_us = pulse_width;
+            SEQLOCK_write(&latest_echo, echo);
+            RING_push(&echo_ring, echo);
             
             // Switch back to Rising Edge Detection for next cycle
             TIM3->CCER &= ~(1 << 5);   // CC2P = 0 (Rising)
@@ -97,13 +123,54 @@ void TIM3_IRQHandler(void){
         // Clear Interrupt Flag
         TIM3->SR &= ~(1 << 2);
     }
+
+    PROFILE_END(PROFILE_ISR_TIM3);
 }
 
-/**
- * 
- */
 uint16_t SONAR_get_distance(void){
+    SonarEcho echo;
+    SEQLOCK_read(&latest_echo, echo);
+
     // Formula: Distance (cm) = Pulse_Width (us) / 58
     // Based on speed of sound 343m/s
-    return (uint16_t)(pulse_width / 58);
+    return (uint16_t)(echo.width_us / 58);
+}
+
+uint8_t SONAR_get_latest(SonarEcho* echo){
+    SEQLOCK_read(&latest_echo, *echo);
+    return (SEQLOCK_writes(&latest_echo) != 0) ? 1 : 0;
+}
+
+uint8_t SONAR_read_echo(SonarEcho* echo){
+    return (uint8_t)RING_pop(&echo_ring, *echo);
+}
+
+uint32_t SONAR_read_filtered(uint16_t* cm){
+    int16_t block[SONAR_RING_SIZE + 2];
+    SonarEcho echo;
+    uint32_t len = 2;
+
+    // 1. Queued echoes in cm behind the two before them
+    while ((len < SONAR_RING_SIZE + 2) && RING_pop(&echo_ring, echo)) {
+        block[len++] = (int16_t)(echo.width_us / 58);
+    }
+    if (len == 2) {
+        return 0;
+    }
+    if (!filter_primed) {
+        filter_history[0] = filter_history[1] = block[2];   // First echo: nothing to compare
+        filter_primed = 1;
+    }
+    block[0] = filter_history[0];
+    block[1] = filter_history[1];
+
+    // 2. One median per new echo, then keep the newest two for next time
+    uint32_t count = DSP_median3(block, (int16_t*)cm, len);
+    filter_history[0] = block[len - 2];
+    filter_history[1] = block[len - 1];
+    return count;
+}
+
+uint32_t SONAR_get_overflows(void){
+    return echo_ring.overflows;
 }
\ No newline at end of file
@@ -0,0 +1,128 @@
+/*
+* filename: spinwait.c
+* purpose: implementation of busy-wait accounting and timeouts
+* author: Connor Ockerse
+* date: 10/19/2026
+*/
+
+#include "spinwait.h"
+#include "usart.h"
+#include <stdio.h>  // For sprintf
+#include <string.h> // For memset
+
+static SpinStats spin_stats[SPIN_NUM_SITES];
+static uint32_t spin_timeout[SPIN_NUM_SITES];   // 0 = no timeout
+
+static const char* const spin_names[SPIN_NUM_SITES] = {
+    "RCC HSE ready", "RCC PLL lock", "RCC SWS", "RCC PLL off", "PWR OD ready", "PWR OD switch",
+    "I2C busy", "I2C SB", "I2C ADDR", "I2C TXE", "I2C BTF", "I2C RXNE", "I2C recover",
+    "USART TXE", "USART TC", "ADC EOC", "IWDG SR", "DMA disable",
+    "RCC LSI ready", "RTC INITF", "RTC WUTWF", "Stop drain", "LSI capture", "FLASH BSY",
+    "CRC DMA"
+};
+
+// Waits can start before anyone set up the DWT (e.g. SysClockConfig)
+static void SPIN_enable_cycle_counter(void) {
+    if (!(DWT->CTRL & (1 << 0))) {
+        CoreDebug->DEMCR |= (1 << 24);  // TRCENA
+        DWT->CTRL |= (1 << 0);          // CYCCNTENA
+    }
+}
+
+void SPIN_begin(SpinProbe* probe, SpinSite site) {
+    SPIN_enable_cycle_counter();
+    probe->site = site;
+    probe->spins = 0;
+    probe->timed_out = 0;
+    probe->start = DWT->CYCCNT;
+}
+
+uint8_t SPIN_continue(SpinProbe* probe) {
+    probe->spins++;
+
+    uint32_t budget = spin_timeout[probe->site];
+    if (budget && ((DWT->CYCCNT - probe->start) > budget)) {
+        probe->timed_out = 1;
+        return 0;               // Stop waiting
+    }
+    return 1;
+}
+
+uint8_t SPIN_end(SpinProbe* probe) {
+    uint32_t elapsed = DWT->CYCCNT - probe->start;
+    SpinStats* stats = &spin_stats[probe->site];
+
+    stats->calls++;
+    stats->spins += probe->spins;
+    stats->cycles += elapsed;
+    if (elapsed > stats->max_cycles) {
+        stats->max_cycles = elapsed;
+    }
+    if (probe->timed_out) {
+        stats->timeouts++;
+    }
+    return probe->timed_out;
+}
+
+uint32_t SPIN_now(void) {
+    SPIN_enable_cycle_counter();
+    return DWT->CYCCNT;
+}
+
+uint8_t SPIN_expired(SpinSite site, uint32_t start) {
+    uint32_t budget = spin_timeout[site];
+    return (budget && ((DWT->CYCCNT - start) > budget)) ? 1 : 0;
+}
+
+void SPIN_set_timeout(SpinSite site, uint32_t cycles) {
+    if (site < SPIN_NUM_SITES) {
+        spin_timeout[site] = cycles;
+    }
+}
+
+void SPIN_get_stats(SpinSite site, SpinStats* stats) {
+    *stats = spin_stats[site];
+}
+
+void SPIN_reset(void) {
+    memset(spin_stats, 0, sizeof(spin_stats));
+}
+
+void SPIN_report(void) {
+    // Snapshot first: printing goes through USART TXE waits, which update
+    // the very table we are reporting on
+    SpinStats snapshot[SPIN_NUM_SITES];
+    uint8_t order[SPIN_NUM_SITES];
+    char buffer[160];
+
+    for (uint8_t i = 0; i < SPIN_NUM_SITES; i++) {
+        snapshot[i] = spin_stats[i];
+        order[i] = i;
+    }
+
+    // Rank by total cycles (insertion sort, the table is tiny)
+    for (uint8_t i = 1; i < SPIN_NUM_SITES; i++) {
+        uint8_t site = order[i];
+        uint8_t j = i;
+        while (j > 0 && snapshot[order[j - 1]].cycles < snapshot[site].cycles) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = site;
+    }
+
+    USART2_write((char*)"--- busy-wait report (cycles) ---\r\n");
+    for (uint8_t i = 0; i < SPIN_NUM_SITES; i++) {
+        SpinStats* s = &snapshot[order[i]];
+        if (s->calls == 0) {
+            continue;
+        }
+        // Total in kilocycles: newlib-nano printf has no %llu
+        sprintf(buffer, "%2u. %-13s calls=%lu spins=%lu total_k=%lu max=%lu timeouts=%lu\r\n",
+                (unsigned)(i + 1), spin_names[order[i]],
+                (unsigned long)s->calls, (unsigned long)s->spins,
+                (unsigned long)(s->cycles / 1000U), (unsigned long)s->max_cycles,
+                (unsigned long)s->timeouts);
+        USART2_write(buffer);
+    }
+}
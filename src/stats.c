@@ -0,0 +1,275 @@
+/*
+* filename: stats.c
+* purpose: implementation of the incremental windowed statistics
+* author: Connor Ockerse
+* date: 10/19/2026
+*/
+
+#include "stats.h"
+#include <stdio.h>
+#include "swtimer.h"
+#include "usart.h"
+
+static StatsStream* streams = 0;
+static SWTimer roll_timer;
+
+// Division rounded to nearest (d > 0)
+static int64_t STATS_div_round(int64_t n, int64_t d) {
+    return (n >= 0) ? ((n + d / 2) / d) : -((-n + d / 2) / d);
+}
+
+static void STATS_acc_clear(StatsAcc* acc) {
+    acc->count = 0;
+    acc->min = 0;
+    acc->max = 0;
+    acc->mean_q8 = 0;
+    acc->m2_q8 = 0;
+}
+
+// Chan's parallel merge: acc += other
+static void STATS_acc_merge(StatsAcc* acc, const StatsAcc* other) {
+    if (other->count == 0) {
+        return;
+    }
+    if (acc->count == 0) {
+        *acc = *other;
+        return;
+    }
+    int64_t na = acc->count;
+    int64_t nb = other->count;
+    int64_t n = na + nb;
+    int64_t delta = (int64_t)other->mean_q8 - acc->mean_q8;
+
+    acc->mean_q8 += (int32_t)STATS_div_round(delta * nb, n);
+    acc->m2_q8 += other->m2_q8 + STATS_div_round(((delta * delta) >> 8) * na, n) * nb;
+    acc->count = (uint32_t)n;
+    acc->min = (other->min < acc->min) ? other->min : acc->min;
+    acc->max = (other->max > acc->max) ? other->max : acc->max;
+}
+
+// Inverse merge: acc -= other (min and max are left to the deques)
+static void STATS_acc_remove(StatsAcc* acc, const StatsAcc* other) {
+    if (other->count == 0) {
+        return;
+    }
+    if (other->count >= acc->count) {
+        STATS_acc_clear(acc);
+        return;
+    }
+    int64_t n = acc->count;
+    int64_t nb = other->count;
+    int64_t nr = n - nb;
+    int64_t mean = STATS_div_round((int64_t)acc->mean_q8 * n - (int64_t)other->mean_q8 * nb, nr);
+    int64_t delta = (int64_t)other->mean_q8 - mean;
+
+    acc->m2_q8 -= other->m2_q8 + STATS_div_round(((delta * delta) >> 8) * nr, n) * nb;
+    if (acc->m2_q8 < 0) {
+        acc->m2_q8 = 0;
+    }
+    acc->mean_q8 = (int32_t)mean;
+    acc->count = (uint32_t)nr;
+}
+
+// === MONOTONIC DEQUES ===
+
+static uint8_t STATS_deque_at(const StatsDeque* q, uint32_t i) {
+    return q->slot[(q->head + i) % STATS_SLOTS];
+}
+
+// Drops the front if it is the slot about to be overwritten (the oldest)
+static void STATS_deque_expire(StatsDeque* q, uint8_t slot) {
+    if (q->len && (q->slot[q->head] == slot)) {
+        q->head = (uint8_t)((q->head + 1U) % STATS_SLOTS);
+        q->len--;
+    }
+}
+
+// Pushes slot after dropping every newer-side entry it makes useless
+// (is_min: keep increasing minima, else decreasing maxima)
+static void STATS_deque_push(StatsDeque* q, const StatsAcc* ring, uint8_t slot, uint8_t is_min) {
+    while (q->len) {
+        const StatsAcc* back = &ring[STATS_deque_at(q, q->len - 1U)];
+        if (is_min ? (back->min < ring[slot].min) : (back->max > ring[slot].max)) {
+            break;
+        }
+        q->len--;
+    }
+    q->slot[(q->head + q->len) % STATS_SLOTS] = slot;
+    q->len++;
+}
+
+// === SLIDING WINDOWS ===
+
+static void STATS_level_clear(StatsLevel* level) {
+    STATS_acc_clear(&level->window);
+    level->min_q.head = level->min_q.len = 0;
+    level->max_q.head = level->max_q.len = 0;
+    level->next = 0;
+    level->used = 0;
+}
+
+// Adds a closed sub-window, dropping the oldest once the ring is full
+static void STATS_level_push(StatsLevel* level, const StatsAcc* acc) {
+    uint8_t i = level->next;
+
+    // 1. Evict the oldest
+    if (level->used == STATS_SLOTS) {
+        STATS_acc_remove(&level->window, &level->slot[i]);
+        STATS_deque_expire(&level->min_q, i);
+        STATS_deque_expire(&level->max_q, i);
+    } else {
+        level->used++;
+    }
+
+    // 2. Add the new one (empty sub-windows only take up the slot)
+    level->slot[i] = *acc;
+    if (acc->count) {
+        STATS_acc_merge(&level->window, acc);
+        STATS_deque_push(&level->min_q, level->slot, i, 1);
+        STATS_deque_push(&level->max_q, level->slot, i, 0);
+    }
+    level->next = (uint8_t)((i + 1U) % STATS_SLOTS);
+
+    // 3. Once per lap: rebuild from the ring (drops the rounding of the removals)
+    if (level->next == 0) {
+        STATS_acc_clear(&level->window);
+        for (uint32_t s = 0; s < level->used; s++) {
+            STATS_acc_merge(&level->window, &level->slot[s]);
+        }
+    }
+
+    // 4. Extremes of whatever is left come from the deque fronts
+    if (level->window.count) {
+        level->window.min = level->slot[STATS_deque_at(&level->min_q, 0)].min;
+        level->window.max = level->slot[STATS_deque_at(&level->max_q, 0)].max;
+    }
+}
+
+// Integer square root (floor)
+static uint32_t STATS_isqrt(uint64_t value) {
+    uint64_t root = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+static void STATS_roll_timer(void* arg) {
+    (void)arg;
+    STATS_roll();
+}
+
+// === PUBLIC FUNCTIONS ===
+
+void STATS_INIT(void) {
+    SWTIMER_start(&roll_timer, STATS_SECOND_MS, STATS_SECOND_MS, STATS_roll_timer, 0);
+}
+
+void STATS_register(StatsStream* stream, const char* name) {
+    stream->name = name;
+    STATS_acc_clear(&stream->second);
+    STATS_acc_clear(&stream->last_second);
+    STATS_level_clear(&stream->minute);
+    STATS_level_clear(&stream->hour);
+
+    for (StatsStream* s = streams; s; s = s->next) {
+        if (s == stream) {
+            return;                 // Already in the list
+        }
+    }
+    stream->next = streams;
+    streams = stream;
+}
+
+void STATS_add(StatsStream* stream, int32_t sample) {
+    StatsAcc* acc = &stream->second;
+
+    if (sample > STATS_SAMPLE_LIMIT) {
+        sample = STATS_SAMPLE_LIMIT;
+    } else if (sample < -STATS_SAMPLE_LIMIT) {
+        sample = -STATS_SAMPLE_LIMIT;
+    }
+    int32_t x = sample * 256;
+
+    // Welford: mean moves by delta / n, M2 by delta * (x - new mean)
+    acc->count++;
+    if (acc->count == 1U) {
+        acc->mean_q8 = x;
+        acc->m2_q8 = 0;
+        acc->min = acc->max = sample;
+        return;
+    }
+    int32_t delta = x - acc->mean_q8;
+    acc->mean_q8 += (int32_t)STATS_div_round(delta, acc->count);
+    acc->m2_q8 += ((int64_t)delta * (x - acc->mean_q8)) >> 8;
+    acc->min = (sample < acc->min) ? sample : acc->min;
+    acc->max = (sample > acc->max) ? sample : acc->max;
+}
+
+void STATS_roll(void) {
+    for (StatsStream* s = streams; s; s = s->next) {
+        // 1. Second closes into the minute window
+        s->last_second = s->second;
+        STATS_level_push(&s->minute, &s->second);
+        STATS_acc_clear(&s->second);
+
+        // 2. Every full lap of the minute ring is one closed minute for the hour
+        if (s->minute.next == 0) {
+            STATS_level_push(&s->hour, &s->minute.window);
+        }
+    }
+}
+
+uint8_t STATS_get(const StatsStream* stream, StatsWindow window, StatsSummary* summary) {
+    const StatsAcc* acc = (window == STATS_WINDOW_SECOND) ? &stream->last_second :
+                          (window == STATS_WINDOW_MINUTE) ? &stream->minute.window :
+                                                            &stream->hour.window;
+    summary->count = acc->count;
+    if (acc->count == 0) {
+        summary->min = summary->max = summary->mean_q8 = 0;
+        summary->stddev_q8 = 0;
+        return 0;
+    }
+    summary->min = acc->min;
+    summary->max = acc->max;
+    summary->mean_q8 = acc->mean_q8;
+
+    // Variance in Q8, shifted to Q16 so its root comes out in Q8
+    uint64_t variance_q8 = (uint64_t)acc->m2_q8 / acc->count;
+    summary->stddev_q8 = STATS_isqrt(variance_q8 << 8);
+    return 1;
+}
+
+void STATS_report(void) {
+    static const char* const window_names[STATS_NUM_WINDOWS] = { "1s", "1min", "1h" };
+    char buffer[112];
+    StatsSummary s;
+
+    USART2_write((char*)"--- stats ---\r\n");
+    for (StatsStream* stream = streams; stream; stream = stream->next) {
+        for (uint32_t w = 0; w < STATS_NUM_WINDOWS; w++) {
+            if (!STATS_get(stream, (StatsWindow)w, &s)) {
+                continue;
+            }
+            // Q8 printed with two decimals
+            int32_t mean_abs = (s.mean_q8 < 0) ? -s.mean_q8 : s.mean_q8;
+            sprintf(buffer, "%-8.8s %-4s n=%lu min=%ld max=%ld mean=%s%ld.%02ld sd=%lu.%02lu\r\n",
+                    stream->name, window_names[w], (unsigned long)s.count, (long)s.min, (long)s.max,
+                    (s.mean_q8 < 0) ? "-" : "", (long)(mean_abs >> 8),
+                    (long)(((mean_abs & 0xFF) * 100) >> 8),
+                    (unsigned long)(s.stddev_q8 >> 8), (unsigned long)(((s.stddev_q8 & 0xFF) * 100U) >> 8));
+            USART2_write(buffer);
+        }
+    }
+}
@@ -6,14 +6,15 @@
 */
 
 #include "stepper.h"
-#include "TIM6.h"
+#include "swtimer.h"
+#include "eventloop.h"
 
 // === PRIVATE STATE VARIABLES ===
-static uint32_t steps_remaining = 0;   // How many steps left to go
-static uint32_t step_delay = 0;        // How long to wait between steps
-static uint32_t last_step_time = 0;    // Timestamp of the previous step
+static volatile uint32_t steps_remaining = 0; // How many steps left to go
 static uint8_t  current_direction = 0; // CW or CCW
 static uint8_t  step_index = 0;        // Current position in the 0-1-2-3 sequence
+static volatile int32_t position = 0;  // Steps from home, CW positive
+static SWTimer  step_timer;            // Periodic timer that paces the steps
 
 // The 4-step sequence lookup table
 static const uint8_t step_sequence[4] = {STEP1, STEP2, STEP3, STEP4};
@@ -24,57 +25,81 @@ static void STEPPER_write_pattern(uint8_t pattern) {
     GPIOB->BSRR = (0xF << 16) | (pattern & 0xF);
 }
 
-void STEPPER_INIT(void){
-    // 1. Enable GPIOB Clock
-    RCC->AHB1ENR |= (1 << 1); 
-    
-    // 2. Configure PB0-PB3 as Outputs
-    GPIOB->MODER &= ~(0xFF << 0); // Clear
-    GPIOB->MODER |= 0x55;         // Set Output
-    GPIOB->OSPEEDR |= 0x55;       // High Speed
+// Timer callback: takes ONE step, stops the timer when the move is done
+static void STEPPER_step(void* arg) {
+    (void)arg;
+
+    // STEPPER_stop() may come from an interrupt: a step is taken whole or not at all
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (steps_remaining == 0) {
+        __set_PRIMASK(primask);
+        SWTIMER_cancel(&step_timer);
+        return;
+    }
+
+    // A. Update the Step Index (0-3)
+    if (current_direction == STEP_CW) {
+        step_index++;
+        if (step_index > 3) step_index = 0;
+    } else {
+        if (step_index == 0) step_index = 3;
+        else step_index--;
+    }
 
+    // B. Write the hardware pins
+    STEPPER_write_pattern(step_sequence[step_index]);
+
+    // C. Update State
+    position += (current_direction == STEP_CW) ? 1 : -1;
+    steps_remaining--;
+    __set_PRIMASK(primask);
+    if (steps_remaining == 0) {
+        SWTIMER_cancel(&step_timer);
+    }
+}
+
+void STEPPER_INIT(void){
+    // PB0-PB3 are outputs (BOARD_INIT); start with every coil off
+    GPIOB->BSRR = (0xFU << 16);
 }
 
 void STEPPER_set_target(uint32_t steps, uint8_t direction, uint32_t delay_ms) {
     // Set the state variables
     steps_remaining = steps;
     current_direction = direction;
-    step_delay = delay_ms;
-    
-    // Reset timer so movement starts immediately
-    last_step_time = TIM6_get_count() - delay_ms; 
-}
 
-uint8_t STEPPER_update(void) {
-    // 1. Check if we have work to do
-    if (steps_remaining == 0) {
-        return 0; // Idle
+    if (steps == 0) {
+        SWTIMER_cancel(&step_timer);
+        return;
     }
 
-    // 2. Check if enough time has passed (Non-Blocking Check)
-    uint32_t now = TIM6_get_count();
-    
-    if ((now - last_step_time) >= step_delay) {
-        // Time to take a step!
-        
-        // A. Update the Step Index (0-3)
-        if (current_direction == STEP_CW) {
-            step_index++;
-            if (step_index > 3) step_index = 0;
-        } else {
-            if (step_index == 0) step_index = 3;
-            else step_index--;
-        }
-        
-        // B. Write the hardware pins
-        STEPPER_write_pattern(step_sequence[step_index]);
-        
-        // C. Update State
-        steps_remaining--;
-        last_step_time = now;
-    }
-    
-    return 1; // Still busy moving
+    // First step right away, then one step every delay_ms
+    SWTIMER_start(&step_timer, 0, (delay_ms > 0) ? delay_ms : 1, STEPPER_step, 0);
+}
+
+void STEPPER_stop(void) {
+    // The timer cancels itself on its next call
+    steps_remaining = 0;
+    GPIOB->BSRR = (0xFU << 16);
+}
+
+int32_t STEPPER_get_position(void) {
+    return position;
+}
+
+void STEPPER_set_position(int32_t steps) {
+    position = steps;
+    // The coil sequence repeats every 4 steps, so the index follows the position
+    step_index = (uint8_t)((uint32_t)steps & 3U);
+}
+
+uint8_t STEPPER_update(void) {
+    // Steps are taken by the timer callback. Servicing the wheel here keeps
+    // plain polling loops (without the event loop) working as before.
+    SWTIMER_process();
+    return (steps_remaining != 0) ? 1 : 0;
 }
 
 void wag(void) {
@@ -83,8 +108,9 @@ void wag(void) {
     STEPPER_set_target(65, STEP_CW, 2);
     
     // "Blocking" Loop: Wait for this specific move to finish
-    // We must call STEPPER_update() here so the motor actually moves!
+    // The event loop sleeps between steps instead of spinning
     while(STEPPER_update() == 1) {
+        EVENTLOOP_poll();
     }
 
     // === STEP 2: Move CCW ===
@@ -93,5 +119,6 @@ void wag(void) {
     
     // Wait for the return trip to finish
     while(STEPPER_update() == 1) {
+        EVENTLOOP_poll();
     }
-}
\ No newline at end of file
+}
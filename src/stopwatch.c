@@ -6,17 +6,27 @@
 */
 
 #include "stopwatch.h"
-#include "RccConfig.h" // Needed for CLOCK_FREQUENCY
+#include "RccConfig.h" // Needed for CLOCK_get_apb1_timer_clock
+
+// PSC must fit 16 bits and give an exact tick at every SYSCLK
+#define STOPWATCH_CLOCK_CHECK(sysclk) CLOCK_ASSERT_TIMER(CLOCK_APB1_TIMER_HZ(sysclk), STOPWATCH_TICK_HZ, 0);
+CLOCK_SYSCLK_LIST(STOPWATCH_CLOCK_CHECK)
+
+// Keeps the tick rate across clock changes (the count carries on)
+static void STOPWATCH_reclock(ClockEvent event){
+    if (event == CLOCK_POST_CHANGE) {
+        CLOCK_timer_set_prescaler(TIM2, CLOCK_TIMER_PSC(CLOCK_get_apb1_timer_clock(), STOPWATCH_TICK_HZ));
+    }
+}
 
 void STOPWATCH_INIT(void){
-    // 1. Enable TIM2 Clock (APB1 Bus)
-    RCC->APB1ENR |= (1 << 0); // TIM2EN is Bit 0
-    
+    // 1. TIM2 clock comes from BOARD_INIT
+
     // 2. Configure Prescaler
     // Formula: PSC = (TimerClock / TargetFreq) - 1
-    // Target: 1000 Hz (1 ms)
-    // Example: 45,000,000 / 1000 = 45,000. PSC = 44,999.
-    uint32_t psc_val = (CLOCK_FREQUENCY / 1000) - 1;
+    // Target: STOPWATCH_TICK_HZ (2000 Hz, 0.5 ms)
+    // Example: 45,000,000 / 2000 = 22,500. PSC = 22,499.
+    uint32_t psc_val = CLOCK_TIMER_PSC(CLOCK_get_apb1_timer_clock(), STOPWATCH_TICK_HZ);
     TIM2->PSC = psc_val;
     
     // 3. Set Auto-Reload to Max (32-bit)
@@ -36,6 +46,7 @@ void STOPWATCH_INIT(void){
     
     // 6. Reset Counter
     TIM2->CNT = 0;
+    CLOCK_register(STOPWATCH_reclock);
 }
 
 void STOPWATCH_start(void){
@@ -46,11 +57,25 @@ void STOPWATCH_start(void){
 }
 
 uint32_t STOPWATCH_read(void){
-    // Return current 32-bit counter value (in milliseconds)
-    return TIM2->CNT;
+    // Convert ticks to milliseconds
+    return TIM2->CNT / (STOPWATCH_TICK_HZ / 1000);
 }
 
 void STOPWATCH_stop(void){
     // Disable Counter
     TIM2->CR1 &= ~(1 << 0);
+}
+
+void STOPWATCH_resume(void){
+    // Enable Counter (CEN) without touching the count
+    TIM2->CR1 |= (1 << 0);
+}
+
+uint8_t STOPWATCH_is_running(void){
+    return (TIM2->CR1 & (1 << 0)) ? 1 : 0;
+}
+
+void STOPWATCH_set(uint32_t ms){
+    // Convert milliseconds to ticks
+    TIM2->CNT = ms * (STOPWATCH_TICK_HZ / 1000);
 }
\ No newline at end of file
@@ -0,0 +1,302 @@
+/*
+* filename: supervisor.c
+* purpose: implementation of the main loop latency supervisor
+* author: Connor Ockerse
+* date: 10/19/2026
+*/
+
+#include "supervisor.h"
+#include <stdio.h>
+#include "RccConfig.h"
+#include "timebase.h"
+#include "swtimer.h"
+#include "watchdog.h"
+#include "usart.h"
+
+// Snapshot at the start of backup SRAM
+#define SUPERVISOR_SNAPSHOT ((SupervisorSnapshot*)(uintptr_t)BKPSRAM_BASE)
+
+typedef struct {
+    const char* name;
+    uint32_t budget_ms;
+    uint32_t last_ms;           // Last check-in (low 32 bits of the timebase)
+    uint32_t worst_ms;          // Longest time between two check-ins
+    uint32_t misses;            // Budgets missed (once per late episode)
+    uint8_t late;
+}SupervisorTask;
+
+static SupervisorTask tasks[SUPERVISOR_MAX_TASKS];
+static uint32_t task_count = 0;
+
+// Current pass (read by the WWDG interrupt)
+static volatile uint32_t pass_depth = 0;
+static volatile uint64_t pass_start_us = 0;
+static volatile uint64_t pass_end_us = 0;
+static uint8_t wwdg_pending = 0;     // SUPERVISOR_INIT() ran, the WWDG waits for a pass
+
+static uint32_t histogram[SUPERVISOR_HIST_BUCKETS];
+static uint32_t passes = 0;
+static uint32_t worst_pass_us = 0;
+
+// Snapshot the previous boot left, and whether this boot wrote one yet
+static SupervisorSnapshot last_snapshot;
+static uint8_t have_last_snapshot = 0;
+static uint8_t snapshot_taken = 0;
+
+static SWTimer kick_timer;
+
+// Writes the snapshot to backup SRAM (thread or WWDG interrupt)
+static void SUPERVISOR_capture(SupervisorMiss reason, uint32_t task, uint32_t pass_us) {
+    SupervisorSnapshot* snap = SUPERVISOR_SNAPSHOT;
+    uint32_t now_ms = (uint32_t)TIMEBASE_now_ms();
+
+    snap->reason = reason;
+    snap->task = task;
+    snap->time_ms = now_ms;
+    snap->pass_us = pass_us;
+    snap->worst_pass_us = worst_pass_us;
+    snap->passes = passes;
+    snap->sysclk_hz = CLOCK_get_sysclk();
+    for (uint32_t i = 0; i < SUPERVISOR_MAX_TASKS; i++) {
+        snap->task_age_ms[i] = (i < task_count) ? (now_ms - tasks[i].last_ms) : 0;
+    }
+
+    // Magic last, so a reset halfway leaves no valid snapshot
+    __DMB();
+    snap->magic = SUPERVISOR_SNAPSHOT_MAGIC;
+    __DSB();
+    snapshot_taken = 1;
+}
+
+// Kicks the IWDG only while every task is on time
+static void SUPERVISOR_kick(void* arg) {
+    (void)arg;
+    if (SUPERVISOR_healthy()) {
+        WDT_kick();
+        return;
+    }
+    if (!snapshot_taken) {
+        for (uint32_t i = 0; i < task_count; i++) {
+            if (tasks[i].late) {
+                SUPERVISOR_capture(SUPERVISOR_MISS_TASK, i, 0);
+                break;
+            }
+        }
+    }
+}
+
+// === PUBLIC FUNCTIONS ===
+
+void SUPERVISOR_INIT(void) {
+    // 1. Backup SRAM (clocked by BOARD_INIT) is behind the DBP write protection
+    PWR->CR |= (1 << 8);                // DBP
+
+    // 2. Keep what the previous boot left, then invalidate it
+    SupervisorSnapshot* snap = SUPERVISOR_SNAPSHOT;
+    have_last_snapshot = (snap->magic == SUPERVISOR_SNAPSHOT_MAGIC) ? 1 : 0;
+    if (have_last_snapshot) {
+        last_snapshot = *snap;
+    }
+    snap->magic = 0;
+    snapshot_taken = 0;
+
+    // 3. Statistics
+    for (uint32_t i = 0; i < SUPERVISOR_HIST_BUCKETS; i++) {
+        histogram[i] = 0;
+    }
+    passes = 0;
+    worst_pass_us = 0;
+    pass_depth = 0;
+    pass_end_us = TIMEBASE_now_us();
+
+    // 4. The window watchdog starts with the first pass (init may still block)
+    wwdg_pending = 1;
+
+    // 5. The IWDG kick now depends on the tasks
+    WDT_kick();
+    SWTIMER_start(&kick_timer, SUPERVISOR_KICK_MS, SUPERVISOR_KICK_MS, SUPERVISOR_kick, 0);
+}
+
+uint8_t SUPERVISOR_register(const char* name, uint32_t budget_ms) {
+    if (task_count >= SUPERVISOR_MAX_TASKS) {
+        return SUPERVISOR_NO_TASK;
+    }
+    SupervisorTask* task = &tasks[task_count];
+    task->name = name;
+    task->budget_ms = budget_ms;
+    task->last_ms = (uint32_t)TIMEBASE_now_ms();
+    task->worst_ms = 0;
+    task->misses = 0;
+    task->late = 0;
+    return (uint8_t)task_count++;
+}
+
+void SUPERVISOR_checkin(uint8_t handle) {
+    if (handle >= task_count) {
+        return;
+    }
+    SupervisorTask* task = &tasks[handle];
+    uint32_t now_ms = (uint32_t)TIMEBASE_now_ms();
+    uint32_t interval = now_ms - task->last_ms;
+
+    if (interval > task->worst_ms) {
+        task->worst_ms = interval;
+    }
+    task->last_ms = now_ms;
+    task->late = 0;
+}
+
+void SUPERVISOR_pass_begin(void) {
+    if (wwdg_pending) {
+        WWDG_start(SUPERVISOR_LOOP_BUDGET_MS * 1000U);     // Checked at least once per budget
+        wwdg_pending = 0;
+    }
+    if (pass_depth == 0) {
+        pass_start_us = TIMEBASE_now_us();
+    }
+    pass_depth++;
+}
+
+void SUPERVISOR_pass_end(void) {
+    if ((pass_depth == 0) || (--pass_depth != 0)) {
+        return;
+    }
+    uint64_t now_us = TIMEBASE_now_us();
+    uint64_t elapsed = now_us - pass_start_us;
+    uint32_t pass_us = (elapsed > 0xFFFFFFFFU) ? 0xFFFFFFFFU : (uint32_t)elapsed;
+
+    // Bucket = bit length of the time: 0 us in 0, 1 us in 1, 2-3 us in 2, ...
+    uint32_t bucket = 32U - __CLZ(pass_us);
+    if (bucket >= SUPERVISOR_HIST_BUCKETS) {
+        bucket = SUPERVISOR_HIST_BUCKETS - 1U;
+    }
+    histogram[bucket]++;
+    passes++;
+    if (pass_us > worst_pass_us) {
+        worst_pass_us = pass_us;
+    }
+
+    pass_end_us = now_us;
+    WWDG_refresh();
+}
+
+uint8_t SUPERVISOR_healthy(void) {
+    uint32_t now_ms = (uint32_t)TIMEBASE_now_ms();
+    uint8_t healthy = 1;
+
+    for (uint32_t i = 0; i < task_count; i++) {
+        SupervisorTask* task = &tasks[i];
+        uint32_t age = now_ms - task->last_ms;
+        if (age > task->budget_ms) {
+            if (!task->late) {
+                task->late = 1;
+                task->misses++;
+            }
+            if (age > task->worst_ms) {
+                task->worst_ms = age;
+            }
+            healthy = 0;
+        }
+    }
+    return healthy;
+}
+
+void SUPERVISOR_get_stats(SupervisorStats* stats) {
+    // Pass count at or below each percentile, rounded up
+    uint32_t p50 = (passes * 50U + 99U) / 100U;
+    uint32_t p90 = (passes * 90U + 99U) / 100U;
+    uint32_t p99 = (passes * 99U + 99U) / 100U;
+    uint32_t seen = 0;
+
+    stats->passes = passes;
+    stats->worst_us = worst_pass_us;
+    stats->p50_us = stats->p90_us = stats->p99_us = 0;
+
+    for (uint32_t i = 0; i < SUPERVISOR_HIST_BUCKETS; i++) {
+        if (histogram[i] == 0) {
+            continue;
+        }
+        seen += histogram[i];
+        // Upper bound of the bucket, but never above the worst pass
+        uint32_t bound = (i == 0) ? 0U : ((1UL << i) - 1U);
+        if ((bound > worst_pass_us) || (i == SUPERVISOR_HIST_BUCKETS - 1U)) {
+            bound = worst_pass_us;
+        }
+        if ((stats->p50_us == 0) && (seen >= p50)) {
+            stats->p50_us = bound;
+        }
+        if ((stats->p90_us == 0) && (seen >= p90)) {
+            stats->p90_us = bound;
+        }
+        if ((stats->p99_us == 0) && (seen >= p99)) {
+            stats->p99_us = bound;
+        }
+    }
+}
+
+uint8_t SUPERVISOR_get_snapshot(SupervisorSnapshot* snapshot) {
+    if (!have_last_snapshot) {
+        return 0;
+    }
+    *snapshot = last_snapshot;
+    return 1;
+}
+
+void SUPERVISOR_report(void) {
+    char buffer[128];
+    SupervisorStats s;
+
+    SUPERVISOR_get_stats(&s);
+    USART2_write((char*)"--- supervisor (us) ---\r\n");
+    sprintf(buffer, "loop: %lu passes, p50 <= %lu, p90 <= %lu, p99 <= %lu, worst %lu\r\n",
+            (unsigned long)s.passes, (unsigned long)s.p50_us, (unsigned long)s.p90_us,
+            (unsigned long)s.p99_us, (unsigned long)s.worst_us);
+    USART2_write(buffer);
+    sprintf(buffer, "budget %lu ms, WWDG timeout %lu us\r\n",
+            (unsigned long)SUPERVISOR_LOOP_BUDGET_MS, (unsigned long)WWDG_get_timeout_us());
+    USART2_write(buffer);
+
+    for (uint32_t i = 0; i < task_count; i++) {
+        sprintf(buffer, "task %-10.10s worst %lu ms of %lu, %lu misses\r\n", tasks[i].name,
+                (unsigned long)tasks[i].worst_ms, (unsigned long)tasks[i].budget_ms,
+                (unsigned long)tasks[i].misses);
+        USART2_write(buffer);
+    }
+
+    if (!have_last_snapshot) {
+        USART2_write((char*)"last boot: no miss\r\n");
+        return;
+    }
+    if (last_snapshot.reason == SUPERVISOR_MISS_LOOP) {
+        sprintf(buffer, "last boot: loop pass over budget at %lu ms (%lu us, worst before %lu)\r\n",
+                (unsigned long)last_snapshot.time_ms, (unsigned long)last_snapshot.pass_us,
+                (unsigned long)last_snapshot.worst_pass_us);
+    } else if (last_snapshot.reason == SUPERVISOR_MISS_STALL) {
+        sprintf(buffer, "last boot: stuck between passes at %lu ms (%lu us since the last one)\r\n",
+                (unsigned long)last_snapshot.time_ms, (unsigned long)last_snapshot.pass_us);
+    } else {
+        const char* name = (last_snapshot.task < task_count) ? tasks[last_snapshot.task].name : "?";
+        sprintf(buffer, "last boot: task %.10s late at %lu ms (%lu ms since check-in)\r\n",
+                name, (unsigned long)last_snapshot.time_ms,
+                (unsigned long)last_snapshot.task_age_ms[last_snapshot.task % SUPERVISOR_MAX_TASKS]);
+    }
+    USART2_write(buffer);
+}
+
+// IRQ handler: early warning, one WWDG count before the reset
+void WWDG_IRQHandler(void) {
+    WWDG_clear_warning();
+
+    // Pass inside its budget (longer than the WWDG timeout): keep the WWDG going
+    uint64_t now_us = TIMEBASE_now_us();
+    uint64_t age_us = now_us - (pass_depth ? pass_start_us : pass_end_us);
+    if (pass_depth && (age_us < (uint64_t)SUPERVISOR_LOOP_BUDGET_MS * 1000U)) {
+        WWDG_refresh();
+        return;
+    }
+
+    // Stuck pass, or stuck between passes (POWER_idle() wakes the loop before
+    // this fires): record it and let the reset happen
+    SUPERVISOR_capture(pass_depth ? SUPERVISOR_MISS_LOOP : SUPERVISOR_MISS_STALL, SUPERVISOR_NO_TASK,
+                       (age_us > 0xFFFFFFFFU) ? 0xFFFFFFFFU : (uint32_t)age_us);
+}
@@ -0,0 +1,182 @@
+/*
+* filename: swtimer.c
+* purpose: implementation of the hashed software timer wheel
+* author: Connor Ockerse
+* date: 10/19/2026
+*/
+
+#include "swtimer.h"
+#include "timebase.h"
+#include "profile.h"
+
+#define SWTIMER_SLOT_MASK (SWTIMER_WHEEL_SLOTS - 1U)
+
+// Each bucket is a doubly linked list of timers whose deadline hashes to it
+static SWTimer* wheel[SWTIMER_WHEEL_SLOTS];
+
+// Last millisecond whose bucket has been processed
+static uint64_t wheel_ms = 0;
+static uint8_t wheel_started = 0;
+
+// Guards against SWTIMER_process being re-entered from a callback
+static uint8_t processing = 0;
+
+// === PRIVATE HELPERS (call with interrupts masked) ===
+
+static void SWTIMER_link(SWTimer* timer) {
+    SWTimer** head = &wheel[timer->expiry_ms & SWTIMER_SLOT_MASK];
+    timer->prev = 0;
+    timer->next = *head;
+    if (*head) {
+        (*head)->prev = timer;
+    }
+    *head = timer;
+    timer->active = 1;
+}
+
+static void SWTIMER_unlink(SWTimer* timer) {
+    if (timer->prev) {
+        timer->prev->next = timer->next;
+    } else {
+        wheel[timer->expiry_ms & SWTIMER_SLOT_MASK] = timer->next;
+    }
+    if (timer->next) {
+        timer->next->prev = timer->prev;
+    }
+    timer->next = 0;
+    timer->prev = 0;
+    timer->active = 0;
+}
+
+// === PUBLIC FUNCTIONS ===
+
+void SWTIMER_start(SWTimer* timer, uint32_t delay_ms, uint32_t period_ms,
+                   SWTimerCallback callback, void* arg) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uint64_t now = TIMEBASE_now_ms();
+    if (!wheel_started) {
+        wheel_ms = now;
+        wheel_started = 1;
+    }
+
+    if (timer->active) {
+        SWTIMER_unlink(timer);
+    }
+
+    timer->callback = callback;
+    timer->arg = arg;
+    timer->period_ms = period_ms;
+    timer->expiry_ms = now + delay_ms;
+
+    // Buckets up to wheel_ms were already visited: push the deadline to the
+    // next bucket so it is not left waiting a whole revolution
+    if (timer->expiry_ms <= wheel_ms) {
+        timer->expiry_ms = wheel_ms + 1;
+    }
+
+    SWTIMER_link(timer);
+    __set_PRIMASK(primask);
+}
+
+void SWTIMER_cancel(SWTimer* timer) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (timer->active) {
+        SWTIMER_unlink(timer);
+    }
+    __set_PRIMASK(primask);
+}
+
+uint8_t SWTIMER_is_active(SWTimer* timer) {
+    return timer->active;
+}
+
+uint32_t SWTIMER_process(void) {
+    uint32_t fired = 0;
+
+    if (processing || !wheel_started) {
+        return 0;
+    }
+    processing = 1;
+    PROFILE_BEGIN(PROFILE_TIMERS);
+
+    uint64_t now = TIMEBASE_now_ms();
+
+    // Visit every bucket between the last pass and now (at most one revolution)
+    uint64_t span = now - wheel_ms;
+    if (span > SWTIMER_WHEEL_SLOTS) {
+        span = SWTIMER_WHEEL_SLOTS;
+    }
+
+    for (uint64_t ms = now - span + 1; ms <= now; ms++) {
+        uint32_t slot = (uint32_t)(ms & SWTIMER_SLOT_MASK);
+
+        // Mark the bucket visited first: a timer restarted with delay 0 from
+        // a callback lands in the next bucket instead of looping here forever
+        wheel_ms = ms;
+
+        // Pull due timers off the bucket one at a time so callbacks are free
+        // to start/cancel any timer (including this one) while they run
+        for (;;) {
+            uint32_t primask = __get_PRIMASK();
+            __disable_irq();
+
+            SWTimer* timer = wheel[slot];
+            while (timer && timer->expiry_ms > now) {
+                timer = timer->next;    // Due on a later revolution
+            }
+            if (timer == 0) {
+                __set_PRIMASK(primask);
+                break;
+            }
+
+            SWTIMER_unlink(timer);
+            if (timer->period_ms) {
+                // Keep the period drift-free, skip periods we fell behind on
+                timer->expiry_ms += timer->period_ms;
+                if (timer->expiry_ms <= now) {
+                    timer->expiry_ms = now + timer->period_ms;
+                }
+                SWTIMER_link(timer);
+            }
+            SWTimerCallback callback = timer->callback;
+            void* arg = timer->arg;
+            __set_PRIMASK(primask);
+
+            callback(arg);
+            fired++;
+        }
+    }
+
+    // Only passes that did work are interesting
+    if (fired) {
+        PROFILE_END(PROFILE_TIMERS);
+    }
+
+    processing = 0;
+    return fired;
+}
+
+uint8_t SWTIMER_next_deadline(uint64_t* deadline_ms) {
+    uint8_t found = 0;
+    uint64_t earliest = 0;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (uint32_t slot = 0; slot < SWTIMER_WHEEL_SLOTS; slot++) {
+        for (SWTimer* timer = wheel[slot]; timer; timer = timer->next) {
+            if (!found || timer->expiry_ms < earliest) {
+                earliest = timer->expiry_ms;
+                found = 1;
+            }
+        }
+    }
+    __set_PRIMASK(primask);
+
+    if (found) {
+        *deadline_ms = earliest;
+    }
+    return found;
+}
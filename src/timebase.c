@@ -0,0 +1,130 @@
+/*
+* filename: timebase.c
+* purpose: implementation of the monotonic 64-bit microsecond timebase
+* author: Connor Ockerse
+* date: 10/19/2026
+*/
+
+#include "timebase.h"
+#include "RccConfig.h" // Needed for CLOCK_get_apb1_timer_clock
+#include "profile.h"
+
+// === TIM5 FREE-RUNNING 32-BIT COUNTER ===
+
+// 1 us tick, exact at every SYSCLK the clock profiles use
+#define TIMEBASE_TICK_HZ 1000000U
+#define TIMEBASE_CLOCK_CHECK(sysclk) CLOCK_ASSERT_TIMER(CLOCK_APB1_TIMER_HZ(sysclk), TIMEBASE_TICK_HZ, 0);
+CLOCK_SYSCLK_LIST(TIMEBASE_CLOCK_CHECK)
+
+// Number of TIM5 wraps since boot (1 wrap = 2^32 us)
+static volatile uint32_t overflow_count = 0;
+
+// Keeps the 1 us tick across clock changes (the count carries on)
+static void TIMEBASE_reclock(ClockEvent event) {
+    if (event == CLOCK_POST_CHANGE) {
+        CLOCK_timer_set_prescaler(TIM5, CLOCK_TIMER_PSC(CLOCK_get_apb1_timer_clock(), TIMEBASE_TICK_HZ));
+    }
+}
+
+void TIMEBASE_INIT(void) {
+    // 1. TIM5 clock comes from BOARD_INIT
+
+    // 2. 1 MHz tick (1 microsecond), full 32-bit range
+    TIM5->CR1 = 0;
+    TIM5->PSC = CLOCK_TIMER_PSC(CLOCK_get_apb1_timer_clock(), TIMEBASE_TICK_HZ);
+    TIM5->ARR = 0xFFFFFFFF;
+
+    // 3. Load PSC now (UG) and drop the flag it raises
+    TIM5->EGR |= (1 << 0);
+    TIM5->SR = 0;
+    TIM5->CNT = 0;
+
+    // 4. Only the wrap interrupt is on; CC1 is armed on demand for wakeups
+    TIM5->DIER = (1 << 0);              // UIE
+    NVIC_EnableIRQ(TIM5_IRQn);
+
+    // 5. Start
+    TIM5->CR1 |= (1 << 0);              // CEN
+    CLOCK_register(TIMEBASE_reclock);
+}
+
+uint64_t TIMEBASE_now_us(void) {
+    uint32_t hi, cnt, pending;
+
+    // Retry if the wrap interrupt ran while we were reading
+    do {
+        hi = overflow_count;
+        cnt = TIM5->CNT;                // Read counter BEFORE the flag
+        pending = TIM5->SR & (1 << 0);  // UIF: wrap not yet serviced
+    } while (hi != overflow_count);
+
+    // Wrapped but not serviced yet (higher priority ISR / interrupts masked)
+    if (pending && (cnt < 0x80000000U)) {
+        hi++;
+    }
+
+    return ((uint64_t)hi << 32) | cnt;
+}
+
+uint64_t TIMEBASE_now_ms(void) {
+    return TIMEBASE_now_us() / 1000U;
+}
+
+void TIMEBASE_set_wakeup(uint64_t deadline_us) {
+    // Only the low 32 bits can be compared; a deadline further out than one
+    // wrap is still caught because the wrap interrupt wakes the core too
+    TIM5->DIER &= ~(1 << 1);            // CC1IE off while re-arming
+    TIM5->CCR1 = (uint32_t)deadline_us;
+    TIM5->SR = ~(1 << 1);               // Clear CC1IF (rc_w0: write 0 only to it)
+    TIM5->DIER |= (1 << 1);             // CC1IE on
+
+    // Counter may already be past the compare value: fire immediately
+    if (TIMEBASE_now_us() >= deadline_us) {
+        TIM5->EGR = (1 << 1);           // CC1G
+    }
+}
+
+void TIMEBASE_advance_us(uint64_t us) {
+    // The count moves on between the read and the write: ~1 us lost
+    uint64_t total = (uint64_t)TIM5->CNT + us;
+    overflow_count += (uint32_t)(total >> 32);
+    TIM5->CNT = (uint32_t)total;
+}
+
+void TIM5_IRQHandler(void) {
+    PROFILE_BEGIN(PROFILE_ISR_TIM5);
+    uint32_t sr = TIM5->SR;
+
+    if (sr & (1 << 0)) {
+        // Clear UIF and count the wrap as one step for ISR readers
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        TIM5->SR = ~(1 << 0);
+        overflow_count++;
+        __set_PRIMASK(primask);
+    }
+
+    if (sr & (1 << 1)) {
+        // Latency: 1 us ticks since the compare matched
+        PROFILE_LATENCY_US_TICKS(PROFILE_ISR_TIM5, TIM5->CNT - TIM5->CCR1);
+
+        // Wakeup deadline reached: the interrupt itself ended the WFI
+        TIM5->SR = ~(1 << 1);
+        TIM5->DIER &= ~(1 << 1);        // One-shot
+    }
+
+    PROFILE_END(PROFILE_ISR_TIM5);
+}
+
+void TIMEBASE_sleep_until(uint64_t deadline_us) {
+    while (TIMEBASE_now_us() < deadline_us) {
+        // Mask so the wakeup can't fire between the check and the WFI
+        __disable_irq();
+        TIMEBASE_set_wakeup(deadline_us);
+        if (TIMEBASE_now_us() < deadline_us) {
+            __DSB();
+            __WFI();
+        }
+        __enable_irq();
+    }
+}
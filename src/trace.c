@@ -0,0 +1,108 @@
+/*
+* filename: trace.c
+* purpose: implementation of sensor trace capture over USART2
+* author: Connor Ockerse
+* date: 10/19/2026
+*/
+
+#include "trace.h"
+
+#if TRACE_ENABLE
+
+#include "usart.h"
+#include "timebase.h"
+#include "swtimer.h"
+
+#define TRACE_QUEUE_MASK (TRACE_QUEUE_SIZE - 1U)
+
+// One queued record
+typedef struct {
+    uint64_t time_us;
+    uint32_t value;
+    uint8_t source;
+}TraceRecord;
+
+static TraceRecord queue[TRACE_QUEUE_SIZE];
+static volatile uint32_t queue_head = 0;    // Next slot to fill
+static volatile uint32_t queue_tail = 0;    // Next slot to send
+static volatile uint32_t dropped = 0;       // Lost since the last flush
+
+static uint64_t last_time_us = 0;           // Timestamp of the last record sent
+static SWTimer flush_timer;
+
+// Sends an unsigned LEB128 varint (1 byte below 128, 5 at most for 32 bits)
+static void TRACE_write_varint(uint64_t value) {
+    while (value >= 0x80U) {
+        USART2_write_char((uint8_t)(value | 0x80U));
+        value >>= 7;
+    }
+    USART2_write_char((uint8_t)value);
+}
+
+static void TRACE_write_record(uint8_t source, uint64_t time_us, uint32_t value) {
+    // Records are queued in time order, but never send a negative delta
+    uint64_t delta = (time_us > last_time_us) ? (time_us - last_time_us) : 0;
+    last_time_us += delta;
+
+    USART2_write_char((uint8_t)(TRACE_TAG | source));
+    TRACE_write_varint(delta);
+    TRACE_write_varint(value);
+}
+
+static void TRACE_flush_expired(void* arg) {
+    (void)arg;
+    TRACE_flush();
+}
+
+// === PUBLIC FUNCTIONS ===
+
+void TRACE_INIT(void) {
+    queue_head = 0;
+    queue_tail = 0;
+    dropped = 0;
+    last_time_us = TIMEBASE_now_us();
+
+    USART_INIT();
+    USART2_write((char*)TRACE_MAGIC);
+    SWTIMER_start(&flush_timer, TRACE_FLUSH_MS, TRACE_FLUSH_MS, TRACE_flush_expired, 0);
+}
+
+void TRACE_record(TraceSource source, uint32_t value) {
+    // ISRs of any priority can record: claim the slot with interrupts off
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if ((queue_head - queue_tail) >= TRACE_QUEUE_SIZE) {
+        dropped++;
+    } else {
+        TraceRecord* record = &queue[queue_head & TRACE_QUEUE_MASK];
+        record->time_us = TIMEBASE_now_us();
+        record->value = value;
+        record->source = (uint8_t)source;
+        queue_head++;
+    }
+
+    __set_PRIMASK(primask);
+}
+
+void TRACE_flush(void) {
+    // 1. Send what is queued; new records may arrive while we write
+    while (queue_tail != queue_head) {
+        TraceRecord record = queue[queue_tail & TRACE_QUEUE_MASK];
+        queue_tail++;
+        TRACE_write_record(record.source, record.time_us, record.value);
+    }
+
+    // 2. Tell the reader about any gap, stamped with the flush time
+    if (dropped) {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        uint32_t lost = dropped;
+        dropped = 0;
+        __set_PRIMASK(primask);
+
+        TRACE_write_record(TRACE_DROPPED, TIMEBASE_now_us(), lost);
+    }
+}
+
+#endif
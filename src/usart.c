@@ -6,36 +6,50 @@
 */
 
 #include "usart.h"
-#include "RccConfig.h" // <--- Added to get CLOCK_FREQUENCY
+#include "RccConfig.h" // <--- Added to get CLOCK_get_pclk1
+#include "spinwait.h"
+#include "crc.h"
+#include <string.h> // For strlen
 
+// Baud rate within 1% (half of what a receiver tolerates) at every SYSCLK
+#define USART_BAUD_MAX_PPM 10000U
+#define USART_CLOCK_CHECK(sysclk) CLOCK_ASSERT_USART(CLOCK_PCLK1_HZ(sysclk), BAUD_RATE, USART_BAUD_MAX_PPM);
+CLOCK_SYSCLK_LIST(USART_CLOCK_CHECK)
 
+// BRR for the current PCLK1, rounded to the nearest integer
+static uint32_t USART_brr(void){
+    return CLOCK_USART_BRR(CLOCK_get_pclk1(), BAUD_RATE);
+}
+
+// Lets the frame in flight finish at the old rate, then retunes the baud rate
+static void USART_reclock(ClockEvent event){
+    if (event == CLOCK_PRE_CHANGE) {
+        SPIN_WHILE(SPIN_USART_TC, !(USART2->SR & 0x0040));
+    } else {
+        USART2->BRR = USART_brr();
+    }
+}
 
 // USART initialization function
 void USART_INIT(void){
-    // 1. Enable Clocks
-    RCC->AHB1ENR |= 1;             // Enable GPIOA clock
-    RCC->APB1ENR |= 0x20000;       // Enable USART2 clock
+    // 1. USART2 clock and PA2 (AF7, USART2_TX) come from BOARD_INIT
 
-    // 2. Configure PA2 as Alternate Function (USART2_TX)
-    GPIOA->AFR[0] |= 0x0700;       // Set PA2 to AF7
-    GPIOA->MODER |= 0x0020;        // Set PA2 to Alternate Function Mode
-    
-    // 3. Configure Baud Rate Dynamically
+    // 2. Configure Baud Rate Dynamically
     // Formula: BRR = APB1_Clock / Baud_Rate
     // We add (BAUD_RATE / 2) to round to the nearest integer
-    uint32_t brr_val = (CLOCK_FREQUENCY + (BAUD_RATE / 2)) / BAUD_RATE;
-    USART2->BRR = brr_val;          
+    USART2->BRR = USART_brr();
     
-    // 4. Configure Control Registers
+    // 3. Configure Control Registers
     USART2->CR1 = 0x0008;          // Enable Transmitter (TE)
     USART2->CR2 = 0x0000;          // 1 Stop bit
     USART2->CR3 = 0x0000;          // No flow control
     USART2->CR1 |= 0x2000;         // Enable USART (UE)
+    CLOCK_register(USART_reclock);
 }
 
 // Send char over UART
 void USART2_write_char (uint8_t ch){
-    while(!(USART2->SR & 0x0080)) {} 
+    SPIN_WHILE(SPIN_USART_TXE, !(USART2->SR & 0x0080));
     USART2->DR = (ch & 0xFF);
 }
 
@@ -44,4 +58,17 @@ void USART2_write(char *line){
     for(uint8_t u8_string_inc = 0; line[u8_string_inc] != '\0'; u8_string_inc++){
         USART2_write_char(line[u8_string_inc]);
     }
-}
\ No newline at end of file
+}
+
+// Print a line with its CRC-32 appended
+void USART2_write_frame(char *line){
+    static const char hex[] = "0123456789ABCDEF";
+    uint32_t crc = CRC_bytes((const uint8_t*)line, (uint32_t)strlen(line));
+
+    USART2_write(line);
+    USART2_write((char*)" *");
+    for (int8_t shift = 28; shift >= 0; shift -= 4){
+        USART2_write_char((uint8_t)hex[(crc >> shift) & 0xF]);
+    }
+    USART2_write((char*)"\r\n");
+}
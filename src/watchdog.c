@@ -6,8 +6,19 @@
 */
 
 #include "watchdog.h"
+#include "spinwait.h"
+#include "RccConfig.h" // Needed for CLOCK_get_pclk1
+
+// Requested WWDG timeout and the counter value that gives it
+static uint32_t wwdg_timeout_us = 0;
+static uint8_t wwdg_reload = 0;
 
 void WDT_INIT(void) {
+    WDT_start();
+    WDT_wait_ready();
+}
+
+void WDT_start(void) {
     // 1. Enable IWDG (Starts the LSI clock automatically)
     // Write 0xCCCC to Key Register (KR)
     IWDG->KR = 0xCCCC;
@@ -27,11 +38,13 @@ void WDT_INIT(void) {
     uint32_t reload_val = WDT_TIMEOUT_MS / 8;
     
     IWDG->RLR = reload_val;
+}
 
+void WDT_wait_ready(void) {
     // 5. Wait for flags to clear (Hardware requires this)
     // SR Bit 1: PVU (Prescaler Value Update)
     // SR Bit 0: RVU (Reload Value Update)
-    while (IWDG->SR & 0x03); 
+    SPIN_WHILE(SPIN_IWDG_SR, IWDG->SR & 0x03);
 
     // 6. Initial Kick (Reloads counter with RLR value)
     IWDG->KR = 0xAAAA;
@@ -41,3 +54,68 @@ void WDT_kick(void) {
     // Write 0xAAAA to reload the counter
     IWDG->KR = 0xAAAA;
 }
+
+// === WINDOW WATCHDOG ===
+
+// Microseconds per WWDG count at the current PCLK1
+static uint32_t WWDG_count_us(void) {
+    uint64_t cycles = (uint64_t)4096U << WWDG_PRESCALER_SHIFT;
+    return (uint32_t)((cycles * 1000000U) / CLOCK_get_pclk1());
+}
+
+// Counter value for wwdg_timeout_us at the current PCLK1
+static uint8_t WWDG_compute_reload(void) {
+    uint32_t counts = wwdg_timeout_us / WWDG_count_us();
+    if (counts < 1U) {
+        counts = 1U;
+    } else if (counts > WWDG_MAX_COUNTS) {
+        counts = WWDG_MAX_COUNTS;
+    }
+    return (uint8_t)(0x3FU + counts);
+}
+
+// Keeps the timeout across clock changes (refreshed with the new count)
+static void WWDG_reclock(ClockEvent event) {
+    if (event == CLOCK_POST_CHANGE) {
+        wwdg_reload = WWDG_compute_reload();
+        WWDG_refresh();
+    }
+}
+
+void WWDG_start(uint32_t timeout_us) {
+    // 1. WWDG clock comes from BOARD_INIT
+    wwdg_timeout_us = timeout_us;
+    wwdg_reload = WWDG_compute_reload();
+
+    // 2. Early wakeup interrupt, PCLK1/4096/8, window open all the way (W = 0x7F)
+    WWDG->CFR = (1 << 9) | (WWDG_PRESCALER_SHIFT << 7) | 0x7F;
+    WWDG->SR = 0;
+    NVIC_EnableIRQ(WWDG_IRQn);
+
+    // 3. Load the counter and start (WDGA can't be cleared again)
+    WWDG->CR = (1 << 7) | wwdg_reload;
+    CLOCK_register(WWDG_reclock);
+}
+
+void WWDG_refresh(void) {
+    // T[6:0] only: WDGA = 0 is ignored once running and starts nothing otherwise
+    if (wwdg_reload) {
+        WWDG->CR = wwdg_reload;
+    }
+}
+
+void WWDG_clear_warning(void) {
+    WWDG->SR = 0;       // EWIF: rc_w0
+}
+
+uint32_t WWDG_get_timeout_us(void) {
+    return wwdg_reload ? ((uint32_t)(wwdg_reload - 0x3FU) * WWDG_count_us()) : 0U;
+}
+
+uint32_t WWDG_get_remaining_us(void) {
+    if (!wwdg_reload) {
+        return 0U;
+    }
+    uint32_t count = WWDG->CR & 0x7FU;
+    return (count > 0x40U) ? ((count - 0x40U) * WWDG_count_us()) : 0U;
+}
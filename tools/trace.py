@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+"""
+filename: trace.py
+purpose: Converts sensor captures (header/trace.h) to CSV and back
+author: Connor Ockerse
+date: 10/19/2026
+
+Usage:
+    stty -F /dev/ttyACM0 9600 raw && cat /dev/ttyACM0 > capture.bin
+    python3 tools/trace.py decode capture.bin > capture.csv
+    python3 tools/trace.py encode edited.csv edited.bin
+    ./sim/build/sim_replay edited.bin
+
+CSV columns are time_us (since TRACE_INIT), source and value, one record
+per line. Sources are sonar, adc, encoder, button and dropped. Text the
+firmware printed between records is skipped when decoding. Encoding writes
+the same stream the firmware sends, so a hand-edited or synthetic CSV can
+be replayed like a real capture.
+"""
+
+import argparse
+import csv
+import sys
+
+MAGIC = b"TRC1"
+TAG = 0xA0
+SOURCES = ["sonar", "adc", "encoder", "button", "dropped"]
+
+
+def read_varint(data, pos):
+    """Returns (value, next position) or (None, pos) if the data ran out."""
+    value = 0
+    shift = 0
+    while pos < len(data):
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return value, pos
+        shift += 7
+    return None, pos
+
+
+def write_varint(value):
+    out = bytearray()
+    while value >= 0x80:
+        out.append((value & 0x7F) | 0x80)
+        value >>= 7
+    out.append(value)
+    return out
+
+
+def decode(data):
+    """Yields (time_us, source name, value) for every record in a capture."""
+    start = data.find(MAGIC)
+    if start < 0:
+        sys.exit("error: no %s marker in the capture" % MAGIC.decode())
+    pos = start + len(MAGIC)
+    time_us = 0
+    while pos < len(data):
+        tag = data[pos]
+        pos += 1
+        if (tag & 0xF0) != TAG or (tag & 0x0F) >= len(SOURCES):
+            continue  # Text printed between records
+        delta, pos = read_varint(data, pos)
+        value, pos = read_varint(data, pos) if delta is not None else (None, pos)
+        if value is None:
+            break  # Capture cut off mid-record
+        time_us += delta
+        yield time_us, SOURCES[tag & 0x0F], value
+
+
+def encode(rows):
+    out = bytearray(MAGIC)
+    last = 0
+    for time_us, source, value in rows:
+        if time_us < last:
+            sys.exit("error: records must be in time order (%d after %d)" % (time_us, last))
+        out.append(TAG | SOURCES.index(source))
+        out += write_varint(time_us - last)
+        out += write_varint(value)
+        last = time_us
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command", required=True)
+    dec = sub.add_parser("decode", help="capture -> CSV on stdout")
+    dec.add_argument("capture")
+    enc = sub.add_parser("encode", help="CSV -> capture")
+    enc.add_argument("csv")
+    enc.add_argument("capture")
+    args = parser.parse_args()
+
+    if args.command == "decode":
+        with open(args.capture, "rb") as f:
+            data = f.read()
+        writer = csv.writer(sys.stdout, lineterminator="\n")
+        writer.writerow(["time_us", "source", "value"])
+        for row in decode(data):
+            writer.writerow(row)
+    else:
+        rows = []
+        with open(args.csv, newline="") as f:
+            for row in csv.DictReader(f):
+                if row["source"] not in SOURCES:
+                    sys.exit("error: unknown source '%s'" % row["source"])
+                rows.append((int(row["time_us"]), row["source"], int(row["value"])))
+        with open(args.capture, "wb") as f:
+            f.write(encode(rows))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+"""
+filename: wav2c.py
+purpose: Converts a WAV file into an 8-bit PCM C array for BUZZER_pcm_play()
+author: Connor Ockerse
+date: 10/19/2026
+
+Usage:
+    python3 tools/wav2c.py alert.wav header/alert_clip.h --name alert --rate 8000
+
+Accepts 8/16/24/32-bit PCM WAV files (mono or stereo). Channels are mixed
+down to mono, resampled (linear interpolation) to --rate and quantized to
+unsigned 8-bit samples centered on 0x80, which is what the TIM1 PWM-DAC
+expects in CCR1. The output header defines:
+
+    <NAME>_RATE    sample rate in Hz
+    <NAME>_LENGTH  number of samples
+    <name>_clip[]  const uint8_t samples (placed in flash)
+"""
+
+import argparse
+import os
+import sys
+import wave
+
+
+def read_wav(path):
+    """Returns (samples as floats in -1.0..1.0 mono, sample rate)."""
+    with wave.open(path, "rb") as wav:
+        channels = wav.getnchannels()
+        width = wav.getsampwidth()
+        rate = wav.getframerate()
+        if wav.getcomptype() != "NONE":
+            sys.exit("error: only uncompressed PCM WAV files are supported")
+        raw = wav.readframes(wav.getnframes())
+
+    frame_bytes = channels * width
+    mono = []
+    for offset in range(0, len(raw) - frame_bytes + 1, frame_bytes):
+        total = 0.0
+        for ch in range(channels):
+            start = offset + ch * width
+            chunk = raw[start:start + width]
+            if width == 1:
+                # 8-bit WAV data is unsigned
+                value = (chunk[0] - 128) / 128.0
+            else:
+                full_scale = float(1 << (8 * width - 1))
+                value = int.from_bytes(chunk, "little", signed=True) / full_scale
+            total += value
+        mono.append(total / channels)
+    return mono, rate
+
+
+def resample(samples, src_rate, dst_rate):
+    """Linear interpolation resampler (good enough for a buzzer)."""
+    if src_rate == dst_rate or not samples:
+        return samples
+    out_len = max(1, int(len(samples) * dst_rate / src_rate))
+    step = src_rate / dst_rate
+    out = []
+    for i in range(out_len):
+        pos = i * step
+        idx = int(pos)
+        frac = pos - idx
+        a = samples[min(idx, len(samples) - 1)]
+        b = samples[min(idx + 1, len(samples) - 1)]
+        out.append(a + (b - a) * frac)
+    return out
+
+
+def quantize(samples, gain):
+    """Maps -1.0..1.0 onto 0..255 with 0x80 as silence."""
+    out = []
+    for s in samples:
+        v = int(round(s * gain * 127.0)) + 128
+        out.append(min(255, max(0, v)))
+    return out
+
+
+def normalize_gain(samples):
+    peak = max((abs(s) for s in samples), default=0.0)
+    return 1.0 / peak if peak > 0 else 1.0
+
+
+def write_header(path, name, rate, data, source):
+    guard = os.path.basename(path).upper().replace(".", "_").replace("-", "_")
+    upper = name.upper()
+    lines = [
+        "/*",
+        "* filename: %s" % os.path.basename(path),
+        "* purpose: 8-bit PCM clip generated by tools/wav2c.py from %s" % os.path.basename(source),
+        "* note: Play with BUZZER_pcm_play(%s_clip, %s_LENGTH, %s_RATE)" % (name, upper, upper),
+        "*/",
+        "",
+        "#ifndef %s" % guard,
+        "#define %s" % guard,
+        "",
+        "#include <stdint.h>",
+        "",
+        "#define %s_RATE   %uU" % (upper, rate),
+        "#define %s_LENGTH %uU" % (upper, len(data)),
+        "",
+        "static const uint8_t %s_clip[%s_LENGTH] = {" % (name, upper),
+    ]
+    for i in range(0, len(data), 16):
+        row = ", ".join("0x%02X" % b for b in data[i:i + 16])
+        lines.append("    %s," % row)
+    lines += ["};", "", "#endif", ""]
+    with open(path, "w") as f:
+        f.write("\n".join(lines))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("wav", help="input WAV file")
+    parser.add_argument("header", help="output C header")
+    parser.add_argument("--name", default="sound", help="C identifier prefix (default: sound)")
+    parser.add_argument("--rate", type=int, default=8000, help="output sample rate in Hz (default: 8000)")
+    parser.add_argument("--max-seconds", type=float, default=0.0,
+                        help="truncate the clip to this length (0 = no limit)")
+    parser.add_argument("--no-normalize", action="store_true",
+                        help="keep the original level instead of scaling to full range")
+    args = parser.parse_args()
+
+    if not args.name.isidentifier():
+        sys.exit("error: --name must be a valid C identifier")
+
+    samples, src_rate = read_wav(args.wav)
+    samples = resample(samples, src_rate, args.rate)
+    if args.max_seconds > 0:
+        samples = samples[:int(args.max_seconds * args.rate)]
+    if not samples:
+        sys.exit("error: WAV file contains no samples")
+
+    gain = 1.0 if args.no_normalize else normalize_gain(samples)
+    data = quantize(samples, gain)
+    write_header(args.header, args.name, args.rate, data, args.wav)
+
+    print("%s: %u samples @ %u Hz (%.2f s, %u bytes of flash)"
+          % (args.header, len(data), args.rate, len(data) / args.rate, len(data)))
+
+
+if __name__ == "__main__":
+    main()